@@ -3,11 +3,18 @@ C++ 代码分析工具 - 直接输出结果（带日志）
 """
 import sys
 import io
+import json
 import os
 from pathlib import Path
 from datetime import datetime
 from simple_ast import CppProjectAnalyzer, AnalysisMode, get_mode_from_string
 from simple_ast.analysis_modes import get_mode_config
+from simple_ast.change_detector import GitDiffError, detect_changes, find_dependent_functions
+from simple_ast.searchers import (SearchTool, set_search_tool, configure_definition_index,
+                                   configure_search_concurrency)
+from simple_ast.reporters import configure_report_cache
+from simple_ast.logger import enable_profiling, format_profile_summary, span, write_chrome_trace
+from simple_ast.project_indexer import DEFAULT_HOT_CACHE_SIZE, STORE_KINDS
 
 # 设置标准输出为 UTF-8 编码
 if sys.platform == 'win32':
@@ -27,11 +34,39 @@ def log(message):
         log_file.flush()
 
 
+def collect_internal_calls(root, functions: set):
+    """收集调用树中的内部函数（外部节点及其下方不收集）"""
+    if not root or root.is_external:
+        return
+    functions.add(root.function_name)
+    seen_children = set()
+    stack = [root]
+    while stack:
+        node = stack.pop()
+        if id(node.children) in seen_children:
+            continue
+        seen_children.add(id(node.children))
+        for child in node.children:
+            if not child.is_external:
+                functions.add(child.function_name)
+                stack.append(child)
+
+
+def write_trace(result_dir: Path):
+    """写出 trace.json 并把阶段耗时/计数器汇总写入日志"""
+    trace_file = result_dir / "trace.json"
+    log(f"  - 写入性能追踪: {trace_file}")
+    write_chrome_trace(trace_file)
+    log("")
+    log(format_profile_summary())
+    log("")
+
+
 def main():
     global log_file
 
     if len(sys.argv) < 3:
-        print("用法: python analyze.py <项目根目录> <目标CPP文件> [模式] [追踪深度] [函数名] [--output <输出目录>]")
+        print("用法: python analyze.py <项目根目录> <目标CPP文件> [模式] [追踪深度] [函数名] [--output <输出目录>] [--no-cache] [--store S] [--hot-cache N] [--jobs N] [--search-tool T] [--trace] [--jsonl] [--lazy] [--changed <修订范围>] [--report-cache <目录>]")
         print()
         print("参数说明:")
         print("  项目根目录  - C++项目的根目录")
@@ -40,6 +75,16 @@ def main():
         print("  追踪深度    - 可选，函数调用链追踪深度（默认: 根据模式）")
         print("  函数名      - 可选，只分析指定的函数（默认分析文件中所有函数）")
         print("  --output    - 可选，输出目录（默认: ./output）")
+        print("  --no-cache  - 可选，不使用/不写入索引缓存和报告缓存（.simple_ast_cache/，含符号索引、定义索引和函数报告）")
+        print("  --report-cache D - 可选，函数报告缓存目录（默认 .simple_ast_cache/reports/，可放在多台机器共享的存储上）")
+        print("  --store S   - 可选，完整模式的符号索引存储: memory（默认，全部在内存）/ sqlite（存于 .simple_ast_cache/symbol_index.sqlite，内存占用不随项目规模增长，适合超大仓库）")
+        print(f"  --hot-cache N - 可选，--store sqlite 时在内存中缓存查找结果的名字数（默认: {DEFAULT_HOT_CACHE_SIZE}，0 表示不缓存）")
+        print("  --jobs N    - 可选，并行工作进程数，用于建索引和生成函数报告，同时也是并发 rg 搜索数上限（默认: 1，0 表示使用全部CPU核）")
+        print("  --search-tool T - 可选，文本搜索工具: auto / rg / grep / python（python 为进程内搜索，不启动子进程）")
+        print("  --trace     - 可选，记录各阶段耗时和计数器，输出 trace.json（Chrome trace 格式）并在日志末尾汇总")
+        print("  --jsonl     - 可选，输出 analysis.jsonl（JSON Lines，逐条流式写出，函数报告边生成边写），代替会展开完整调用树的 analysis.json / analysis.txt / call_chains.txt")
+        print("  --lazy      - 可选，配合函数名使用：只分析该函数可达的内部函数及其用到的类型，耗时与函数闭包大小相关而非文件大小")
+        print("  --changed R - 可选，单文件模式：只为修订范围 R（如 origin/main...HEAD）中改动的函数、引用了改动定义（结构体/typedef/宏/枚举/全局变量，包括包含闭包中的头文件）的函数及调用链经过它们的函数生成报告；都没有时直接退出")
         print()
         print("可用模式:")
         print("  single / boundary  - 单文件边界模式：快速分析单个文件，外部调用标记但不深入")
@@ -59,6 +104,9 @@ def main():
         print()
         print("  # 完整项目模式分析")
         print("  python analyze.py ./project src/main.cpp full 15")
+        print()
+        print("  # 合并请求中只分析改动的函数")
+        print("  python analyze.py . src/main.cpp --changed origin/main...HEAD")
         sys.exit(1)
 
     project_root = sys.argv[1]
@@ -69,6 +117,16 @@ def main():
     trace_depth = None
     target_function = None
     output_dir_str = "output"  # 默认输出目录
+    use_index_cache = True
+    jobs = 1
+    search_tool = None
+    trace = False
+    jsonl = False
+    lazy = False
+    changed_range = None
+    report_cache_dir = None
+    store = 'memory'
+    hot_cache_size = DEFAULT_HOT_CACHE_SIZE
 
     # 处理 --output 参数
     args = sys.argv[3:]
@@ -82,6 +140,89 @@ def main():
             print("错误：--output 需要指定目录路径")
             sys.exit(1)
 
+    # 处理 --changed 参数
+    if "--changed" in args:
+        changed_idx = args.index("--changed")
+        if changed_idx + 1 < len(args):
+            changed_range = args[changed_idx + 1]
+            args = args[:changed_idx] + args[changed_idx + 2:]
+        else:
+            print("错误：--changed 需要指定修订范围（如 origin/main...HEAD）")
+            sys.exit(1)
+
+    # 处理 --report-cache 参数
+    if "--report-cache" in args:
+        cache_idx = args.index("--report-cache")
+        if cache_idx + 1 < len(args):
+            report_cache_dir = args[cache_idx + 1]
+            args = args[:cache_idx] + args[cache_idx + 2:]
+        else:
+            print("错误：--report-cache 需要指定目录路径")
+            sys.exit(1)
+
+    # 处理 --jobs 参数
+    if "--jobs" in args:
+        jobs_idx = args.index("--jobs")
+        try:
+            jobs = int(args[jobs_idx + 1])
+        except (IndexError, ValueError):
+            print("错误：--jobs 需要指定进程数")
+            sys.exit(1)
+        args = args[:jobs_idx] + args[jobs_idx + 2:]
+        if jobs <= 0:
+            jobs = os.cpu_count() or 1
+
+    # 处理 --store 参数
+    if "--store" in args:
+        store_idx = args.index("--store")
+        if store_idx + 1 >= len(args) or args[store_idx + 1] not in STORE_KINDS:
+            print(f"错误：--store 需要指定存储（{' / '.join(STORE_KINDS)}）")
+            sys.exit(1)
+        store = args[store_idx + 1]
+        args = args[:store_idx] + args[store_idx + 2:]
+
+    # 处理 --hot-cache 参数
+    if "--hot-cache" in args:
+        hot_idx = args.index("--hot-cache")
+        try:
+            hot_cache_size = int(args[hot_idx + 1])
+        except (IndexError, ValueError):
+            hot_cache_size = -1
+        if hot_cache_size < 0:
+            print("错误：--hot-cache 需要指定非负整数")
+            sys.exit(1)
+        args = args[:hot_idx] + args[hot_idx + 2:]
+
+    # 处理 --search-tool 参数
+    if "--search-tool" in args:
+        tool_idx = args.index("--search-tool")
+        try:
+            search_tool = SearchTool(args[tool_idx + 1])
+        except (IndexError, ValueError):
+            print(f"错误：--search-tool 需要指定工具（{' / '.join(t.value for t in SearchTool)}）")
+            sys.exit(1)
+        args = args[:tool_idx] + args[tool_idx + 2:]
+
+    # 处理 --trace 参数
+    if "--trace" in args:
+        trace = True
+        args.remove("--trace")
+
+    # 处理 --jsonl 参数
+    if "--jsonl" in args:
+        jsonl = True
+        args.remove("--jsonl")
+
+    # 处理 --lazy 参数
+    if "--lazy" in args:
+        lazy = True
+        args.remove("--lazy")
+
+    # 处理 --no-cache 参数
+    if "--no-cache" in args:
+        use_index_cache = False
+        args.remove("--no-cache")
+
     # 处理其他参数
     if len(args) > 0:
         # 第1个参数：可能是模式或追踪深度
@@ -112,6 +253,10 @@ def main():
         print(f"错误: {e}")
         sys.exit(1)
 
+    if changed_range and (mode != AnalysisMode.SINGLE_FILE_BOUNDARY or target_function):
+        print("错误：--changed 只能用于单文件模式，且不能同时指定函数名")
+        sys.exit(1)
+
     # 如果没有指定追踪深度，使用模式默认值
     if trace_depth is None:
         trace_depth = mode_config.max_trace_depth
@@ -133,6 +278,26 @@ def main():
     log(f"日志文件: {log_filename}")
     log("=" * 80)
 
+    # 指定搜索工具（未指定时首次搜索自动检测）
+    if search_tool is not None:
+        try:
+            set_search_tool(search_tool)
+        except RuntimeError as e:
+            log(f"错误：{e}")
+            sys.exit(1)
+        log(f"搜索工具: {search_tool.value}")
+    # 相互独立的外部搜索并发执行，同时运行的 rg 进程数不超过 --jobs
+    configure_search_concurrency(jobs)
+
+    if trace:
+        enable_profiling()
+
+    # 定义索引（结构体/宏/常量/全局变量查找）与符号索引共用缓存开关
+    if not use_index_cache:
+        configure_definition_index(persist=False)
+    # 函数报告缓存：--no-cache 时关闭，指定 --report-cache 时使用共享目录
+    configure_report_cache(enabled=use_index_cache or bool(report_cache_dir), cache_dir=report_cache_dir)
+
     # 验证路径
     if not os.path.exists(project_root):
         log(f"错误：项目目录不存在: {project_root}")
@@ -153,16 +318,45 @@ def main():
     log(f"目标文件: {target_file}")
     log(f"分析模式: {mode.value} - {mode_config.description}")
     log(f"追踪深度: {trace_depth}")
+    if jobs > 1:
+        log(f"并行进程: {jobs}")
+    if store != 'memory':
+        log(f"符号存储: {store}")
     if target_function:
         log(f"目标函数: {target_function}")
+    elif changed_range:
+        log(f"分析范围: {changed_range} 中改动的函数及依赖它们的函数")
     else:
         log(f"分析范围: 文件中所有函数")
     log("")
 
+    change_set = None
+    if changed_range:
+        try:
+            change_set = detect_changes(project_root, full_path, changed_range)
+        except GitDiffError as e:
+            log(f"错误：无法获取改动: {e}")
+            sys.exit(1)
+        log(f"改动区间: {len(change_set.line_ranges)} 处，涉及函数: {', '.join(sorted(change_set.changed)) or '无'}")
+        if change_set.headers:
+            log(f"  包含的头文件有改动: {', '.join(sorted(change_set.headers))}")
+        if change_set.outside_functions or change_set.headers:
+            log(f"  函数外的改动涉及定义: {', '.join(sorted(change_set.definitions)) or '无'}")
+        if not change_set.changed:
+            if change_set.definitions:
+                log("✅ 文件中没有函数引用改动的定义，跳过分析")
+            else:
+                log("✅ 文件中没有函数或定义改动，跳过分析")
+            log_file.close()
+            sys.exit(0)
+        log("")
+
     try:
         # 创建分析器（根据模式）
         log("步骤 1/4: 初始化分析器...")
-        analyzer = CppProjectAnalyzer(project_root, mode=mode)
+        analyzer = CppProjectAnalyzer(project_root, mode=mode, use_index_cache=use_index_cache,
+                                      jobs=jobs, lazy=lazy and bool(target_function), store=store,
+                                      hot_cache_size=hot_cache_size)
         log("✓ 分析器初始化完成")
         log("")
 
@@ -198,19 +392,7 @@ def main():
 
         if use_structured_output:
             # 分层输出模式
-            # 1. 生成摘要报告（无分类信息）
-            summary_file = result_dir / "summary.txt"
-            log(f"  - 写入摘要报告: {summary_file}")
-            with open(summary_file, 'w', encoding='utf-8') as f:
-                f.write(result.generate_simple_summary_report())
-
-            # 2. 生成边界分析
-            boundary_file = result_dir / "boundary.txt"
-            log(f"  - 写入边界分析: {boundary_file}")
-            with open(boundary_file, 'w', encoding='utf-8') as f:
-                f.write(result.generate_boundary_report())
-
-            # 3. 生成每个函数的独立文件
+            # 1. 生成每个函数的独立文件（--jsonl 时边生成边写入 JSONL，JSONL 最先写出）
             functions_dir = result_dir / "functions"
             functions_dir.mkdir(exist_ok=True)
 
@@ -220,46 +402,85 @@ def main():
                 all_functions = set()
                 if target_function in result.call_chains:
                     all_functions.add(target_function)
-                    # 递归收集内部依赖
-                    def collect_internal_funcs(node):
-                        if node and not node.is_external:
-                            all_functions.add(node.function_name)
-                            for child in node.children:
-                                collect_internal_funcs(child)
-                    collect_internal_funcs(result.call_chains[target_function])
+                    # 递归收集内部依赖（共享子树只遍历一次）
+                    collect_internal_calls(result.call_chains[target_function], all_functions)
                 all_functions = sorted(all_functions)
                 log(f"  - 生成 {len(all_functions)} 个函数文件（目标函数及依赖）到: {functions_dir}/")
+            elif change_set:
+                # 改动的函数 + 调用链经过它们的函数（报告中的调用链随之变化）
+                change_set.dependents = find_dependent_functions(result.call_chains, change_set.changed)
+                all_functions = sorted(change_set.functions & set(result.file_boundary.internal_functions))
+                changes_file = result_dir / "changes.json"
+                log(f"  - 写入改动清单: {changes_file}")
+                with open(changes_file, 'w', encoding='utf-8') as f:
+                    json.dump(change_set.to_dict(), f, indent=2, ensure_ascii=False)
+                log(f"  - 生成 {len(all_functions)} 个函数文件（改动 {len(change_set.changed)} 个，"
+                    f"依赖 {len(change_set.dependents)} 个）到: {functions_dir}/")
             else:
                 # 生成所有函数的文件
                 all_functions = sorted(result.file_boundary.internal_functions) if result.file_boundary else sorted(result.function_signatures.keys())
                 log(f"  - 生成 {len(all_functions)} 个函数文件到: {functions_dir}/")
 
-            for idx, func_name in enumerate(all_functions, 1):
-                func_file = functions_dir / f"{func_name}.txt"
-                print(f"\n[文件输出] 生成函数报告 ({idx}/{len(all_functions)}): {func_name}", file=sys.stderr)
-                report = result.generate_single_function_report(func_name)
-                with open(func_file, 'w', encoding='utf-8') as f:
-                    f.write(report)
-                print(f"[文件输出] ✓ 写入文件: {func_file.name} ({len(report)} 字符)", file=sys.stderr)
+            # 先批量预取所有报告要用到的常量/宏/数据结构/签名，再逐个生成；
+            # jobs > 1 时报告在工作进程中生成，仍按函数名顺序写出
+            reports = result.generate_single_function_reports(all_functions, jobs=jobs)
+
+            def write_function_files():
+                for idx, (func_name, report) in enumerate(reports, 1):
+                    func_file = functions_dir / f"{func_name}.txt"
+                    print(f"\n[文件输出] 生成函数报告 ({idx}/{len(all_functions)}): {func_name}", file=sys.stderr)
+                    with span('report.write', 'report'), open(func_file, 'w', encoding='utf-8') as f:
+                        f.write(report)
+                    print(f"[文件输出] ✓ 写入文件: {func_file.name} ({len(report)} 字符)", file=sys.stderr)
+                    yield func_name, report
+
+            if jsonl:
+                # 先写出入口/边界/调用链，函数报告每生成一个追加一行
+                jsonl_file = result_dir / "analysis.jsonl"
+                log(f"  - 流式写入JSONL: {jsonl_file}")
+                with open(jsonl_file, 'w', encoding='utf-8') as f:
+                    result.write_jsonl(f, reports=write_function_files())
+            else:
+                for _ in write_function_files():
+                    pass
+
+            # 2. 生成摘要报告（无分类信息）
+            summary_file = result_dir / "summary.txt"
+            log(f"  - 写入摘要报告: {summary_file}")
+            with open(summary_file, 'w', encoding='utf-8') as f:
+                f.write(result.generate_simple_summary_report())
+
+            # 3. 生成边界分析
+            boundary_file = result_dir / "boundary.txt"
+            log(f"  - 写入边界分析: {boundary_file}")
+            with open(boundary_file, 'w', encoding='utf-8') as f:
+                f.write(result.generate_boundary_report())
 
             # 4. 生成调用链和数据结构报告（仅在多函数时）
             # 注意：单函数分析时，functions/ 已包含所有信息，无需额外文件
             if len(all_functions) > 1:
-                call_chains_file = result_dir / "call_chains.txt"
-                log(f"  - 写入调用链: {call_chains_file}")
-                with open(call_chains_file, 'w', encoding='utf-8') as f:
-                    f.write(result.generate_call_chains_report())
+                # call_chains.txt 与 analysis.json 会把共享子树逐份展开（可能指数级），
+                # --jsonl 时调用树只写在 analysis.jsonl 中（共享子树只写一次）
+                if not jsonl:
+                    call_chains_file = result_dir / "call_chains.txt"
+                    log(f"  - 写入调用链: {call_chains_file}")
+                    with open(call_chains_file, 'w', encoding='utf-8') as f:
+                        f.write(result.generate_call_chains_report())
 
                 data_structures_file = result_dir / "data_structures.txt"
                 log(f"  - 写入数据结构: {data_structures_file}")
                 with open(data_structures_file, 'w', encoding='utf-8') as f:
                     f.write(result.generate_data_structures_report())
 
-            # 6. JSON 输出
-            json_file = result_dir / "analysis.json"
-            log(f"  - 写入JSON数据: {json_file}")
-            with open(json_file, 'w', encoding='utf-8') as f:
-                f.write(result.to_json())
+            # 5. JSON 输出（--jsonl 时由 analysis.jsonl 代替）
+            if not jsonl:
+                json_file = result_dir / "analysis.json"
+                log(f"  - 写入JSON数据: {json_file}")
+                with open(json_file, 'w', encoding='utf-8') as f:
+                    f.write(result.to_json())
+
+            if trace:
+                write_trace(result_dir)
 
             log("✓ 输出文件生成完成")
             log("")
@@ -274,25 +495,38 @@ def main():
 
         else:
             # 小文件输出模式 - 也使用目录结构
-            # 保存文本报告
-            txt_file = result_dir / "analysis.txt"
-            log(f"  - 写入文本报告: {txt_file}")
-            with open(txt_file, 'w', encoding='utf-8') as f:
-                f.write(result.format_report())
-
-            # 保存 JSON
-            json_file = result_dir / "analysis.json"
-            log(f"  - 写入JSON数据: {json_file}")
-            with open(json_file, 'w', encoding='utf-8') as f:
-                f.write(result.to_json())
+            # --jsonl 时只流式写出 analysis.jsonl：文本报告和 JSON 都会展开完整调用树
+            if jsonl:
+                jsonl_file = result_dir / "analysis.jsonl"
+                log(f"  - 流式写入JSONL: {jsonl_file}")
+                with open(jsonl_file, 'w', encoding='utf-8') as f:
+                    result.write_jsonl(f)
+            else:
+                # 保存文本报告
+                txt_file = result_dir / "analysis.txt"
+                log(f"  - 写入文本报告: {txt_file}")
+                with open(txt_file, 'w', encoding='utf-8') as f:
+                    f.write(result.format_report())
+
+                # 保存 JSON
+                json_file = result_dir / "analysis.json"
+                log(f"  - 写入JSON数据: {json_file}")
+                with open(json_file, 'w', encoding='utf-8') as f:
+                    f.write(result.to_json())
+
+            if trace:
+                write_trace(result_dir)
 
             log("✓ 输出文件生成完成")
             log("")
             log("=" * 80)
             log("✅ 分析完成!")
             log(f"📁 输出目录: {result_dir}")
-            log(f"📄 文本报告: {txt_file}")
-            log(f"📊 JSON数据: {json_file}")
+            if jsonl:
+                log(f"📊 JSONL数据: {jsonl_file}")
+            else:
+                log(f"📄 文本报告: {txt_file}")
+                log(f"📊 JSON数据: {json_file}")
             log(f"📝 执行日志: {log_filename}")
             log("=" * 80)
 
@@ -0,0 +1,129 @@
+"""
+SimpleAST 批量分析 - 一次运行分析项目中的多个源文件，共享索引和缓存
+
+用法:
+    python batch_analyze.py <项目根目录> <目标...> [--mode M] [--depth N] [--output <输出目录>]
+                            [--jobs N] [--no-cache] [--store S] [--hot-cache N] [--search-tool T] [--reports] [--jsonl]
+                            [--report-cache <目录>] [--verbose]
+
+目标可以是：
+    @files.txt    列表文件，每行一个路径或通配符（# 开头为注释）
+    src/          目录，递归收集 .c/.cc/.cpp/.cxx
+    'src/**/*.cpp'  通配符（相对项目根目录）
+    src/foo.cpp   单个文件
+
+每个文件的结果写到 <输出目录>/<相对路径>/（summary.txt、analysis.json，
+--reports 时还有 functions/，--jsonl 时以流式的 analysis.jsonl 代替 analysis.json），
+汇总写到 <输出目录>/batch_summary.json。有文件失败时退出码为 1。
+--reports 生成的函数报告按内容缓存（默认 .simple_ast_cache/reports/，
+--report-cache 指定共享目录，--no-cache 关闭）。
+full 模式下 --store sqlite 把符号索引放在 .simple_ast_cache/symbol_index.sqlite，
+内存占用不随项目规模增长（默认 memory）；--hot-cache N 为其在内存中缓存查找结果的
+名字数（默认 4096，0 关闭）。
+"""
+import io
+import sys
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+import os
+from datetime import datetime
+from pathlib import Path
+from simple_ast import get_mode_from_string
+from simple_ast.reporters import configure_report_cache
+from simple_ast.project_indexer import DEFAULT_HOT_CACHE_SIZE, STORE_KINDS
+from simple_ast.batch_runner import SUMMARY_FILE_NAME, BatchOptions, collect_targets, run_batch
+from simple_ast.searchers import (SearchTool, set_search_tool, configure_definition_index,
+                                   configure_search_concurrency)
+
+
+def main():
+    args = sys.argv[1:]
+    if len(args) < 2 or args[0] in ('-h', '--help'):
+        print(__doc__)
+        sys.exit(0 if args and args[0] in ('-h', '--help') else 1)
+
+    project_root = args.pop(0)
+    options = {'--mode': 'single', '--depth': None, '--output': None, '--jobs': '1',
+               '--search-tool': None, '--report-cache': None, '--store': 'memory',
+               '--hot-cache': str(DEFAULT_HOT_CACHE_SIZE)}
+    flags = {'--no-cache': False, '--reports': False, '--jsonl': False,
+             '--verbose': False}
+    specs = []
+    while args:
+        arg = args.pop(0)
+        if arg in flags:
+            flags[arg] = True
+        elif arg in options:
+            if not args:
+                print(f"错误：{arg} 需要指定参数值", file=sys.stderr)
+                sys.exit(1)
+            options[arg] = args.pop(0)
+        else:
+            specs.append(arg)
+
+    try:
+        mode = get_mode_from_string(options['--mode'])
+        trace_depth = int(options['--depth']) if options['--depth'] is not None else None
+        jobs = int(options['--jobs'])
+        if jobs <= 0:
+            jobs = os.cpu_count() or 1
+        search_tool = SearchTool(options['--search-tool']) if options['--search-tool'] else None
+        if options['--store'] not in STORE_KINDS:
+            raise ValueError(f"--store 需要指定存储（{' / '.join(STORE_KINDS)}）")
+        hot_cache_size = int(options['--hot-cache'])
+        if hot_cache_size < 0:
+            raise ValueError("--hot-cache 需要指定非负整数")
+    except ValueError as e:
+        print(f"错误: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if not os.path.isdir(project_root):
+        print(f"错误：项目目录不存在: {project_root}", file=sys.stderr)
+        sys.exit(1)
+
+    if search_tool is not None:
+        try:
+            set_search_tool(search_tool)
+        except RuntimeError as e:
+            print(f"错误：{e}", file=sys.stderr)
+            sys.exit(1)
+    configure_search_concurrency(jobs)
+    if flags['--no-cache']:
+        configure_definition_index(persist=False)
+    configure_report_cache(enabled=not flags['--no-cache'] or bool(options['--report-cache']),
+                           cache_dir=options['--report-cache'])
+
+    targets = collect_targets(project_root, specs)
+    if not targets:
+        print("错误：没有找到要分析的文件", file=sys.stderr)
+        sys.exit(1)
+
+    output_dir = Path(options['--output'] or
+                      Path("output") / f"_batch_{datetime.now().strftime('%Y%m%d_%H%M%S')}")
+    batch_options = BatchOptions(mode=mode, trace_depth=trace_depth,
+                                 use_index_cache=not flags['--no-cache'], store=options['--store'],
+                                 hot_cache_size=hot_cache_size, reports=flags['--reports'], jsonl=flags['--jsonl'],
+                                 quiet=not flags['--verbose'])
+
+    print(f"批量分析 {len(targets)} 个文件（{mode.value}，{jobs} 个进程）-> {output_dir}")
+
+    def progress(item, done, total):
+        mark = '✓' if item.status == 'ok' else '✗'
+        detail = f"{item.functions} 个函数" if item.status == 'ok' else item.error
+        print(f"[{done}/{total}] {mark} {item.file} ({item.seconds:.2f}s, {detail})", flush=True)
+
+    results = run_batch(project_root, targets, output_dir, batch_options, jobs=jobs, on_result=progress)
+
+    failed = [item for item in results if item.status != 'ok']
+    print(f"\n完成: {len(results) - len(failed)} 成功, {len(failed)} 失败")
+    print(f"汇总: {output_dir / SUMMARY_FILE_NAME}")
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,403 @@
+"""
+性能基准 - 对 tests/ 下的样例文件（可选加上合成的大文件）逐阶段计时
+
+阶段：indexing（全项目符号索引）、boundary（单文件边界分析）、tracing（调用链追踪）、
+branches（分支分析）、lookups（报告用到的常量/宏/数据结构/签名查找）、reports（生成并写出函数报告）
+
+每个阶段在冷缓存下运行 --repeat 次，记录最小值/中位数；另跑一轮用 tracemalloc 记录各阶段
+Python 堆峰值。结果写成 JSON，可以用 --baseline 与之前的结果对比，超过阈值的变慢会列出并
+以退出码 1 结束（便于在发版前的流水线中拦截性能回退）。
+
+用法:
+    python benchmark.py [--fixtures <目录>] [--synthetic N] [--repeat N] [--search-tool T]
+                        [--output <结果.json>] [--baseline <基线.json>] [--threshold 0.2]
+"""
+import contextlib
+import io
+import json
+import os
+import platform
+import shutil
+import statistics
+import sys
+import tempfile
+import time
+import tracemalloc
+from datetime import datetime
+from pathlib import Path
+from typing import Callable, Dict, List, Optional
+
+from simple_ast.branch_analyzer import BranchAnalyzer
+from simple_ast.call_chain_tracer import visit_call_tree
+from simple_ast.cpp_analyzer import AnalysisResult
+from simple_ast.cpp_parser import CppParser
+from simple_ast.external_classifier import ExternalFunctionClassifier
+from simple_ast.extractors import clear_macro_tables
+from simple_ast.project_indexer import ProjectIndexer
+from simple_ast.reporters import configure_report_cache
+from simple_ast.searchers import (SearchTool, clear_corpus_cache, clear_include_resolvers,
+                                  configure_definition_index, get_search_config, set_search_tool)
+from simple_ast.single_file_analyzer import SingleFileAnalyzer
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+BENCHMARK_VERSION = 1
+PHASES = ['indexing', 'boundary', 'tracing', 'branches', 'lookups', 'reports']
+
+# 与基线对比时忽略绝对耗时过小的阶段（计时抖动比例太大）
+MIN_COMPARABLE_SECONDS = 0.005
+
+
+# ==================== 合成语料 ====================
+
+def generate_synthetic_project(root: Path, function_count: int) -> Path:
+    """
+    生成一个按 function_count 放大的合成项目（一个头文件 + 一个源文件）
+
+    每个函数带 if/switch 分支，调用后面的两个函数并使用头文件中的结构体/宏/枚举常量，
+    覆盖追踪、分支分析和各类外部标识符查找。
+    """
+    include_dir = root / 'include'
+    src_dir = root / 'src'
+    include_dir.mkdir(parents=True, exist_ok=True)
+    src_dir.mkdir(parents=True, exist_ok=True)
+
+    struct_count = max(1, function_count // 10)
+    header = ['#ifndef SYNTHETIC_H', '#define SYNTHETIC_H', '']
+    for i in range(struct_count):
+        header.append(f'#define SYN_LIMIT_{i} {i + 16}')
+        header.append(f'typedef struct tag_SynData{i} {{')
+        header.append('    int id;')
+        header.append(f'    unsigned char payload[SYN_LIMIT_{i}];')
+        header.append(f'}} SynData{i};')
+        header.append('')
+    header.append('enum SynState {')
+    header.extend(f'    SYN_STATE_{i} = {i},' for i in range(8))
+    header.append('};')
+    header.append('')
+    header.append('int SynExternalSend(int id, const void *data);')
+    header.append('#endif')
+    (include_dir / 'synthetic.h').write_text('\n'.join(header) + '\n', encoding='utf-8')
+
+    source = ['#include "synthetic.h"', '']
+    for i in reversed(range(function_count)):
+        struct_name = f'SynData{i % struct_count}'
+        source.append(f'int SynFunc{i}({struct_name} *data, int state)')
+        source.append('{')
+        source.append(f'    if (data == 0 || data->id > SYN_LIMIT_{i % struct_count}) {{')
+        source.append('        return -1;')
+        source.append('    }')
+        source.append('    switch (state) {')
+        for case in range(4):
+            source.append(f'        case SYN_STATE_{case}:')
+            source.append(f'            data->id += {case};')
+            source.append('            break;')
+        source.append('        default:')
+        source.append('            break;')
+        source.append('    }')
+        for callee in (i + 1, i + 2):
+            if callee < function_count:
+                source.append(f'    SynFunc{callee}((SynData{callee % struct_count} *)data, state);')
+        source.append('    return SynExternalSend(data->id, data->payload);')
+        source.append('}')
+        source.append('')
+    target = src_dir / 'synthetic.cpp'
+    target.write_text('\n'.join(source), encoding='utf-8')
+    return target
+
+
+# ==================== 计时 ====================
+
+def reset_caches():
+    """清空所有进程级缓存，保证每次运行都是冷启动"""
+    CppParser.clear_parse_cache()
+    clear_corpus_cache()
+    clear_include_resolvers()
+    configure_definition_index(persist=False)
+    clear_macro_tables()
+    configure_report_cache(enabled=False)
+
+
+@contextlib.contextmanager
+def quiet():
+    """屏蔽分析过程中的控制台输出"""
+    with contextlib.redirect_stdout(io.StringIO()), contextlib.redirect_stderr(io.StringIO()):
+        yield
+
+
+def run_phases(project_root: Path, target: Path, output_dir: Path,
+               measure: Callable[[str, Callable], object]):
+    """
+    按顺序执行各阶段；measure(phase, fn) 负责执行并记录 fn()
+
+    与 CppProjectAnalyzer 的单文件边界模式流程一致，只是拆开以便逐段计时。
+    """
+    measure('indexing', lambda: ProjectIndexer(str(project_root), use_cache=False).index_project())
+
+    analyzer = SingleFileAnalyzer(str(project_root))
+    boundary = measure('boundary', lambda: analyzer.analyze_file(str(target)))
+    source_code = boundary.source_code
+
+    def trace():
+        entry_points = analyzer.get_entry_points(source_code, str(target))
+        chains = {}
+        signatures = {}
+
+        def collect(node):
+            if node.function_name not in signatures:
+                location = f"{node.file_path}:{node.line_number}" if not node.is_external else "<external>"
+                signatures[node.function_name] = f"{node.signature} // {location}"
+
+        for ep in entry_points:
+            tree = analyzer.trace_call_chain(ep.name, source_code, max_depth=10)
+            if tree:
+                chains[ep.name] = tree
+                visit_call_tree(tree, collect)
+        return entry_points, chains, signatures
+    entry_points, call_chains, signatures = measure('tracing', trace)
+
+    def branches():
+        branch_analyzer = BranchAnalyzer()
+        return {name: branch_analyzer.analyze_function(info['node'], source_code)
+                for name, info in analyzer.file_functions.items()}
+    branch_analyses = measure('branches', branches)
+
+    result = AnalysisResult(
+        target_file=str(target),
+        project_root=str(project_root),
+        entry_points=entry_points,
+        call_chains=call_chains,
+        function_signatures=signatures,
+        data_structures=analyzer.get_data_structures_info(),
+        mode='single_file_boundary',
+        file_boundary=boundary,
+        branch_analyses=branch_analyses,
+        external_classifier=ExternalFunctionClassifier()
+    )
+    func_names = sorted(boundary.internal_functions)
+    measure('lookups', lambda: result.prefetch_single_function_reports(func_names))
+
+    def reports():
+        for func_name, report in result.generate_single_function_reports(func_names):
+            (output_dir / f'{func_name}.txt').write_text(report, encoding='utf-8')
+    measure('reports', reports)
+    return len(func_names)
+
+
+def benchmark_target(project_root: Path, target: Path, repeat: int) -> dict:
+    """对单个目标文件做 repeat 轮计时 + 一轮内存测量"""
+    timings: Dict[str, List[float]] = {phase: [] for phase in PHASES}
+    function_count = 0
+
+    def timed(phase, fn):
+        start = time.perf_counter()
+        value = fn()
+        timings[phase].append(time.perf_counter() - start)
+        return value
+
+    for _ in range(repeat):
+        reset_caches()
+        with tempfile.TemporaryDirectory() as out, quiet():
+            function_count = run_phases(project_root, target, Path(out), timed)
+
+    # 内存单独测一轮：tracemalloc 本身会明显拖慢计时
+    peaks: Dict[str, int] = {}
+
+    def traced(phase, fn):
+        tracemalloc.start()
+        try:
+            return fn()
+        finally:
+            peaks[phase] = tracemalloc.get_traced_memory()[1] // 1024
+            tracemalloc.stop()
+
+    reset_caches()
+    with tempfile.TemporaryDirectory() as out, quiet():
+        run_phases(project_root, target, Path(out), traced)
+
+    try:
+        line_count = target.read_bytes().count(b'\n') + 1
+    except OSError:
+        line_count = 0
+
+    return {
+        'file': target.name,
+        'lines': line_count,
+        'functions': function_count,
+        'phases': {
+            phase: {
+                'min': round(min(runs), 6),
+                'median': round(statistics.median(runs), 6),
+                'runs': [round(t, 6) for t in runs],
+                'peak_kb': peaks.get(phase, 0),
+            }
+            for phase, runs in timings.items() if runs
+        },
+    }
+
+
+def max_rss_kb() -> Optional[int]:
+    """进程峰值常驻内存（Windows 上不可用）"""
+    try:
+        import resource
+    except ImportError:
+        return None
+    rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # macOS 返回字节，Linux 返回 KB
+    return rss // 1024 if sys.platform == 'darwin' else rss
+
+
+# ==================== 基线对比 ====================
+
+def compare_with_baseline(current: dict, baseline: dict, threshold: float) -> List[str]:
+    """返回变慢超过阈值的 文件/阶段 说明（按中位数比较）"""
+    baseline_targets = {t['file']: t for t in baseline.get('targets', [])}
+    regressions = []
+
+    print()
+    print(f"{'文件':<32} {'阶段':<10} {'基线(s)':>10} {'当前(s)':>10} {'变化':>8}")
+    print('-' * 74)
+    for target in current['targets']:
+        base = baseline_targets.get(target['file'])
+        if base is None:
+            continue
+        for phase in PHASES:
+            now = target['phases'].get(phase)
+            before = base['phases'].get(phase)
+            if not now or not before:
+                continue
+            old, new = before['median'], now['median']
+            if max(old, new) < MIN_COMPARABLE_SECONDS or old <= 0:
+                continue
+            change = (new - old) / old
+            mark = ''
+            if change > threshold:
+                mark = '  ← 变慢'
+                regressions.append(f"{target['file']} {phase}: {old:.4f}s -> {new:.4f}s ({change:+.0%})")
+            print(f"{target['file']:<32} {phase:<10} {old:>10.4f} {new:>10.4f} {change:>+8.0%}{mark}")
+    return regressions
+
+
+# ==================== 入口 ====================
+
+def parse_args(argv: List[str]) -> dict:
+    options = {
+        'fixtures': Path(__file__).resolve().parent / 'tests',
+        'synthetic': 0,
+        'repeat': 3,
+        'search_tool': None,
+        'output': None,
+        'baseline': None,
+        'threshold': 0.2,
+    }
+    args = list(argv)
+    while args:
+        arg = args.pop(0)
+        if arg in ('-h', '--help'):
+            print(__doc__)
+            sys.exit(0)
+        if not args:
+            print(f"错误：{arg} 需要指定参数值")
+            sys.exit(1)
+        value = args.pop(0)
+        try:
+            if arg == '--fixtures':
+                options['fixtures'] = Path(value).resolve()
+            elif arg == '--synthetic':
+                options['synthetic'] = int(value)
+            elif arg == '--repeat':
+                options['repeat'] = max(1, int(value))
+            elif arg == '--search-tool':
+                options['search_tool'] = SearchTool(value)
+            elif arg == '--output':
+                options['output'] = Path(value)
+            elif arg == '--baseline':
+                options['baseline'] = Path(value)
+            elif arg == '--threshold':
+                options['threshold'] = float(value)
+            else:
+                print(f"错误：未知参数 {arg}")
+                sys.exit(1)
+        except ValueError:
+            print(f"错误：{arg} 的参数值无效: {value}")
+            sys.exit(1)
+    return options
+
+
+def main():
+    options = parse_args(sys.argv[1:])
+
+    if options['search_tool'] is not None:
+        try:
+            set_search_tool(options['search_tool'])
+        except RuntimeError as e:
+            print(f"错误：{e}")
+            sys.exit(1)
+
+    fixtures_dir: Path = options['fixtures']
+    targets = [(fixtures_dir, path) for path in sorted(fixtures_dir.glob('*.cpp'))]
+
+    synthetic_root = None
+    if options['synthetic'] > 0:
+        synthetic_root = Path(tempfile.mkdtemp(prefix='simple_ast_bench_'))
+        targets.append((synthetic_root, generate_synthetic_project(synthetic_root, options['synthetic'])))
+
+    if not targets:
+        print(f"错误：{fixtures_dir} 下没有 .cpp 样例文件")
+        sys.exit(1)
+
+    result = {
+        'version': BENCHMARK_VERSION,
+        'timestamp': datetime.now().isoformat(timespec='seconds'),
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'cpu_count': os.cpu_count(),
+        'search_tool': get_search_config().tool.value,
+        'repeat': options['repeat'],
+        'synthetic_functions': options['synthetic'],
+        'targets': [],
+    }
+
+    try:
+        for project_root, target in targets:
+            print(f"基准: {target.name} ...", end='', flush=True)
+            entry = benchmark_target(project_root, target, options['repeat'])
+            result['targets'].append(entry)
+            total = sum(p['median'] for p in entry['phases'].values())
+            print(f" {entry['functions']} 个函数，合计 {total:.3f}s")
+    finally:
+        if synthetic_root is not None:
+            shutil.rmtree(synthetic_root, ignore_errors=True)
+
+    result['max_rss_kb'] = max_rss_kb()
+
+    print()
+    print(f"{'文件':<32} " + ' '.join(f'{phase:>10}' for phase in PHASES))
+    for entry in result['targets']:
+        cells = [f"{entry['phases'][p]['median']:>10.4f}" if p in entry['phases'] else f"{'-':>10}"
+                 for p in PHASES]
+        print(f"{entry['file']:<32} " + ' '.join(cells))
+
+    if options['output']:
+        options['output'].parent.mkdir(parents=True, exist_ok=True)
+        with open(options['output'], 'w', encoding='utf-8') as f:
+            json.dump(result, f, indent=2, ensure_ascii=False)
+        print(f"\n结果已写入: {options['output']}")
+
+    if options['baseline']:
+        with open(options['baseline'], 'r', encoding='utf-8') as f:
+            baseline = json.load(f)
+        regressions = compare_with_baseline(result, baseline, options['threshold'])
+        if regressions:
+            print(f"\n发现 {len(regressions)} 处超过 {options['threshold']:.0%} 的性能回退:")
+            for line in regressions:
+                print(f"  {line}")
+            sys.exit(1)
+        print("\n未发现性能回退")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,130 @@
+"""
+SimpleAST 调用者查询 - 用全项目反向调用索引回答“谁调用了它 / 改它会影响什么”
+
+用法:
+    python callers.py <项目根目录> <函数名> [--transitive] [--depth N] [--json]
+                                            [--jobs N] [--no-cache] [--store S] [--hot-cache N]
+    python callers.py <项目根目录> --impact <函数名,...> [--depth N] [--json]
+                                            [--jobs N] [--no-cache] [--store S] [--hot-cache N]
+
+默认列出直接调用点（文件:行号、所在函数）；--transitive 列出所有间接调用者及调用距离；
+--impact 给出一组函数的影响范围：这些函数、它们的全部（或 --depth 层以内的）调用者，
+以及涉及的文件。索引与 full 模式共用 .simple_ast_cache/symbol_index.pkl，
+只有变化的文件会重新解析。函数按名字匹配（obj->Send 与 ns::Send 都算 Send），
+与调用链追踪的规则一致。--store sqlite 时索引存于 .simple_ast_cache/symbol_index.sqlite，
+查询直接走数据库，内存占用不随项目规模增长；--hot-cache N 为在内存中缓存查找结果的
+名字数（默认 4096，0 关闭）。
+"""
+import io
+import sys
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+import contextlib
+import json
+import os
+from simple_ast.project_indexer import DEFAULT_HOT_CACHE_SIZE, STORE_KINDS, ProjectIndexer
+
+
+def main():
+    args = sys.argv[1:]
+    if len(args) < 2 or args[0] in ('-h', '--help'):
+        print(__doc__)
+        sys.exit(0 if args and args[0] in ('-h', '--help') else 1)
+
+    project_root = args.pop(0)
+    options = {'--depth': None, '--jobs': '1', '--impact': None, '--store': 'memory',
+               '--hot-cache': str(DEFAULT_HOT_CACHE_SIZE)}
+    flags = {'--transitive': False, '--json': False, '--no-cache': False}
+    names = []
+    while args:
+        arg = args.pop(0)
+        if arg in flags:
+            flags[arg] = True
+        elif arg in options:
+            if not args:
+                print(f"错误：{arg} 需要指定参数值", file=sys.stderr)
+                sys.exit(1)
+            options[arg] = args.pop(0)
+        else:
+            names.append(arg)
+
+    if options['--impact']:
+        names += [name.strip() for name in options['--impact'].split(',') if name.strip()]
+    if not names:
+        print("错误：需要指定函数名", file=sys.stderr)
+        sys.exit(1)
+
+    try:
+        depth = int(options['--depth']) if options['--depth'] is not None else None
+        jobs = int(options['--jobs'])
+        if jobs <= 0:
+            jobs = os.cpu_count() or 1
+        if options['--store'] not in STORE_KINDS:
+            raise ValueError(f"--store 需要指定存储（{' / '.join(STORE_KINDS)}）")
+        hot_cache_size = int(options['--hot-cache'])
+        if hot_cache_size < 0:
+            raise ValueError("--hot-cache 需要指定非负整数")
+    except ValueError as e:
+        print(f"错误: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if not os.path.isdir(project_root):
+        print(f"错误：项目目录不存在: {project_root}", file=sys.stderr)
+        sys.exit(1)
+
+    indexer = ProjectIndexer(project_root, use_cache=not flags['--no-cache'], jobs=jobs,
+                             store=options['--store'], hot_cache_size=hot_cache_size)
+    # --json 时索引进度写到 stderr，stdout 只有结果
+    with contextlib.redirect_stdout(sys.stderr if flags['--json'] else sys.stdout):
+        indexer.index_project()
+
+    if options['--impact']:
+        impact = indexer.impact_set(names, max_depth=depth)
+        if flags['--json']:
+            print(json.dumps(impact.to_dict(), ensure_ascii=False, indent=2))
+            return
+        print(f"影响范围: {', '.join(impact.roots)}"
+              f"（{len(impact.functions)} 个函数，{len(impact.files)} 个文件）")
+        for name in impact.functions:
+            print(f"  [{impact.distances[name]}] {name}")
+        print("涉及文件:")
+        for path, functions in impact.files.items():
+            print(f"  {path}: {', '.join(functions)}")
+        return
+
+    results = {}
+    for name in names:
+        if flags['--transitive'] or depth is not None:
+            results[name] = indexer.find_transitive_callers(name, max_depth=depth)
+        else:
+            results[name] = indexer.find_callers(name)
+
+    if flags['--json']:
+        output = {}
+        for name, value in results.items():
+            if isinstance(value, dict):
+                output[name] = [{'name': caller, 'distance': distance}
+                                for caller, distance in sorted(value.items(), key=lambda kv: (kv[1], kv[0]))]
+            else:
+                output[name] = [{'caller': site.caller, 'file': site.file_path, 'line': site.line}
+                                for site in value]
+        print(json.dumps(output, ensure_ascii=False, indent=2))
+        return
+
+    for name, value in results.items():
+        if isinstance(value, dict):
+            print(f"{name} 的调用者（{len(value)} 个）:")
+            for caller, distance in sorted(value.items(), key=lambda kv: (kv[1], kv[0])):
+                print(f"  [{distance}] {caller}")
+        else:
+            print(f"{name} 的调用点（{len(value)} 处）:")
+            for site in value:
+                print(f"  {site.file_path}:{site.line}  {site.caller}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,317 @@
+"""
+SimpleAST 规模压力测试 - 在不同规模的合成项目上测量各分析模式的耗时和峰值内存
+
+对 --sizes 中的每个文件数生成一个合成项目（见 synthetic_project.py，其余规模参数可一并指定），
+每个 (规模, 模式) 在一个全新的子进程中冷启动运行，分阶段计时并记录该进程的峰值 RSS：
+    setup    创建分析器（full 模式包括全项目符号索引）
+    headers  HeaderSearcher 查找抽样源文件的头文件（#include 闭包）
+    analyze  analyze_file 分析抽样源文件
+    reports  为抽样源文件的全部内部函数生成单函数报告
+抽样文件数固定（--samples），理想情况下 analyze/reports 不随项目规模增长、setup 线性增长。
+
+输出每个阶段相邻两个规模之间的增长指数（log(耗时比) / log(规模比)，1 为线性），
+超过 --threshold 的标记为超线性；可写出 JSON（--output），安装了 matplotlib 时
+可画出 耗时 / 峰值 RSS - 规模 曲线（--plot）。超线性时退出码为 1。
+
+用法:
+    python scaling_benchmark.py [--sizes 10,40,160] [--modes single,full] [--samples 3]
+                                [--search-tool T] [--threshold 1.3] [--output <结果.json>]
+                                [--plot <图.png>] [--keep <目录>] [synthetic_project.py 的规模参数]
+"""
+import io
+import sys
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+import contextlib
+import json
+import math
+import os
+import platform
+import shutil
+import subprocess
+import tempfile
+import time
+from dataclasses import asdict, replace
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from synthetic_project import SyntheticSpec, generate_project, parse_spec_options
+
+SCALING_VERSION = 1
+PHASES = ['setup', 'headers', 'analyze', 'reports']
+MODES = ('single', 'full')
+
+# 计算增长指数时忽略耗时过小的阶段（计时抖动比例太大）
+MIN_COMPARABLE_SECONDS = 0.05
+
+
+# ==================== 子进程：单次测量 ====================
+
+def sample_targets(sources: List[str], samples: int) -> List[str]:
+    """在源文件中均匀抽取 samples 个（规模变化时抽样数不变）"""
+    if len(sources) <= samples:
+        return list(sources)
+    step = (len(sources) - 1) / max(1, samples - 1)
+    return [sources[round(i * step)] for i in range(samples)]
+
+
+def run_worker(job: dict) -> dict:
+    """在当前（全新的）进程中测量一个 (项目, 模式)"""
+    from benchmark import max_rss_kb
+    from simple_ast import get_mode_from_string
+    from simple_ast.reporters import configure_report_cache
+    from simple_ast.searchers import (HeaderSearcher, SearchTool, configure_definition_index,
+                                      set_search_tool)
+    from simple_ast.cpp_analyzer import CppProjectAnalyzer
+
+    if job.get('search_tool'):
+        set_search_tool(SearchTool(job['search_tool']))
+    configure_definition_index(persist=False)
+    configure_report_cache(enabled=False)
+
+    project_root = job['root']
+    targets = job['targets']
+    timings: Dict[str, float] = {}
+    reports = 0
+
+    @contextlib.contextmanager
+    def timed(phase):
+        start = time.perf_counter()
+        yield
+        timings[phase] = round(time.perf_counter() - start, 6)
+
+    with contextlib.redirect_stdout(io.StringIO()):
+        with timed('setup'):
+            analyzer = CppProjectAnalyzer(project_root, mode=get_mode_from_string(job['mode']),
+                                          use_index_cache=False)
+        with timed('headers'):
+            searcher = HeaderSearcher(project_root=project_root)
+            for target in targets:
+                searcher.find_headers(target)
+        results = []
+        with timed('analyze'):
+            for target in targets:
+                results.append(analyzer.analyze_file(target))
+        with timed('reports'):
+            for result in results:
+                boundary = result.file_boundary
+                names = sorted(boundary.internal_functions if boundary else result.function_signatures)
+                for _ in result.generate_single_function_reports(names):
+                    reports += 1
+
+    return {'phases': timings, 'total': round(sum(timings.values()), 6),
+            'peak_rss_kb': max_rss_kb(), 'reports': reports}
+
+
+def measure(job: dict) -> dict:
+    """在子进程中运行 run_worker，返回其结果（失败时带 error）"""
+    cmd = [sys.executable, os.path.abspath(__file__), '--worker', json.dumps(job, ensure_ascii=False)]
+    proc = subprocess.run(cmd, capture_output=True, text=True, encoding='utf-8', errors='replace',
+                          cwd=os.path.dirname(os.path.abspath(__file__)))
+    lines = proc.stdout.strip().splitlines()
+    if proc.returncode != 0 or not lines:
+        return {'error': (proc.stderr.strip().splitlines() or ['子进程失败'])[-1]}
+    return json.loads(lines[-1])
+
+
+# ==================== 增长分析 ====================
+
+def growth_exponents(points: List[dict], key,
+                     minimum: float = MIN_COMPARABLE_SECONDS) -> List[Optional[float]]:
+    """相邻两个规模之间的增长指数（按源码行数），数据不足或数值小于 minimum 时为 None"""
+    exponents = []
+    for before, after in zip(points, points[1:]):
+        old, new = key(before), key(after)
+        size_ratio = after['lines'] / before['lines'] if before['lines'] else 0
+        if old is None or new is None or size_ratio <= 1 or max(old, new) < minimum or old <= 0:
+            exponents.append(None)
+        else:
+            exponents.append(round(math.log(new / old) / math.log(size_ratio), 2))
+    return exponents
+
+
+def print_mode_table(mode: str, points: List[dict], threshold: float) -> List[str]:
+    """打印一个模式的结果表，返回超线性的说明"""
+    print(f"\n[{mode}]")
+    print(f"{'文件':>6} {'行数':>9} " + ' '.join(f'{phase:>9}' for phase in PHASES) +
+          f" {'合计(s)':>9} {'峰值RSS':>10}")
+    for point in points:
+        if 'error' in point:
+            print(f"{point['files']:>6} {point['lines']:>9}  失败: {point['error']}")
+            continue
+        rss = f"{point['peak_rss_kb'] / 1024:.0f} MB" if point.get('peak_rss_kb') else '-'
+        print(f"{point['files']:>6} {point['lines']:>9} " +
+              ' '.join(f"{point['phases'].get(phase, 0):>9.3f}" for phase in PHASES) +
+              f" {point['total']:>9.3f} {rss:>10}")
+
+    ok_points = [p for p in points if 'error' not in p]
+    findings = []
+    series = {phase: (lambda p, phase=phase: p['phases'].get(phase), MIN_COMPARABLE_SECONDS)
+              for phase in PHASES}
+    series['total'] = (lambda p: p['total'], MIN_COMPARABLE_SECONDS)
+    series['peak_rss'] = (lambda p: p.get('peak_rss_kb'), 0)
+    for name, (key, minimum) in series.items():
+        exponents = growth_exponents(ok_points, key, minimum)
+        if not any(e is not None for e in exponents):
+            continue
+        cells = ' '.join('-' if e is None else f'{e:.2f}' for e in exponents)
+        worst = max(e for e in exponents if e is not None)
+        mark = '  ← 超线性' if worst > threshold else ''
+        print(f"  增长指数 {name:<9} {cells}{mark}")
+        if worst > threshold:
+            findings.append(f"{mode} {name}: 增长指数 {worst:.2f}")
+    return findings
+
+
+def plot(result: dict, path: Path) -> bool:
+    """画出各模式 耗时 / 峰值 RSS - 源码行数 曲线（需要 matplotlib）"""
+    try:
+        import matplotlib
+        matplotlib.use('Agg')
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("未安装 matplotlib，跳过绘图")
+        return False
+
+    fig, (time_ax, rss_ax) = plt.subplots(1, 2, figsize=(12, 5))
+    for mode, points in result['modes'].items():
+        points = [p for p in points if 'error' not in p]
+        lines = [p['lines'] for p in points]
+        time_ax.plot(lines, [p['total'] for p in points], marker='o', label=f'{mode} total')
+        for phase in PHASES:
+            time_ax.plot(lines, [p['phases'].get(phase, 0) for p in points], linestyle='--',
+                         alpha=0.6, label=f'{mode} {phase}')
+        if all(p.get('peak_rss_kb') for p in points):
+            rss_ax.plot(lines, [p['peak_rss_kb'] / 1024 for p in points], marker='o', label=mode)
+    for ax, ylabel in ((time_ax, 'seconds'), (rss_ax, 'peak RSS (MB)')):
+        ax.set_xscale('log')
+        ax.set_yscale('log')
+        ax.set_xlabel('source lines')
+        ax.set_ylabel(ylabel)
+        ax.grid(True, which='both', alpha=0.3)
+        ax.legend(fontsize='small')
+    fig.tight_layout()
+    path.parent.mkdir(parents=True, exist_ok=True)
+    fig.savefig(path)
+    return True
+
+
+# ==================== 入口 ====================
+
+def parse_args(argv: List[str]) -> dict:
+    options = {'sizes': [10, 40, 160], 'modes': list(MODES), 'samples': 3, 'search_tool': None,
+               'threshold': 1.3, 'output': None, 'plot': None, 'keep': None}
+    spec = SyntheticSpec()
+    try:
+        args = parse_spec_options(argv, spec)
+    except ValueError as e:
+        print(f"错误：{e}")
+        sys.exit(1)
+    while args:
+        arg = args.pop(0)
+        if arg in ('-h', '--help'):
+            print(__doc__)
+            sys.exit(0)
+        if not args:
+            print(f"错误：{arg} 需要指定参数值")
+            sys.exit(1)
+        value = args.pop(0)
+        try:
+            if arg == '--sizes':
+                options['sizes'] = sorted({int(v) for v in value.split(',') if v.strip()})
+            elif arg == '--modes':
+                options['modes'] = [v.strip() for v in value.split(',') if v.strip()]
+                unknown = [m for m in options['modes'] if m not in MODES]
+                if unknown:
+                    raise ValueError(f"未知模式 {', '.join(unknown)}")
+            elif arg == '--samples':
+                options['samples'] = max(1, int(value))
+            elif arg == '--search-tool':
+                options['search_tool'] = value
+            elif arg == '--threshold':
+                options['threshold'] = float(value)
+            elif arg == '--output':
+                options['output'] = Path(value)
+            elif arg == '--plot':
+                options['plot'] = Path(value)
+            elif arg == '--keep':
+                options['keep'] = Path(value)
+            else:
+                print(f"错误：未知参数 {arg}")
+                sys.exit(1)
+        except ValueError as e:
+            print(f"错误：{arg} 的参数值无效: {value} ({e})")
+            sys.exit(1)
+    options['spec'] = spec
+    return options
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == '--worker':
+        result = run_worker(json.loads(sys.argv[2]))
+        print(json.dumps(result))
+        return
+
+    options = parse_args(sys.argv[1:])
+    base_spec: SyntheticSpec = options['spec']
+    work_dir = options['keep'] or Path(tempfile.mkdtemp(prefix='simple_ast_scaling_'))
+
+    result = {
+        'version': SCALING_VERSION,
+        'timestamp': datetime.now().isoformat(timespec='seconds'),
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'cpu_count': os.cpu_count(),
+        'spec': asdict(base_spec),
+        'samples': options['samples'],
+        'modes': {mode: [] for mode in options['modes']},
+    }
+
+    try:
+        for files in options['sizes']:
+            spec = replace(base_spec, files=files)
+            project = generate_project(work_dir / f'files_{files}', spec)
+            print(f"规模 {files} 个文件: {project.functions} 个函数，{project.lines} 行，"
+                  f"{project.bytes / 1024:.0f} KB", flush=True)
+            sources = [str(p.relative_to(project.root)) for p in project.sources]
+            for mode in options['modes']:
+                job = {'root': str(project.root), 'mode': mode,
+                       'targets': sample_targets(sources, options['samples']),
+                       'search_tool': options['search_tool']}
+                print(f"  {mode} ...", end='', flush=True)
+                point = measure(job)
+                point.update({'files': files, 'lines': project.lines, 'functions': project.functions})
+                result['modes'][mode].append(point)
+                print(f" 失败: {point['error']}" if 'error' in point else f" {point['total']:.3f}s")
+    finally:
+        if options['keep'] is None:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    findings = []
+    for mode, points in result['modes'].items():
+        findings += print_mode_table(mode, points, options['threshold'])
+    result['superlinear'] = findings
+
+    if options['output']:
+        options['output'].parent.mkdir(parents=True, exist_ok=True)
+        with open(options['output'], 'w', encoding='utf-8') as f:
+            json.dump(result, f, indent=2, ensure_ascii=False)
+        print(f"\n结果已写入: {options['output']}")
+    if options['plot'] and plot(result, options['plot']):
+        print(f"曲线已写入: {options['plot']}")
+
+    if findings:
+        print(f"\n发现 {len(findings)} 处超过 {options['threshold']} 的增长指数:")
+        for line in findings:
+            print(f"  {line}")
+        sys.exit(1)
+    print("\n未发现超线性增长")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,104 @@
+"""
+SimpleAST 长驻服务 - 供 IDE 插件 / CI 机器人复用已加载的解析器和索引
+
+用法:
+    python serve.py <项目根目录> [模式] [--port N] [--host H] [--no-cache] [--store S]
+                    [--hot-cache N] [--jobs N] [--search-tool T] [--watch-interval 秒] [--report-cache <目录>]
+
+默认通过 stdio 通信（每行一个 JSON-RPC 请求/响应，分析过程的输出转到 stderr）；
+指定 --port 时改为在本地 TCP 端口上监听。协议和方法见 simple_ast/server.py。
+--hot-cache N 为 --store sqlite 在内存中缓存查找结果的名字数（默认 4096，0 关闭）。
+"""
+import io
+import sys
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+import os
+from simple_ast import get_mode_from_string
+from simple_ast.project_indexer import DEFAULT_HOT_CACHE_SIZE, STORE_KINDS
+from simple_ast.reporters import configure_report_cache
+from simple_ast.searchers import (SearchTool, set_search_tool, configure_definition_index,
+                                   configure_search_concurrency)
+from simple_ast.server import AnalysisServer, serve_stdio, serve_tcp
+
+
+def main():
+    args = sys.argv[1:]
+    if not args or args[0] in ('-h', '--help'):
+        print(__doc__)
+        sys.exit(0 if args else 1)
+
+    project_root = args.pop(0)
+    options = {'--port': None, '--host': '127.0.0.1', '--jobs': '1',
+               '--search-tool': None, '--watch-interval': '2', '--report-cache': None,
+               '--store': 'memory', '--hot-cache': str(DEFAULT_HOT_CACHE_SIZE)}
+    use_index_cache = True
+    positional = []
+    while args:
+        arg = args.pop(0)
+        if arg == '--no-cache':
+            use_index_cache = False
+        elif arg in options:
+            if not args:
+                print(f"错误：{arg} 需要指定参数值", file=sys.stderr)
+                sys.exit(1)
+            options[arg] = args.pop(0)
+        else:
+            positional.append(arg)
+
+    try:
+        mode = get_mode_from_string(positional[0] if positional else 'single')
+        jobs = int(options['--jobs'])
+        if jobs <= 0:
+            jobs = os.cpu_count() or 1
+        watch_interval = float(options['--watch-interval'])
+        port = int(options['--port']) if options['--port'] is not None else None
+        search_tool = SearchTool(options['--search-tool']) if options['--search-tool'] else None
+        if options['--store'] not in STORE_KINDS:
+            raise ValueError(f"--store 需要指定存储（{' / '.join(STORE_KINDS)}）")
+        hot_cache_size = int(options['--hot-cache'])
+        if hot_cache_size < 0:
+            raise ValueError("--hot-cache 需要指定非负整数")
+    except ValueError as e:
+        print(f"错误: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if not os.path.isdir(project_root):
+        print(f"错误：项目目录不存在: {project_root}", file=sys.stderr)
+        sys.exit(1)
+
+    # stdio 模式下 stdout 只用于协议，分析过程中的 print 全部转到 stderr
+    protocol_out = sys.stdout
+    sys.stdout = sys.stderr
+
+    if search_tool is not None:
+        try:
+            set_search_tool(search_tool)
+        except RuntimeError as e:
+            print(f"错误：{e}", file=sys.stderr)
+            sys.exit(1)
+    configure_search_concurrency(jobs)
+    if not use_index_cache:
+        configure_definition_index(persist=False)
+    configure_report_cache(enabled=use_index_cache or bool(options['--report-cache']),
+                           cache_dir=options['--report-cache'])
+
+    server = AnalysisServer(project_root, mode=mode, use_index_cache=use_index_cache,
+                            jobs=jobs, watch_interval=watch_interval, store=options['--store'],
+                            hot_cache_size=hot_cache_size)
+
+    if port is None:
+        print("SimpleAST 服务已就绪（stdio）", file=sys.stderr)
+        serve_stdio(server, sys.stdin, protocol_out)
+    else:
+        def ready(host, bound_port):
+            print(f"SimpleAST 服务已就绪: {host}:{bound_port}", file=sys.stderr)
+        serve_tcp(server, options['--host'], port, on_ready=ready)
+
+
+if __name__ == '__main__':
+    main()
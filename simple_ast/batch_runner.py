@@ -0,0 +1,307 @@
+"""
+批量分析 - 一次运行分析项目中的多个源文件
+
+所有目标共享同一个 CppProjectAnalyzer（全量模式下即同一个 ProjectIndexer）、
+进程级解析缓存、定义索引和 #include 解析器，索引和搜索器只初始化一次。
+
+jobs > 1 时按文件大小从大到小分发到工作进程：
+- 支持 fork 的平台：工作进程直接继承父进程已建好的分析器、索引和缓存
+- 其他平台：工作进程各自创建分析器（符号索引/定义索引从磁盘缓存加载）
+
+每个文件的结果写到 <输出目录>/<相对路径>/，各文件的状态和耗时汇总写到
+<输出目录>/batch_summary.json。
+"""
+import contextlib
+import glob
+import io
+import json
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor, as_completed
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from typing import Callable, List, Optional, Tuple
+
+from .analysis_modes import AnalysisMode, get_mode_config
+from .cpp_analyzer import CppProjectAnalyzer
+from .index_cache import CACHE_DIR_NAME
+from .logger import get_logger, span
+from .project_indexer import DEFAULT_HOT_CACHE_SIZE
+from .reporters.parallel_reporter import _pool_context
+from .reporters.report_cache import configure_report_cache, get_report_cache_options
+from .searchers import (SearchTool, configure_definition_index, configure_search_concurrency,
+                        get_definition_index, get_definition_index_options, get_search_config,
+                        set_search_tool)
+
+logger = get_logger()
+
+# 目录/通配符展开时收集的源文件（头文件不单独作为翻译单元分析）
+BATCH_SOURCE_EXTENSIONS = {'.c', '.cc', '.cpp', '.cxx'}
+
+SUMMARY_FILE_NAME = 'batch_summary.json'
+
+
+@dataclass
+class BatchOptions:
+    """批量分析选项（会传给工作进程，只包含可序列化的值）"""
+    mode: AnalysisMode = AnalysisMode.SINGLE_FILE_BOUNDARY
+    trace_depth: Optional[int] = None
+    use_index_cache: bool = True
+    store: str = 'memory'   # 全量模式的符号存储：memory / sqlite
+    hot_cache_size: int = DEFAULT_HOT_CACHE_SIZE  # sqlite 存储在内存中缓存查找结果的名字数
+    reports: bool = False   # 为每个函数生成独立报告（functions/ 目录）
+    jsonl: bool = False     # 写出 analysis.jsonl（代替 analysis.json）
+    quiet: bool = True      # 屏蔽单个文件分析过程中的控制台输出
+
+
+@dataclass
+class BatchFileResult:
+    """单个文件的分析状态"""
+    file: str
+    status: str             # 'ok' / 'error'
+    seconds: float
+    functions: int = 0
+    output_dir: str = ''
+    error: str = ''
+
+
+def collect_targets(project_root, specs: List[str]) -> List[str]:
+    """
+    把目标说明展开为相对项目根目录的文件列表（去重，保持首次出现的顺序）
+
+    每个说明可以是：
+    - @列表文件：每行一个路径或通配符，# 开头的行为注释
+    - 目录：递归收集其中的源文件
+    - 通配符（相对项目根目录，支持 **）
+    - 单个文件
+    """
+    root = Path(project_root).resolve()
+    targets: List[str] = []
+    seen = set()
+
+    def add(path: Path):
+        path = path.resolve()
+        try:
+            rel_path = str(path.relative_to(root))
+        except ValueError:
+            logger.warning(f"[批量分析] 跳过项目外的文件: {path}")
+            return
+        if rel_path not in seen:
+            seen.add(rel_path)
+            targets.append(rel_path)
+
+    def expand(spec: str):
+        if spec.startswith('@'):
+            list_file = Path(spec[1:])
+            with open(list_file, 'r', encoding='utf-8') as f:
+                for line in f:
+                    line = line.strip()
+                    if line and not line.startswith('#'):
+                        expand(line)
+            return
+
+        path = Path(spec)
+        if not path.is_absolute():
+            path = root / spec
+        if path.is_dir():
+            for dirpath, dirnames, filenames in os.walk(path):
+                dirnames[:] = sorted(d for d in dirnames
+                                     if not d.startswith('.') and d != CACHE_DIR_NAME)
+                for filename in sorted(filenames):
+                    if os.path.splitext(filename)[1] in BATCH_SOURCE_EXTENSIONS:
+                        add(Path(dirpath) / filename)
+        elif path.is_file():
+            add(path)
+        elif glob.has_magic(spec):
+            for match in sorted(glob.glob(str(path), recursive=True)):
+                if os.path.isfile(match):
+                    add(Path(match))
+        else:
+            logger.warning(f"[批量分析] 目标不存在: {spec}")
+
+    for spec in specs:
+        expand(spec)
+    return targets
+
+
+class BatchRunner:
+    """持有共享的分析器，逐个分析文件并写出结果"""
+
+    def __init__(self, project_root, output_dir, options: BatchOptions, jobs: int = 1):
+        self.project_root = Path(project_root).resolve()
+        self.output_dir = Path(output_dir)
+        self.options = options
+        self.trace_depth = options.trace_depth or get_mode_config(options.mode).max_trace_depth
+        with self._quiet():
+            # 全量模式下在这里建一次符号索引，所有文件共用
+            self.analyzer = CppProjectAnalyzer(str(self.project_root), mode=options.mode,
+                                               use_index_cache=options.use_index_cache, jobs=jobs,
+                                               store=options.store, hot_cache_size=options.hot_cache_size)
+            # 提前建好定义索引，fork 出的工作进程直接继承
+            index, _ = get_definition_index(self.project_root)
+            if index is not None:
+                index.refresh()
+
+    def _quiet(self):
+        if self.options.quiet:
+            return contextlib.redirect_stdout(io.StringIO())
+        return contextlib.nullcontext()
+
+    def run_one(self, rel_path: str) -> BatchFileResult:
+        """分析一个文件并写出结果（异常记录在返回值中，不向外抛出）"""
+        started = time.perf_counter()
+        file_dir = self.output_dir / rel_path
+        try:
+            with span('batch.file', 'batch', file=rel_path), self._quiet():
+                result = self.analyzer.analyze_file(rel_path, trace_depth=self.trace_depth)
+                functions = self._write_outputs(result, file_dir)
+        except Exception as e:
+            logger.error(f"[批量分析] {rel_path} 分析失败: {e}")
+            return BatchFileResult(file=rel_path, status='error',
+                                   seconds=round(time.perf_counter() - started, 3),
+                                   output_dir=str(file_dir), error=str(e))
+        return BatchFileResult(file=rel_path, status='ok',
+                               seconds=round(time.perf_counter() - started, 3),
+                               functions=functions, output_dir=str(file_dir))
+
+    def _write_outputs(self, result, file_dir: Path) -> int:
+        """写出单个文件的结果，返回函数数量"""
+        file_dir.mkdir(parents=True, exist_ok=True)
+        boundary = result.file_boundary
+
+        func_names = sorted(boundary.internal_functions) if boundary else sorted(result.call_chains)
+        reports = None
+        if self.options.reports and boundary:
+            functions_dir = file_dir / 'functions'
+            functions_dir.mkdir(exist_ok=True)
+
+            def write_reports():
+                # 并行度已经在文件之间，单个文件内串行生成
+                for func_name, report in result.generate_single_function_reports(func_names):
+                    with open(functions_dir / f"{func_name}.txt", 'w', encoding='utf-8') as f:
+                        f.write(report)
+                    yield func_name, report
+            reports = write_reports()
+
+        # JSONL 最先写出；analysis.json 和完整文本报告会展开共享子树，--jsonl 时不再生成
+        if self.options.jsonl:
+            with open(file_dir / 'analysis.jsonl', 'w', encoding='utf-8') as f:
+                result.write_jsonl(f, reports=reports)
+        elif reports is not None:
+            for _ in reports:
+                pass
+
+        if boundary or not self.options.jsonl:
+            with open(file_dir / 'summary.txt', 'w', encoding='utf-8') as f:
+                f.write(result.generate_simple_summary_report() if boundary else result.format_report())
+        if not self.options.jsonl:
+            with open(file_dir / 'analysis.json', 'w', encoding='utf-8') as f:
+                f.write(result.to_json())
+        return len(func_names)
+
+
+# 工作进程内的批量分析器（fork 时继承父进程的实例）
+_worker_runner: Optional[BatchRunner] = None
+
+
+def _init_worker(project_root: str, output_dir: str, options: BatchOptions,
+                 search_tool: SearchTool, definition_index_options: Tuple[bool, bool],
+                 report_cache_options: Tuple[bool, Optional[str]]):
+    global _worker_runner
+    if get_search_config().tool != search_tool:
+        set_search_tool(search_tool)
+    # 并行度由工作进程数提供，进程内的搜索不再并发（否则 rg 进程数为 jobs 的平方）
+    configure_search_concurrency(1)
+    if get_definition_index_options() != definition_index_options:
+        configure_definition_index(*definition_index_options)
+    if get_report_cache_options() != report_cache_options:
+        configure_report_cache(*report_cache_options)
+    if _worker_runner is None:
+        _worker_runner = BatchRunner(project_root, output_dir, options)
+
+
+def _run_one_worker(rel_path: str) -> BatchFileResult:
+    return _worker_runner.run_one(rel_path)
+
+
+def run_batch(project_root, targets: List[str], output_dir, options: BatchOptions,
+              jobs: int = 1,
+              on_result: Optional[Callable[[BatchFileResult, int, int], None]] = None) -> List[BatchFileResult]:
+    """
+    分析所有目标文件，写出每个文件的结果和 batch_summary.json
+
+    Args:
+        project_root: 项目根目录
+        targets: 相对项目根目录的文件列表（见 collect_targets）
+        output_dir: 输出目录
+        options: 批量分析选项
+        jobs: 工作进程数（1 = 串行）
+        on_result: 每完成一个文件回调 (结果, 已完成数, 总数)
+
+    Returns:
+        按文件路径排序的结果列表
+    """
+    global _worker_runner
+    root = Path(project_root).resolve()
+    output_dir = Path(output_dir)
+    output_dir.mkdir(parents=True, exist_ok=True)
+    started = time.perf_counter()
+
+    # 大文件先分发，避免最后只剩一个大文件在跑
+    def size_of(rel_path: str) -> int:
+        try:
+            return (root / rel_path).stat().st_size
+        except OSError:
+            return 0
+    ordered = sorted(targets, key=size_of, reverse=True)
+
+    # 全量模式的符号索引也按 jobs 并行构建
+    runner = BatchRunner(root, output_dir, options, jobs=jobs)
+    results: List[BatchFileResult] = []
+
+    def record(item: BatchFileResult):
+        results.append(item)
+        if on_result:
+            on_result(item, len(results), len(ordered))
+
+    jobs = min(max(1, jobs or 1), len(ordered))
+    done = set()
+    if jobs > 1:
+        logger.info(f"[批量分析] {len(ordered)} 个文件，{jobs} 个工作进程")
+        _worker_runner = runner  # fork 出的工作进程直接继承
+        initargs = (str(root), str(output_dir), options, get_search_config().tool,
+                    get_definition_index_options(), get_report_cache_options())
+        try:
+            with ProcessPoolExecutor(max_workers=jobs, mp_context=_pool_context(),
+                                     initializer=_init_worker, initargs=initargs) as executor:
+                futures = {executor.submit(_run_one_worker, rel_path): rel_path for rel_path in ordered}
+                for future in as_completed(futures):
+                    record(future.result())
+                    done.add(futures[future])
+        except Exception as e:
+            logger.warning(f"[批量分析] 并行分析失败（{e}），剩余 {len(ordered) - len(done)} 个文件改为串行分析")
+        finally:
+            _worker_runner = None
+
+    for rel_path in ordered:
+        if rel_path not in done:
+            record(runner.run_one(rel_path))
+
+    results.sort(key=lambda item: item.file)
+    write_batch_summary(output_dir, root, options, results, time.perf_counter() - started)
+    return results
+
+
+def write_batch_summary(output_dir: Path, project_root: Path, options: BatchOptions,
+                        results: List[BatchFileResult], elapsed: float):
+    failed = [item for item in results if item.status != 'ok']
+    summary = {
+        'project_root': str(project_root),
+        'mode': options.mode.value,
+        'files': len(results),
+        'failed': len(failed),
+        'seconds': round(elapsed, 3),
+        'results': [asdict(item) for item in results],
+    }
+    with open(Path(output_dir) / SUMMARY_FILE_NAME, 'w', encoding='utf-8') as f:
+        json.dump(summary, f, indent=2, ensure_ascii=False)
@@ -0,0 +1,275 @@
+"""
+文件边界快照 - FileBoundary 不含语法树的紧凑可序列化形式
+
+FileBoundary 持有 tree-sitter 节点和整份源码：不能 pickle，整棵语法树也随分析结果
+一直存活。快照只记录：
+- 函数：名字、字节范围、起始行、签名、是否 static、调用边（被调用文本、行号）
+- 数据结构：名字、字节范围、节点类型、类别、行号、定义文本
+- 内部/外部函数与数据结构的划分
+- 分析时的源码及其内容哈希：进程内快照一直持有源码（比语法树小得多），源文件在
+  分析后被修改也能恢复；pickle 时源文件内容未变就不带源码，接收方读取源文件并校验哈希
+
+FileBoundary.from_snapshot() 恢复的边界中，调用点（call_sites）直接由快照中的调用边
+重建（node 为 None），调用链追踪和报告不需要重新解析；只有 node 在第一次被访问时才
+解析源码补上（整个文件只解析一次，解析缓存中有同样内容的语法树时直接复用）。只需要
+函数文本或行号的地方（报告缓存键、常量提取）按字节范围切源码，也不触发解析。
+"""
+import threading
+from dataclasses import dataclass, fields
+from pathlib import Path
+from typing import Dict, FrozenSet, List, Optional, Tuple
+
+from .cpp_parser import CppParser
+from .function_index import CallSite, FunctionIndex
+from .index_cache import content_hash
+from .logger import count, get_logger, span
+from .source_loader import read_source
+
+logger = get_logger()
+
+# 恢复的边界信息中按需补上的键
+LAZY_FUNCTION_KEYS = frozenset({'node'})
+LAZY_DATA_STRUCTURE_KEYS = frozenset({'node'})
+
+
+@dataclass(frozen=True)
+class FunctionRecord:
+    """文件内一个函数定义"""
+    name: str
+    start_byte: int
+    end_byte: int
+    line: int
+    signature: str
+    is_static: bool
+    calls: Tuple[Tuple[str, int], ...] = ()  # 调用边：(被调用文本, 行号)
+
+    def call_sites(self) -> List[CallSite]:
+        """由调用边重建的调用点（没有语法树节点，node 为 None）"""
+        return [CallSite(node=None, callee_text=callee_text, line=line) for callee_text, line in self.calls]
+
+
+@dataclass(frozen=True)
+class StructureRecord:
+    """文件内一个数据结构定义"""
+    name: str
+    start_byte: int
+    end_byte: int
+    node_type: str
+    type: str
+    line: int
+    definition: str
+
+
+@dataclass(frozen=True)
+class BoundarySnapshot:
+    """FileBoundary 的快照（只读，可 pickle）"""
+    file_path: str
+    internal_functions: FrozenSet[str]
+    external_functions: FrozenSet[str]
+    internal_data_structures: FrozenSet[str]
+    external_data_structures: FrozenSet[str]
+    functions: Tuple[FunctionRecord, ...]
+    data_structures: Tuple[StructureRecord, ...]
+    source_hash: str
+    source: Optional[bytes] = None  # 分析时的源码（pickle 后源文件未变时为 None）
+
+    @classmethod
+    def from_boundary(cls, boundary) -> 'BoundarySnapshot':
+        source_code = boundary.source_code or b''
+        functions = []
+        for name, info in (boundary.file_functions or {}).items():
+            start_byte, end_byte = _function_span(info)
+            call_sites = dict.get(info, 'call_sites') or ()
+            functions.append(FunctionRecord(
+                name=name,
+                start_byte=start_byte,
+                end_byte=end_byte,
+                line=info.get('line', 0),
+                signature=info.get('signature', ''),
+                is_static=bool(info.get('is_static', False)),
+                calls=tuple((call_site.callee_text, call_site.line) for call_site in call_sites)
+            ))
+
+        data_structures = []
+        for name, info in (boundary.file_data_structures or {}).items():
+            node = info.get('node')
+            if node is None:
+                continue
+            data_structures.append(StructureRecord(
+                name=name,
+                start_byte=node.start_byte,
+                end_byte=node.end_byte,
+                node_type=node.type,
+                type=info.get('type', ''),
+                line=info.get('line', 0),
+                definition=info.get('definition', '')
+            ))
+
+        return cls(
+            file_path=str(boundary.file_path),
+            internal_functions=frozenset(boundary.internal_functions),
+            external_functions=frozenset(boundary.external_functions),
+            internal_data_structures=frozenset(boundary.internal_data_structures),
+            external_data_structures=frozenset(boundary.external_data_structures),
+            functions=tuple(functions),
+            data_structures=tuple(data_structures),
+            source_hash=content_hash(source_code),
+            source=source_code
+        )
+
+    def __reduce__(self):
+        """pickle 时源文件内容与分析时相同就不带源码：接收方读取源文件并校验内容哈希"""
+        values = {f.name: getattr(self, f.name) for f in fields(self)}
+        if values['source'] is not None and _file_matches(self.file_path, values['source']):
+            values['source'] = None
+        return (self.__class__, tuple(values.values()))
+
+    def load_source(self) -> Optional[bytes]:
+        """分析时的源码：优先用持有的副本，否则读源文件并校验内容哈希"""
+        if self.source is not None:
+            return self.source
+        loaded = read_source(self.file_path)
+        if loaded is None:
+            logger.warning(f"[边界快照] 无法读取源文件: {self.file_path}")
+            return None
+        if content_hash(loaded.data) != self.source_hash:
+            logger.warning(f"[边界快照] 源文件在分析后被修改，节点不可用: {self.file_path}")
+            return None
+        return loaded.data
+
+    def lazy_infos(self, source_code: Optional[bytes]) -> Tuple[Dict[str, dict], Dict[str, dict]]:
+        """
+        恢复 FileBoundary.file_functions / file_data_structures，节点在第一次访问时补上
+
+        Args:
+            source_code: load_source() 的结果；为 None 时节点不可用（调用点仍然可用）
+        """
+        hydrator = NodeHydrator(self.file_path, source_code)
+        for record in self.functions:
+            hydrator.functions[record.name] = LazyInfo({
+                'signature': record.signature,
+                'line': record.line,
+                'is_static': record.is_static,
+                'span': (record.start_byte, record.end_byte),
+                'call_sites': record.call_sites(),
+            }, hydrator, LAZY_FUNCTION_KEYS)
+        for record in self.data_structures:
+            info = LazyInfo({
+                'type': record.type,
+                'line': record.line,
+                'definition': record.definition,
+            }, hydrator, LAZY_DATA_STRUCTURE_KEYS)
+            hydrator.data_structures.append((record, info))
+        file_data_structures = {record.name: info for record, info in hydrator.data_structures}
+        return dict(hydrator.functions), file_data_structures
+
+
+def _function_span(info: dict) -> Tuple[int, int]:
+    if 'span' in info:
+        return info['span']
+    node = info['node']
+    return node.start_byte, node.end_byte
+
+
+def _file_matches(file_path, source_code: bytes) -> bool:
+    try:
+        with open(file_path, 'rb') as f:
+            return f.read() == source_code
+    except OSError:
+        return False
+
+
+class LazyInfo(dict):
+    """边界信息字典：语法树节点（node）在第一次访问时才补上"""
+
+    __slots__ = ('_hydrator', '_lazy_keys')
+
+    def __init__(self, values: dict, hydrator: 'NodeHydrator', lazy_keys: FrozenSet[str]):
+        super().__init__(values)
+        self._hydrator = hydrator
+        self._lazy_keys = lazy_keys
+
+    def __missing__(self, key):
+        if key not in self._lazy_keys:
+            raise KeyError(key)
+        self._hydrator.hydrate()
+        return dict.__getitem__(self, key)
+
+    def get(self, key, default=None):
+        try:
+            return self[key]
+        except KeyError:
+            return default
+
+
+class NodeHydrator:
+    """为一个恢复的边界按需解析源码，把节点补回各信息字典（只做一次）"""
+
+    def __init__(self, file_path: str, source_code: Optional[bytes]):
+        self.file_path = file_path
+        self.source_code = source_code
+        self.functions: Dict[str, LazyInfo] = {}
+        self.data_structures: List[Tuple[StructureRecord, LazyInfo]] = []
+        self._done = False
+        self._lock = threading.Lock()
+
+    def hydrate(self):
+        """补上所有懒加载键（找不到的节点为 None）"""
+        if self._done:
+            return
+        with self._lock:
+            if not self._done:
+                with span('boundary.hydrate', 'boundary', file=self.file_path):
+                    self._hydrate()
+                self._done = True
+
+    def _hydrate(self):
+        count('boundary.hydrate')
+        function_index, root_node = self._parse()
+
+        definitions = {}
+        if function_index is not None:
+            definitions = {(d.start_byte, d.end_byte): d for d in function_index.definitions}
+        for info in self.functions.values():
+            func_def = definitions.get(info['span'])
+            dict.__setitem__(info, 'node', func_def.node if func_def else None)
+            if func_def is not None:
+                # 解析后换成带节点的调用点（与快照中的调用边一致）
+                dict.__setitem__(info, 'call_sites', func_def.call_sites)
+
+        for record, info in self.data_structures:
+            node = None
+            if root_node is not None:
+                node = find_node_by_span(root_node, record.start_byte, record.end_byte, record.node_type)
+            dict.__setitem__(info, 'node', node)
+
+    def _parse(self):
+        """复用解析缓存中内容相同的语法树，否则解析携带/读取到的源码"""
+        if self.source_code is None:
+            return None, None
+        parser = CppParser()
+        parsed = parser.get_parsed_file(self.file_path) if Path(self.file_path).exists() else None
+        if parsed is not None and parsed.source_code == self.source_code:
+            return parsed.function_index, parsed.root_node
+
+        tree = parser.parse_source(self.source_code, self.file_path)
+        if tree is None:
+            logger.warning(f"[边界快照] 重新解析失败，函数节点不可用: {self.file_path}")
+            return None, None
+        function_index = FunctionIndex(tree.root_node, self.source_code)
+        if parsed is None and _file_matches(self.file_path, self.source_code):
+            # 源文件已被修改时不登记：解析缓存按当前 mtime 校验，会把旧内容当成新文件
+            CppParser.register_parsed_file(self.file_path, self.source_code, tree, function_index)
+        return function_index, tree.root_node
+
+
+def find_node_by_span(root_node, start_byte: int, end_byte: int, node_type: str):
+    """按字节范围和类型找回节点"""
+    node = root_node.descendant_for_byte_range(start_byte, end_byte)
+    while node is not None:
+        if node.type == node_type and node.start_byte == start_byte and node.end_byte == end_byte:
+            return node
+        if node.start_byte < start_byte or node.end_byte > end_byte:
+            break
+        node = node.parent
+    return None
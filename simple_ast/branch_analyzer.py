@@ -6,9 +6,15 @@ from typing import Dict, List, Tuple, Optional
 from dataclasses import dataclass, field
 from .cpp_parser import CppParser
 from .logger import get_logger
+from .tree_visitor import TreeVisitor
 
 logger = get_logger()
 
+# 关键条件最多提取的个数（避免报告太长）
+MAX_IF_CONDITIONS = 10
+MAX_SWITCH_CONDITIONS = 5
+MAX_LOOP_CONDITIONS = 3
+
 
 @dataclass
 class SwitchCaseInfo:
@@ -42,6 +48,109 @@ class BranchAnalysis:
     conditions: List[BranchCondition]  # 关键分支条件
 
 
+class _SwitchNodes:
+    """一个 switch 及其子树中的 case/default 节点（先序）"""
+    __slots__ = ('node', 'cases', 'defaults')
+
+    def __init__(self, node):
+        self.node = node
+        self.cases = []
+        self.defaults = []
+
+
+class _BranchMetrics:
+    """
+    一次遍历函数体收集的分支统计
+
+    与逐项遍历的口径一致：嵌套 switch 中的 case 对每个外层 switch 都计一次，
+    关键条件按先序取前 N 个 if / switch / for / while。
+    """
+
+    def __init__(self):
+        self.if_count = 0
+        self.switch_count = 0
+        self.switch_cases = 0
+        self.loop_count = 0
+        self.return_count = 0
+        self.logical_ops = 0
+        self.ternary_ops = 0
+        self.if_nodes = []
+        self.switches: List[_SwitchNodes] = []
+        self.for_nodes = []
+        self.while_nodes = []
+        self._open_switches: List[Optional[_SwitchNodes]] = []
+
+    def visitor(self) -> TreeVisitor:
+        return (TreeVisitor()
+                .on('if_statement', self._on_if)
+                .on('switch_statement', self._on_switch, leave=self._leave_switch)
+                .on('case_statement', self._on_case)
+                .on('default_statement', self._on_default)
+                .on('for_statement', self._on_for)
+                .on('while_statement', self._on_while)
+                .on('do_statement', self._on_do)
+                .on('return_statement', self._on_return)
+                .on('binary_expression', self._on_binary)
+                .on('conditional_expression', self._on_ternary))
+
+    @property
+    def early_return_count(self) -> int:
+        # 简化处理：如果有多个return，认为除了1个正常return，其他都是early
+        return self.return_count - 1 if self.return_count > 1 else 0
+
+    def _on_if(self, node):
+        self.if_count += 1
+        if len(self.if_nodes) < MAX_IF_CONDITIONS:
+            self.if_nodes.append(node)
+
+    def _on_switch(self, node):
+        self.switch_count += 1
+        tracked = None
+        if len(self.switches) < MAX_SWITCH_CONDITIONS:
+            tracked = _SwitchNodes(node)
+            self.switches.append(tracked)
+        self._open_switches.append(tracked)
+
+    def _leave_switch(self, node):
+        self._open_switches.pop()
+
+    def _on_case(self, node):
+        self.switch_cases += len(self._open_switches)
+        for tracked in self._open_switches:
+            if tracked is not None:
+                tracked.cases.append(node)
+
+    def _on_default(self, node):
+        for tracked in self._open_switches:
+            if tracked is not None:
+                tracked.defaults.append(node)
+
+    def _on_for(self, node):
+        self.loop_count += 1
+        if len(self.for_nodes) < MAX_LOOP_CONDITIONS:
+            self.for_nodes.append(node)
+
+    def _on_while(self, node):
+        self.loop_count += 1
+        if len(self.while_nodes) < MAX_LOOP_CONDITIONS:
+            self.while_nodes.append(node)
+
+    def _on_do(self, node):
+        self.loop_count += 1
+
+    def _on_return(self, node):
+        self.return_count += 1
+
+    def _on_binary(self, node):
+        for child in node.children:
+            if child.type in ('&&', '||'):
+                self.logical_ops += 1
+                break
+
+    def _on_ternary(self, node):
+        self.ternary_ops += 1
+
+
 class BranchAnalyzer:
     """分支结构分析器"""
 
@@ -59,7 +168,6 @@ class BranchAnalyzer:
         Returns:
             BranchAnalysis: 分支分析结果
         """
-        import sys
 
         # 获取函数名用于日志
         func_name = "unknown"
@@ -80,36 +188,31 @@ class BranchAnalyzer:
             logger.info("[分支分析] 未找到函数体")
             return BranchAnalysis(1, 0, 0, 0, 0, 0, [])
 
-        # 统计各类分支
-        if_count = self._count_nodes(body_node, ['if_statement'])
-        switch_count = self._count_nodes(body_node, ['switch_statement'])
-        switch_cases = self._count_switch_cases(body_node)
-        loop_count = self._count_nodes(body_node, ['for_statement', 'while_statement', 'do_statement'])
-        early_return_count = self._count_early_returns(body_node)
+        # 一次遍历统计各类分支，同时记下提取关键条件要用的节点
+        metrics = _BranchMetrics()
+        metrics.visitor().visit(body_node)
 
-        logger.info(f"[分支分析] 统计: if={if_count}, switch={switch_count}, case={switch_cases}, loop={loop_count}, early_return={early_return_count}")
+        logger.info(f"[分支分析] 统计: if={metrics.if_count}, switch={metrics.switch_count}, case={metrics.switch_cases}, loop={metrics.loop_count}, early_return={metrics.early_return_count}")
 
         # 计算圈复杂度：1 + 决策点数量
         # 决策点包括：if, while, for, case, &&, ||, ?:
-        decision_points = if_count + loop_count + switch_cases
-        logical_ops = self._count_logical_operators(body_node, source_code)
-        ternary_ops = self._count_ternary_operators(body_node)
-        decision_points += logical_ops + ternary_ops
+        decision_points = metrics.if_count + metrics.loop_count + metrics.switch_cases
+        decision_points += metrics.logical_ops + metrics.ternary_ops
 
         cyclomatic = 1 + decision_points
-        logger.info(f"[分支分析] 圈复杂度: {cyclomatic} (基础1 + 决策点{decision_points}, 逻辑运算符{logical_ops}, 三元运算{ternary_ops})")
+        logger.info(f"[分支分析] 圈复杂度: {cyclomatic} (基础1 + 决策点{decision_points}, 逻辑运算符{metrics.logical_ops}, 三元运算{metrics.ternary_ops})")
 
         # 提取关键分支条件
-        conditions = self._extract_key_conditions(body_node, source_code)
+        conditions = self._extract_key_conditions(metrics, source_code)
         logger.info(f"[分支分析] 提取了 {len(conditions)} 个关键条件")
 
         return BranchAnalysis(
             cyclomatic_complexity=cyclomatic,
-            if_count=if_count,
-            switch_count=switch_count,
-            switch_cases=switch_cases,
-            loop_count=loop_count,
-            early_return_count=early_return_count,
+            if_count=metrics.if_count,
+            switch_count=metrics.switch_count,
+            switch_cases=metrics.switch_cases,
+            loop_count=metrics.loop_count,
+            early_return_count=metrics.early_return_count,
             conditions=conditions
         )
 
@@ -120,92 +223,25 @@ class BranchAnalyzer:
                 return child
         return None
 
-    def _count_nodes(self, node, node_types: List[str]) -> int:
-        """递归统计指定类型的节点数量"""
-        count = 0
-        if node.type in node_types:
-            count = 1
-
-        for child in node.children:
-            count += self._count_nodes(child, node_types)
-
-        return count
-
-    def _count_switch_cases(self, node) -> int:
-        """统计switch语句中的case数量"""
-        total_cases = 0
-
-        # 找到所有switch语句
-        switch_nodes = self._find_all_nodes(node, 'switch_statement')
-        for switch_node in switch_nodes:
-            # 统计每个switch中的case
-            case_count = self._count_nodes(switch_node, ['case_statement'])
-            total_cases += case_count
-
-        return total_cases
-
-    def _find_all_nodes(self, node, node_type: str) -> List:
-        """查找所有指定类型的节点"""
-        result = []
-        if node.type == node_type:
-            result.append(node)
-
-        for child in node.children:
-            result.extend(self._find_all_nodes(child, node_type))
-
-        return result
-
-    def _count_early_returns(self, node) -> int:
-        """统计提前返回的数量（不包括函数末尾的return）"""
-        # 获取所有return语句
-        return_nodes = self._find_all_nodes(node, 'return_statement')
-
-        # 函数体中如果有多个return，除了最后一个，其他都算early return
-        # 简化处理：如果有多个return，认为除了1个正常return，其他都是early
-        if len(return_nodes) > 1:
-            return len(return_nodes) - 1
-        return 0
-
-    def _count_logical_operators(self, node, source_code: bytes) -> int:
-        """统计逻辑运算符数量 (&&, ||)"""
-        count = 0
-        logical_ops = self._find_all_nodes(node, 'binary_expression')
-
-        for op_node in logical_ops:
-            # 获取运算符
-            for child in op_node.children:
-                if child.type in ['&&', '||']:
-                    count += 1
-                    break
-
-        return count
-
-    def _count_ternary_operators(self, node) -> int:
-        """统计三元运算符数量 (?:)"""
-        return self._count_nodes(node, ['conditional_expression'])
-
-    def _extract_key_conditions(self, node, source_code: bytes) -> List[BranchCondition]:
-        """提取关键分支条件"""
+    def _extract_key_conditions(self, metrics: _BranchMetrics, source_code: bytes) -> List[BranchCondition]:
+        """提取关键分支条件（节点已在统计遍历中收集）"""
         conditions = []
 
-        # 提取if条件
-        if_nodes = self._find_all_nodes(node, 'if_statement')
-        for if_node in if_nodes[:10]:  # 最多提取10个，避免太长
+        # 提取if条件（最多10个，避免太长）
+        for if_node in metrics.if_nodes:
             condition_info = self._analyze_if_condition(if_node, source_code)
             if condition_info:
                 conditions.append(condition_info)
 
-        # 提取switch条件
-        switch_nodes = self._find_all_nodes(node, 'switch_statement')
-        for switch_node in switch_nodes[:5]:  # 最多5个switch
-            condition_info = self._analyze_switch_condition(switch_node, source_code)
+        # 提取switch条件（最多5个switch）
+        for switch in metrics.switches:
+            condition_info = self._analyze_switch_condition(switch, source_code)
             if condition_info:
                 conditions.append(condition_info)
 
-        # 提取循环条件（仅for和while的关键循环）
-        loop_nodes = self._find_all_nodes(node, 'for_statement')
-        loop_nodes.extend(self._find_all_nodes(node, 'while_statement'))
-        for loop_node in loop_nodes[:3]:  # 最多3个循环
+        # 提取循环条件（仅for和while的关键循环，最多3个，for在前）
+        loop_nodes = (metrics.for_nodes + metrics.while_nodes)[:MAX_LOOP_CONDITIONS]
+        for loop_node in loop_nodes:
             condition_info = self._analyze_loop_condition(loop_node, source_code)
             if condition_info:
                 conditions.append(condition_info)
@@ -237,9 +273,9 @@ class BranchAnalyzer:
             suggestions=suggestions
         )
 
-    def _analyze_switch_condition(self, switch_node, source_code: bytes) -> Optional[BranchCondition]:
+    def _analyze_switch_condition(self, switch: _SwitchNodes, source_code: bytes) -> Optional[BranchCondition]:
         """分析switch语句的条件和每个case的内容"""
-        import sys
+        switch_node = switch.node
 
         # 找到switch的条件和所有case
         condition_node = None
@@ -257,7 +293,7 @@ class BranchAnalyzer:
         logger.info(f"[分支分析]   分析switch: 行{line}, 条件={condition_text}")
 
         # 提取所有case标签和对应的处理内容
-        case_nodes = self._find_all_nodes(switch_node, 'case_statement')
+        case_nodes = switch.cases
         case_values = []
         switch_cases_info = []  # 保存详细的 case 信息
 
@@ -285,13 +321,11 @@ class BranchAnalyzer:
             logger.info(f"[分支分析]       ... 还有 {len(case_values)-5} 个case")
 
         # 检查 default 分支
-        has_default = self._count_nodes(switch_node, ['default_statement']) > 0
+        has_default = bool(switch.defaults)
         if has_default:
-            default_nodes = self._find_all_nodes(switch_node, 'default_statement')
-            if default_nodes:
-                default_info = self._extract_case_body(default_nodes[0], 'default', source_code)
-                if default_info:
-                    switch_cases_info.append(default_info)
+            default_info = self._extract_case_body(switch.defaults[0], 'default', source_code)
+            if default_info:
+                switch_cases_info.append(default_info)
 
         logger.info(f"[分支分析]     有default分支: {has_default}")
 
@@ -330,7 +364,6 @@ class BranchAnalyzer:
         - ':' 冒号
         - 后续的所有语句（expression_statement, if_statement, break_statement 等）
         """
-        import sys
 
         # 获取 case 的起止行
         line_start = case_node.start_point[0] + 1
@@ -398,7 +431,7 @@ class BranchAnalyzer:
         function_calls = []
 
         # 查找所有 call_expression 节点
-        call_nodes = self._find_all_nodes(node, 'call_expression')
+        call_nodes = CppParser.find_nodes_by_type(node, 'call_expression')
 
         logger.debug(f"[函数调用提取] 节点类型={node.type}, 找到{len(call_nodes)}个call_expression")
 
@@ -1,28 +1,65 @@
 """
 Call chain tracer - traces function call chains from entry points.
 """
-from typing import Dict, List, Set, Optional
-from dataclasses import dataclass, field
+from typing import Dict, FrozenSet, List, Set, Optional, Tuple
 from pathlib import Path
 from .cpp_parser import CppParser
+from .logger import count, span
 from .project_indexer import ProjectIndexer, SymbolInfo
 
+# Returned by the tracers when a subtree references no ancestor on the call path
+NO_BACK_EDGE = float('inf')
+
 
-@dataclass
 class CallNode:
-    """Represents a node in the call chain tree."""
-    function_name: str
-    file_path: str = ""
-    line_number: int = 0
-    signature: str = ""
-    called_from_line: int = 0  # Line where this function is called
-    children: List['CallNode'] = field(default_factory=list)
-    is_external: bool = False  # True if definition not found in project
-    is_recursive: bool = False  # True if this creates a cycle
+    """
+    Represents a node in the call chain tree.
+
+    Slotted rather than a dataclass: large traces create many nodes, and the
+    memoized tracers already share children lists between identical subtrees.
+    """
+    __slots__ = ('function_name', 'file_path', 'line_number', 'signature', 'called_from_line',
+                 'children', 'is_external', 'is_recursive')
+
+    def __init__(self, function_name: str, file_path: str = "", line_number: int = 0,
+                 signature: str = "", called_from_line: int = 0,
+                 children: Optional[List['CallNode']] = None,
+                 is_external: bool = False, is_recursive: bool = False):
+        self.function_name = function_name
+        self.file_path = file_path
+        self.line_number = line_number
+        self.signature = signature
+        self.called_from_line = called_from_line  # Line where this function is called
+        self.children: List['CallNode'] = children if children is not None else []
+        self.is_external = is_external  # True if definition not found in project
+        self.is_recursive = is_recursive  # True if this creates a cycle
+
+    def _fields(self) -> tuple:
+        return tuple(getattr(self, name) for name in self.__slots__)
+
+    def __eq__(self, other):
+        if other.__class__ is not self.__class__:
+            return NotImplemented
+        return self._fields() == other._fields()
+
+    __hash__ = None
+
+    def __repr__(self) -> str:
+        fields = ', '.join(f"{name}={getattr(self, name)!r}" for name in self.__slots__)
+        return f"CallNode({fields})"
 
 
 class CallChainTracer:
-    """Traces function call chains from entry points."""
+    """
+    Traces function call chains from entry points.
+
+    One tracer is shared by all entry points of a file, so the memoized call
+    graph and subtrees make overlapping closures cost one expansion in total.
+    Tracing stays serial: with trace_internal_only every expanded function is
+    in the already-parsed entry file, and the remaining work is tree assembly
+    in pure Python, which neither threads (GIL) nor worker processes (the
+    trees would have to be pickled back) can speed up.
+    """
 
     def __init__(self, indexer: ProjectIndexer):
         self.indexer = indexer
@@ -30,6 +67,12 @@ class CallChainTracer:
         self.max_depth = 999  # Effectively unlimited for internal-only tracing
         self.trace_internal_only = True  # Only trace functions in same file
 
+        # Memoized call graph: (file, function) -> [(called_name, line), ...]
+        self.call_graph: Dict[Tuple[str, str], List[tuple]] = {}
+        self._definition_cache: Dict[str, Optional[SymbolInfo]] = {}
+        # (function key, remaining depth, entry file) -> (children, expanded keys)
+        self._subtree_cache: Dict[tuple, Tuple[List[CallNode], FrozenSet[str]]] = {}
+
     def trace_from_entry_point(self, entry_point_name: str,
                                entry_file: str) -> Optional[CallNode]:
         """
@@ -62,38 +105,61 @@ class CallChainTracer:
         )
 
         # Trace calls recursively
-        visited = set()  # Track visited functions to detect cycles
-        self._trace_calls_recursive(root, visited, depth=0, entry_file=entry_file)
+        visited = {}  # Functions on the current path, to detect cycles
+        with span('tracer.trace', 'tracer', function=entry_point_name):
+            self._trace_calls_recursive(root, visited, depth=0, entry_file=entry_file)
 
         return root
 
-    def _trace_calls_recursive(self, node: CallNode, visited: Set[str], depth: int, entry_file: str):
+    def _trace_calls_recursive(self, node: CallNode, visited: Dict[str, int], depth: int,
+                               entry_file: str) -> Tuple[int, FrozenSet[str]]:
         """
         Recursively trace function calls.
 
+        Subtrees are memoized per (function, remaining depth, entry file) and
+        shared between callers: a memoized children list is reused whenever the
+        current call path does not contain any function expanded inside it, so
+        the result is identical to a fresh expansion.
+
         Args:
             node: Current CallNode
-            visited: Set of function names already visited (cycle detection)
+            visited: Functions on the current call path -> their depth (cycle detection)
             depth: Current recursion depth
             entry_file: Original entry point file (for internal-only tracing)
+
+        Returns:
+            (shallowest path depth referenced by a cycle inside this subtree or
+             NO_BACK_EDGE, set of function keys expanded in this subtree)
         """
         if depth >= self.max_depth:
-            return
+            return NO_BACK_EDGE, frozenset()
 
         # Mark as visited
         func_key = f"{node.file_path}:{node.function_name}"
         if func_key in visited:
             node.is_recursive = True
-            return
+            return visited[func_key], frozenset()
+
+        memo_key = (func_key, self.max_depth - depth, entry_file)
+        cached = self._subtree_cache.get(memo_key)
+        if cached is not None:
+            children, expanded = cached
+            if visited.keys().isdisjoint(expanded):
+                node.children = children
+                count('tracer.memo_hit')
+                return NO_BACK_EDGE, expanded
+        count('tracer.memo_miss')
 
-        visited.add(func_key)
+        visited[func_key] = depth
+        low = NO_BACK_EDGE
+        expanded = {func_key}
 
-        # Parse the function body to find calls
-        called_functions = self._extract_function_calls(node.file_path, node.function_name)
+        # Call graph edges of this function (extracted once, then memoized)
+        called_functions = self._get_function_calls(node.file_path, node.function_name)
 
         for call_name, call_line in called_functions:
             # Find the definition of the called function
-            call_def = self.indexer.find_definition(call_name)
+            call_def = self._find_definition(call_name)
 
             if call_def:
                 # Check if function is external (in different file)
@@ -111,14 +177,12 @@ class CallChainTracer:
                 node.children.append(child_node)
 
                 # Only recursively trace if it's in the same file (when trace_internal_only is True)
-                if self.trace_internal_only:
-                    if not is_external_file:
-                        # Internal function - continue tracing
-                        self._trace_calls_recursive(child_node, visited.copy(), depth + 1, entry_file)
-                    # else: External function - stop tracing here, just mark it
-                else:
-                    # Trace all functions regardless of file
-                    self._trace_calls_recursive(child_node, visited.copy(), depth + 1, entry_file)
+                if not self.trace_internal_only or not is_external_file:
+                    child_low, child_expanded = self._trace_calls_recursive(
+                        child_node, visited, depth + 1, entry_file)
+                    low = min(low, child_low)
+                    expanded.update(child_expanded)
+                # else: External function - stop tracing here, just mark it
             else:
                 # External or unresolved function (not in project)
                 child_node = CallNode(
@@ -128,7 +192,36 @@ class CallChainTracer:
                 )
                 node.children.append(child_node)
 
-        visited.remove(func_key)
+        del visited[func_key]
+
+        expanded = frozenset(expanded)
+        if low < depth:
+            # Depends on an ancestor outside this subtree - not reusable
+            return low, expanded
+
+        self._subtree_cache[memo_key] = (node.children, expanded)
+        return NO_BACK_EDGE, expanded
+
+    def _get_function_calls(self, file_path: str, function_name: str) -> List[tuple]:
+        """Adjacency list of the call graph, built lazily once per function."""
+        key = (file_path, function_name)
+        calls = self.call_graph.get(key)
+        if calls is None:
+            calls = self._extract_function_calls(file_path, function_name)
+            self.call_graph[key] = calls
+        return calls
+
+    def _find_definition(self, symbol_name: str) -> Optional[SymbolInfo]:
+        """Memoized indexer.find_definition."""
+        if symbol_name not in self._definition_cache:
+            self._definition_cache[symbol_name] = self.indexer.find_definition(symbol_name)
+        return self._definition_cache[symbol_name]
+
+    def clear_cache(self):
+        """Forget the memoized call graph and subtrees (e.g. after re-indexing)."""
+        self.call_graph.clear()
+        self._definition_cache.clear()
+        self._subtree_cache.clear()
 
     def _extract_function_calls(self, file_path: str, function_name: str) -> List[tuple]:
         """
@@ -139,35 +232,22 @@ class CallChainTracer:
         """
         try:
             full_path = self.indexer.project_root / file_path
-            with open(full_path, 'rb') as f:
-                source_code = f.read()
-
-            tree = self.parser.parse_file(str(full_path))
-            if not tree:
+            parsed = self.parser.get_parsed_file(full_path)
+            if not parsed:
                 return []
+            source_code = parsed.source_code
 
-            # Find the function definition
-            func_defs = CppParser.find_nodes_by_type(tree.root_node, 'function_definition')
-
-            target_func_node = None
-            for func_def in func_defs:
-                name = CppParser.get_function_name(func_def, source_code)
-                if name == function_name:
-                    target_func_node = func_def
-                    break
-
-            if not target_func_node:
+            # Find the function definition (O(1) via the per-file function index)
+            func_def = parsed.function_index.get(function_name)
+            if not func_def:
                 return []
 
-            # Find all call_expression nodes within this function
-            call_nodes = CppParser.find_nodes_by_type(target_func_node, 'call_expression')
-
+            # Call sites were collected while building the index
             calls = []
-            for call_node in call_nodes:
-                call_name = self._extract_call_name(call_node, source_code)
+            for call_site in func_def.call_sites:
+                call_name = CppParser.get_call_name(call_site.node, source_code)
                 if call_name:
-                    line_num = call_node.start_point[0] + 1
-                    calls.append((call_name, line_num))
+                    calls.append((call_name, call_site.line))
 
             return calls
 
@@ -175,45 +255,6 @@ class CallChainTracer:
             print(f"Error extracting calls from {file_path}::{function_name}: {e}")
             return []
 
-    def _extract_call_name(self, call_node, source_code: bytes) -> Optional[str]:
-        """
-        Extract the function name from a call_expression node.
-
-        Handles:
-        - Simple calls: foo()
-        - Method calls: obj.foo()
-        - Scoped calls: namespace::foo()
-        """
-        # The first child is typically the function identifier
-        function_node = call_node.children[0] if call_node.children else None
-
-        if not function_node:
-            return None
-
-        if function_node.type == 'identifier':
-            return CppParser.get_node_text(function_node, source_code)
-
-        elif function_node.type == 'qualified_identifier':
-            # namespace::function
-            text = CppParser.get_node_text(function_node, source_code)
-            parts = text.split('::')
-            return parts[-1] if parts else None
-
-        elif function_node.type == 'field_expression':
-            # obj.method() or ptr->method()
-            # Get the field name (method name)
-            field_node = CppParser.find_child_by_type(function_node, 'field_identifier')
-            if field_node:
-                return CppParser.get_node_text(field_node, source_code)
-
-        elif function_node.type == 'scoped_identifier':
-            # Class::method
-            name_node = call_node.children[0].children[-1] if call_node.children[0].children else None
-            if name_node:
-                return CppParser.get_node_text(name_node, source_code)
-
-        return None
-
     def format_call_tree(self, root: CallNode, indent: int = 0) -> str:
         """
         Format the call tree as a readable string.
@@ -269,9 +310,25 @@ class CallChainTracer:
         Returns:
             Set of function names
         """
-        result = {root.function_name}
+        result = set()
+        visit_call_tree(root, lambda node: result.add(node.function_name))
+        return result
 
-        for child in root.children:
-            result.update(self.get_all_called_functions(child))
 
-        return result
+def visit_call_tree(root: Optional[CallNode], visit) -> None:
+    """
+    Pre-order walk over a call tree that may share memoized subtrees.
+
+    A shared children list is walked only the first time it is reached, so
+    set-style collectors stay linear in the number of distinct subtrees.
+    """
+    if not root:
+        return
+    seen_children = set()
+    stack = [root]
+    while stack:
+        node = stack.pop()
+        visit(node)
+        if node.children and id(node.children) not in seen_children:
+            seen_children.add(id(node.children))
+            stack.extend(reversed(node.children))
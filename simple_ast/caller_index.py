@@ -0,0 +1,208 @@
+"""
+Project-wide reverse call index (callee name -> call sites).
+
+Call edges are collected in the same per-file pass that builds the symbol
+table (FileIndexEntry.calls), cached with it and merged file by file.
+Storage follows SymbolStore: parallel integer arrays, names and paths
+interned in StringPools, rows of one callee chained through ``_next`` and
+rows of one file kept contiguous so incremental refresh can copy them.
+
+Callees are resolved by name only (``obj->Send`` and ``ns::Send`` both
+count as calls of ``Send``), the same approximation the call chain tracer
+and the reports use.
+"""
+from array import array
+from collections import deque
+from dataclasses import dataclass
+from typing import Dict, Iterable, Iterator, List, Optional, Set, Tuple
+
+from .function_index import callee_name
+from .symbol_store import StringPool
+
+_NO_ROW = -1
+
+
+def callee_key(callee_text: str) -> str:
+    """Name a call is indexed under: method name, without scope or template arguments."""
+    return _strip_template_args(callee_name(callee_text)).rsplit('::', 1)[-1].strip()
+
+
+def _strip_template_args(name: str) -> str:
+    """Drop balanced template argument lists anywhere in a name; an unclosed '<' (operator<) stays."""
+    if '<' not in name:
+        return name
+    kept = []
+    depth = 0
+    opened_at = 0
+    for pos, char in enumerate(name):
+        if char == '<' and pos > 0:
+            if depth == 0:
+                opened_at = pos
+            depth += 1
+        elif char == '>' and depth:
+            depth -= 1
+        elif not depth:
+            kept.append(char)
+    if depth:
+        # Unbalanced: keep the tail as written
+        kept.append(name[opened_at:])
+    return ''.join(kept)
+
+
+@dataclass
+class CallerSite:
+    """One call of a function: who calls it, where."""
+    __slots__ = ('callee', 'caller', 'file_path', 'line')
+
+    callee: str
+    caller: str  # Enclosing function definition
+    file_path: str
+    line: int
+
+
+@dataclass
+class ImpactSet:
+    """Functions (and their files) that transitively call a set of root functions."""
+    roots: List[str]
+    distances: Dict[str, int]  # function -> shortest call distance to a root (roots are 0)
+    files: Dict[str, List[str]]  # file -> impacted functions calling from / defined in it
+    max_depth: Optional[int] = None
+
+    @property
+    def functions(self) -> List[str]:
+        """Impacted functions, nearest first."""
+        return sorted(self.distances, key=lambda name: (self.distances[name], name))
+
+    def to_dict(self) -> dict:
+        return {
+            'roots': self.roots,
+            'max_depth': self.max_depth,
+            'functions': [{'name': name, 'distance': self.distances[name]} for name in self.functions],
+            'files': self.files,
+        }
+
+
+class CallerIndex:
+    """Struct-of-arrays reverse call graph: callee -> call sites in insertion order."""
+
+    def __init__(self):
+        self.names = StringPool()  # callee and caller names
+        self.files = StringPool()
+        self._callee = array('i')
+        self._caller = array('i')
+        self._file = array('i')
+        self._line = array('i')
+        self._next = array('i')
+        self._head = array('i')  # callee name id -> first row (-1 for caller-only names)
+        self._tail = array('i')
+        self._file_rows: Dict[str, Tuple[int, int]] = {}
+
+    # -- building --------------------------------------------------------
+
+    def add_row(self, callee: str, caller: str, file_path: str, line: int) -> int:
+        row = len(self._callee)
+        callee_id = self.names.intern(callee)
+        self._callee.append(callee_id)
+        self._caller.append(self.names.intern(caller))
+        self._file.append(self.files.intern(file_path))
+        self._line.append(line)
+        self._next.append(_NO_ROW)
+
+        while len(self._head) < len(self.names):
+            self._head.append(_NO_ROW)
+            self._tail.append(_NO_ROW)
+        if self._head[callee_id] == _NO_ROW:
+            self._head[callee_id] = row
+        else:
+            self._next[self._tail[callee_id]] = row
+        self._tail[callee_id] = row
+
+        span = self._file_rows.get(file_path)
+        self._file_rows[file_path] = (span[0] if span else row, row + 1)
+        return row
+
+    def add_file(self, file_path: str, calls: Iterable[Tuple[str, str, int]]):
+        """Append one file's (callee, caller, line) edges (keeps the file's rows contiguous)."""
+        for callee, caller, line in calls:
+            self.add_row(callee, caller, file_path, line)
+
+    def copy_file_from(self, other: 'CallerIndex', file_path: str):
+        """Append one file's rows from another index (used by incremental refresh)."""
+        span = other._file_rows.get(file_path)
+        if span is None:
+            return
+        names = other.names
+        for row in range(*span):
+            self.add_row(names[other._callee[row]], names[other._caller[row]],
+                         file_path, other._line[row])
+
+    # -- queries ---------------------------------------------------------
+
+    def rows(self, callee: str) -> Iterator[int]:
+        name_id = self.names.lookup(callee)
+        row = self._head[name_id] if 0 <= name_id < len(self._head) else _NO_ROW
+        while row != _NO_ROW:
+            yield row
+            row = self._next[row]
+
+    def site_at(self, row: int) -> CallerSite:
+        names = self.names
+        return CallerSite(
+            callee=names[self._callee[row]],
+            caller=names[self._caller[row]],
+            file_path=self.files[self._file[row]],
+            line=self._line[row]
+        )
+
+    def callers_of(self, callee: str) -> List[CallerSite]:
+        """All call sites of a function name."""
+        return [self.site_at(row) for row in self.rows(callee_key(callee))]
+
+    def caller_names(self, callee: str) -> Set[str]:
+        """Names of the functions calling a function name directly."""
+        names = self.names
+        return {names[self._caller[row]] for row in self.rows(callee_key(callee))}
+
+    def transitive_callers(self, roots: Iterable[str],
+                           max_depth: Optional[int] = None) -> Dict[str, int]:
+        """
+        Breadth-first walk up the call graph.
+
+        Returns:
+            function -> shortest call distance to any root (roots map to 0)
+        """
+        distances = {callee_key(root): 0 for root in roots}
+        queue = deque(distances)
+        while queue:
+            name = queue.popleft()
+            depth = distances[name]
+            if max_depth is not None and depth >= max_depth:
+                continue
+            for caller in sorted(self.caller_names(name)):
+                if caller not in distances:
+                    distances[caller] = depth + 1
+                    queue.append(caller)
+        return distances
+
+    def impact(self, roots: Iterable[str], max_depth: Optional[int] = None) -> ImpactSet:
+        """Transitive callers of the roots plus the files their calls sit in."""
+        roots = [callee_key(root) for root in roots]
+        distances = self.transitive_callers(roots, max_depth)
+        files: Dict[str, Set[str]] = {}
+        for name in distances:
+            for site in self.callers_of(name):
+                if site.caller in distances:
+                    files.setdefault(site.file_path, set()).add(site.caller)
+        return ImpactSet(
+            roots=roots,
+            distances=distances,
+            files={path: sorted(functions) for path, functions in sorted(files.items())},
+            max_depth=max_depth
+        )
+
+    @property
+    def row_count(self) -> int:
+        return len(self._callee)
+
+    def __len__(self) -> int:
+        return len(self._callee)
@@ -0,0 +1,437 @@
+"""
+基于 git diff 的增量分析 - 只重新生成改动函数及依赖它们的函数的报告
+
+1. git diff -U0 <修订范围> -- <文件>，取新版本中改动的行区间
+2. 用文件的函数索引把行区间映射到函数定义（FunctionIndex.definitions_in_lines）
+3. 不在函数内的改动（结构体成员、typedef、宏、枚举、全局变量、函数声明）以及
+   包含闭包中头文件的改动：映射到所在的文件作用域声明及其定义的名字，再沿
+   引用它们的其它类型定义扩展一次闭包；函数体或签名引用这些名字的内部函数
+   算作改动函数
+4. 沿 CallChainTracer 生成的调用树反向扩展：调用链中经过改动函数的内部函数，
+   报告内容也会变化，一起重新生成
+
+分析的是工作区中的文件，修订范围的新版本应与工作区一致（CI 中通常是
+<目标分支>...HEAD）。
+"""
+import re
+import subprocess
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional, Set, Tuple
+
+from .call_chain_tracer import CallNode
+from .cpp_parser import CppParser
+from .logger import get_logger
+from .searchers.definition_index import scan_source
+from .searchers.include_resolver import get_include_resolver
+
+logger = get_logger()
+
+# @@ -旧起始[,旧行数] +新起始[,新行数] @@
+_HUNK_RE = re.compile(r'^@@ -\d+(?:,\d+)? \+(\d+)(?:,(\d+))? @@', re.MULTILINE)
+# +++ b/路径（新版本的文件名；删除的文件是 /dev/null）
+_NEW_FILE_RE = re.compile(r'^\+\+\+ (?:b/(.*)|/dev/null)$', re.MULTILINE)
+
+_IDENT_RE = re.compile(r'[A-Za-z_]\w*')
+# 声明中第一个 "名字(" 是函数声明/定义的名字，这些不是
+_NON_CALLABLE_WORDS = {'__attribute__', '__declspec', 'alignas', 'decltype', 'sizeof', 'typeof'}
+# 以 ) 结尾（可带 const/noexcept 等）的 { 前缀是函数体，它的 } 结束声明；其余的 }
+# （struct/enum/数组初始化）要等到 ; 才结束
+_FUNCTION_HEAD_RE = re.compile(r'\)\s*(?:(?:const|noexcept|override|final|volatile)\b\s*)*$')
+_ATTRIBUTE_RE = re.compile(r'__attribute__\s*\(\(.*?\)\)', re.DOTALL)
+
+
+class GitDiffError(RuntimeError):
+    """git 不可用或 diff 执行失败"""
+
+
+@dataclass
+class ChangeSet:
+    """一个文件在修订范围内的改动"""
+    file_path: str
+    rev_range: str
+    line_ranges: List[Tuple[int, int]] = field(default_factory=list)      # 新版本中改动的行区间
+    changed: Set[str] = field(default_factory=set)                         # 定义被改动的函数
+    dependents: Set[str] = field(default_factory=set)                      # 调用链经过改动函数的函数
+    outside_functions: List[Tuple[int, int]] = field(default_factory=list)  # 不在任何函数内的改动
+    definitions: Set[str] = field(default_factory=set)                     # 被改动的类型/宏/全局变量等的名字
+    headers: Dict[str, List[Tuple[int, int]]] = field(default_factory=dict)  # 包含闭包中改动的头文件 -> 行区间
+
+    @property
+    def functions(self) -> Set[str]:
+        """需要重新生成报告的函数"""
+        return self.changed | self.dependents
+
+    def to_dict(self) -> dict:
+        return {
+            'file': self.file_path,
+            'rev_range': self.rev_range,
+            'line_ranges': [list(r) for r in self.line_ranges],
+            'changed': sorted(self.changed),
+            'dependents': sorted(self.dependents),
+            'outside_functions': [list(r) for r in self.outside_functions],
+            'definitions': sorted(self.definitions),
+            'headers': {path: [list(r) for r in ranges] for path, ranges in sorted(self.headers.items())},
+        }
+
+
+def parse_diff_line_ranges(diff_text: str) -> List[Tuple[int, int]]:
+    """从 -U0 的 diff 输出中取新版本的改动行区间（从1开始，含两端）"""
+    ranges = []
+    for match in _HUNK_RE.finditer(diff_text):
+        start = int(match.group(1))
+        length = int(match.group(2)) if match.group(2) is not None else 1
+        if length == 0:
+            # 纯删除：发生在新版本第 start 行之后，前后两行所在的函数都算改动
+            ranges.append((max(start, 1), start + 1))
+        else:
+            ranges.append((start, start + length - 1))
+    return ranges
+
+
+def parse_diff_files(diff_text: str) -> Dict[str, List[Tuple[int, int]]]:
+    """按文件拆分多文件 diff：新版本路径 -> 改动行区间（被删除的文件不计）"""
+    files: Dict[str, List[Tuple[int, int]]] = {}
+    headers = list(_NEW_FILE_RE.finditer(diff_text))
+    for i, match in enumerate(headers):
+        end = headers[i + 1].start() if i + 1 < len(headers) else len(diff_text)
+        if match.group(1) is None:
+            continue
+        ranges = parse_diff_line_ranges(diff_text[match.end():end])
+        if ranges:
+            files[match.group(1)] = ranges
+    return files
+
+
+def changed_line_ranges(project_root, file_path, rev_range: str) -> List[Tuple[int, int]]:
+    """
+    运行 git diff 取文件在修订范围内的改动行区间
+
+    Raises:
+        GitDiffError: git 不可用、不是 git 仓库或修订范围无效
+    """
+    return parse_diff_line_ranges(_git_diff(project_root, [file_path], rev_range))
+
+
+def changed_files_line_ranges(project_root, file_paths, rev_range: str) -> Dict[Path, List[Tuple[int, int]]]:
+    """
+    一次 git diff 取多个文件的改动行区间，只返回有改动的文件
+
+    Raises:
+        GitDiffError: 见 changed_line_ranges
+    """
+    root = Path(project_root).resolve()
+    diff_text = _git_diff(project_root, file_paths, rev_range, relative=True)
+    return {root / rel_path: ranges for rel_path, ranges in parse_diff_files(diff_text).items()}
+
+
+def _git_diff(project_root, file_paths, rev_range: str, relative: bool = False) -> str:
+    # --relative：路径相对 project_root 输出（项目可以是仓库的子目录）
+    cmd = ['git', '-C', str(project_root), 'diff', '--unified=0', '--no-color', '--no-ext-diff']
+    if relative:
+        cmd.append('--relative')
+    cmd += [rev_range, '--'] + [str(path) for path in file_paths]
+    try:
+        result = subprocess.run(
+            cmd,
+            capture_output=True,
+            text=True,
+            timeout=60,
+            encoding='utf-8',
+            errors='ignore'
+        )
+    except (OSError, subprocess.SubprocessError) as e:
+        raise GitDiffError(f"无法运行 git: {e}")
+
+    if result.returncode != 0:
+        raise GitDiffError(result.stderr.strip() or f"git diff 失败（退出码 {result.returncode}）")
+    return result.stdout
+
+
+def find_changed_functions(function_index, line_ranges: List[Tuple[int, int]]) -> Tuple[Set[str], List[Tuple[int, int]]]:
+    """
+    把改动行区间映射到函数
+
+    Returns:
+        (改动的函数名集合, 不落在任何函数内的行区间)
+    """
+    changed: Set[str] = set()
+    outside: List[Tuple[int, int]] = []
+    for start_line, end_line in line_ranges:
+        definitions = function_index.definitions_in_lines(start_line, end_line)
+        for func_def in definitions:
+            if func_def.name:
+                changed.add(func_def.name)
+        if not definitions:
+            outside.append((start_line, end_line))
+    return changed, outside
+
+
+def top_level_spans(text: str) -> List[Tuple[int, int, str]]:
+    """
+    文件作用域声明的行区间（从1开始，含两端）
+
+    namespace / extern "C" 的花括号是透明的。种类：'pp' 预处理指令（含续行），
+    'fn' 函数定义（到函数体的 } 为止），'decl' 其余声明（到文件作用域的 ; 为止，
+    如 struct/enum/typedef/全局变量/函数声明）
+
+    Returns:
+        [(起始行, 结束行, 种类), ...]，按出现顺序
+    """
+    spans: List[Tuple[int, int, str]] = []
+    stack: List[str] = []        # 'ns' / 'fn' / 'other'
+    head: List[str] = []         # 自上一个 ; { } 以来的代码文本，用于判断 { 的种类
+    start = 0                    # 当前声明的起始行，0 表示不在声明中
+    in_block_comment = False
+    pp_start = 0
+
+    lines = text.split('\n')
+    for idx, line in enumerate(lines):
+        line_num = idx + 1
+        if not in_block_comment and not pp_start and line.lstrip().startswith('#'):
+            pp_start = line_num
+        if pp_start:
+            if not line.rstrip().endswith('\\'):
+                if all(kind == 'ns' for kind in stack):
+                    spans.append((pp_start, line_num, 'pp'))
+                pp_start = 0
+            continue
+
+        i = 0
+        n = len(line)
+        while i < n:
+            c = line[i]
+            if in_block_comment:
+                end = line.find('*/', i)
+                if end < 0:
+                    break
+                in_block_comment = False
+                i = end + 2
+                continue
+            if c == '/' and i + 1 < n and line[i + 1] == '/':
+                break
+            if c == '/' and i + 1 < n and line[i + 1] == '*':
+                in_block_comment = True
+                i += 2
+                continue
+
+            at_scope = all(kind == 'ns' for kind in stack)
+            if at_scope and not start and not c.isspace():
+                start = line_num
+            if c == '"' or c == "'":
+                j = i + 1
+                while j < n and line[j] != c:
+                    j += 2 if line[j] == '\\' else 1
+                head.append(line[i:j + 1])
+                i = j + 1
+                continue
+
+            if c == '{':
+                code = ''.join(head)
+                if not at_scope:
+                    stack.append('other')
+                elif re.search(r'\bnamespace\b', code) or re.search(r'\bextern\s*"C', code):
+                    stack.append('ns')
+                    start = 0
+                elif _FUNCTION_HEAD_RE.search(_ATTRIBUTE_RE.sub('', code).rstrip()):
+                    stack.append('fn')
+                else:
+                    stack.append('other')
+                head = []
+            elif c == '}':
+                kind = stack.pop() if stack else 'ns'
+                if kind == 'ns':
+                    start = 0
+                elif kind == 'fn' and all(k == 'ns' for k in stack):
+                    spans.append((start, line_num, 'fn'))
+                    start = 0
+                head = []
+            elif c == ';':
+                if at_scope and start:
+                    spans.append((start, line_num, 'decl'))
+                    start = 0
+                head = []
+            else:
+                head.append(c)
+            i += 1
+        head.append('\n')
+
+    if start:
+        spans.append((start, len(lines), 'decl'))
+    return spans
+
+
+class _SourceDefinitions:
+    """一个文件的文件作用域声明：每个声明定义的名字和引用的标识符"""
+
+    def __init__(self, rel_path: str, text: str):
+        lines = text.split('\n')
+        self.spans = top_level_spans(text)
+        definitions = scan_source(rel_path, text)
+        self.names: List[Set[str]] = []
+        self.identifiers: List[Set[str]] = []
+        self.is_function: List[bool] = []     # 函数声明/定义，名字取自 "名字("
+        for start, end, kind in self.spans:
+            names = {d.name for d in definitions if start <= d.line <= end}
+            span_text = '\n'.join(lines[start - 1:end])
+            is_function = kind == 'fn' or (not names and kind != 'pp')
+            if not names and kind != 'pp':
+                # 函数声明/定义：第一个 "名字(" 即函数名
+                for m in re.finditer(r'([A-Za-z_]\w*)\s*\(', span_text):
+                    if m.group(1) not in _NON_CALLABLE_WORDS:
+                        names.add(m.group(1))
+                        break
+            self.names.append(names)
+            self.is_function.append(is_function)
+            self.identifiers.append(set(_IDENT_RE.findall(span_text)))
+
+    def touched_names(self, line_ranges: List[Tuple[int, int]]) -> Set[str]:
+        """与改动行区间重叠的声明所定义的名字"""
+        names: Set[str] = set()
+        for (start, end, _), span_names in zip(self.spans, self.names):
+            if any(start <= range_end and end >= range_start for range_start, range_end in line_ranges):
+                names |= span_names
+        return names
+
+
+def find_changed_definitions(sources: Dict[str, str],
+                             changes: Dict[str, List[Tuple[int, int]]]) -> Set[str]:
+    """
+    改动行区间触及的文件作用域定义的名字
+
+    再沿引用关系扩展到闭包：结构体成员、typedef、宏中引用了已改动名字的类型
+    和宏定义也算改动（函数的声明和定义不参与扩展，它们由函数映射处理）
+
+    Args:
+        sources: 相对路径 -> 文件文本（目标文件及其包含闭包）
+        changes: 相对路径 -> 不在函数内的改动行区间
+    """
+    scanned = {rel_path: _SourceDefinitions(rel_path, text) for rel_path, text in sources.items()}
+    changed: Set[str] = set()
+    for rel_path, line_ranges in changes.items():
+        if rel_path in scanned:
+            changed |= scanned[rel_path].touched_names(line_ranges)
+
+    pending = [(span_names, identifiers)
+               for source in scanned.values()
+               for span_names, identifiers, is_function in zip(source.names, source.identifiers,
+                                                                source.is_function)
+               if span_names and not is_function]
+    grown = bool(changed)
+    while grown:
+        grown = False
+        remaining = []
+        for span_names, identifiers in pending:
+            if span_names <= changed:
+                continue
+            if identifiers & changed:
+                changed |= span_names
+                grown = True
+            else:
+                remaining.append((span_names, identifiers))
+        pending = remaining
+    return changed
+
+
+def find_definition_users(function_index, source_code: bytes, names: Set[str]) -> Set[str]:
+    """函数体或签名中引用了 names 中任一名字的函数"""
+    if not names:
+        return set()
+    users: Set[str] = set()
+    for func_def in function_index.definitions:
+        if not func_def.name or func_def.name in users:
+            continue
+        text = source_code[func_def.start_byte:func_def.end_byte].decode('utf-8', errors='ignore')
+        if not names.isdisjoint(_IDENT_RE.findall(text)):
+            users.add(func_def.name)
+    return users
+
+
+def find_dependent_functions(call_chains: Dict[str, CallNode], changed: Set[str]) -> Set[str]:
+    """
+    调用链（直接或间接）经过改动函数的内部函数，不含改动函数本身
+
+    只用每棵调用树根节点的直接子节点建立 调用者 <- 被调用者 的反向边，
+    再从改动函数出发广度优先扩展
+    """
+    callers: Dict[str, Set[str]] = {}
+    for caller, root in call_chains.items():
+        if root is None:
+            continue
+        for child in root.children:
+            if not child.is_external and child.function_name != caller:
+                callers.setdefault(child.function_name, set()).add(caller)
+
+    dependents: Set[str] = set()
+    queue = list(changed)
+    while queue:
+        callee = queue.pop()
+        for caller in callers.get(callee, ()):
+            if caller not in changed and caller not in dependents:
+                dependents.add(caller)
+                queue.append(caller)
+    return dependents
+
+
+def detect_changes(project_root, file_path, rev_range: str,
+                   parser: Optional[CppParser] = None) -> ChangeSet:
+    """
+    计算文件在修订范围内改动的函数（依赖它们的函数在分析后用 find_dependent_functions 补充）
+
+    同时 diff 目标文件包含闭包中的头文件；不在函数内的改动和头文件的改动
+    映射为改动的定义，引用这些定义的内部函数一并算作改动函数
+
+    Raises:
+        GitDiffError: 见 changed_line_ranges
+    """
+    root = Path(project_root).resolve()
+    path = Path(file_path)
+    if not path.is_absolute():
+        path = root / path
+    path = path.resolve()
+
+    closure = [header.resolve() for header in get_include_resolver(project_root).include_closure(path)]
+    diffs = changed_files_line_ranges(project_root, [path] + closure, rev_range)
+
+    change_set = ChangeSet(file_path=str(file_path), rev_range=rev_range)
+    change_set.line_ranges = diffs.pop(path, [])
+    change_set.headers = {_relative(root, header): ranges for header, ranges in diffs.items()}
+    if not change_set.line_ranges and not change_set.headers:
+        return change_set
+
+    parsed = (parser or CppParser()).get_parsed_file(path)
+    if parsed is None:
+        logger.warning(f"[增量分析] 无法解析 {path}，按无函数改动处理")
+        change_set.outside_functions = list(change_set.line_ranges)
+        return change_set
+
+    change_set.changed, change_set.outside_functions = find_changed_functions(
+        parsed.function_index, change_set.line_ranges)
+
+    if change_set.outside_functions or change_set.headers:
+        target_rel = _relative(root, path)
+        sources = {target_rel: parsed.source_code.decode('utf-8', errors='ignore')}
+        for header in closure:
+            try:
+                sources[_relative(root, header)] = header.read_text(encoding='utf-8', errors='ignore')
+            except OSError:
+                continue
+        changes = dict(change_set.headers)
+        if change_set.outside_functions:
+            changes[target_rel] = change_set.outside_functions
+        change_set.definitions = find_changed_definitions(sources, changes)
+        users = find_definition_users(parsed.function_index, parsed.source_code, change_set.definitions)
+        change_set.changed |= users
+        logger.info(f"[增量分析] {len(change_set.definitions)} 个定义改动，"
+                    f"{len(users)} 个函数引用了它们")
+
+    logger.info(f"[增量分析] {len(change_set.line_ranges)} 处改动，"
+                f"{len(change_set.headers)} 个头文件改动，涉及 {len(change_set.changed)} 个函数")
+    return change_set
+
+
+def _relative(root: Path, path: Path) -> str:
+    try:
+        return path.relative_to(root).as_posix()
+    except ValueError:
+        return str(path)
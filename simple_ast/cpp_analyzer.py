@@ -3,18 +3,19 @@ Main C++ Project Analyzer - integrates all components.
 """
 import json
 from pathlib import Path
-from typing import Dict, List, Optional, Set
-from dataclasses import dataclass, asdict
+from typing import Dict, Iterable, Iterator, List, Optional, Set, Tuple
+from dataclasses import dataclass, asdict, field
 
-from .project_indexer import ProjectIndexer
+from .project_indexer import DEFAULT_HOT_CACHE_SIZE, ProjectIndexer
 from .entry_point_classifier import EntryPointClassifier, EntryPointInfo
-from .call_chain_tracer import CallChainTracer, CallNode
+from .call_chain_tracer import CallChainTracer, CallNode, visit_call_tree
 from .data_structure_analyzer import DataStructureAnalyzer, DataStructureInfo
 from .analysis_modes import AnalysisMode, get_mode_config, AnalysisModeConfig
 from .single_file_analyzer import SingleFileAnalyzer, FileBoundary
 from .branch_analyzer import BranchAnalyzer, format_branch_analysis
 from .external_classifier import ExternalFunctionClassifier, format_classified_externals
-from .logger import get_logger
+from .logger import get_logger, span
+from .searchers import get_include_resolver
 logger = get_logger()
 
 
@@ -32,6 +33,29 @@ class AnalysisResult:
     file_boundary: Optional[FileBoundary] = None  # 单文件边界信息（仅在 single_file_boundary 模式）
     branch_analyses: Dict[str, 'BranchAnalysis'] = None  # 函数分支分析结果（func_name -> BranchAnalysis）
     external_classifier: Optional['ExternalFunctionClassifier'] = None  # 外部函数分类器
+    # 复用的单函数报告生成器（提取器内的搜索缓存跨函数共享）
+    _function_reporter: Optional['FunctionReporter'] = field(default=None, init=False, repr=False, compare=False)
+
+    def __getstate__(self):
+        """Pickle without the cached reporter; worker processes build their own."""
+        state = self.__dict__.copy()
+        state['_function_reporter'] = None
+        return state
+
+    def release_syntax_trees(self):
+        """
+        Swap the file boundary for one restored from its AST-free snapshot.
+
+        Call sites come back from the snapshot's call edges and the snapshot
+        keeps the analyzed source, so reports work even after the file is
+        edited; nodes are re-hydrated lazily (one re-parse, usually a parse
+        cache hit) only where a report needs them. Long-lived results no longer
+        pin whole syntax trees. Drops the cached reporter, which holds the old
+        boundary.
+        """
+        if self.file_boundary is not None:
+            self.file_boundary = FileBoundary.from_snapshot(self.file_boundary.snapshot())
+            self._function_reporter = None
 
     def format_report(self) -> str:
         """Format the complete analysis as a readable report."""
@@ -177,6 +201,16 @@ class AnalysisResult:
         }
         return json.dumps(data, indent=2)
 
+    def write_jsonl(self, fp, reports: Optional[Iterable[Tuple[str, str]]] = None):
+        """
+        以 JSON Lines 流式写出分析结果（格式见 reporters/jsonl_writer.py）
+
+        调用树按节点逐行写出、共享子树只写一次；reports 为 (函数名, 报告) 流，
+        每生成一个报告就写出一行，不在内存中拼出完整结果。
+        """
+        from .reporters.jsonl_writer import write_analysis_jsonl
+        return write_analysis_jsonl(self, fp, reports=reports)
+
     def _call_node_to_dict(self, node: Optional[CallNode]) -> Optional[dict]:
         """Convert CallNode tree to dictionary."""
         if not node:
@@ -327,17 +361,19 @@ class AnalysisResult:
 
         return "\n".join(lines)
 
-    def _get_call_depth(self, node: Optional[CallNode], current_depth: int = 0) -> int:
-        """计算调用链的深度"""
+    def _get_call_depth(self, node: Optional[CallNode], current_depth: int = 0,
+                        _heights: Optional[Dict[int, int]] = None) -> int:
+        """计算调用链的深度（按共享的 children 列表记忆化，避免重复计算共享子树）"""
         if not node or not node.children:
             return current_depth
 
-        max_child_depth = current_depth
-        for child in node.children:
-            child_depth = self._get_call_depth(child, current_depth + 1)
-            max_child_depth = max(max_child_depth, child_depth)
+        if _heights is None:
+            _heights = {}
+        key = id(node.children)
+        if key not in _heights:
+            _heights[key] = max(self._get_call_depth(child, 1, _heights) for child in node.children)
 
-        return max_child_depth
+        return current_depth + _heights[key]
 
     def generate_boundary_report(self) -> str:
         """生成边界分析详细报告"""
@@ -583,9 +619,31 @@ class AnalysisResult:
 
         重构说明：委托给 FunctionReporter 实现，降低复杂度
         """
-        from .reporters import FunctionReporter
-        reporter = FunctionReporter(self)
-        return reporter.generate(func_name)
+        return self.get_function_reporter().generate(func_name)
+
+    def get_function_reporter(self) -> 'FunctionReporter':
+        """获取（首次调用时创建）本结果共用的 FunctionReporter"""
+        if self._function_reporter is None:
+            from .reporters import FunctionReporter
+            self._function_reporter = FunctionReporter(self)
+        return self._function_reporter
+
+    def prefetch_single_function_reports(self, func_names: List[str]):
+        """
+        为一批函数报告预先批量解析所有外部标识符（常量、宏、数据结构、签名）
+
+        之后逐个调用 generate_single_function_report() 时只查缓存。
+        """
+        self.get_function_reporter().prefetch(func_names)
+
+    def generate_single_function_reports(self, func_names: List[str], jobs: int = 1) -> Iterator[Tuple[str, str]]:
+        """
+        批量生成单函数报告（先统一预取），jobs > 1 时分发到多个工作进程
+
+        按 func_names 的顺序逐个产出 (函数名, 报告)，与进程数无关。
+        """
+        from .reporters import generate_reports
+        return generate_reports(self, func_names, jobs=jobs)
 
     # ==================== 以下方法已废弃，由 FunctionReporter 使用 ====================
     # 保留是为了向后兼容，如果直接调用这些内部方法
@@ -1317,17 +1375,28 @@ class AnalysisResult:
 class CppProjectAnalyzer:
     """Main analyzer class that orchestrates all analysis components."""
 
-    def __init__(self, project_root: str, mode: AnalysisMode = AnalysisMode.FULL_PROJECT):
+    def __init__(self, project_root: str, mode: AnalysisMode = AnalysisMode.FULL_PROJECT,
+                 use_index_cache: bool = True, jobs: int = 1, lazy: bool = False,
+                 store: str = 'memory', hot_cache_size: int = DEFAULT_HOT_CACHE_SIZE):
         """
         Initialize the analyzer.
 
         Args:
             project_root: Path to the root directory of the C++ project
             mode: Analysis mode
+            use_index_cache: Reuse the on-disk symbol index (full mode only)
+            jobs: Number of worker processes for parallel work (1 = serial)
+            lazy: With a target function, only analyze what it transitively
+                reaches (boundary mode only)
+            store: Symbol store for the full index, 'memory' or 'sqlite'
+                (disk-backed, bounded memory; full mode only)
+            hot_cache_size: Names whose lookups the sqlite store caches in memory
         """
         self.project_root = Path(project_root).resolve()
         self.mode = mode
         self.mode_config = get_mode_config(mode)
+        self.jobs = max(1, jobs or 1)
+        self.lazy = lazy
 
         print(f"Initializing analyzer for project: {self.project_root}")
         print(f"Analysis mode: {self.mode.value} - {self.mode_config.description}")
@@ -1336,7 +1405,8 @@ class CppProjectAnalyzer:
         if self.mode_config.requires_full_index:
             # 全局索引模式
             print("Mode requires full project indexing...")
-            self.indexer = ProjectIndexer(str(self.project_root))
+            self.indexer = ProjectIndexer(str(self.project_root), use_cache=use_index_cache,
+                                          jobs=self.jobs, store=store, hot_cache_size=hot_cache_size)
             self.classifier = EntryPointClassifier(self.indexer)
             self.tracer = CallChainTracer(self.indexer)
             self.data_analyzer = DataStructureAnalyzer(self.indexer)
@@ -1346,6 +1416,9 @@ class CppProjectAnalyzer:
             self.indexer.index_project()
             print("Indexing complete!")
 
+            # 头文件查找复用索引中的 #include 关系，不再逐个读取文件
+            get_include_resolver(self.project_root).use_include_graph(self.indexer.include_graph)
+
             self.single_file_analyzer = None
         else:
             # 单文件模式或其他不需要全局索引的模式
@@ -1377,10 +1450,11 @@ class CppProjectAnalyzer:
             AnalysisResult containing all analysis data
         """
         # 根据模式选择分析方法
-        if self.mode == AnalysisMode.SINGLE_FILE_BOUNDARY:
-            return self._analyze_file_boundary_mode(target_file, trace_depth, target_function)
-        else:
-            return self._analyze_file_full_mode(target_file, trace_depth, target_function)
+        with span('analyze.file', 'analyze', file=str(target_file), mode=self.mode.value):
+            if self.mode == AnalysisMode.SINGLE_FILE_BOUNDARY:
+                return self._analyze_file_boundary_mode(target_file, trace_depth, target_function)
+            else:
+                return self._analyze_file_full_mode(target_file, trace_depth, target_function)
 
     def _analyze_file_boundary_mode(self, target_file: str, trace_depth: int, target_function: Optional[str]) -> AnalysisResult:
         """单文件边界模式分析"""
@@ -1393,26 +1467,20 @@ class CppProjectAnalyzer:
         if target_function:
             print(f"Target function: {target_function}")
 
-        # 读取文件
-        source_code = self.single_file_analyzer._read_file(target_path)
-        if not source_code:
-            raise ValueError(f"Could not read file: {target_path}")
-
-        # 解析并存储文件路径
+        # 存储文件路径
         self.single_file_analyzer._file_path = str(target_path)
-        from .cpp_parser import CppParser
-        parser = CppParser()
-        tree = parser.parser.parse(source_code)  # 使用内部 parser 的 parse 方法
-        if not tree:
-            raise ValueError(f"Failed to parse file: {target_path}")
 
-        root_node = tree.root_node
+        # 分析文件边界（读取+解析只做一次，AST 同时进入进程级解析缓存）
+        # 惰性模式：只分析目标函数可达的内部函数闭包
+        focus_function = target_function if self.lazy else None
+        boundary = self.single_file_analyzer.analyze_file(str(target_path), focus_function=focus_function)
+        source_code = boundary.source_code
 
-        # 分析文件边界
-        boundary = self.single_file_analyzer.analyze_file(str(target_path))
-
-        # 获取入口点
-        entry_points = self.single_file_analyzer.get_entry_points(source_code, str(target_path))
+        # 获取入口点（惰性模式下只分类目标函数）
+        entry_points = self.single_file_analyzer.get_entry_points(
+            source_code, str(target_path),
+            only={target_function} if focus_function else None
+        )
 
         # 过滤目标函数
         if target_function:
@@ -1448,7 +1516,8 @@ class CppProjectAnalyzer:
 
         # 获取数据结构信息
         print("Analyzing data structures...")
-        data_structures = self.single_file_analyzer.get_data_structures_info()
+        with span('analyze.data_structures', 'analyze'):
+            data_structures = self.single_file_analyzer.get_data_structures_info()
         print(f"  Found {len(data_structures)} data structures")
 
         # 分析函数分支结构
@@ -1468,12 +1537,13 @@ class CppProjectAnalyzer:
             functions_to_analyze = set(self.single_file_analyzer.file_functions.keys())
             print(f"  Full file mode: analyzing {len(functions_to_analyze)} functions")
 
-        for func_name in functions_to_analyze:
-            if func_name in self.single_file_analyzer.file_functions:
-                func_info = self.single_file_analyzer.file_functions[func_name]
-                func_node = func_info['node']
-                branch_analysis = self.branch_analyzer.analyze_function(func_node, source_code)
-                branch_analyses[func_name] = branch_analysis
+        with span('analyze.branches', 'analyze', functions=len(functions_to_analyze)):
+            for func_name in functions_to_analyze:
+                if func_name in self.single_file_analyzer.file_functions:
+                    func_info = self.single_file_analyzer.file_functions[func_name]
+                    func_node = func_info['node']
+                    branch_analysis = self.branch_analyzer.analyze_function(func_node, source_code)
+                    branch_analyses[func_name] = branch_analysis
         print(f"  Analyzed {len(branch_analyses)} functions")
 
         # 创建结果
@@ -1494,29 +1564,22 @@ class CppProjectAnalyzer:
         return result
 
     def _collect_signatures_from_tree(self, node: CallNode, signatures: Dict[str, str]):
-        """从调用树收集函数签名"""
-        if not node:
-            return
+        """从调用树收集函数签名（共享子树只遍历一次）"""
+        def collect(current: CallNode):
+            if current.function_name not in signatures:
+                location = f"{current.file_path}:{current.line_number}" if not current.is_external else "<external>"
+                signatures[current.function_name] = f"{current.signature} // {location}"
 
-        if node.function_name not in signatures:
-            location = f"{node.file_path}:{node.line_number}" if not node.is_external else "<external>"
-            signatures[node.function_name] = f"{node.signature} // {location}"
-
-        for child in node.children:
-            self._collect_signatures_from_tree(child, signatures)
+        visit_call_tree(node, collect)
 
     def _collect_internal_functions_from_chain(self, node: CallNode, functions_set: Set[str]):
-        """从调用链收集所有内部函数名"""
-        if not node:
-            return
+        """从调用链收集所有内部函数名（共享子树只遍历一次）"""
+        def collect(current: CallNode):
+            # 只收集内部函数（非外部调用）
+            if not current.is_external:
+                functions_set.add(current.function_name)
 
-        # 只收集内部函数（非外部调用）
-        if not node.is_external:
-            functions_set.add(node.function_name)
-
-        # 递归收集子节点
-        for child in node.children:
-            self._collect_internal_functions_from_chain(child, functions_set)
+        visit_call_tree(node, collect)
 
     def _analyze_file_full_mode(self, target_file: str, trace_depth: int, target_function: Optional[str]) -> AnalysisResult:
         """全局索引模式分析（原始模式）"""
@@ -1577,7 +1640,8 @@ class CppProjectAnalyzer:
 
         # Step 4: Analyze data structures
         print("Step 4: Analyzing data structures...")
-        data_structures = self.data_analyzer.analyze_data_structures(all_called_functions)
+        with span('analyze.data_structures', 'analyze'):
+            data_structures = self.data_analyzer.analyze_data_structures(all_called_functions)
         print(f"  Found {len(data_structures)} data structures")
 
         # Create result
@@ -2,14 +2,69 @@
 Tree-sitter based C++ parser wrapper.
 """
 import os
+import threading
+from collections import OrderedDict
+from dataclasses import dataclass
 from pathlib import Path
-from typing import Optional
-from tree_sitter import Language, Parser, Node, Tree
+from typing import Dict, List, Optional, Tuple, TYPE_CHECKING
+from tree_sitter import Parser, Node, Tree
+
+from .logger import count, span
+from .queries import cpp_language, find_nodes, precompile
+from .source_loader import decode_text, read_source
+
+if TYPE_CHECKING:
+    from .function_index import FunctionIndex
+
+
+@dataclass
+class ParsedFile:
+    """A parsed source file held by the process-wide parse cache."""
+    path: str
+    source_code: bytes
+    tree: Tree
+    mtime_ns: int = 0
+    size: int = 0
+    _function_index: Optional["FunctionIndex"] = None
+    _function_nodes: Optional[Dict[str, Node]] = None
+
+    @property
+    def root_node(self) -> Node:
+        return self.tree.root_node
+
+    @property
+    def function_index(self) -> "FunctionIndex":
+        """One-pass function definition index, built on first use."""
+        if self._function_index is None:
+            from .function_index import FunctionIndex
+            self._function_index = FunctionIndex(self.tree.root_node, self.source_code)
+        return self._function_index
+
+    @property
+    def function_nodes(self) -> Dict[str, Node]:
+        """Function name -> function_definition node (first definition wins)."""
+        if self._function_nodes is None:
+            index = self.function_index
+            self._function_nodes = {name: index.get(name).node for name in index.names()}
+        return self._function_nodes
+
+    def find_function(self, function_name: str) -> Optional[Node]:
+        """O(1) lookup of a function definition node by name."""
+        func_def = self.function_index.get(function_name)
+        return func_def.node if func_def else None
 
 
 class CppParser:
     """Wrapper for tree-sitter C++ parser."""
 
+    # Process-wide LRU parse cache shared by every CppParser instance:
+    # normalized path -> ParsedFile. Bounded by file count and source bytes.
+    parse_cache_max_files = 64
+    parse_cache_max_bytes = 64 * 1024 * 1024
+    _parse_cache: "OrderedDict[str, ParsedFile]" = OrderedDict()
+    _parse_cache_bytes = 0
+    _parse_cache_lock = threading.Lock()
+
     def __init__(self):
         self.parser = None
         self._init_parser()
@@ -17,19 +72,16 @@ class CppParser:
     def _init_parser(self):
         """Initialize tree-sitter parser with C++ language."""
         try:
-            import tree_sitter_cpp
-
-            # Get C++ language pointer and create Language object
-            lang_ptr = tree_sitter_cpp.language()
-            CPP_LANGUAGE = Language(lang_ptr, "cpp")
-
-            # Create parser and set language
+            # The Language object is shared process-wide (see queries.cpp_language)
             self.parser = Parser()
-            self.parser.set_language(CPP_LANGUAGE)
+            self.parser.set_language(cpp_language())
 
         except Exception as e:
             raise RuntimeError(f"Failed to initialize C++ parser: {e}")
 
+        # Compile the common node queries once per process
+        precompile()
+
     def parse_file(self, file_path: str) -> Optional[Tree]:
         """
         Parse a C++ source file.
@@ -40,14 +92,131 @@ class CppParser:
         Returns:
             Tree-sitter Tree object or None if parsing fails
         """
+        source = read_source(file_path)
+        if source is None:
+            return None
+        return self.parse_source(source.data, file_path)
+
+    def parse_source(self, source_code: bytes, file_path=None) -> Optional[Tree]:
+        """
+        Parse an already loaded source buffer.
+
+        Args:
+            source_code: Raw file bytes (as returned by source_loader.read_source)
+            file_path: Optional path, only used for error messages and tracing
+
+        Returns:
+            Tree-sitter Tree object or None if parsing fails
+        """
+        try:
+            count('parser.parse')
+            with span('parser.parse', 'parser', file=str(file_path or '<buffer>')):
+                return self.parser.parse(source_code)
+        except Exception as e:
+            print(f"Error parsing {file_path or 'source buffer'}: {e}")
+            return None
+
+    def get_parsed_file(self, file_path) -> Optional[ParsedFile]:
+        """
+        Return the cached parse of a file, parsing it on a miss.
+
+        Entries are validated against the file's mtime/size, so an edited file
+        is transparently re-parsed.
+
+        Args:
+            file_path: Path to the C++ file
+
+        Returns:
+            ParsedFile or None if the file cannot be read/parsed
+        """
+        key = self._cache_key(file_path)
+        try:
+            stat = os.stat(key)
+        except OSError as e:
+            print(f"Error parsing {file_path}: {e}")
+            return None
+
+        with CppParser._parse_cache_lock:
+            cached = CppParser._parse_cache.get(key)
+            if cached and cached.mtime_ns == stat.st_mtime_ns and cached.size == stat.st_size:
+                CppParser._parse_cache.move_to_end(key)
+                count('parser.cache_hit')
+                return cached
+        count('parser.cache_miss')
+
+        source = read_source(key)
+        if source is None:
+            return None
+        source_code = source.data
         try:
-            with open(file_path, 'rb') as f:
-                source_code = f.read()
-            return self.parser.parse(source_code)
+            count('parser.parse')
+            with span('parser.parse', 'parser', file=key):
+                tree = self.parser.parse(source_code)
         except Exception as e:
             print(f"Error parsing {file_path}: {e}")
             return None
 
+        if not tree:
+            return None
+
+        parsed = ParsedFile(path=key, source_code=source_code, tree=tree,
+                            mtime_ns=stat.st_mtime_ns, size=stat.st_size)
+        CppParser._store_parsed_file(parsed)
+        return parsed
+
+    @classmethod
+    def register_parsed_file(cls, file_path, source_code: bytes, tree: Tree,
+                             function_index: Optional["FunctionIndex"] = None) -> ParsedFile:
+        """Put an already parsed (and optionally indexed) file into the cache."""
+        key = cls._cache_key(file_path)
+        try:
+            stat = os.stat(key)
+            mtime_ns, size = stat.st_mtime_ns, stat.st_size
+        except OSError:
+            mtime_ns, size = 0, len(source_code)
+
+        parsed = ParsedFile(path=key, source_code=source_code, tree=tree,
+                            mtime_ns=mtime_ns, size=size, _function_index=function_index)
+        cls._store_parsed_file(parsed)
+        return parsed
+
+    @classmethod
+    def clear_parse_cache(cls):
+        """Drop every cached parse tree."""
+        with cls._parse_cache_lock:
+            cls._parse_cache.clear()
+            cls._parse_cache_bytes = 0
+
+    @classmethod
+    def invalidate_parsed_file(cls, file_path):
+        """Drop one file from the cache."""
+        key = cls._cache_key(file_path)
+        with cls._parse_cache_lock:
+            parsed = cls._parse_cache.pop(key, None)
+            if parsed:
+                cls._parse_cache_bytes -= len(parsed.source_code)
+
+    @staticmethod
+    def _cache_key(file_path) -> str:
+        return os.path.normcase(os.path.abspath(str(file_path)))
+
+    @classmethod
+    def _store_parsed_file(cls, parsed: ParsedFile):
+        with cls._parse_cache_lock:
+            old = cls._parse_cache.pop(parsed.path, None)
+            if old:
+                cls._parse_cache_bytes -= len(old.source_code)
+
+            cls._parse_cache[parsed.path] = parsed
+            cls._parse_cache_bytes += len(parsed.source_code)
+
+            # Evict least recently used entries, always keeping the newest one
+            while len(cls._parse_cache) > 1 and (
+                    len(cls._parse_cache) > cls.parse_cache_max_files or
+                    cls._parse_cache_bytes > cls.parse_cache_max_bytes):
+                _, evicted = cls._parse_cache.popitem(last=False)
+                cls._parse_cache_bytes -= len(evicted.source_code)
+
     def parse_string(self, source_code: str) -> Optional[Tree]:
         """
         Parse C++ source code from string.
@@ -59,6 +228,7 @@ class CppParser:
             Tree-sitter Tree object or None if parsing fails
         """
         try:
+            count('parser.parse')
             return self.parser.parse(bytes(source_code, 'utf8'))
         except Exception as e:
             print(f"Error parsing source code: {e}")
@@ -67,23 +237,21 @@ class CppParser:
     @staticmethod
     def get_node_text(node: Node, source_code: bytes) -> str:
         """Extract text content from a node."""
-        # Try UTF-8 first, fall back to ignore/replace for other encodings
-        try:
-            return source_code[node.start_byte:node.end_byte].decode('utf8')
-        except UnicodeDecodeError:
-            # Try common encodings
-            for encoding in ['gbk', 'gb2312', 'latin-1']:
-                try:
-                    return source_code[node.start_byte:node.end_byte].decode(encoding)
-                except (UnicodeDecodeError, LookupError):
-                    continue
-            # Last resort: decode with errors='replace'
-            return source_code[node.start_byte:node.end_byte].decode('utf8', errors='replace')
+        return CppParser.get_text(source_code, node.start_byte, node.end_byte)
+
+    @staticmethod
+    def get_text(source_code: bytes, start_byte: int, end_byte: int) -> str:
+        """Decode a byte range of the source (no node needed)."""
+        # Buffers from read_source carry the file's detected encoding
+        return decode_text(source_code[start_byte:end_byte], getattr(source_code, 'encoding', None))
 
     @staticmethod
     def find_nodes_by_type(node: Node, node_type: str) -> list:
         """
-        Recursively find all nodes of a specific type.
+        Find all nodes of a specific type in preorder.
+
+        Matching runs as a precompiled tree-sitter query (see queries.py),
+        falling back to a cursor walk when queries are unavailable.
 
         Args:
             node: Root node to search from
@@ -92,15 +260,57 @@ class CppParser:
         Returns:
             List of matching nodes
         """
-        results = []
+        return find_nodes(node, (node_type,))[node_type]
 
-        if node.type == node_type:
-            results.append(node)
+    @staticmethod
+    def find_nodes_by_types(node: Node, node_types) -> Dict[str, list]:
+        """Find nodes of several types with one query: node type -> nodes (preorder)."""
+        return find_nodes(node, node_types)
 
-        for child in node.children:
-            results.extend(CppParser.find_nodes_by_type(child, node_type))
+    @staticmethod
+    def get_call_name(call_node: Node, source_code: bytes) -> Optional[str]:
+        """
+        Extract the called function name from a call_expression node.
 
-        return results
+        Handles:
+        - Simple calls: foo()
+        - Scoped calls: namespace::foo()
+        - Method calls: obj.foo() / ptr->foo()
+        """
+        function_node = call_node.children[0] if call_node.children else None
+        if not function_node:
+            return None
+
+        if function_node.type == 'identifier':
+            return CppParser.get_node_text(function_node, source_code)
+
+        elif function_node.type == 'qualified_identifier':
+            # namespace::function
+            parts = CppParser.get_node_text(function_node, source_code).split('::')
+            return parts[-1] if parts else None
+
+        elif function_node.type == 'field_expression':
+            # obj.method() or ptr->method(): take the field name (method name)
+            field_node = CppParser.find_child_by_type(function_node, 'field_identifier')
+            if field_node:
+                return CppParser.get_node_text(field_node, source_code)
+
+        elif function_node.type == 'scoped_identifier':
+            # Class::method
+            if function_node.children:
+                return CppParser.get_node_text(function_node.children[-1], source_code)
+
+        return None
+
+    @staticmethod
+    def find_call_names(node: Node, source_code: bytes) -> List[Tuple[str, Node]]:
+        """Calls under node whose callee name can be resolved: [(name, call_expression)] in preorder."""
+        calls = []
+        for call_node in find_nodes(node, ('call_expression',))['call_expression']:
+            name = CppParser.get_call_name(call_node, source_code)
+            if name:
+                calls.append((name, call_node))
+        return calls
 
     @staticmethod
     def find_child_by_type(node: Node, child_type: str) -> Optional[Node]:
@@ -153,19 +363,7 @@ class CppParser:
             if body:
                 signature_end = body.start_byte
                 signature_start = func_node.start_byte
-                # Use get_node_text helper for consistent encoding handling
-                try:
-                    signature = source_code[signature_start:signature_end].decode('utf8').strip()
-                except UnicodeDecodeError:
-                    for encoding in ['gbk', 'gb2312', 'latin-1']:
-                        try:
-                            signature = source_code[signature_start:signature_end].decode(encoding).strip()
-                            break
-                        except (UnicodeDecodeError, LookupError):
-                            continue
-                    else:
-                        signature = source_code[signature_start:signature_end].decode('utf8', errors='replace').strip()
-                return signature
+                return CppParser.get_text(source_code, signature_start, signature_end).strip()
 
         # For declarations, return full text
         return CppParser.get_node_text(func_node, source_code).strip()
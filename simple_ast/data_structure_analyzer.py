@@ -82,51 +82,24 @@ class DataStructureAnalyzer:
 
         try:
             full_path = self.indexer.project_root / func_symbol.file_path
-            with open(full_path, 'rb') as f:
-                source_code = f.read()
-
-            tree = self.parser.parse_file(str(full_path))
-            if not tree:
+            parsed = self.parser.get_parsed_file(full_path)
+            if not parsed:
                 return used_types
+            source_code = parsed.source_code
 
             # Find the function definition
-            func_defs = CppParser.find_nodes_by_type(tree.root_node, 'function_definition')
-
-            target_func_node = None
-            for func_def in func_defs:
-                name = CppParser.get_function_name(func_def, source_code)
-                if name == func_symbol.name:
-                    target_func_node = func_def
-                    break
-
+            target_func_node = parsed.find_function(func_symbol.name)
             if not target_func_node:
                 return used_types
 
-            # Extract types from:
-            # 1. Return type
-            # 2. Parameters
-            # 3. Local variable declarations
-
-            # Get return type
-            return_types = self._extract_types_from_node(target_func_node, source_code, 'type_identifier')
-            used_types.update(return_types)
-
-            # Get parameter types
-            param_list = CppParser.find_child_by_type(target_func_node, 'parameter_list')
-            if param_list:
-                param_types = self._extract_types_from_node(param_list, source_code, 'type_identifier')
-                used_types.update(param_types)
-
-            # Get local variable types (from declaration statements)
-            declarations = CppParser.find_nodes_by_type(target_func_node, 'declaration')
-            for decl in declarations:
-                decl_types = self._extract_types_from_node(decl, source_code, 'type_identifier')
-                used_types.update(decl_types)
-
-            # Also look for primitive types wrapped in structs/classes
-            # Look for qualified identifiers (namespace::Type)
-            qualified_ids = CppParser.find_nodes_by_type(target_func_node, 'qualified_identifier')
-            for qid in qualified_ids:
+            # One query over the whole function covers the return type,
+            # parameters and local declarations (all are subtrees of it),
+            # plus qualified identifiers (namespace::Type)
+            nodes = CppParser.find_nodes_by_types(target_func_node,
+                                                  ('type_identifier', 'qualified_identifier'))
+            used_types.update(self._filter_type_names(nodes['type_identifier'], source_code))
+
+            for qid in nodes['qualified_identifier']:
                 text = CppParser.get_node_text(qid, source_code)
                 # Extract the last part (type name)
                 parts = text.split('::')
@@ -150,9 +123,12 @@ class DataStructureAnalyzer:
         Returns:
             Set of type names
         """
-        types = set()
-        type_nodes = CppParser.find_nodes_by_type(node, target_type)
+        return self._filter_type_names(CppParser.find_nodes_by_type(node, target_type), source_code)
 
+    @staticmethod
+    def _filter_type_names(type_nodes, source_code: bytes) -> Set[str]:
+        """Type names of the given nodes, without primitive types."""
+        types = set()
         for type_node in type_nodes:
             type_name = CppParser.get_node_text(type_node, source_code)
             # Filter out primitive types
@@ -2,9 +2,30 @@
 外部函数分类器 - 根据配置区分业务依赖、标准库、日志函数
 """
 import json
+import threading
 from pathlib import Path
-from typing import Set, Dict, List
-import fnmatch
+from typing import Set, Dict, List, Tuple
+
+from .glob_matcher import get_glob_matcher
+
+# 判断“全大写”时忽略的字符
+_MACRO_IGNORED_CHARS = str.maketrans('', '', '_0123456789')
+
+# 分类结果按配置共享：同一配置的所有分类器共用一份 名字 -> 分类 的记忆
+_memos: Dict[str, Dict[str, str]] = {}
+_memos_lock = threading.Lock()
+
+
+def _shared_memo(config: Dict) -> Dict[str, str]:
+    key = json.dumps(config, sort_keys=True, ensure_ascii=False)
+    with _memos_lock:
+        return _memos.setdefault(key, {})
+
+
+def clear_classification_memo():
+    """清空分类记忆（修改配置文件后调用）"""
+    with _memos_lock:
+        _memos.clear()
 
 
 class ExternalFunctionClassifier:
@@ -23,6 +44,15 @@ class ExternalFunctionClassifier:
         self.macro_patterns = self.config.get('macro_definitions', {}).get('patterns', [])
         self.custom_exclusions = self.config.get('custom_exclusions', {}).get('patterns', [])
 
+        # 每组模式编译成一个组合匹配器（前缀字典树 + 一个正则）
+        self._macro_matcher = get_glob_matcher(self.macro_patterns)
+        self._ordered_matchers: List[Tuple[str, object]] = [
+            ('logging_utility', get_glob_matcher(self.custom_exclusions)),
+            ('standard_library', get_glob_matcher(self.standard_lib_patterns)),
+            ('logging_utility', get_glob_matcher(self.logging_patterns)),
+        ]
+        self._memo = _shared_memo(self.config)
+
     def _load_config(self, config_path: str = None) -> Dict:
         """加载配置文件"""
         if config_path is None:
@@ -71,10 +101,7 @@ class ExternalFunctionClassifier:
 
     def _matches_patterns(self, func_name: str, patterns: List[str]) -> bool:
         """检查函数名是否匹配任一模式"""
-        for pattern in patterns:
-            if fnmatch.fnmatch(func_name, pattern):
-                return True
-        return False
+        return get_glob_matcher(patterns).matches(func_name)
 
     def _is_likely_macro(self, func_name: str) -> bool:
         """
@@ -85,14 +112,14 @@ class ExternalFunctionClassifier:
         2. 匹配宏模式
         """
         # 检查是否全大写（允许下划线和数字）
-        is_all_caps = func_name.replace('_', '').replace('0', '').replace('1', '').replace('2', '').replace('3', '').replace('4', '').replace('5', '').replace('6', '').replace('7', '').replace('8', '').replace('9', '').isupper()
+        is_all_caps = func_name.translate(_MACRO_IGNORED_CHARS).isupper()
 
         # 全大写且至少有一个下划线
         if is_all_caps and '_' in func_name:
             return True
 
         # 匹配宏模式
-        if self._matches_patterns(func_name, self.macro_patterns):
+        if self._macro_matcher.matches(func_name):
             return True
 
         return False
@@ -119,25 +146,30 @@ class ExternalFunctionClassifier:
         }
 
         for func in external_functions:
-            # 优先级：macros > custom_exclusions > standard_library > logging_utility > business
-
-            if self._is_likely_macro(func):
-                # 宏定义，不需要Mock
-                result['macros'].add(func)
-            elif self._matches_patterns(func, self.custom_exclusions):
-                # 用户自定义排除的，根据配置归类
-                # 默认归入logging_utility（因为通常是项目特定的工具函数）
-                result['logging_utility'].add(func)
-            elif self._matches_patterns(func, self.standard_lib_patterns):
-                result['standard_library'].add(func)
-            elif self._matches_patterns(func, self.logging_patterns):
-                result['logging_utility'].add(func)
-            else:
-                # 无法匹配任何模式，归类为业务依赖
-                result['business'].add(func)
+            result[self.category(func)].add(func)
 
         return result
 
+    def category(self, func_name: str) -> str:
+        """单个函数的分类（结果在同一配置的分类器之间共享记忆）"""
+        category = self._memo.get(func_name)
+        if category is None:
+            category = self._categorize(func_name)
+            self._memo[func_name] = category
+        return category
+
+    def _categorize(self, func_name: str) -> str:
+        # 优先级：macros > custom_exclusions > standard_library > logging_utility > business
+        if self._is_likely_macro(func_name):
+            # 宏定义，不需要Mock
+            return 'macros'
+        # 用户自定义排除的默认归入logging_utility（因为通常是项目特定的工具函数）
+        for category, matcher in self._ordered_matchers:
+            if matcher.matches(func_name):
+                return category
+        # 无法匹配任何模式，归类为业务依赖
+        return 'business'
+
     def get_config_info(self) -> str:
         """获取配置信息（用于显示）"""
         lines = []
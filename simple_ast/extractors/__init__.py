@@ -4,8 +4,9 @@ from .constant_extractor import ConstantExtractor
 from .signature_extractor import SignatureExtractor
 from .structure_extractor import StructureExtractor
 from .macro_extractor import MacroExtractor
+from .macro_table import MacroTable, MacroExpander, clear_macro_tables, get_macro_expander, get_macro_table
 from .global_variable_extractor import GlobalVariableExtractor
 from .type_cast_extractor import TypeCastExtractor
 from .function_impl_extractor import FunctionImplExtractor
 
-__all__ = ['ConstantExtractor', 'SignatureExtractor', 'StructureExtractor', 'MacroExtractor', 'GlobalVariableExtractor', 'TypeCastExtractor', 'FunctionImplExtractor']
+__all__ = ['ConstantExtractor', 'SignatureExtractor', 'StructureExtractor', 'MacroExtractor', 'MacroTable', 'MacroExpander', 'clear_macro_tables', 'get_macro_expander', 'get_macro_table', 'GlobalVariableExtractor', 'TypeCastExtractor', 'FunctionImplExtractor']
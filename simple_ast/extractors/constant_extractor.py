@@ -8,7 +8,9 @@ import sys
 from pathlib import Path
 from typing import Dict, Set, Optional
 from ..searchers import HeaderSearcher, GrepSearcher
-from ..logger import get_logger
+from ..searchers.definition_index import KIND_MACRO, KIND_ASSIGN
+from ..logger import count, get_logger, traced
+from .macro_table import get_macro_table
 logger = get_logger()
 
 
@@ -22,7 +24,35 @@ class ConstantExtractor:
         self.project_root = project_root
         self.grep_searcher = GrepSearcher(project_root) if project_root else None
         self.file_boundary = file_boundary  # 用于复用已解析的AST
+        # 全局搜索结果缓存 {标识符: 定义 或 None(未找到)}，跨函数共享
+        self._definition_cache: Dict[str, Optional[str]] = {}
 
+    @traced('extract.constants.prefetch', 'extract')
+    def prefetch(self, func_names, function_signatures: Dict[str, str],
+                 branch_analyses: Dict, target_file: str):
+        """
+        预先收集多个函数的标识符，一次批量搜索全部定义
+
+        之后对这些函数调用 extract() 只查缓存，不再逐函数搜索。
+        """
+        if not self.grep_searcher:
+            return
+
+        identifiers = set()
+        for func_name in func_names:
+            if func_name in function_signatures:
+                identifiers |= self._collect_identifiers(
+                    func_name, function_signatures, branch_analyses, target_file
+                )
+
+        logger.info(f"[常量提取] 预取 {len(func_names)} 个函数的 {len(identifiers)} 个标识符")
+        self._search_definitions(identifiers, target_file)
+
+    def cached_definitions(self) -> Dict[str, str]:
+        """已找到的全局搜索结果 {标识符: 定义}"""
+        return {k: v for k, v in self._definition_cache.items() if v is not None}
+
+    @traced('extract.constants', 'extract')
     def extract(self, func_name: str, function_signatures: Dict[str, str],
                 branch_analyses: Dict, target_file: str) -> Dict[str, str]:
         """
@@ -118,16 +148,13 @@ class ConstantExtractor:
             # 优先使用 file_boundary 中已解析的函数信息（避免重复解析大文件）
             if self.file_boundary and hasattr(self.file_boundary, 'file_functions'):
                 if func_name in self.file_boundary.file_functions:
-                    func_info = self.file_boundary.file_functions[func_name]
-                    func_node = func_info.get('node')
-                    source_code = self.file_boundary.source_code
+                    # 按记录的字节范围取函数文本，不需要语法树节点
+                    func_text = self.file_boundary.function_text(func_name)
 
-                    if func_node and source_code:
-                        logger.debug(f"[常量提取-函数体] ✓ 使用已解析的函数节点: {func_name}")
+                    if func_text is not None:
+                        logger.debug(f"[常量提取-函数体] ✓ 使用已解析的函数范围: {func_name}")
 
                         # 从函数体中提取所有标识符
-                        from ..cpp_parser import CppParser
-                        func_text = CppParser.get_node_text(func_node, source_code)
                         # 只提取全大写的标识符（可能是宏或常量）
                         upper_ids = re.findall(r'\b[A-Z][A-Z0-9_]+\b', func_text)
                         identifiers.update(upper_ids)
@@ -135,7 +162,7 @@ class ConstantExtractor:
                         logger.debug(f"[常量提取-函数体] ✓ 从函数体提取到 {len(upper_ids)} 个大写标识符")
                         return identifiers
                     else:
-                        logger.warning(f"[常量提取-函数体] file_boundary中缺少函数节点或源代码")
+                        logger.warning(f"[常量提取-函数体] file_boundary中缺少函数范围或源代码")
                 else:
                     logger.warning(f"[常量提取-函数体] file_boundary中未找到函数: {func_name}")
 
@@ -156,42 +183,27 @@ class ConstantExtractor:
                 logger.warning(f"[常量提取-函数体] project_root={self.project_root}, target_file={target_file}")
                 return identifiers
 
-            with open(file_path, 'r', encoding='utf-8', errors='ignore') as f:
-                content = f.read()
-
-            logger.debug(f"[常量提取-函数体] 文件读取成功，大小: {len(content)} 字符")
-
-            # 使用tree-sitter解析
+            # 使用进程级解析缓存（同一文件只解析一次）
             from ..cpp_parser import CppParser
-            parser = CppParser()
-            tree = parser.parse_file(str(file_path))
+            parsed = CppParser().get_parsed_file(file_path)
 
-            if not tree:
+            if not parsed:
                 logger.warning(f"[常量提取-函数体] tree-sitter解析失败: {file_path}")
                 return identifiers
 
-            logger.debug(f"[常量提取-函数体] tree-sitter解析成功")
+            logger.debug(f"[常量提取-函数体] 解析完成，大小: {len(parsed.source_code)} 字节")
 
             # 查找目标函数
-            func_defs = CppParser.find_nodes_by_type(tree.root_node, 'function_definition')
-            logger.debug(f"[常量提取-函数体] 文件中共有 {len(func_defs)} 个函数")
-
-            target_func = None
-
-            for func_def in func_defs:
-                name = CppParser.get_function_name(func_def, content.encode())
-                if name == func_name:
-                    target_func = func_def
-                    logger.debug(f"[常量提取-函数体] ✓ 找到目标函数: {func_name}")
-                    break
-
+            target_func = parsed.find_function(func_name)
             if not target_func:
                 logger.warning(f"[常量提取-函数体] 未找到目标函数: {func_name}")
-                logger.warning(f"[常量提取-函数体] 文件中的函数: {[CppParser.get_function_name(f, content.encode()) for f in func_defs[:5]]}")
+                logger.warning(f"[常量提取-函数体] 文件中的函数: {list(parsed.function_nodes)[:5]}")
                 return identifiers
 
+            logger.debug(f"[常量提取-函数体] ✓ 找到目标函数: {func_name}")
+
             # 从函数体中提取所有标识符
-            func_text = CppParser.get_node_text(target_func, content.encode())
+            func_text = CppParser.get_node_text(target_func, parsed.source_code)
             # 只提取全大写的标识符（可能是宏或常量）
             upper_ids = re.findall(r'\b[A-Z][A-Z0-9_]+\b', func_text)
             identifiers.update(upper_ids)
@@ -209,50 +221,51 @@ class ConstantExtractor:
         """在头文件中搜索定义 - 使用全局搜索"""
         constants = {}
 
-        # 优先使用 GrepSearcher 进行全局搜索
+        # 优先使用 GrepSearcher 进行全局搜索（已搜索过的标识符直接取缓存）
         if self.grep_searcher:
-            logger.info(f"[常量提取] 使用 GrepSearcher 进行全局搜索")
-            return self._search_with_grep(identifiers)
+            missing = {i for i in identifiers if i not in self._definition_cache}
+            count('cache.constant.hit', len(identifiers) - len(missing))
+            count('cache.constant.miss', len(missing))
+            if missing:
+                logger.info(f"[常量提取] 使用 GrepSearcher 进行全局搜索（{len(missing)} 个未缓存）")
+                found = self._search_with_grep(missing)
+                for identifier in missing:
+                    self._definition_cache[identifier] = found.get(identifier)
+            for identifier in identifiers:
+                definition = self._definition_cache.get(identifier)
+                if definition is not None:
+                    constants[identifier] = definition
+            return constants
 
         # 降级到原有的 HeaderSearcher 方法
         logger.info(f"[常量提取] 使用 HeaderSearcher 进行局部搜索（降级）")
         return self._search_with_header_searcher(identifiers, target_file)
 
     def _search_with_grep(self, identifiers: Set[str]) -> Dict[str, str]:
-        """使用 GrepSearcher 全局搜索常量定义（批量优化版本）"""
+        """使用 GrepSearcher 全局搜索常量定义（批量：所有标识符一次查完）"""
         constants = {}
+        identifiers = sorted(identifiers)
 
-        # 构建所有搜索模式
-        define_patterns = []
-        enum_patterns = []
-        identifier_to_define_pattern = {}
-        identifier_to_enum_pattern = {}
-
-        for identifier in identifiers:
-            # #define 模式
-            define_pattern = rf'^\s*#define\s+{re.escape(identifier)}\b'
-            define_patterns.append(define_pattern)
-            identifier_to_define_pattern[define_pattern] = identifier
-
-            # enum 成员模式
-            enum_pattern = rf'^\s*{re.escape(identifier)}\s*='
-            enum_patterns.append(enum_pattern)
-            identifier_to_enum_pattern[enum_pattern] = identifier
+        # #define 模式
+        define_patterns = {
+            identifier: rf'^\s*#define\s+{re.escape(identifier)}\b'
+            for identifier in identifiers
+        }
 
         # 批量搜索 #define
         logger.info(f"[常量提取] 批量搜索 {len(define_patterns)} 个 #define 模式")
-        define_results = self.grep_searcher.search_content_batch(
-            patterns=define_patterns,
+        define_results = self.grep_searcher.search_definitions_batch(
+            define_patterns,
+            kinds=(KIND_MACRO,),
             file_glob='*.h',
-            max_results_per_pattern=1
+            max_results_per_name=1
         )
 
         # 处理 #define 结果
-        for pattern, results in define_results.items():
+        for identifier, results in define_results.items():
             if not results:
                 continue
 
-            identifier = identifier_to_define_pattern[pattern]
             file_path, line_num, line_content = results[0]
 
             # 检查是否是多行宏（以 \ 结尾）
@@ -266,24 +279,27 @@ class ConstantExtractor:
                 logger.info(f"[常量提取] ✓ 在 {file_path.name}:{line_num} 找到 #define {identifier}")
 
         # 对于没找到 #define 的标识符，批量搜索 enum
-        not_found = [id for id in identifiers if id not in constants]
+        not_found = [identifier for identifier in identifiers if identifier not in constants]
         if not_found:
-            # 收集没找到的标识符对应的 enum 模式
-            enum_patterns_to_search = [p for p, id in identifier_to_enum_pattern.items() if id in not_found]
-
-            logger.info(f"[常量提取] 批量搜索 {len(enum_patterns_to_search)} 个 enum 模式")
-            enum_results = self.grep_searcher.search_content_batch(
-                patterns=enum_patterns_to_search,
+            # enum 成员模式
+            enum_patterns = {
+                identifier: rf'^\s*{re.escape(identifier)}\s*='
+                for identifier in not_found
+            }
+
+            logger.info(f"[常量提取] 批量搜索 {len(enum_patterns)} 个 enum 模式")
+            enum_results = self.grep_searcher.search_definitions_batch(
+                enum_patterns,
+                kinds=(KIND_ASSIGN,),
                 file_glob='*.h',
-                max_results_per_pattern=1
+                max_results_per_name=1
             )
 
             # 处理 enum 结果
-            for pattern, results in enum_results.items():
+            for identifier, results in enum_results.items():
                 if not results:
                     continue
 
-                identifier = identifier_to_enum_pattern[pattern]
                 file_path, line_num, line_content = results[0]
                 constants[identifier] = line_content.strip()
                 logger.info(f"[常量提取] ✓ 在 {file_path.name}:{line_num} 找到 enum {identifier}")
@@ -301,6 +317,11 @@ class ConstantExtractor:
         Returns:
             完整的多行宏定义
         """
+        # 宏表中已有该行开始的宏时直接取其续行，不再回读文件
+        macro = get_macro_table(self.project_root).at(file_path, start_line)
+        if macro is not None:
+            return '\n'.join(line.rstrip() for line in macro.lines[:20])
+
         try:
             with open(file_path, 'r', encoding='utf-8', errors='ignore') as f:
                 lines = f.readlines()
@@ -6,7 +6,7 @@
 from pathlib import Path
 from typing import Optional, Dict
 from ..cpp_parser import CppParser
-from ..logger import get_logger
+from ..logger import get_logger, traced
 
 logger = get_logger()
 
@@ -22,6 +22,7 @@ class FunctionImplExtractor:
         self.project_root = Path(project_root)
         self.parser = CppParser()
 
+    @traced('extract.function_impl', 'extract')
     def extract(self, func_name: str, source_file: str, file_boundary=None) -> Optional[str]:
         """
         提取函数的完整实现
@@ -41,17 +42,12 @@ class FunctionImplExtractor:
         if file_boundary and hasattr(file_boundary, 'file_functions'):
             logger.info(f"[函数实现提取] 使用已缓存的AST")
             if func_name in file_boundary.file_functions:
-                func_info = file_boundary.file_functions[func_name]
-                func_node = func_info.get('node')
-                source_code = file_boundary.source_code
-
-                if func_node and source_code:
-                    impl = self._extract_from_node(func_node, source_code)
-                    if impl:
-                        logger.info(f"[函数实现提取] ✓ 从缓存AST成功提取 {func_name} ({len(impl)} 字符)")
-                        return impl
-                    else:
-                        logger.warning(f"[函数实现提取] ✗ 从缓存AST提取失败")
+                # 按记录的字节范围取函数文本，不需要语法树节点
+                impl = file_boundary.function_text(func_name)
+                if impl:
+                    logger.info(f"[函数实现提取] ✓ 从缓存AST成功提取 {func_name} ({len(impl)} 字符)")
+                    return impl
+                logger.warning(f"[函数实现提取] ✗ 从缓存AST提取失败")
             else:
                 logger.warning(f"[函数实现提取] 函数 {func_name} 不在 file_boundary.file_functions 中")
 
@@ -62,21 +58,17 @@ class FunctionImplExtractor:
             return None
 
         logger.info(f"[函数实现提取] 解析文件: {file_path}")
-        try:
-            with open(file_path, 'r', encoding='utf-8', errors='ignore') as f:
-                source_code = f.read()
-        except Exception as e:
-            logger.error(f"[函数实现提取] 读取文件失败: {e}")
-            return None
-
-        # 解析文件
-        tree = self.parser.parse(source_code)
-        if not tree or not tree.root_node:
+        # 解析文件（复用进程级解析缓存）
+        parsed = self.parser.get_parsed_file(file_path)
+        if not parsed:
             logger.error(f"[函数实现提取] 解析AST失败")
             return None
+        source_code = parsed.source_code
 
-        # 3. 查找函数节点
-        func_node = self._find_function_node(tree.root_node, func_name, source_code)
+        # 3. 查找函数节点（函数索引 O(1) 命中，未命中再按声明器规则匹配）
+        func_node = parsed.find_function(func_name)
+        if not func_node:
+            func_node = self._find_function_node(parsed.function_index, func_name, source_code)
         if not func_node:
             logger.warning(f"[函数实现提取] 未找到函数: {func_name}")
             return None
@@ -122,20 +114,14 @@ class FunctionImplExtractor:
             logger.error(f"[批量提取] 文件不存在: {file_path}")
             return result
 
-        try:
-            with open(file_path, 'r', encoding='utf-8', errors='ignore') as f:
-                source_code = f.read()
-        except Exception as e:
-            logger.error(f"[批量提取] 读取文件失败: {e}")
-            return result
-
-        tree = self.parser.parse(source_code)
-        if not tree or not tree.root_node:
+        parsed = self.parser.get_parsed_file(file_path)
+        if not parsed:
             logger.error(f"[批量提取] 解析AST失败")
             return result
+        source_code = parsed.source_code
 
         # 查找所有函数定义
-        all_func_nodes = self._find_all_function_nodes(tree.root_node, source_code)
+        all_func_nodes = self._find_all_function_nodes(parsed.function_index, source_code)
 
         # 筛选要提取的函数
         if function_list:
@@ -153,12 +139,10 @@ class FunctionImplExtractor:
 
         return result
 
-    def _find_function_node(self, root_node, func_name: str, source_code: str):
+    def _find_function_node(self, function_index, func_name: str, source_code: bytes):
         """查找指定函数的节点"""
-        # 查找所有函数定义节点
-        function_defs = CppParser.find_nodes_by_type(root_node, 'function_definition')
-
-        for func_def in function_defs:
+        # 遍历函数索引中的所有函数定义节点
+        for func_def in (d.node for d in function_index.definitions):
             # 获取声明器节点
             declarator = func_def.child_by_field_name('declarator')
             if not declarator:
@@ -171,12 +155,11 @@ class FunctionImplExtractor:
 
         return None
 
-    def _find_all_function_nodes(self, root_node, source_code: str) -> Dict[str, any]:
+    def _find_all_function_nodes(self, function_index, source_code: bytes) -> Dict[str, any]:
         """查找所有函数节点，返回 {函数名: 节点} 字典"""
         result = {}
-        function_defs = CppParser.find_nodes_by_type(root_node, 'function_definition')
 
-        for func_def in function_defs:
+        for func_def in (d.node for d in function_index.definitions):
             declarator = func_def.child_by_field_name('declarator')
             if not declarator:
                 continue
@@ -187,7 +170,7 @@ class FunctionImplExtractor:
 
         return result
 
-    def _extract_function_name(self, declarator, source_code: str) -> Optional[str]:
+    def _extract_function_name(self, declarator, source_code: bytes) -> Optional[str]:
         """从声明器节点中提取函数名"""
         # 处理不同类型的声明器
         # function_declarator -> identifier
@@ -238,7 +221,7 @@ class FunctionImplExtractor:
 
         return None
 
-    def _extract_from_node(self, func_node, source_code: str) -> Optional[str]:
+    def _extract_from_node(self, func_node, source_code: bytes) -> Optional[str]:
         """从函数节点提取完整实现代码"""
         if not func_node:
             return None
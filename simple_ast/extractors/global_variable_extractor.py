@@ -9,8 +9,8 @@
 import re
 from typing import Set, Dict, List, Optional
 from pathlib import Path
-from ..cpp_parser import CppParser
-from ..logger import get_logger
+from ..cpp_parser import CppParser, ParsedFile
+from ..logger import count, get_logger, traced
 
 logger = get_logger()
 
@@ -21,7 +21,10 @@ class GlobalVariableExtractor:
     def __init__(self):
         """初始化提取器"""
         self.parser = CppParser()
+        # 定义搜索结果缓存 {(变量名, 搜索根目录): 定义信息 或 None}
+        self._definition_cache: Dict[tuple, Optional[Dict]] = {}
 
+    @traced('extract.globals', 'extract')
     def extract_from_function(
         self,
         file_path: str,
@@ -46,31 +49,20 @@ class GlobalVariableExtractor:
                 }
             }
         """
-        # 读取源代码
+        # 解析AST（未提供源代码时复用进程级解析缓存）
         if source_code is None:
-            try:
-                with open(file_path, 'rb') as f:
-                    source_code = f.read()
-            except Exception as e:
-                logger.error(f"[全局变量提取] 无法读取文件: {file_path}, {e}")
-                return {}
-
-        # 解析AST
-        tree = self.parser.parser.parse(source_code)
-        if not tree:
+            parsed = self.parser.get_parsed_file(file_path)
+        else:
+            count('parser.parse')
+            tree = self.parser.parser.parse(source_code)
+            parsed = ParsedFile(path=str(file_path), source_code=source_code, tree=tree) if tree else None
+        if not parsed:
             logger.error(f"[全局变量提取] 解析失败: {file_path}")
             return {}
+        source_code = parsed.source_code
 
         # 查找目标函数
-        func_defs = CppParser.find_nodes_by_type(tree.root_node, 'function_definition')
-        target_func_node = None
-
-        for func_def in func_defs:
-            name = CppParser.get_function_name(func_def, source_code)
-            if name == function_name:
-                target_func_node = func_def
-                break
-
+        target_func_node = parsed.find_function(function_name)
         if not target_func_node:
             logger.info(f"[全局变量提取] 未找到函数: {function_name}")
             return {}
@@ -88,9 +80,22 @@ class GlobalVariableExtractor:
         # 搜索全局变量定义
         global_vars = {}
         from pathlib import Path
+        from ..searchers.rg_stream import map_searches
         project_root = Path(file_path).parent
+        misses = []
+        for var_name in sorted(global_var_names):
+            if (var_name, str(project_root)) in self._definition_cache:
+                count('cache.global.hit')
+            else:
+                count('cache.global.miss')
+                misses.append(var_name)
+        # 未缓存的变量并发搜索（外部搜索工具时每个变量可能各启动一次 rg/grep）
+        found = map_searches(lambda name: self._search_variable_definition(name, project_root), misses)
+        for var_name, definition_info in zip(misses, found):
+            self._definition_cache[(var_name, str(project_root))] = definition_info
+
         for var_name in global_var_names:
-            definition_info = self._search_variable_definition(var_name, project_root)
+            definition_info = self._definition_cache[(var_name, str(project_root))]
             if definition_info:
                 global_vars[var_name] = definition_info
 
@@ -138,6 +143,7 @@ class GlobalVariableExtractor:
             Dict包含：definition, type, file, line
         """
         from ..searchers import GrepSearcher
+        from ..searchers.definition_index import KIND_GLOBAL
 
         grep = GrepSearcher(str(project_root))
 
@@ -145,18 +151,25 @@ class GlobalVariableExtractor:
         # 或者 Type var_name;
         pattern = rf'\b\w+\s+{re.escape(var_name)}\s*(=|;)'
 
-        results = grep.search_content(
+        # 定义索引只记录文件作用域的声明，没命中时再做文本搜索
+        results = grep.search_definitions(
+            var_name,
+            kinds=(KIND_GLOBAL,),
             pattern=pattern,
             file_glob='*.cpp',
-            max_results=5
+            max_results=5,
+            fallback_on_miss=True
         )
 
         if not results:
             # 尝试在头文件中搜索
-            results = grep.search_content(
+            results = grep.search_definitions(
+                var_name,
+                kinds=(KIND_GLOBAL,),
                 pattern=pattern,
                 file_glob='*.h',
-                max_results=5
+                max_results=5,
+                fallback_on_miss=True
             )
 
         if not results:
@@ -0,0 +1,384 @@
+"""
+项目级宏表与带缓存的宏展开
+
+MacroTable：名字 -> 宏定义（参数、主体、原始续行），定义索引启用时一次从索引的
+#define 条目建好整张表（多行宏的续行已在索引中，不再回读文件）；索引未启用时
+按名字搜索一次后记入表中。
+
+MacroExpander：结构体成员宏（如 VOS_MSG_HEADER）的展开结果按宏名缓存，
+嵌套的成员宏递归展开，展开链上出现循环引用时保留原名不再展开。
+
+两者都按项目根目录在进程内共享，所有 FunctionReporter / MacroExtractor /
+ConstantExtractor 使用同一份。文件变化后调用 clear_macro_tables()。
+"""
+import os
+import re
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Set, Tuple
+
+from ..logger import count, get_logger, traced
+from ..searchers import GrepSearcher, get_definition_index
+from ..searchers.definition_index import KIND_MACRO
+
+logger = get_logger()
+
+# #define NAME 或 #define NAME(params) body
+_DEFINE_RE = re.compile(r'^\s*#\s*define\s+(\w+)(\([^)]*\))?\s*(.*?)$')
+# 对象宏的主体（与原 extract_struct_macro 一致，函数宏不作为成员宏展开）
+_OBJECT_BODY_RE = re.compile(r'^\s*#\s*define\s+\w+\s+(.*?)$', re.DOTALL)
+# 结构体定义中独占一行的宏标识符，可带一个块注释
+_MEMBER_MACRO_RE = re.compile(r'^(\s*)([A-Z][A-Z0-9_]+)\s*(\/\*.*\*\/)?$')
+_INDENT_RE = re.compile(r'^(\s*)')
+_NAME_RE = re.compile(r'\w+')
+
+
+def define_pattern(pure_macro_name: str) -> str:
+    """宏定义模式：#define MACRO_NAME ..."""
+    return rf'^\s*#\s*define\s+{re.escape(pure_macro_name)}\b'
+
+
+def format_define_line(define_line: str) -> Optional[str]:
+    """规范化单行 #define（不含续行）：#define NAME[(params)] body"""
+    match = _DEFINE_RE.match(define_line)
+    if not match:
+        return None
+    macro_name, params, body = match.groups()
+    if params:
+        return f"#define {macro_name}{params} {body}".strip()
+    return f"#define {macro_name} {body}".strip()
+
+
+@dataclass(frozen=True)
+class MacroDefinition:
+    """一个 #define（多行宏包含全部续行）"""
+    name: str
+    params: Optional[str]         # '(a, b)'；对象宏为 None
+    body: str                     # 去掉续行符后的主体
+    lines: Tuple[str, ...]        # 原始行（含行末续行符）
+    file: Path
+    line: int
+
+    @classmethod
+    def from_lines(cls, lines: List[str], file: Path, line: int) -> Optional['MacroDefinition']:
+        if not lines:
+            return None
+        match = _DEFINE_RE.match(lines[0])
+        if not match:
+            return None
+        name, params, _ = match.groups()
+        joined = '\n'.join(_strip_continuation(text) for text in lines)
+        body_match = re.match(r'^\s*#\s*define\s+\w+(?:\([^)]*\))?\s*(.*)$', joined, re.DOTALL)
+        body = body_match.group(1) if body_match else ''
+        return cls(name=name, params=params, body=body, lines=tuple(lines), file=file, line=line)
+
+    @property
+    def is_multiline(self) -> bool:
+        return len(self.lines) > 1
+
+    def definition(self) -> str:
+        """完整定义文本：单行宏规范化空白，多行宏逐行去掉续行符"""
+        if self.is_multiline:
+            return '\n'.join(_strip_continuation(text) for text in self.lines)
+        return format_define_line(self.lines[0]) or self.lines[0].strip()
+
+
+def _strip_continuation(text: str) -> str:
+    text = text.rstrip()
+    if text.endswith('\\'):
+        text = text[:-1].rstrip()
+    return text
+
+
+def _read_macro_lines(path: Path, start_line: int) -> List[str]:
+    """从文件中读取 start_line 开始的宏（直到不以 \\ 结尾的行）"""
+    try:
+        with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+            lines = f.readlines()
+    except OSError as e:
+        logger.warning(f"[宏表] 读取失败 {path}: {e}")
+        return []
+
+    macro_lines = []
+    for i in range(start_line - 1, len(lines)):
+        text = lines[i].rstrip('\n\r')
+        macro_lines.append(text)
+        if not text.rstrip().endswith('\\'):
+            break
+    return macro_lines
+
+
+class MacroTable:
+    """一个项目根目录的宏表（线程安全）"""
+
+    def __init__(self, project_root):
+        self.project_root = project_root
+        self._macros: Dict[str, Optional[MacroDefinition]] = {}  # 未找到的宏记为 None
+        self._by_location: Dict[Tuple[str, int], MacroDefinition] = {}
+        self._complete = False  # 整表已从定义索引建好：表中没有的名字就是没有定义
+        self._grep_searcher: Optional[GrepSearcher] = None
+        self._lock = threading.Lock()
+        self._build_from_index()
+
+    @traced('macro_table.build', 'extract')
+    def _build_from_index(self):
+        index, scope = get_definition_index(self.project_root)
+        if index is None:
+            return
+
+        continuation_lines = 0
+        for name, definitions in index.definitions_of_kind(KIND_MACRO, scope).items():
+            for position, definition in enumerate(definitions):
+                lines = definition.body.split('\n') if definition.body else [definition.text]
+                continuation_lines += len(lines) - 1
+                macro = MacroDefinition.from_lines(lines, index.path_of(definition), definition.line)
+                if macro is None:
+                    continue
+                self._by_location[(os.path.normcase(str(macro.file)), macro.line)] = macro
+                if position == 0:
+                    self._macros[name] = macro
+        self._complete = True
+        logger.info(f"[宏表] {len(self._macros)} 个宏（{continuation_lines} 行续行）")
+
+    def get(self, name: str) -> Optional[MacroDefinition]:
+        """按名字取宏定义（同名多处定义时取第一个，顺序与搜索结果一致）"""
+        macro = self._macros.get(name)
+        if macro is not None or name in self._macros:
+            count('cache.macro.hit')
+            return macro
+        if self._complete and _NAME_RE.fullmatch(name):
+            count('cache.macro.hit')
+            return None
+
+        count('cache.macro.miss')
+        with self._lock:
+            if name not in self._macros:
+                self._macros[name] = self._search(name)
+            return self._macros[name]
+
+    def prefetch(self, names: Iterable[str]):
+        """批量查找尚未在表中的宏（整表已建好时无事可做）"""
+        names = sorted({name for name in names if name and name not in self._macros})
+        if self._complete:
+            names = [name for name in names if not _NAME_RE.fullmatch(name)]
+        if not names:
+            return
+
+        logger.info(f"[宏表] 批量搜索 {len(names)} 个宏")
+        try:
+            batch = self._searcher().search_definitions_batch(
+                {name: define_pattern(name) for name in names},
+                kinds=(KIND_MACRO,),
+                file_glob='*',  # 搜索所有文件
+                max_results_per_name=5
+            )
+        except Exception as e:
+            logger.error(f"[宏表] 批量搜索宏定义失败: {e}")
+            return
+
+        with self._lock:
+            for name in names:
+                if name not in self._macros:
+                    self._macros[name] = self._from_results(name, batch.get(name))
+
+    def at(self, file_path, line: int) -> Optional[MacroDefinition]:
+        """搜索结果中某一行（文件, 行号）开始的宏；表中没有时返回 None"""
+        return self._by_location.get((os.path.normcase(str(file_path)), int(line)))
+
+    def _searcher(self) -> GrepSearcher:
+        if self._grep_searcher is None:
+            self._grep_searcher = GrepSearcher(project_root=self.project_root)
+        return self._grep_searcher
+
+    def _search(self, name: str) -> Optional[MacroDefinition]:
+        logger.info(f"[宏表] 搜索宏: {name}")
+        try:
+            results = self._searcher().search_definitions(
+                name,
+                kinds=(KIND_MACRO,),
+                pattern=define_pattern(name),
+                file_glob='*',  # 搜索所有文件
+                max_results=5
+            )
+        except Exception as e:
+            logger.error(f"[宏表] 搜索宏定义失败: {e}")
+            return None
+        return self._from_results(name, results)
+
+    def _from_results(self, name: str, results) -> Optional[MacroDefinition]:
+        """从搜索结果（取第一个匹配）建立宏定义，多行宏读取一次续行"""
+        if not results or not isinstance(results, list):
+            logger.info(f"[宏表] 未找到宏定义: {name}")
+            return None
+
+        file_path, line_num, content = results[0]
+        path = Path(file_path)
+        if not path.is_absolute():
+            path = Path(self.project_root) / path
+        macro = self.at(path, line_num)
+        if macro is None:
+            lines = [content]
+            if content.rstrip().endswith('\\'):
+                lines = _read_macro_lines(path, int(line_num)) or lines
+            macro = MacroDefinition.from_lines(lines, path, int(line_num))
+            if macro is not None:
+                self._by_location[(os.path.normcase(str(path)), macro.line)] = macro
+        if macro is not None:
+            logger.info(f"[宏表] 找到宏定义: {name} ({path}:{line_num})")
+        return macro
+
+
+class MacroExpander:
+    """结构体成员宏的展开（结果按宏名和定义文本缓存）"""
+
+    def __init__(self, table: MacroTable):
+        self.table = table
+        # 宏名 -> (成员行, 展开中用到的宏)；不是成员宏记为 None
+        self._members: Dict[str, Optional[Tuple[Tuple[str, ...], Tuple[str, ...]]]] = {}
+        # 定义文本 -> (展开结果, 展开中用到的宏)
+        self._expanded: Dict[str, Tuple[str, Tuple[str, ...]]] = {}
+        self._lock = threading.Lock()
+
+    def struct_macro(self, macro_name: str) -> Optional[str]:
+        """成员宏展开后的成员定义（多行，续行缩进 4 格）；不是对象宏或未找到时返回 None"""
+        expansion, _ = self._struct_members(macro_name, set())
+        if expansion is None:
+            return None
+        return '\n    '.join(expansion[0])
+
+    def expand_definition(self, definition: str) -> str:
+        """展开数据结构定义中独占一行的成员宏（保留原缩进和行尾注释）"""
+        return self._expand_definition(definition)[0]
+
+    def expanded_macros(self, definition: str) -> Set[str]:
+        """展开 definition 时用到的全部宏（含嵌套）"""
+        return set(self._expand_definition(definition)[1])
+
+    def _expand_definition(self, definition: str) -> Tuple[str, Tuple[str, ...]]:
+        cached = self._expanded.get(definition)
+        if cached is not None:
+            count('cache.macro_expansion.hit')
+            return cached
+        count('cache.macro_expansion.miss')
+
+        result_lines = []
+        used: List[str] = []
+        for line in definition.split('\n'):
+            match = _MEMBER_MACRO_RE.match(line.strip())
+            expansion = None
+            if match:
+                expansion, _ = self._struct_members(match.group(2), set())
+            if expansion is None:
+                # 普通行，或未找到展开：保留原行
+                result_lines.append(line)
+                continue
+
+            indent = _INDENT_RE.match(line).group(1)  # 保留原缩进
+            macro_name = match.group(2)
+            comment = match.group(3) or ''  # 保留注释
+            members, uses = expansion
+            used.extend(uses)
+            result_lines.append(f"{indent}/* {macro_name} 展开: */")
+            for exp_line in '\n    '.join(members).split('\n'):
+                result_lines.append(f"{indent}{exp_line}")
+            if comment:
+                result_lines.append(f"{indent}{comment}")
+            logger.info(f"[宏展开] ✓ {macro_name}: 已展开到结构体定义中")
+
+        cached = ('\n'.join(result_lines), tuple(dict.fromkeys(used)))
+        with self._lock:
+            self._expanded[definition] = cached
+        return cached
+
+    def _struct_members(self, macro_name: str, active: Set[str]
+                        ) -> Tuple[Optional[Tuple[Tuple[str, ...], Tuple[str, ...]]], bool]:
+        """
+        成员宏的成员行（嵌套的成员宏就地展开为同一层的成员行）
+
+        Args:
+            active: 正在展开的宏（展开链），再次遇到即为循环引用
+
+        Returns:
+            ((成员行, 用到的宏) 或 None, 结果是否受循环引用影响——此时不缓存)
+        """
+        if macro_name in active:
+            logger.debug(f"[宏展开] 循环引用: {macro_name}")
+            return None, True
+        if macro_name in self._members:
+            return self._members[macro_name], False
+
+        macro = self.table.get(macro_name)
+        body_match = _OBJECT_BODY_RE.match(macro.definition()) if macro is not None else None
+        lines = []
+        if body_match is not None:
+            # 去掉续行符，逐行清理空白
+            body = body_match.group(1).replace('\\\n', '\n').replace('\\', '')
+            lines = [line.strip() for line in body.split('\n') if line.strip()]
+        if not lines:
+            logger.debug(f"[宏展开] ✗ {macro_name}: 未找到定义")
+            with self._lock:
+                self._members[macro_name] = None
+            return None, False
+
+        members: List[str] = []
+        used = [macro_name]
+        cyclic = False
+        active.add(macro_name)
+        try:
+            for line in lines:
+                match = _MEMBER_MACRO_RE.match(line)
+                nested = None
+                if match:
+                    nested, nested_cyclic = self._struct_members(match.group(2), active)
+                    cyclic = cyclic or nested_cyclic
+                if nested is None:
+                    members.append(line)
+                    continue
+                members.append(f"/* {match.group(2)} 展开: */")
+                members.extend(nested[0])
+                used.extend(nested[1])
+                if match.group(3):
+                    members.append(match.group(3))
+        finally:
+            active.discard(macro_name)
+
+        expansion = (tuple(members), tuple(dict.fromkeys(used)))
+        if not cyclic:
+            with self._lock:
+                self._members[macro_name] = expansion
+        return expansion, cyclic
+
+
+# 进程级共享：规范化的项目根目录 -> (宏表, 展开器)
+_tables: Dict[str, Tuple[MacroTable, MacroExpander]] = {}
+_tables_lock = threading.Lock()
+
+
+def _shared(project_root) -> Tuple[MacroTable, MacroExpander]:
+    key = os.path.normcase(str(Path(project_root).resolve()))
+    shared = _tables.get(key)
+    if shared is None:
+        with _tables_lock:
+            shared = _tables.get(key)
+            if shared is None:
+                table = MacroTable(project_root)
+                shared = (table, MacroExpander(table))
+                _tables[key] = shared
+    return shared
+
+
+def get_macro_table(project_root) -> MacroTable:
+    """项目的宏表（首次调用时建立）"""
+    return _shared(project_root)[0]
+
+
+def get_macro_expander(project_root) -> MacroExpander:
+    """项目的成员宏展开器（与宏表一起建立）"""
+    return _shared(project_root)[1]
+
+
+def clear_macro_tables():
+    """丢弃进程内的宏表和展开缓存（文件变化或切换索引设置后调用）"""
+    with _tables_lock:
+        _tables.clear()
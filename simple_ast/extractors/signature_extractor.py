@@ -5,8 +5,10 @@
 """
 import re
 import sys
-from typing import Optional
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
 from ..searchers import HeaderSearcher
+from ..logger import count, traced
 
 
 class SignatureExtractor:
@@ -14,6 +16,10 @@ class SignatureExtractor:
 
     def __init__(self, header_searcher: Optional[HeaderSearcher] = None):
         self.header_searcher = header_searcher or HeaderSearcher()
+        # 同一个报告生成器内反复查找同一批头文件，缓存查找结果和文件内容
+        self._cache: Dict[Tuple[str, str], Optional[str]] = {}
+        self._headers: Dict[str, List[Path]] = {}
+        self._header_lines: Dict[Path, Optional[List[str]]] = {}
 
     def extract(self, func_name: str, target_file: str) -> Optional[str]:
         """
@@ -26,15 +32,38 @@ class SignatureExtractor:
         Returns:
             函数签名，未找到返回 None
         """
-        possible_headers = self.header_searcher.find_headers(target_file)
+        key = (func_name, target_file)
+        if key in self._cache:
+            count('cache.signature.hit')
+        else:
+            count('cache.signature.miss')
+            self._cache[key] = self._extract_uncached(func_name, target_file)
+        return self._cache[key]
 
-        for header_file in possible_headers:
+    def _get_header_lines(self, header_file: Path) -> Optional[List[str]]:
+        """读取头文件（按行，缓存）"""
+        if header_file not in self._header_lines:
             try:
                 with open(header_file, 'r', encoding='utf-8', errors='ignore') as f:
-                    content = f.read()
+                    self._header_lines[header_file] = f.read().split('\n')
+            except Exception:
+                self._header_lines[header_file] = None
+        return self._header_lines[header_file]
+
+    @traced('extract.signature', 'extract')
+    def _extract_uncached(self, func_name: str, target_file: str) -> Optional[str]:
+        """在候选头文件中逐行查找函数声明"""
+        if target_file not in self._headers:
+            self._headers[target_file] = self.header_searcher.find_headers(target_file)
+        possible_headers = self._headers[target_file]
+
+        for header_file in possible_headers:
+            try:
+                lines = self._get_header_lines(header_file)
+                if lines is None:
+                    continue
 
                 # 搜索函数声明（支持多行）
-                lines = content.split('\n')
                 for i, line in enumerate(lines):
                     if func_name in line and '(' in line:
                         # 可能是函数声明
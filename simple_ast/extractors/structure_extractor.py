@@ -7,8 +7,9 @@
 """
 import re
 import sys
-from typing import Optional
+from typing import Dict, Iterable, Optional, Tuple
 from pathlib import Path
+from ..logger import count, traced
 
 
 class StructureExtractor:
@@ -20,14 +21,28 @@ class StructureExtractor:
             project_root: 项目根目录，用于全局搜索
         """
         self.project_root = project_root
+        # 已提取的定义 {(名字, 目标文件): 定义 或 None}
+        self._cache: Dict[Tuple[str, str], Optional[str]] = {}
+        # 预取的全局搜索结果 {名字: 定义 或 None}
+        self._global_results: Dict[str, Optional[str]] = {}
+
+    @traced('extract.structures.prefetch', 'extract')
+    def prefetch(self, struct_names: Iterable[str], target_file: str):
+        """批量全局搜索多个数据结构（一次搜索代替逐个搜索）"""
+        self._infer_project_root(target_file)
+        names = [name for name in struct_names
+                 if name not in self._global_results and (name, target_file) not in self._cache]
+        if not names:
+            return
+        try:
+            from ..searchers import StructureSearcher
+            self._global_results.update(StructureSearcher(self.project_root).search_many(names))
+        except Exception:
+            pass
 
     def extract(self, struct_name: str, target_file: str) -> Optional[str]:
         """
-        尝试从头文件中读取外部数据结构的定义
-
-        策略：
-        1. 优先使用 StructureSearcher 全局搜索（准确性优先）
-        2. 降级到 HeaderSearcher 路径搜索（兼容性）
+        尝试从头文件中读取外部数据结构的定义（结果按名字缓存）
 
         Args:
             struct_name: 数据结构名称
@@ -36,7 +51,16 @@ class StructureExtractor:
         Returns:
             数据结构定义，未找到返回 None
         """
-        # 推断项目根目录
+        key = (struct_name, target_file)
+        if key in self._cache:
+            count('cache.structure.hit')
+        else:
+            count('cache.structure.miss')
+            self._cache[key] = self._extract_uncached(struct_name, target_file)
+        return self._cache[key]
+
+    def _infer_project_root(self, target_file: str):
+        """未指定项目根目录时从 target_file 推断"""
         if not self.project_root:
             # 从 target_file 向上查找，找到包含 .git 或合理的项目根
             target_path = Path(target_file)
@@ -46,23 +70,47 @@ class StructureExtractor:
             else:
                 self.project_root = "."
 
-        # 尝试使用 StructureSearcher 全局搜索
-        try:
-            from ..searchers import StructureSearcher
+    @traced('extract.structure', 'extract')
+    def _extract_uncached(self, struct_name: str, target_file: str) -> Optional[str]:
+        """
+        尝试从头文件中读取外部数据结构的定义
 
-            searcher = StructureSearcher(self.project_root)
-            result = searcher.search(struct_name)
+        策略：
+        1. 优先使用 StructureSearcher 全局搜索（准确性优先）
+        2. 降级到 HeaderSearcher 路径搜索（兼容性）
+
+        Args:
+            struct_name: 数据结构名称
+            target_file: 目标文件路径（用于推断项目根目录）
+
+        Returns:
+            数据结构定义，未找到返回 None
+        """
+        # 推断项目根目录
+        self._infer_project_root(target_file)
+
+        # 尝试使用 StructureSearcher 全局搜索（已预取的直接使用）
+        if struct_name in self._global_results:
+            result = self._global_results[struct_name]
             if result:
                 return result
-        except Exception as e:
-            # 如果全局搜索失败，降级到旧方法
-            pass
+        else:
+            try:
+                from ..searchers import StructureSearcher
+
+                searcher = StructureSearcher(self.project_root)
+                result = searcher.search(struct_name)
+                if result:
+                    return result
+            except Exception as e:
+                # 如果全局搜索失败，降级到旧方法
+                pass
 
         # 降级：使用 HeaderSearcher 路径搜索（保持兼容性）
         try:
             from ..searchers import HeaderSearcher
 
-            header_searcher = HeaderSearcher()
+            header_searcher = HeaderSearcher(project_root=self.project_root)
             possible_headers = header_searcher.find_headers(target_file)
 
             for header_file in possible_headers:
@@ -8,8 +8,8 @@
 """
 from typing import Dict, List, Set, Optional, Tuple
 from pathlib import Path
-from ..cpp_parser import CppParser
-from ..logger import get_logger
+from ..cpp_parser import CppParser, ParsedFile
+from ..logger import count, get_logger, traced
 
 logger = get_logger()
 
@@ -21,6 +21,7 @@ class TypeCastExtractor:
         """初始化提取器"""
         self.parser = CppParser()
 
+    @traced('extract.type_casts', 'extract')
     def extract_from_function(
         self,
         file_path: str,
@@ -57,31 +58,20 @@ class TypeCastExtractor:
                 }
             }
         """
-        # 读取源代码
+        # 解析AST（未提供源代码时复用进程级解析缓存）
         if source_code is None:
-            try:
-                with open(file_path, 'rb') as f:
-                    source_code = f.read()
-            except Exception as e:
-                logger.error(f"[类型转换提取] 无法读取文件: {file_path}, {e}")
-                return {'casts': [], 'usage': {}}
-
-        # 解析AST
-        tree = self.parser.parser.parse(source_code)
-        if not tree:
+            parsed = self.parser.get_parsed_file(file_path)
+        else:
+            count('parser.parse')
+            tree = self.parser.parser.parse(source_code)
+            parsed = ParsedFile(path=str(file_path), source_code=source_code, tree=tree) if tree else None
+        if not parsed:
             logger.error(f"[类型转换提取] 解析失败: {file_path}")
             return {'casts': [], 'usage': {}}
+        source_code = parsed.source_code
 
         # 查找目标函数
-        func_defs = CppParser.find_nodes_by_type(tree.root_node, 'function_definition')
-        target_func_node = None
-
-        for func_def in func_defs:
-            name = CppParser.get_function_name(func_def, source_code)
-            if name == function_name:
-                target_func_node = func_def
-                break
-
+        target_func_node = parsed.find_function(function_name)
         if not target_func_node:
             logger.info(f"[类型转换提取] 未找到函数: {function_name}")
             return {'casts': [], 'usage': {}}
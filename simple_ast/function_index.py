@@ -0,0 +1,129 @@
+"""
+文件级函数定义索引 - 一次遍历建立 函数名 -> 定义信息 的映射
+
+替代各模块中重复的 find_nodes_by_type('function_definition') + 线性名字比较，
+按名字查找为 O(1)。
+"""
+from dataclasses import dataclass, field
+from typing import Dict, Iterator, List, Optional
+
+from tree_sitter import Node
+
+from .cpp_parser import CppParser
+from .queries import find_nodes_in_order
+
+
+@dataclass
+class CallSite:
+    """函数体内的一次调用"""
+    node: Optional[Node]  # call_expression 节点（由边界快照重建的调用点为 None）
+    callee_text: str    # function 字段的原始文本，如 foo / obj->Send / ns::Bar
+    line: int           # 调用所在行（从1开始）
+
+    @property
+    def name(self) -> str:
+        """被调用函数名（成员调用取方法名，与边界分析的规则一致）"""
+        return callee_name(self.callee_text)
+
+
+def callee_name(callee_text: str) -> str:
+    """调用表达式 function 字段文本 -> 被调用函数名（obj->Send / obj.Send 取 Send）"""
+    called = callee_text
+    if '.' in called or '->' in called:
+        parts = called.replace('->', '.').split('.')
+        if len(parts) >= 2:
+            called = parts[-1]
+    return called
+
+
+@dataclass
+class FunctionDefinition:
+    """单个函数定义"""
+    name: str
+    node: Node
+    start_byte: int
+    end_byte: int
+    line: int           # 起始行（从1开始）
+    end_line: int       # 结束行（从1开始）
+    signature: str
+    is_static: bool
+    call_sites: List[CallSite] = field(default_factory=list)
+
+
+class FunctionIndex:
+    """单个文件的函数定义索引（一次遍历构建）"""
+
+    def __init__(self, root_node: Node, source_code: bytes):
+        self.source_code = source_code
+        self.definitions: List[FunctionDefinition] = []   # 按出现顺序
+        self.all_call_sites: List[CallSite] = []          # 整个文件的调用点
+        self._by_name: Dict[str, FunctionDefinition] = {}
+        self._build(root_node)
+
+    def _build(self, root_node: Node):
+        """一次查询取出函数定义和调用点，按先序归属到所在的函数"""
+        source_code = self.source_code
+        open_defs: List[FunctionDefinition] = []  # 当前所在的（可能嵌套的）函数定义
+
+        for node_type, node in find_nodes_in_order(root_node, ('function_definition', 'call_expression')):
+            # 离开已结束的函数定义
+            while open_defs and node.start_byte >= open_defs[-1].end_byte:
+                open_defs.pop()
+
+            if node_type == 'function_definition':
+                func_def = FunctionDefinition(
+                    name=CppParser.get_function_name(node, source_code),
+                    node=node,
+                    start_byte=node.start_byte,
+                    end_byte=node.end_byte,
+                    line=node.start_point[0] + 1,
+                    end_line=node.end_point[0] + 1,
+                    signature=CppParser.get_function_signature(node, source_code),
+                    is_static=self.is_static_function(node, source_code)
+                )
+                self.definitions.append(func_def)
+                if func_def.name and func_def.name not in self._by_name:
+                    self._by_name[func_def.name] = func_def
+                open_defs.append(func_def)
+
+            else:
+                func_expr = node.child_by_field_name('function')
+                call_site = CallSite(
+                    node=node,
+                    callee_text=CppParser.get_node_text(func_expr, source_code) if func_expr else '',
+                    line=node.start_point[0] + 1
+                )
+                self.all_call_sites.append(call_site)
+                # 与 find_nodes_by_type(func_node, ...) 一致：嵌套定义中的调用也算外层的
+                for func_def in open_defs:
+                    func_def.call_sites.append(call_site)
+
+    @staticmethod
+    def is_static_function(func_node: Node, source_code: bytes) -> bool:
+        """检查函数定义是否带 static 存储类说明符"""
+        for child in func_node.children:
+            if child.type == 'storage_class_specifier':
+                if CppParser.get_node_text(child, source_code) == 'static':
+                    return True
+        return False
+
+    def get(self, function_name: str) -> Optional[FunctionDefinition]:
+        """按名字查找（同名时返回第一个定义）"""
+        return self._by_name.get(function_name)
+
+    def __contains__(self, function_name: str) -> bool:
+        return function_name in self._by_name
+
+    def __iter__(self) -> Iterator[FunctionDefinition]:
+        return iter(self.definitions)
+
+    def __len__(self) -> int:
+        return len(self.definitions)
+
+    def names(self) -> List[str]:
+        return list(self._by_name.keys())
+
+    def definitions_in_lines(self, start_line: int, end_line: int) -> List[FunctionDefinition]:
+        """与行区间 [start_line, end_line]（从1开始，含两端）有重叠的函数定义"""
+        return [func_def for func_def in self.definitions
+                if func_def.line <= end_line and func_def.end_line >= start_line]
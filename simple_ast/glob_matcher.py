@@ -0,0 +1,93 @@
+"""
+组合通配符匹配器 - 把一组 fnmatch 模式编译成一次匹配
+
+- 不含通配符的模式：集合查找
+- 只有结尾一个 * 的模式（如 memset*、std::*）：前缀字典树，按名字逐字符走一遍
+- 其余模式（*LOG*、OFFSET_?? 等）：fnmatch.translate 后合并成一个正则
+
+结果与逐个 fnmatch.fnmatch(name, pattern) 相同（包括按 os.path.normcase 处理大小写），
+但匹配代价与模式数量基本无关。
+"""
+import fnmatch
+import os
+import re
+import threading
+from typing import Dict, Iterable, Optional, Tuple
+
+_MAGIC_CHARS = frozenset('*?[')
+_TERMINAL = ''  # 字典树中标记“到此为止的前缀是一个模式”的键（不会与单个字符冲突）
+
+
+class GlobMatcher:
+    """一组通配符模式的组合匹配器（只读，可在线程间共享）"""
+
+    __slots__ = ('patterns', '_literals', '_prefix_trie', '_regex')
+
+    def __init__(self, patterns: Iterable[str]):
+        self.patterns: Tuple[str, ...] = tuple(patterns)
+        self._literals = set()
+        self._prefix_trie: Dict[str, dict] = {}
+        wildcard = []
+
+        for pattern in self.patterns:
+            normalized = os.path.normcase(pattern)
+            head = normalized[:-1]
+            if not _MAGIC_CHARS.intersection(normalized):
+                self._literals.add(normalized)
+            elif normalized.endswith('*') and not _MAGIC_CHARS.intersection(head):
+                self._add_prefix(head)
+            else:
+                wildcard.append(fnmatch.translate(normalized))
+
+        self._regex = re.compile('|'.join(f'(?:{p})' for p in wildcard)) if wildcard else None
+
+    def _add_prefix(self, prefix: str):
+        node = self._prefix_trie
+        for char in prefix:
+            node = node.setdefault(char, {})
+        node[_TERMINAL] = {}
+
+    def _matches_prefix(self, name: str) -> bool:
+        node = self._prefix_trie
+        if _TERMINAL in node:
+            return True
+        for char in name:
+            node = node.get(char)
+            if node is None:
+                return False
+            if _TERMINAL in node:
+                return True
+        return False
+
+    def matches(self, name: str) -> bool:
+        """name 是否匹配任一模式"""
+        name = os.path.normcase(name)
+        if name in self._literals:
+            return True
+        if self._prefix_trie and self._matches_prefix(name):
+            return True
+        return self._regex is not None and self._regex.match(name) is not None
+
+    def __bool__(self) -> bool:
+        return bool(self.patterns)
+
+    def __len__(self) -> int:
+        return len(self.patterns)
+
+
+# 进程内按模式列表共享已编译的匹配器
+_matchers: Dict[Tuple[str, ...], GlobMatcher] = {}
+_matchers_lock = threading.Lock()
+
+
+def get_glob_matcher(patterns: Iterable[str]) -> GlobMatcher:
+    """获取（首次调用时编译）一组模式的匹配器"""
+    key = tuple(patterns)
+    matcher: Optional[GlobMatcher] = _matchers.get(key)
+    if matcher is None:
+        with _matchers_lock:
+            matcher = _matchers.get(key)
+            if matcher is None:
+                matcher = GlobMatcher(key)
+                _matchers[key] = matcher
+    return matcher
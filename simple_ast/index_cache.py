@@ -0,0 +1,123 @@
+"""
+On-disk cache for per-file index results.
+
+Each entry is keyed by the file's project-relative path and validated by
+(mtime, size); when those changed, a content hash decides whether the file
+really needs re-parsing (e.g. after a `git checkout` that only touched mtimes).
+"""
+import hashlib
+import os
+import pickle
+from pathlib import Path
+from typing import Any, Dict, Optional, Set, Tuple
+
+from .logger import count
+
+# Directory (under the project root) holding all SimpleAST cache files
+CACHE_DIR_NAME = '.simple_ast_cache'
+
+
+def content_hash(data: bytes) -> str:
+    """Hash used to detect real content changes."""
+    return hashlib.sha1(data).hexdigest()
+
+
+def default_cache_dir(project_root) -> Path:
+    """Default cache directory for a project."""
+    return Path(project_root) / CACHE_DIR_NAME
+
+
+class IndexCache:
+    """Per-file result cache persisted as one pickle file."""
+
+    def __init__(self, cache_file: Path, version: int):
+        """
+        Args:
+            cache_file: Path of the pickle file
+            version: Format version; a mismatch discards the whole cache
+        """
+        self.cache_file = Path(cache_file)
+        self.version = version
+        # rel_path -> (mtime_ns, size, content_hash, entry)
+        self._entries: Dict[str, Tuple[int, int, str, Any]] = {}
+        self._dirty = False
+
+    def load(self) -> int:
+        """Load the cache file. Returns the number of cached entries."""
+        if not self.cache_file.exists():
+            return 0
+        try:
+            with open(self.cache_file, 'rb') as f:
+                data = pickle.load(f)
+            if data.get('version') != self.version:
+                print(f"Index cache version changed, rebuilding: {self.cache_file}")
+                return 0
+            self._entries = data.get('entries', {})
+        except Exception as e:
+            print(f"Warning: Could not load index cache {self.cache_file}: {e}")
+            self._entries = {}
+        return len(self._entries)
+
+    def lookup(self, rel_path: str, file_path: Path, stat: os.stat_result) -> Optional[Any]:
+        """
+        Return the cached entry if the file is unchanged, otherwise None.
+
+        A (mtime, size) match is trusted as-is; otherwise the content hash is
+        compared so that touched-but-identical files are not re-parsed.
+        """
+        entry = self._lookup(rel_path, file_path, stat)
+        count('index_cache.miss' if entry is None else 'index_cache.hit')
+        return entry
+
+    def _lookup(self, rel_path: str, file_path: Path, stat: os.stat_result) -> Optional[Any]:
+        cached = self._entries.get(rel_path)
+        if cached is None:
+            return None
+
+        mtime_ns, size, digest, entry = cached
+        if mtime_ns == stat.st_mtime_ns and size == stat.st_size:
+            return entry
+
+        if size != stat.st_size:
+            return None
+
+        try:
+            with open(file_path, 'rb') as f:
+                current = content_hash(f.read())
+        except OSError:
+            return None
+
+        if current != digest:
+            return None
+
+        # Same content, only the mtime moved: refresh the key
+        self._entries[rel_path] = (stat.st_mtime_ns, stat.st_size, digest, entry)
+        self._dirty = True
+        return entry
+
+    def store(self, rel_path: str, stat: os.stat_result, digest: str, entry: Any):
+        """Record a freshly indexed entry."""
+        self._entries[rel_path] = (stat.st_mtime_ns, stat.st_size, digest, entry)
+        self._dirty = True
+
+    def save(self, live_paths: Set[str]):
+        """Drop entries for deleted files and write the cache if anything changed."""
+        stale = [path for path in self._entries if path not in live_paths]
+        for path in stale:
+            del self._entries[path]
+        if stale:
+            self._dirty = True
+
+        if not self._dirty:
+            return
+
+        try:
+            self.cache_file.parent.mkdir(parents=True, exist_ok=True)
+            tmp_file = self.cache_file.with_suffix(self.cache_file.suffix + '.tmp')
+            with open(tmp_file, 'wb') as f:
+                pickle.dump({'version': self.version, 'entries': self._entries},
+                            f, protocol=pickle.HIGHEST_PROTOCOL)
+            os.replace(tmp_file, self.cache_file)
+            self._dirty = False
+        except Exception as e:
+            print(f"Warning: Could not write index cache {self.cache_file}: {e}")
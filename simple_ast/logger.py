@@ -1,9 +1,16 @@
 """
 日志配置模块
 
-统一管理项目的日志输出，将日志写入文件而不是控制台
+统一管理项目的日志输出，将日志写入文件而不是控制台；
+另提供轻量的性能埋点（span / 计数器），可导出 Chrome trace JSON
 """
+import json
 import logging
+import os
+import threading
+import time
+from collections import defaultdict
+from functools import wraps
 from pathlib import Path
 from datetime import datetime
 
@@ -71,3 +78,165 @@ def get_logger() -> logging.Logger:
     if _default_logger is None:
         _default_logger = setup_logger()
     return _default_logger
+
+
+# ==================== 性能埋点（span / 计数器） ====================
+#
+# 默认关闭，关闭时 span() 返回共享的空上下文，count() 直接返回，热路径几乎无开销。
+# enable_profiling() 后记录：
+#   - span：各阶段耗时（按名字汇总，同时保留事件用于导出 Chrome trace）
+#   - 计数器：子进程启动次数、解析次数、缓存命中/未命中等
+# 导出的 trace JSON 可直接用 chrome://tracing 或 https://ui.perfetto.dev 打开。
+# 只记录当前进程；--jobs 启动的工作进程里的埋点不会汇总回来。
+
+_profiling_enabled = False
+_profile_lock = threading.Lock()
+_profile_start = time.perf_counter()
+_trace_events = []                                   # Chrome trace 的完整事件（ph = 'X'）
+_span_totals = defaultdict(lambda: [0, 0.0])         # name -> [次数, 总耗时秒]
+_counters = defaultdict(int)                         # name -> 累计值
+
+
+class _NullSpan:
+    """关闭埋点时使用的空上下文"""
+    __slots__ = ()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        return False
+
+
+_NULL_SPAN = _NullSpan()
+
+
+class _Span:
+    """一次计时区间"""
+    __slots__ = ('name', 'category', 'args', 'start')
+
+    def __init__(self, name: str, category: str, args: dict):
+        self.name = name
+        self.category = category
+        self.args = args
+        self.start = 0.0
+
+    def __enter__(self):
+        self.start = time.perf_counter()
+        return self
+
+    def __exit__(self, *exc):
+        end = time.perf_counter()
+        duration = end - self.start
+        event = {
+            'name': self.name,
+            'cat': self.category,
+            'ph': 'X',
+            'ts': round((self.start - _profile_start) * 1e6, 1),
+            'dur': round(duration * 1e6, 1),
+            'pid': os.getpid(),
+            'tid': threading.get_ident(),
+        }
+        if self.args:
+            event['args'] = self.args
+        with _profile_lock:
+            _trace_events.append(event)
+            totals = _span_totals[self.name]
+            totals[0] += 1
+            totals[1] += duration
+        return False
+
+
+def enable_profiling(enabled: bool = True):
+    """开启/关闭埋点（开启时清空之前的记录）"""
+    global _profiling_enabled, _profile_start
+    reset_profiling()
+    _profile_start = time.perf_counter()
+    _profiling_enabled = enabled
+
+
+def profiling_enabled() -> bool:
+    return _profiling_enabled
+
+
+def reset_profiling():
+    """清空已记录的 span 和计数器"""
+    with _profile_lock:
+        _trace_events.clear()
+        _span_totals.clear()
+        _counters.clear()
+
+
+def span(name: str, category: str = '', **args):
+    """
+    计时区间：with span('boundary.parse', file=path): ...
+
+    Args:
+        name: 区间名（用 模块.阶段 的形式，汇总时按名字聚合）
+        category: Chrome trace 中的分类
+        **args: 附加信息（写入 trace 事件的 args）
+    """
+    if not _profiling_enabled:
+        return _NULL_SPAN
+    return _Span(name, category, args)
+
+
+def traced(name: str, category: str = ''):
+    """把整个函数包成一个 span 的装饰器"""
+    def decorator(func):
+        @wraps(func)
+        def wrapper(*args, **kwargs):
+            if not _profiling_enabled:
+                return func(*args, **kwargs)
+            with _Span(name, category, {}):
+                return func(*args, **kwargs)
+        return wrapper
+    return decorator
+
+
+def count(name: str, value: int = 1):
+    """累加计数器（如 search.subprocess、parser.cache_hit）"""
+    if not _profiling_enabled:
+        return
+    with _profile_lock:
+        _counters[name] += value
+
+
+def get_profile_summary() -> dict:
+    """
+    汇总结果
+
+    Returns:
+        {'spans': {name: {'count', 'total_s'}}, 'counters': {name: value}}
+    """
+    with _profile_lock:
+        spans = {name: {'count': c, 'total_s': round(t, 6)} for name, (c, t) in _span_totals.items()}
+        counters = dict(_counters)
+    return {'spans': spans, 'counters': counters}
+
+
+def format_profile_summary() -> str:
+    """可读的汇总文本（按总耗时排序）"""
+    summary = get_profile_summary()
+    lines = ["阶段耗时:"]
+    for name, info in sorted(summary['spans'].items(), key=lambda item: -item[1]['total_s']):
+        lines.append(f"  {name:<40} {info['total_s']:>10.3f}s  x{info['count']}")
+    if summary['counters']:
+        lines.append("计数器:")
+        for name, value in sorted(summary['counters'].items()):
+            lines.append(f"  {name:<40} {value:>10}")
+    return '\n'.join(lines)
+
+
+def write_chrome_trace(path):
+    """把记录的事件写成 Chrome trace JSON（计数器放在 otherData 中）"""
+    summary = get_profile_summary()
+    with _profile_lock:
+        events = list(_trace_events)
+    trace = {
+        'traceEvents': events,
+        'displayTimeUnit': 'ms',
+        'otherData': {'counters': summary['counters'], 'spans': summary['spans']},
+    }
+    with open(path, 'w', encoding='utf-8') as f:
+        json.dump(trace, f, ensure_ascii=False)
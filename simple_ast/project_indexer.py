@@ -2,15 +2,39 @@
 Project-wide symbol table indexer for C++ files.
 """
 import os
+from concurrent.futures import ProcessPoolExecutor
 from pathlib import Path
-from typing import Dict, List, Set, Optional
-from dataclasses import dataclass
+from typing import Dict, Iterable, List, Mapping, Set, Optional, Tuple
+from dataclasses import dataclass, field
+from .caller_index import CallerIndex, CallerSite, ImpactSet, callee_key
 from .cpp_parser import CppParser
+from .function_index import FunctionIndex
+from .index_cache import IndexCache, CACHE_DIR_NAME, content_hash, default_cache_dir
+from .logger import traced
+from .source_loader import read_source
+from .sqlite_store import DEFAULT_HOT_CACHE_SIZE, SqliteIndexStore, file_unchanged
+from .symbol_store import SymbolStore
+
+# Bump when SymbolInfo / FileIndexEntry layout or extraction rules change
+INDEX_CACHE_VERSION = 4
+
+# 'memory': SymbolStore / CallerIndex in RAM, pickle cache
+# 'sqlite': tables kept in <cache_dir>/symbol_index.sqlite, bounded memory
+STORE_KINDS = ('memory', 'sqlite')
+SQLITE_BATCH_FILES = 1024  # files parsed and written per transaction
 
 
 @dataclass
 class SymbolInfo:
-    """Information about a symbol (function, class, struct, etc.)."""
+    """
+    Information about a symbol (function, class, struct, etc.).
+
+    The project-wide table keeps symbols in a SymbolStore; instances are
+    built on lookup as a view of one row.
+    """
+    __slots__ = ('name', 'type', 'file_path', 'line_number', 'signature',
+                 'is_declaration', 'is_in_header')
+
     name: str
     type: str  # 'function', 'class', 'struct', 'enum', 'typedef'
     file_path: str
@@ -20,26 +44,239 @@ class SymbolInfo:
     is_in_header: bool
 
 
+@dataclass
+class FileIndexEntry:
+    """Symbols, includes and call edges extracted from one file (the unit that gets cached)."""
+    symbols: List[SymbolInfo] = field(default_factory=list)
+    includes: List[str] = field(default_factory=list)
+    calls: List[Tuple[str, str, int]] = field(default_factory=list)  # (callee, caller, line)
+    content_hash: str = ''
+
+
 class ProjectIndexer:
     """Builds and maintains a symbol table for the entire project."""
 
-    def __init__(self, project_root: str):
+    def __init__(self, project_root: str, use_cache: bool = True, cache_dir: Optional[str] = None,
+                 jobs: int = 1, store: str = 'memory', hot_cache_size: int = DEFAULT_HOT_CACHE_SIZE):
+        """
+        Args:
+            project_root: Root directory of the project
+            use_cache: Persist per-file results and only re-parse changed files
+            cache_dir: Cache directory (defaults to <project_root>/.simple_ast_cache)
+            jobs: Number of worker processes used to parse files (1 = serial)
+            store: 'memory' or 'sqlite' (disk-backed tables for very large projects)
+            hot_cache_size: Names whose lookups the sqlite store caches in memory
+        """
+        if store not in STORE_KINDS:
+            raise ValueError(f"Unknown symbol store: {store} (expected one of {', '.join(STORE_KINDS)})")
         self.project_root = Path(project_root).resolve()
         self.parser = CppParser()
-        self.symbol_table: Dict[str, List[SymbolInfo]] = {}
-        self.file_symbols: Dict[str, Set[str]] = {}  # file -> symbols defined
-        self.include_graph: Dict[str, List[str]] = {}  # file -> included files
-
+        self.symbol_table = SymbolStore()  # name -> List[SymbolInfo] (read-only mapping)
+        self.include_graph: Mapping[str, List[str]] = {}  # file -> included files (queried on demand with sqlite)
+        self.caller_index = CallerIndex()  # callee -> call sites (reverse call graph)
+        self.use_cache = use_cache
+        self.cache_dir = Path(cache_dir) if cache_dir else default_cache_dir(self.project_root)
+        self.jobs = max(1, jobs or 1)
+        self.store = store
+        self.hot_cache_size = hot_cache_size
+        self._sqlite: Optional[SqliteIndexStore] = None
+        # Last indexed state, used by refresh(): rel_path -> (mtime_ns, size)
+        self._indexed: Dict[str, tuple] = {}
+
+    @traced('index.project', 'index')
     def index_project(self):
         """Index all C++ files in the project."""
         cpp_files = self._find_cpp_files()
         print(f"Found {len(cpp_files)} C++ files to index...")
+        if self.store == 'sqlite':
+            self._sync_sqlite(cpp_files, fresh=not self.use_cache)
+            print(f"Indexed {len(self.symbol_table)} unique symbols")
+            return
 
-        for file_path in cpp_files:
-            self._index_file(file_path)
+        cache = None
+        if self.use_cache:
+            cache = IndexCache(self.cache_dir / 'symbol_index.pkl', INDEX_CACHE_VERSION)
+            cache.load()
+
+        # Pass 1: pick up unchanged files from the cache
+        rel_paths = []
+        entries: List[Optional[FileIndexEntry]] = []
+        stats = []
+        pending = []  # indexes into cpp_files that need parsing
+        for idx, file_path in enumerate(cpp_files):
+            rel_paths.append(str(file_path.relative_to(self.project_root)))
+            entry = None
+            stat = None
+            try:
+                stat = file_path.stat()
+                if cache is not None:
+                    entry = cache.lookup(rel_paths[idx], file_path, stat)
+            except OSError as e:
+                print(f"Warning: Could not stat {file_path}: {e}")
+            entries.append(entry)
+            stats.append(stat)
+            if entry is None:
+                pending.append(idx)
+
+        # Pass 2: parse the rest, in worker processes when jobs > 1
+        parsed = self._index_files([cpp_files[idx] for idx in pending])
+        for idx, entry in zip(pending, parsed):
+            entries[idx] = entry
+            if cache is not None and entry is not None and stats[idx] is not None:
+                cache.store(rel_paths[idx], stats[idx], entry.content_hash, entry)
+
+        self._indexed = {}
+        for rel_path, stat, entry in zip(rel_paths, stats, entries):
+            if entry is not None and stat is not None:
+                self._indexed[rel_path] = (stat.st_mtime_ns, stat.st_size)
+
+        # Merge in file order so the symbol table does not depend on scheduling
+        self._reset_tables()
+        for rel_path, entry in zip(rel_paths, entries):
+            if entry is not None:
+                self._merge_entry(rel_path, entry)
+
+        if cache is not None:
+            cache.save(set(rel_paths))
+            print(f"Index cache: {len(cpp_files) - len(pending)} files reused, {len(pending)} re-indexed")
 
         print(f"Indexed {len(self.symbol_table)} unique symbols")
 
+    def refresh(self) -> int:
+        """
+        Re-index only files added, changed or removed since the last
+        index_project()/refresh() (for long-running processes).
+
+        Returns:
+            Number of files that changed
+        """
+        cpp_files = self._find_cpp_files()
+        if self.store == 'sqlite':
+            return self._sync_sqlite(cpp_files)
+        current = {}
+        changed = []
+        for file_path in cpp_files:
+            rel_path = str(file_path.relative_to(self.project_root))
+            try:
+                stat = file_path.stat()
+            except OSError:
+                continue
+            key = (stat.st_mtime_ns, stat.st_size)
+            current[rel_path] = key
+            if self._indexed.get(rel_path) != key:
+                changed.append((rel_path, file_path, key))
+
+        removed = [rel_path for rel_path in self._indexed if rel_path not in current]
+        if not changed and not removed:
+            return 0
+
+        for rel_path in removed:
+            del self._indexed[rel_path]
+        parsed = {}
+        for (rel_path, _, key), entry in zip(changed, self._index_files([c[1] for c in changed])):
+            if entry is None:
+                self._indexed.pop(rel_path, None)
+            else:
+                self._indexed[rel_path] = key
+                parsed[rel_path] = entry
+
+        # Rebuild in file order: unchanged files are copied row by row from
+        # the old store, changed files are merged from the fresh entries
+        old_table = self.symbol_table
+        old_includes = self.include_graph
+        old_callers = self.caller_index
+        self._reset_tables()
+        for file_path in cpp_files:
+            rel_path = str(file_path.relative_to(self.project_root))
+            if rel_path in parsed:
+                self._merge_entry(rel_path, parsed[rel_path])
+            elif rel_path in self._indexed:
+                self.symbol_table.copy_file_from(old_table, rel_path)
+                self.include_graph[rel_path] = old_includes.get(rel_path, [])
+                self.caller_index.copy_file_from(old_callers, rel_path)
+
+        print(f"Index refresh: {len(changed)} changed, {len(removed)} removed")
+        return len(changed) + len(removed)
+
+    def _sync_sqlite(self, cpp_files: List[Path], fresh: bool = False) -> int:
+        """
+        Bring the sqlite store in line with the files on disk, in batches:
+        unchanged files only get their walk order updated, the rest are parsed
+        and their rows replaced, files no longer present are deleted.
+
+        Returns:
+            Number of files that changed
+        """
+        if self._sqlite is None or fresh:
+            if self._sqlite is not None:
+                self._sqlite.close()
+            self._sqlite = SqliteIndexStore(self.cache_dir / 'symbol_index.sqlite', INDEX_CACHE_VERSION,
+                                            hot_cache_size=self.hot_cache_size, fresh=fresh)
+        store = self._sqlite
+        store.begin_sync()
+        reused = changed = 0
+        for start in range(0, len(cpp_files), SQLITE_BATCH_FILES):
+            touched = []
+            pending = []  # (rel_path, order, stat, file_path)
+            batch = [(order, file_path, str(file_path.relative_to(self.project_root)))
+                     for order, file_path in enumerate(cpp_files[start:start + SQLITE_BATCH_FILES], start)]
+            known = store.file_states([rel_path for _, _, rel_path in batch])
+            for order, file_path, rel_path in batch:
+                state = known.get(rel_path)
+                try:
+                    stat = file_path.stat()
+                except OSError as e:
+                    print(f"Warning: Could not stat {file_path}: {e}")
+                    if state is not None:
+                        store.remove_file(rel_path)
+                        changed += 1
+                    continue
+                if state is not None and file_unchanged(state, file_path, stat):
+                    touched.append((order, stat.st_mtime_ns, stat.st_size, state.id))
+                else:
+                    pending.append((rel_path, order, stat, file_path))
+
+            store.touch_files(touched)
+            reused += len(touched)
+            for (rel_path, order, stat, _), entry in zip(pending, self._index_files([p[3] for p in pending])):
+                if entry is None:
+                    store.remove_file(rel_path)
+                else:
+                    store.replace_file(rel_path, order, stat, entry)
+            changed += len(pending)
+            store.commit()
+
+        changed += store.remove_unvisited()
+        store.commit()
+
+        self.symbol_table = store.symbols
+        self.caller_index = store.callers
+        self.include_graph = store.include_graph()
+        print(f"Index store: {reused} files reused, {changed} re-indexed or removed ({store.db_path})")
+        return changed
+
+    def _reset_tables(self):
+        self.symbol_table = SymbolStore()
+        self.include_graph = {}
+        self.caller_index = CallerIndex()
+
+    def _index_files(self, file_paths: List[Path]) -> List[Optional[FileIndexEntry]]:
+        """Index files serially or with a process pool. Results keep input order."""
+        jobs = min(self.jobs, len(file_paths))
+        if jobs <= 1:
+            return [self._index_file(file_path) for file_path in file_paths]
+
+        print(f"Indexing {len(file_paths)} files with {jobs} worker processes...")
+        tasks = [(str(self.project_root), str(file_path)) for file_path in file_paths]
+        # Small chunks keep the workers balanced when file sizes vary a lot
+        chunksize = max(1, len(tasks) // (jobs * 8))
+        try:
+            with ProcessPoolExecutor(max_workers=jobs) as executor:
+                return list(executor.map(_index_file_worker, tasks, chunksize=chunksize))
+        except Exception as e:
+            print(f"Warning: Parallel indexing failed ({e}), falling back to serial indexing")
+            return [self._index_file(file_path) for file_path in file_paths]
+
     def _find_cpp_files(self) -> List[Path]:
         """Find all C++ source and header files in project."""
         extensions = {'.cpp', '.cc', '.cxx', '.c', '.h', '.hpp', '.hxx'}
@@ -48,7 +285,8 @@ class ProjectIndexer:
         for root, dirs, files in os.walk(self.project_root):
             # Skip common build/dependency directories
             dirs[:] = [d for d in dirs if d not in {'build', 'cmake-build-debug',
-                                                      'node_modules', '.git', 'venv'}]
+                                                      'node_modules', '.git', 'venv',
+                                                      CACHE_DIR_NAME}]
 
             for file in files:
                 if Path(file).suffix in extensions:
@@ -56,48 +294,44 @@ class ProjectIndexer:
 
         return cpp_files
 
-    def _index_file(self, file_path: Path):
-        """Index symbols in a single file."""
-        # Try multiple encodings
-        source_code = None
-        encodings_to_try = ['utf-8', 'gbk', 'gb2312', 'latin-1', 'cp1252']
-
-        for encoding in encodings_to_try:
-            try:
-                with open(file_path, 'r', encoding=encoding) as f:
-                    f.read()  # Test if encoding works
-                # If successful, read as bytes for tree-sitter
-                with open(file_path, 'rb') as f:
-                    source_code = f.read()
-                break
-            except (UnicodeDecodeError, UnicodeError):
-                continue
-
-        if source_code is None:
-            print(f"Warning: Could not decode {file_path} with any supported encoding")
-            return
+    def _index_file(self, file_path: Path) -> Optional[FileIndexEntry]:
+        """Extract symbols and includes from a single file."""
+        # One read: the same buffer is sniffed for its encoding and parsed
+        source = read_source(file_path)
+        if source is None:
+            return None
+        source_code = source.data
 
+        entry = FileIndexEntry(content_hash=content_hash(source_code))
         try:
-            tree = self.parser.parse_file(str(file_path))
+            tree = self.parser.parse_source(source_code, file_path)
             if not tree:
-                return
+                return None
 
             is_header = file_path.suffix in {'.h', '.hpp', '.hxx'}
             rel_path = str(file_path.relative_to(self.project_root))
 
             # Index includes
-            self._index_includes(tree.root_node, source_code, rel_path)
+            self._index_includes(tree.root_node, source_code, entry)
 
             # Index functions
-            self._index_functions(tree.root_node, source_code, rel_path, is_header)
+            self._index_functions(tree.root_node, source_code, rel_path, is_header, entry)
 
             # Index data structures
-            self._index_data_structures(tree.root_node, source_code, rel_path, is_header)
+            self._index_data_structures(tree.root_node, source_code, rel_path, is_header, entry)
 
         except Exception as e:
             print(f"Error indexing {file_path}: {e}")
 
-    def _index_includes(self, root_node, source_code: bytes, file_path: str):
+        return entry
+
+    def _merge_entry(self, rel_path: str, entry: FileIndexEntry):
+        """Merge one file's results into the project-wide tables."""
+        self.include_graph[rel_path] = entry.includes
+        self.symbol_table.add_file(rel_path, entry.symbols)
+        self.caller_index.add_file(rel_path, entry.calls)
+
+    def _index_includes(self, root_node, source_code: bytes, entry: FileIndexEntry):
         """Index #include directives."""
         includes = []
         preproc_includes = CppParser.find_nodes_by_type(root_node, 'preproc_include')
@@ -112,14 +346,17 @@ class ProjectIndexer:
                 inc_path = CppParser.get_node_text(path_node, source_code).strip('"<>')
                 includes.append(inc_path)
 
-        self.include_graph[file_path] = includes
+        entry.includes = includes
 
-    def _index_functions(self, root_node, source_code: bytes, file_path: str, is_header: bool):
+    def _index_functions(self, root_node, source_code: bytes, file_path: str, is_header: bool,
+                         entry: FileIndexEntry):
         """Index function declarations and definitions."""
-        # Find function definitions
-        func_defs = CppParser.find_nodes_by_type(root_node, 'function_definition')
-        for func_node in func_defs:
-            self._add_function_symbol(func_node, source_code, file_path, is_header, is_declaration=False)
+        # Function definitions come from the one-pass function index
+        function_index = FunctionIndex(root_node, source_code)
+        for func_def in function_index.definitions:
+            self._add_function_symbol(func_def.node, source_code, file_path, is_header, entry,
+                                      is_declaration=False, func_def=func_def)
+        self._index_calls(function_index, entry)
 
         # Find function declarations
         func_decls = CppParser.find_nodes_by_type(root_node, 'declaration')
@@ -127,18 +364,39 @@ class ProjectIndexer:
             # Check if it's a function declaration
             declarator = CppParser.find_child_by_type(decl_node, 'function_declarator')
             if declarator:
-                self._add_function_symbol(decl_node, source_code, file_path, is_header, is_declaration=True)
+                self._add_function_symbol(decl_node, source_code, file_path, is_header, entry,
+                                          is_declaration=True)
+
+    @staticmethod
+    def _index_calls(function_index: FunctionIndex, entry: FileIndexEntry):
+        """Record call edges, each attributed to its innermost enclosing definition."""
+        enclosing = {}
+        # Definitions are in preorder, so a nested definition overwrites its parent
+        for func_def in function_index.definitions:
+            if func_def.name:
+                for call_site in func_def.call_sites:
+                    enclosing[id(call_site)] = (call_site, func_def.name)
+        calls = []
+        for call_site, caller in enclosing.values():
+            callee = callee_key(call_site.callee_text)
+            if callee:
+                calls.append((callee, caller, call_site.line))
+        calls.sort(key=lambda call: call[2])
+        entry.calls = calls
 
     def _add_function_symbol(self, func_node, source_code: bytes, file_path: str,
-                            is_header: bool, is_declaration: bool):
-        """Add a function symbol to the symbol table."""
-        func_name = CppParser.get_function_name(func_node, source_code)
+                            is_header: bool, entry: FileIndexEntry, is_declaration: bool,
+                            func_def=None):
+        """Add a function symbol to the file's index entry."""
+        if func_def is not None:
+            func_name, signature, line_number = func_def.name, func_def.signature, func_def.line
+        else:
+            func_name = CppParser.get_function_name(func_node, source_code)
+            signature = CppParser.get_function_signature(func_node, source_code)
+            line_number = func_node.start_point[0] + 1
         if not func_name:
             return
 
-        signature = CppParser.get_function_signature(func_node, source_code)
-        line_number = func_node.start_point[0] + 1
-
         symbol_info = SymbolInfo(
             name=func_name,
             type='function',
@@ -148,27 +406,21 @@ class ProjectIndexer:
             is_declaration=is_declaration,
             is_in_header=is_header
         )
+        entry.symbols.append(symbol_info)
 
-        if func_name not in self.symbol_table:
-            self.symbol_table[func_name] = []
-        self.symbol_table[func_name].append(symbol_info)
-
-        if file_path not in self.file_symbols:
-            self.file_symbols[file_path] = set()
-        self.file_symbols[file_path].add(func_name)
-
-    def _index_data_structures(self, root_node, source_code: bytes, file_path: str, is_header: bool):
+    def _index_data_structures(self, root_node, source_code: bytes, file_path: str, is_header: bool,
+                               entry: FileIndexEntry):
         """Index struct, class, enum, typedef definitions."""
         structure_types = ['struct_specifier', 'class_specifier', 'enum_specifier', 'type_definition']
 
+        nodes_by_type = CppParser.find_nodes_by_types(root_node, structure_types)
         for struct_type in structure_types:
-            nodes = CppParser.find_nodes_by_type(root_node, struct_type)
-            for node in nodes:
-                self._add_structure_symbol(node, source_code, file_path, is_header, struct_type)
+            for node in nodes_by_type[struct_type]:
+                self._add_structure_symbol(node, source_code, file_path, is_header, struct_type, entry)
 
     def _add_structure_symbol(self, node, source_code: bytes, file_path: str,
-                             is_header: bool, node_type: str):
-        """Add a data structure symbol to the symbol table."""
+                             is_header: bool, node_type: str, entry: FileIndexEntry):
+        """Add a data structure symbol to the file's index entry."""
         # Find the name
         name_node = CppParser.find_child_by_type(node, 'type_identifier')
         if not name_node:
@@ -203,14 +455,7 @@ class ProjectIndexer:
             is_declaration=False,
             is_in_header=is_header
         )
-
-        if struct_name not in self.symbol_table:
-            self.symbol_table[struct_name] = []
-        self.symbol_table[struct_name].append(symbol_info)
-
-        if file_path not in self.file_symbols:
-            self.file_symbols[file_path] = set()
-        self.file_symbols[file_path].add(struct_name)
+        entry.symbols.append(symbol_info)
 
     def find_symbol(self, symbol_name: str) -> List[SymbolInfo]:
         """Find all occurrences of a symbol."""
@@ -232,4 +477,49 @@ class ProjectIndexer:
 
     def get_file_symbols(self, file_path: str) -> Set[str]:
         """Get all symbols defined in a file."""
-        return self.file_symbols.get(file_path, set())
+        return self.symbol_table.file_symbol_names(file_path)
+
+    def find_callers(self, function_name: str) -> List[CallerSite]:
+        """Direct call sites of a function (matched by name)."""
+        return self.caller_index.callers_of(function_name)
+
+    def find_transitive_callers(self, function_name: str,
+                                max_depth: Optional[int] = None) -> Dict[str, int]:
+        """Functions reaching function_name through calls -> call distance (excludes itself)."""
+        distances = self.caller_index.transitive_callers([function_name], max_depth)
+        distances.pop(callee_key(function_name), None)
+        return distances
+
+    def impact_set(self, function_names: Iterable[str],
+                   max_depth: Optional[int] = None) -> ImpactSet:
+        """
+        Everything that may be affected by changing the given functions:
+        the functions themselves, their transitive callers and the files
+        those calls or definitions live in.
+        """
+        impact = self.caller_index.impact(function_names, max_depth)
+        files = {path: set(functions) for path, functions in impact.files.items()}
+        for name in impact.distances:
+            for sym in self.find_symbol(name):
+                if sym.type == 'function' and not sym.is_declaration:
+                    files.setdefault(sym.file_path, set()).add(name)
+        impact.files = {path: sorted(functions) for path, functions in sorted(files.items())}
+        return impact
+
+    def get_function_index(self, file_path: str) -> Optional[FunctionIndex]:
+        """Function definition index of a project file (served from the parse cache)."""
+        parsed = self.parser.get_parsed_file(self.project_root / file_path)
+        return parsed.function_index if parsed else None
+
+
+# Per-process indexer used by the worker pool (one parser per worker)
+_worker_indexer: Optional[ProjectIndexer] = None
+
+
+def _index_file_worker(task) -> Optional[FileIndexEntry]:
+    """Pool entry point: index one file in a worker process."""
+    global _worker_indexer
+    project_root, file_path = task
+    if _worker_indexer is None or str(_worker_indexer.project_root) != project_root:
+        _worker_indexer = ProjectIndexer(project_root, use_cache=False)
+    return _worker_indexer._index_file(Path(file_path))
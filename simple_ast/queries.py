@@ -0,0 +1,118 @@
+"""
+预编译的 tree-sitter 查询 - 节点匹配在原生代码中完成
+
+按节点类型查找（find_nodes_by_type、函数定义/调用索引、类型和声明提取）
+都走 S 表达式查询：同一组节点类型的查询在进程内只编译一次，之后每次匹配
+都由 tree-sitter 的 QueryCursor 完成，Python 侧只处理命中的节点。
+
+查询不可用时（语言库缺失、节点类型不在语法中、传入的不是 tree-sitter 节点）
+自动退回 tree_visitor 的游标遍历，结果相同：按先序排列。
+"""
+import threading
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from .logger import count, get_logger
+from .tree_visitor import collect_nodes_by_type
+
+logger = get_logger()
+
+# 常用查询，构建解析器时预编译
+COMMON_NODE_TYPES = (
+    ('call_expression',),
+    ('type_identifier',),
+    ('cast_expression',),
+    ('identifier',),
+    ('declaration',),
+    ('qualified_identifier',),
+    ('function_definition', 'call_expression'),
+)
+
+_language = None
+_language_lock = threading.Lock()
+
+# 查询源码 -> Query（编译失败记为 None，不再重试）
+_queries: Dict[str, Optional[object]] = {}
+_queries_lock = threading.Lock()
+_MISSING = object()
+
+
+def cpp_language():
+    """进程内共享的 C++ Language 对象"""
+    global _language
+    if _language is None:
+        with _language_lock:
+            if _language is None:
+                import tree_sitter_cpp
+                from tree_sitter import Language
+                _language = Language(tree_sitter_cpp.language(), "cpp")
+    return _language
+
+
+def compile_query(source: str):
+    """编译（或取缓存的）查询，不可用时返回 None"""
+    query = _queries.get(source, _MISSING)
+    if query is not _MISSING:
+        return query
+
+    with _queries_lock:
+        query = _queries.get(source, _MISSING)
+        if query is _MISSING:
+            try:
+                query = cpp_language().query(source)
+                count('query.compile')
+            except Exception as e:
+                logger.debug(f"[查询] 编译失败，改用遍历: {source!r} ({e})")
+                query = None
+            _queries[source] = query
+    return query
+
+
+def _node_types_query(node_types: Tuple[str, ...]) -> str:
+    # 捕获名与节点类型相同，一个查询匹配多种类型
+    return ' '.join(f'({node_type}) @{node_type}' for node_type in node_types)
+
+
+def precompile(groups: Iterable[Tuple[str, ...]] = COMMON_NODE_TYPES):
+    """预编译常用查询（可重复调用，已编译的直接跳过）"""
+    for node_types in groups:
+        compile_query(_node_types_query(tuple(node_types)))
+
+
+def _preorder_key(node):
+    return (node.start_byte, -node.end_byte)
+
+
+def find_nodes(node, node_types: Iterable[str]) -> Dict[str, list]:
+    """
+    查找子树（包括 node 本身）中多种类型的节点
+
+    Returns:
+        {节点类型: 节点列表}，每个列表按先序排列
+    """
+    node_types = tuple(node_types)
+    query = compile_query(_node_types_query(node_types))
+    if query is not None:
+        try:
+            captures = query.captures(node)
+        except Exception:
+            captures = None
+        if captures is not None:
+            count('query.run')
+            found: Dict[str, list] = {node_type: [] for node_type in node_types}
+            for captured, name in captures:
+                found[name].append(captured)
+            for nodes in found.values():
+                # 同一起点的嵌套节点（如链式调用）外层在前，与先序一致
+                nodes.sort(key=_preorder_key)
+            return found
+
+    count('query.fallback')
+    return collect_nodes_by_type(node, node_types)
+
+
+def find_nodes_in_order(node, node_types: Iterable[str]) -> List[Tuple[str, object]]:
+    """查找多种类型的节点，合并为一个先序列表 [(节点类型, 节点)]"""
+    merged = [(node_type, found) for node_type, nodes in find_nodes(node, node_types).items()
+              for found in nodes]
+    merged.sort(key=lambda item: _preorder_key(item[1]))
+    return merged
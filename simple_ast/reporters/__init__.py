@@ -1,5 +1,8 @@
 """报告生成模块"""
 
 from .function_reporter import FunctionReporter
+from .parallel_reporter import generate_reports
+from .report_cache import ReportCache, configure_report_cache, get_report_cache, get_report_cache_options
 
-__all__ = ['FunctionReporter']
+__all__ = ['FunctionReporter', 'generate_reports', 'ReportCache', 'configure_report_cache',
+           'get_report_cache', 'get_report_cache_options']
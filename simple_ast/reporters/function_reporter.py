@@ -13,10 +13,12 @@
 - 格式化输出
 """
 import sys
+from pathlib import Path
 from typing import Dict, List, Set, Optional
 from ..extractors import ConstantExtractor, SignatureExtractor, StructureExtractor, MacroExtractor, GlobalVariableExtractor, TypeCastExtractor, FunctionImplExtractor
 from ..searchers import HeaderSearcher
-from ..logger import get_logger
+from ..logger import get_logger, span, traced
+from .report_cache import ReportKeyBuilder, get_report_cache
 logger = get_logger()
 
 
@@ -37,7 +39,7 @@ class FunctionReporter:
         project_root = result.project_root if hasattr(result, 'project_root') else "."
 
         # 创建提取器
-        header_searcher = HeaderSearcher()
+        header_searcher = HeaderSearcher(project_root=project_root)
         self.constant_extractor = ConstantExtractor(
             header_searcher,
             project_root=project_root,
@@ -60,106 +62,174 @@ class FunctionReporter:
         # FunctionImplExtractor 用于函数实现提取
         self.impl_extractor = FunctionImplExtractor(project_root=project_root)
 
-        # 构建函数暴露状态映射 {函数名: (category, declaration_location)}
-        # 使用 file_boundary 中的所有函数信息，而不只是 entry_points（可能被过滤）
-        self.function_exposure_map = {}
-        self._build_complete_exposure_map()
+        # 每个函数使用的数据结构（递归展开时同一函数会在多个报告中出现）
+        self._data_structure_cache: Dict[str, dict] = {}
 
-    def _build_complete_exposure_map(self):
+        # 函数暴露状态映射 {函数名: (category, declaration_location)}
+        # 按需填充：只为报告中实际出现的函数分类，不在构造时遍历整个文件
+        self.function_exposure_map = {}
+        self._entry_point_map = {ep.name: ep for ep in (getattr(result, 'entry_points', None) or [])}
+        self._header_content = None  # (头文件路径, 内容)，首次分类时读取
+
+        # 按内容寻址的报告缓存：命中的函数跳过预取和生成
+        self.report_cache = get_report_cache(project_root)
+        self._key_builder = ReportKeyBuilder(result) if self.report_cache else None
+        if self._key_builder and not self._key_builder.available:
+            logger.info("[报告缓存] 缺少边界分析结果或定义索引，不使用报告缓存")
+            self.report_cache = self._key_builder = None
+        self._report_keys: Dict[str, Optional[str]] = {}
+        self._cached_reports: Dict[str, str] = {}   # 预取时已命中的报告
+
+    @traced('report.prefetch', 'report')
+    def prefetch(self, func_names: List[str]):
         """
-        构建完整的函数暴露状态映射，包含文件中的所有函数
+        为一批函数的报告预先批量解析外部标识符
 
-        这个方法复刻了 SingleFileAnalyzer.get_entry_points() 的分类逻辑
+        报告会递归展开同文件的内部依赖，预取范围包括这些依赖：
+        常量和宏各一次批量搜索，数据结构每个优先级一次批量搜索，外部函数签名写入缓存。
+        之后 generate() 只查各提取器的缓存。
         """
-        # 优先使用 entry_points（如果有完整的）
-        if hasattr(self.result, 'entry_points') and self.result.entry_points:
-            for ep in self.result.entry_points:
-                self.function_exposure_map[ep.name] = (ep.category, ep.declaration_location)
-
-        # 如果 file_boundary 中有更多函数信息，补充到映射中
-        if (hasattr(self.result, 'file_boundary') and self.result.file_boundary and
-            hasattr(self.result.file_boundary, 'file_functions') and self.result.file_boundary.file_functions):
-
-            from pathlib import Path
-
-            # 查找对应的头文件中的函数声明
-            target_file_path = Path(self.result.project_root) / self.result.target_file
-            header_functions = self._find_header_declarations(str(target_file_path))
+        func_names = list(func_names)
+        if self.report_cache:
+            # 缓存命中的报告不需要任何外部标识符
+            misses = [name for name in func_names if self._lookup_cached_report(name) is None]
+            if len(misses) < len(func_names):
+                logger.info(f"[报告缓存] {len(func_names) - len(misses)}/{len(func_names)} 个报告命中缓存")
+            func_names = misses
+        if not func_names:
+            return
+        target_file = self.result.target_file
+        closure = self._collect_internal_closure(func_names)
+        logger.info(f"[批量预取] {len(func_names)} 个函数（含内部依赖共 {len(closure)} 个）")
 
-            # 为每个函数分类
-            for func_name, func_info in self.result.file_boundary.file_functions.items():
-                # 如果已经在映射中，跳过
-                if func_name in self.function_exposure_map:
-                    continue
+        # 1. 常量/宏定义（每个报告只提取主函数的常量）
+        self.constant_extractor.prefetch(
+            func_names,
+            self.result.function_signatures,
+            self.result.branch_analyses,
+            target_file
+        )
+        macro_names = [name for name in self.constant_extractor.cached_definitions()
+                       if '(' in name or self.macro_extractor.is_likely_macro(name)]
+        self.macro_extractor.prefetch(macro_names)
+
+        # 2. 外部数据结构
+        used_names = set()
+        for func_name in closure:
+            used_names.update(self._extract_data_structures_from_single_function(func_name).keys())
+        external_ds = sorted(ds for ds in used_names if ds not in self.result.data_structures)
+        self.structure_extractor.prefetch(external_ds, target_file)
+
+        # 3. 业务外部函数签名
+        external_funcs = set()
+        for func_name in closure:
+            call_tree = self.result.call_chains.get(func_name)
+            if call_tree and call_tree.children:
+                external_funcs.update(c.function_name for c in call_tree.children if c.is_external)
+        if external_funcs and self.result.external_classifier:
+            business = self.result.external_classifier.classify(external_funcs).get('business', set())
+            for func in sorted(business):
+                self.signature_extractor.extract(func, target_file)
+
+    def _report_key(self, func_name: str) -> Optional[str]:
+        if func_name not in self._report_keys:
+            closure = self._collect_internal_closure([func_name])
+            self._report_keys[func_name] = self._key_builder.key(func_name, closure)
+        return self._report_keys[func_name]
+
+    def _lookup_cached_report(self, func_name: str) -> Optional[str]:
+        """从报告缓存取报告（未启用或未命中返回 None）"""
+        if func_name in self._cached_reports:
+            return self._cached_reports[func_name]
+        key = self._report_key(func_name) if self.report_cache else None
+        if key is None:
+            return None
+        report = self.report_cache.get(key)
+        if report is not None:
+            self._cached_reports[func_name] = report
+        return report
+
+    def _collect_internal_closure(self, func_names: List[str]) -> Set[str]:
+        """函数及其（递归的）同文件内部依赖"""
+        closure = set()
+        stack = list(func_names)
+        while stack:
+            func_name = stack.pop()
+            if func_name in closure:
+                continue
+            closure.add(func_name)
+            call_tree = self.result.call_chains.get(func_name)
+            if call_tree and call_tree.children:
+                stack.extend(c.function_name for c in call_tree.children if not c.is_external)
+        return closure
 
-                is_static = func_info.get('is_static', False)
+    def _classify_exposure(self, func_name: str) -> Optional[tuple]:
+        """
+        计算单个函数的暴露状态 (category, declaration_location)
 
-                # 分类逻辑（与 SingleFileAnalyzer.get_entry_points() 一致）
-                if is_static:
-                    category = 'INTERNAL'
-                    decl_location = ""
-                elif func_name in header_functions:
-                    category = 'API'
-                    decl_location = header_functions[func_name]
-                else:
-                    category = 'EXPORTED'
-                    decl_location = ""
+        优先使用 entry_points；否则按 file_boundary 中的函数信息分类，
+        逻辑与 SingleFileAnalyzer.get_entry_points() 一致
+        """
+        ep = self._entry_point_map.get(func_name)
+        if ep is not None:
+            return ep.category, ep.declaration_location
 
-                self.function_exposure_map[func_name] = (category, decl_location)
-                logger.info(f"[暴露状态映射] {func_name}: {category}")
+        file_boundary = getattr(self.result, 'file_boundary', None)
+        file_functions = getattr(file_boundary, 'file_functions', None) if file_boundary else None
+        if not file_functions or func_name not in file_functions:
+            return None
 
-    def _find_header_declarations(self, cpp_file_path: str) -> dict:
-        """
-        查找cpp文件对应的头文件中的函数声明
-        使用简单的文本搜索
-        """
-        from pathlib import Path
+        if file_functions[func_name].get('is_static', False):
+            category, decl_location = 'INTERNAL', ""
+        else:
+            header_path = self._find_header_declaration(func_name)
+            if header_path:
+                category, decl_location = 'API', header_path
+            else:
+                category, decl_location = 'EXPORTED', ""
+        logger.info(f"[暴露状态映射] {func_name}: {category}")
+        return category, decl_location
 
-        header_funcs = {}
-        cpp_path = Path(cpp_file_path)
+    def _load_header_content(self):
+        """读取cpp文件对应的头文件（.h/.hpp，找到一个即可），结果缓存"""
+        if self._header_content is not None:
+            return self._header_content
 
+        self._header_content = (None, "")
+        cpp_path = Path(self.result.project_root) / self.result.target_file
         if not cpp_path.is_absolute():
             cpp_path = cpp_path.resolve()
 
-        possible_headers = [
-            cpp_path.with_suffix('.h'),
-            cpp_path.with_suffix('.hpp'),
-        ]
-
-        # 获取要搜索的函数列表
-        search_functions = set()
-        if (hasattr(self.result, 'file_boundary') and self.result.file_boundary and
-            hasattr(self.result.file_boundary, 'file_functions')):
-            search_functions = set(self.result.file_boundary.file_functions.keys())
-
-        for header_path in possible_headers:
+        for header_path in (cpp_path.with_suffix('.h'), cpp_path.with_suffix('.hpp')):
             if header_path.exists():
                 try:
                     with open(header_path, 'r', encoding='utf-8', errors='ignore') as f:
-                        header_content = f.read()
-
-                    # 简单的文本搜索
-                    for func_name in search_functions:
-                        if func_name in header_content:
-                            for line in header_content.split('\n'):
-                                # 跳过注释行
-                                if line.strip().startswith('//') or line.strip().startswith('/*'):
-                                    continue
-
-                                # 检查行是否包含函数名且看起来像声明
-                                if func_name in line and '(' in line:
-                                    header_funcs[func_name] = str(header_path)
-                                    logger.info(f"[头文件检测] 发现 {func_name} 在 {header_path.name}")
-                                    break
-
-                    if header_funcs:
-                        logger.info(f"[头文件检测] 在 {header_path.name} 中找到 {len(header_funcs)} 个函数声明")
+                        self._header_content = (str(header_path), f.read())
                     break
                 except Exception as e:
                     logger.debug(f"[头文件检测] 读取 {header_path} 失败: {e}")
                     continue
+        return self._header_content
+
+    def _find_header_declaration(self, func_name: str) -> Optional[str]:
+        """
+        在对应头文件中查找函数声明，返回头文件路径
+        使用简单的文本搜索
+        """
+        header_path, header_content = self._load_header_content()
+        if not header_path or func_name not in header_content:
+            return None
+
+        for line in header_content.split('\n'):
+            # 跳过注释行
+            if line.strip().startswith('//') or line.strip().startswith('/*'):
+                continue
 
-        return header_funcs
+            # 检查行是否包含函数名且看起来像声明
+            if func_name in line and '(' in line:
+                logger.info(f"[头文件检测] 发现 {func_name} 在 {Path(header_path).name}")
+                return header_path
+        return None
 
     def generate(self, func_name: str) -> str:
         """
@@ -171,6 +241,19 @@ class FunctionReporter:
         Returns:
             格式化的报告文本
         """
+        cached = self._lookup_cached_report(func_name)
+        if cached is not None:
+            return cached
+
+        with span('report.generate', 'report', function=func_name):
+            report = self._generate(func_name)
+        if self.report_cache:
+            key = self._report_key(func_name)
+            if key is not None:
+                self.report_cache.put(key, report)
+        return report
+
+    def _generate(self, func_name: str) -> str:
         lines = []
         visited = set()
         all_data_structures = set()
@@ -335,7 +418,10 @@ class FunctionReporter:
             暴露状态说明字符串
         """
         if func_name not in self.function_exposure_map:
-            return ""
+            exposure = self._classify_exposure(func_name)
+            if exposure is None:
+                return ""
+            self.function_exposure_map[func_name] = exposure
 
         category, decl_location = self.function_exposure_map[func_name]
 
@@ -523,6 +609,12 @@ class FunctionReporter:
                 )
 
     def _extract_data_structures_from_single_function(self, func_name: str):
+        """从单个函数签名和边界分析中提取使用的数据结构（按函数缓存）"""
+        if func_name not in self._data_structure_cache:
+            self._data_structure_cache[func_name] = self._collect_data_structures_from_single_function(func_name)
+        return self._data_structure_cache[func_name]
+
+    def _collect_data_structures_from_single_function(self, func_name: str):
         """从单个函数签名和边界分析中提取使用的数据结构"""
         import re
         used_ds = {}
@@ -732,7 +824,7 @@ class FunctionReporter:
 
     def _expand_macros_in_definition(self, definition: str) -> str:
         """
-        展开数据结构定义中的宏
+        展开数据结构定义中的宏（嵌套成员宏一起展开，结果在项目内共享缓存）
 
         Args:
             definition: 原始数据结构定义
@@ -740,41 +832,5 @@ class FunctionReporter:
         Returns:
             展开宏后的定义
         """
-        import re
-
-        lines = definition.split('\n')
-        result_lines = []
-
-        for line in lines:
-            # 检查是否有独立的宏标识符（全大写+下划线）
-            # 匹配类似 "    VOS_MSG_HEADER" 或 "    VOS_MSG_HEADER  /* comment */"
-            match = re.match(r'^(\s*)([A-Z][A-Z0-9_]+)\s*(\/\*.*\*\/)?$', line.strip())
-            if match:
-                indent = re.match(r'^(\s*)', line).group(1)  # 保留原缩进
-                macro_name = match.group(2)
-                comment = match.group(3) or ''  # 保留注释
-
-                logger.debug(f"[宏展开] 检测到结构体宏: {macro_name}")
-
-                # 尝试展开这个宏
-                expansion = self.macro_extractor.extract_struct_macro(macro_name)
-                if expansion:
-                    # 添加注释标记
-                    result_lines.append(f"{indent}/* {macro_name} 展开: */")
-                    # 添加展开内容（保持原缩进）
-                    for exp_line in expansion.split('\n'):
-                        result_lines.append(f"{indent}{exp_line}")
-                    # 如果原行有注释，也保留
-                    if comment:
-                        result_lines.append(f"{indent}{comment}")
-                    logger.info(f"[宏展开] ✓ {macro_name}: 已展开到结构体定义中")
-                else:
-                    # 未找到展开，保留原行
-                    result_lines.append(line)
-                    logger.debug(f"[宏展开] ✗ {macro_name}: 未找到定义")
-            else:
-                # 普通行，直接保留
-                result_lines.append(line)
-
-        return '\n'.join(result_lines)
+        return self.macro_extractor.expand_struct_definition(definition)
 
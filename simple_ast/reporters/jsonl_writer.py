@@ -0,0 +1,156 @@
+"""
+JSON Lines 流式输出 - 按记录逐行写出分析结果，不在内存中拼出完整的 JSON 树
+
+每行一个 JSON 对象，type 字段区分记录类型，按以下顺序输出：
+
+    header          目标文件、模式、项目根目录、格式版本
+    entry_point     每个入口函数一条
+    boundary        文件边界（内部/外部函数和数据结构，仅单文件边界模式）
+    signature       每个函数签名一条
+    data_structure  每个数据结构一条
+    call_node       调用树节点，每个节点只写一次（共享子树不重复展开），
+                    children 为子节点 id；子节点总在父节点之前写出
+    call_chain      每个入口函数一条，root 为根节点 id
+    function_report 每个函数报告一条（边生成边写出）
+    end             各类记录的数量
+
+下游可以在后续函数报告还在生成时就开始处理已经写出的记录。
+"""
+import json
+from typing import Dict, IO, Iterable, Iterator, List, Optional, Tuple
+
+JSONL_FORMAT_VERSION = 1
+
+
+class JsonlWriter:
+    """逐行写 JSON 记录（默认每行 flush，便于下游实时读取）"""
+
+    def __init__(self, fp: IO[str], flush: bool = True):
+        self.fp = fp
+        self.flush = flush
+        self.counts: Dict[str, int] = {}
+
+    def write(self, record: dict):
+        self.fp.write(json.dumps(record, ensure_ascii=False))
+        self.fp.write('\n')
+        if self.flush:
+            self.fp.flush()
+        kind = record.get('type', '')
+        self.counts[kind] = self.counts.get(kind, 0) + 1
+
+    def write_all(self, records: Iterable[dict]):
+        for record in records:
+            self.write(record)
+
+    def close(self):
+        """写出 end 记录"""
+        self.write({'type': 'end', 'counts': dict(self.counts)})
+
+
+def iter_analysis_records(result) -> Iterator[dict]:
+    """按顺序产出分析结果的各类记录（不含函数报告和 end）"""
+    yield {
+        'type': 'header',
+        'version': JSONL_FORMAT_VERSION,
+        'target_file': result.target_file,
+        'project_root': result.project_root,
+        'mode': result.mode,
+    }
+
+    for ep in result.entry_points:
+        yield {
+            'type': 'entry_point',
+            'name': ep.name,
+            'category': ep.category,
+            'file_path': ep.file_path,
+            'line_number': ep.line_number,
+            'signature': ep.signature,
+            'declaration_location': ep.declaration_location,
+        }
+
+    boundary = result.file_boundary
+    if boundary is not None:
+        yield {
+            'type': 'boundary',
+            'file_path': boundary.file_path,
+            'internal_functions': sorted(boundary.internal_functions),
+            'external_functions': sorted(boundary.external_functions),
+            'internal_data_structures': sorted(boundary.internal_data_structures),
+            'external_data_structures': sorted(boundary.external_data_structures),
+        }
+
+    for name, signature in result.function_signatures.items():
+        yield {'type': 'signature', 'name': name, 'signature': signature}
+
+    for name, ds in result.data_structures.items():
+        yield {
+            'type': 'data_structure',
+            'name': ds.name,
+            'kind': ds.type,
+            'file_path': ds.file_path,
+            'line_number': ds.line_number,
+            'definition': ds.definition,
+            'used_by_functions': sorted(ds.used_by_functions),
+            'used_in_files': sorted(ds.used_in_files),
+        }
+
+    node_ids: Dict[int, int] = {}
+    for name, tree in result.call_chains.items():
+        if tree is None:
+            continue
+        yield from _iter_call_nodes(tree, node_ids)
+        yield {'type': 'call_chain', 'function': name, 'root': node_ids[id(tree)]}
+
+
+def _iter_call_nodes(root, node_ids: Dict[int, int]) -> Iterator[dict]:
+    """
+    后序遍历（显式栈，不受递归深度限制）写出尚未写过的节点
+
+    node_ids 跨调用链共享：记忆化追踪产生的共享子树只写一次。
+    """
+    stack: List[Tuple[object, bool]] = [(root, False)]
+    while stack:
+        node, children_done = stack.pop()
+        if id(node) in node_ids:
+            continue
+        if not children_done:
+            stack.append((node, True))
+            for child in reversed(node.children):
+                if id(child) not in node_ids:
+                    stack.append((child, False))
+            continue
+        node_id = len(node_ids)
+        node_ids[id(node)] = node_id
+        yield {
+            'type': 'call_node',
+            'id': node_id,
+            'function_name': node.function_name,
+            'file_path': node.file_path,
+            'line_number': node.line_number,
+            'signature': node.signature,
+            'called_from_line': node.called_from_line,
+            'is_external': node.is_external,
+            'is_recursive': node.is_recursive,
+            'children': [node_ids[id(child)] for child in node.children],
+        }
+
+
+def write_analysis_jsonl(result, fp: IO[str],
+                         reports: Optional[Iterable[Tuple[str, str]]] = None) -> JsonlWriter:
+    """
+    把分析结果（以及可选的函数报告流）写成 JSON Lines
+
+    Args:
+        result: AnalysisResult
+        fp: 文本文件对象
+        reports: (函数名, 报告) 的可迭代对象，如 result.generate_single_function_reports(...)
+
+    Returns:
+        已写出 end 记录的 JsonlWriter
+    """
+    writer = JsonlWriter(fp)
+    writer.write_all(iter_analysis_records(result))
+    for func_name, report in reports or ():
+        writer.write({'type': 'function_report', 'function': func_name, 'report': report})
+    writer.close()
+    return writer
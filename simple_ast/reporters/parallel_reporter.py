@@ -0,0 +1,94 @@
+"""
+并行单函数报告生成 - 把 FunctionReporter.generate 分发到多个工作进程
+
+- 支持 fork 的平台（Linux）：工作进程直接继承父进程中只读的 AnalysisResult /
+  FileBoundary 以及已预取的提取器缓存，不做任何序列化
+- 其他平台（spawn）：结果对象经 pickle 传入，FileBoundary 只序列化不含语法树的快照
+  （源码从源文件读取），节点在工作进程第一次需要时才重新解析；工作进程各自做一次批量预取
+
+报告按传入的函数顺序产出，与进程数和完成顺序无关。
+"""
+import multiprocessing
+import sys
+from concurrent.futures import ProcessPoolExecutor
+from typing import Iterator, List, Optional, Tuple
+
+from ..logger import get_logger
+from .report_cache import configure_report_cache, get_report_cache_options
+from ..searchers import (SearchTool, configure_definition_index, configure_search_concurrency,
+                         get_definition_index_options, get_search_config, set_search_tool)
+
+logger = get_logger()
+
+# 工作进程内的分析结果（由 _init_worker 设置）
+_worker_result = None
+
+
+def _pool_context():
+    """优先使用 fork（共享父进程内存）；macOS 上 fork 不安全，使用默认方式"""
+    if sys.platform != 'darwin' and 'fork' in multiprocessing.get_all_start_methods():
+        return multiprocessing.get_context('fork')
+    return None
+
+
+def _init_worker(result, func_names: List[str], search_tool: SearchTool,
+                 definition_index_options: Tuple[bool, bool],
+                 report_cache_options: Tuple[bool, Optional[str]]):
+    """工作进程初始化：恢复搜索配置，必要时重新预取"""
+    global _worker_result
+    _worker_result = result
+    if get_search_config().tool != search_tool:
+        set_search_tool(search_tool)
+    # 并行度由工作进程数提供，进程内的搜索不再并发（否则 rg 进程数为 jobs 的平方）
+    configure_search_concurrency(1)
+    if get_definition_index_options() != definition_index_options:
+        configure_definition_index(*definition_index_options)
+    if get_report_cache_options() != report_cache_options:
+        configure_report_cache(*report_cache_options)
+    # fork 继承的结果已带预取好的报告器；spawn 传入的结果需要自己预取
+    if result._function_reporter is None:
+        result.prefetch_single_function_reports(func_names)
+
+
+def _generate_report_worker(func_name: str) -> Tuple[str, str]:
+    return func_name, _worker_result.generate_single_function_report(func_name)
+
+
+def generate_reports(result, func_names: List[str], jobs: int = 1) -> Iterator[Tuple[str, str]]:
+    """
+    逐个产出 (函数名, 报告)，顺序与 func_names 一致
+
+    Args:
+        result: AnalysisResult（工作进程中只读使用）
+        func_names: 要生成报告的函数
+        jobs: 工作进程数（1 = 串行）
+    """
+    func_names = list(func_names)
+    if not func_names:
+        return
+    # 批量预取常量/宏/数据结构/签名；fork 出的工作进程直接继承这些缓存
+    result.prefetch_single_function_reports(func_names)
+
+    jobs = min(max(1, jobs or 1), len(func_names))
+    if jobs <= 1:
+        for func_name in func_names:
+            yield func_name, result.generate_single_function_report(func_name)
+        return
+
+    logger.info(f"[并行报告] {len(func_names)} 个函数，{jobs} 个工作进程")
+
+    initargs = (result, func_names, get_search_config().tool, get_definition_index_options(),
+                get_report_cache_options())
+    # 报告耗时差异大，小块分发保持各进程负载均衡
+    chunksize = max(1, len(func_names) // (jobs * 8))
+    done = 0
+    try:
+        with ProcessPoolExecutor(max_workers=jobs, mp_context=_pool_context(),
+                                 initializer=_init_worker, initargs=initargs) as executor:
+            for item in executor.map(_generate_report_worker, func_names, chunksize=chunksize):
+                done += 1
+                yield item
+    except Exception as e:
+        logger.warning(f"[并行报告] 并行生成失败（{e}），剩余 {len(func_names) - done} 个函数改为串行生成")
+        for func_name in func_names[done:]:
+            yield func_name, result.generate_single_function_report(func_name)
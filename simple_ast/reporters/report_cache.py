@@ -0,0 +1,285 @@
+"""
+单函数报告缓存 - 按内容寻址，跨运行、跨机器共享
+
+报告只取决于函数本身、它递归展开的同文件内部依赖，以及这些函数引用的
+常量、宏、数据结构、全局变量和外部函数签名的定义。缓存键是这些内容的哈希：
+- 闭包中每个函数的源码、起始行、签名和直接调用（内部/外部）
+- 闭包引用的标识符在目标文件中的定义（定义索引中的行，内部数据结构的完整定义）
+- 提供其余依赖定义的文件的内容哈希：HeaderSearcher 会读取的头文件（#include 闭包，
+  没有可解析的包含时为目录启发式找到的头文件）、对应的 .h/.hpp，
+  以及定义索引中被引用标识符的定义所在的其他文件
+- 外部函数分类配置（.simple_ast_config.json，决定报告中外部调用的分组）
+
+键中只有相对路径和内容哈希，同一份代码在不同机器上得到相同的键，
+缓存目录可以放在共享存储上（--report-cache）。每个报告一个文件，先写临时文件
+再改名，多个进程/机器同时写同一个键也安全。
+"""
+import hashlib
+import json
+import os
+import re
+import tempfile
+import threading
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Set, Tuple
+
+from ..extractors.macro_table import get_macro_expander
+from ..index_cache import content_hash, default_cache_dir
+from ..logger import count, get_logger
+from ..searchers import HeaderSearcher, get_definition_index
+
+logger = get_logger()
+
+# 报告格式或键的组成变化时递增，旧缓存自然失效
+REPORT_CACHE_VERSION = 3
+
+REPORT_CACHE_DIR_NAME = 'reports'
+
+_IDENT_RE = re.compile(rb'[A-Za-z_]\w*')
+
+
+def _identifiers(data: bytes) -> Set[str]:
+    return {match.decode('ascii') for match in _IDENT_RE.findall(data)}
+
+
+class ReportCache:
+    """磁盘上的 键 -> 报告文本 存储（<目录>/<键前两位>/<键>.txt）"""
+
+    def __init__(self, cache_dir):
+        self.cache_dir = Path(cache_dir)
+
+    def _path(self, key: str) -> Path:
+        return self.cache_dir / key[:2] / f"{key}.txt"
+
+    def get(self, key: str) -> Optional[str]:
+        try:
+            with open(self._path(key), 'r', encoding='utf-8', newline='') as f:
+                report = f.read()
+        except FileNotFoundError:
+            count('report_cache.miss')
+            return None
+        except OSError as e:
+            logger.debug(f"[报告缓存] 读取失败 {key}: {e}")
+            count('report_cache.miss')
+            return None
+        count('report_cache.hit')
+        return report
+
+    def put(self, key: str, report: str):
+        path = self._path(key)
+        tmp_path = None
+        try:
+            path.parent.mkdir(parents=True, exist_ok=True)
+            fd, tmp_path = tempfile.mkstemp(dir=path.parent, prefix=f".{key[:8]}.", suffix='.tmp')
+            with os.fdopen(fd, 'w', encoding='utf-8', newline='') as f:
+                f.write(report)
+            os.replace(tmp_path, path)
+            tmp_path = None
+            count('report_cache.store')
+        except OSError as e:
+            logger.warning(f"[报告缓存] 写入失败 {path}: {e}")
+        finally:
+            if tmp_path is not None:
+                try:
+                    os.unlink(tmp_path)
+                except OSError:
+                    pass
+
+
+# 进程内文件内容哈希（按 mtime/大小失效）：绝对路径 -> (mtime_ns, size, hash)
+_file_hashes: Dict[str, Tuple[int, int, str]] = {}
+_file_hashes_lock = threading.Lock()
+
+
+def _file_content_hash(path: Path) -> str:
+    try:
+        stat = path.stat()
+    except OSError:
+        return 'missing'
+    key = str(path)
+    with _file_hashes_lock:
+        cached = _file_hashes.get(key)
+        if cached is not None and cached[0] == stat.st_mtime_ns and cached[1] == stat.st_size:
+            return cached[2]
+    try:
+        with open(path, 'rb') as f:
+            digest = content_hash(f.read())
+    except OSError:
+        return 'missing'
+    with _file_hashes_lock:
+        _file_hashes[key] = (stat.st_mtime_ns, stat.st_size, digest)
+    return digest
+
+
+def _function_location(func_info: Optional[dict]) -> Optional[Tuple[int, int, int]]:
+    """(起始字节, 结束字节, 起始行号-1)；优先用记录的字节范围，不触发节点的按需解析"""
+    if not func_info:
+        return None
+    if 'span' in func_info and func_info.get('line'):
+        start_byte, end_byte = func_info['span']
+        return start_byte, end_byte, func_info['line'] - 1
+    node = func_info.get('node')
+    if node is None:
+        return None
+    return node.start_byte, node.end_byte, node.start_point[0]
+
+
+class ReportKeyBuilder:
+    """为一个 AnalysisResult 中的函数计算报告缓存键"""
+
+    def __init__(self, result):
+        self.result = result
+        self.root = Path(result.project_root).resolve()
+        self.target_path = (self.root / result.target_file).resolve()
+        file_boundary = getattr(result, 'file_boundary', None)
+        self.file_functions = getattr(file_boundary, 'file_functions', None) or {}
+        self.file_data_structures = getattr(file_boundary, 'file_data_structures', None) or {}
+        self.source_code = getattr(file_boundary, 'source_code', None)
+        self.index, _ = get_definition_index(self.root)
+        self._base_deps: Optional[List[Tuple[str, str]]] = None
+        self._classifier_digest: Optional[str] = None
+
+    @property
+    def available(self) -> bool:
+        """需要边界分析结果（函数节点和源码）和定义索引"""
+        return bool(self.file_functions) and self.source_code is not None and self.index is not None
+
+    def key(self, func_name: str, closure: Iterable[str]) -> Optional[str]:
+        """
+        Args:
+            func_name: 报告的主函数
+            closure: 主函数及其递归展开的内部依赖
+
+        Returns:
+            十六进制键；闭包中有函数缺少节点信息时返回 None（不缓存）
+        """
+        if not self.available:
+            return None
+
+        result = self.result
+        digest = hashlib.sha256()
+
+        def add(*parts):
+            digest.update('\x1f'.join(str(p) for p in parts).encode('utf-8', errors='replace'))
+            digest.update(b'\x1e')
+
+        add('version', REPORT_CACHE_VERSION)
+        add('file', self._relative(self.target_path))
+        add('function', func_name)
+        # 签名中出现的内部数据结构名会被列出，文件中新增/删除结构体会影响报告
+        add('structures', *sorted(result.data_structures))
+        add('classifier', self._classifier_hash())
+
+        identifiers: Set[str] = set()
+        for name in sorted(closure):
+            func_info = self.file_functions.get(name)
+            location = _function_location(func_info)
+            if location is None:
+                return None
+            start_byte, end_byte, start_row = location
+            text = self.source_code[start_byte:end_byte]
+            signature = result.function_signatures.get(name, '')
+            identifiers |= _identifiers(text)
+            identifiers |= _identifiers(signature.encode('utf-8'))
+            call_tree = result.call_chains.get(name)
+            calls = [(c.function_name, c.is_external) for c in call_tree.children] if call_tree else []
+            add('fn', name, start_row, hashlib.sha1(text).hexdigest(), signature, calls)
+
+        # 内部数据结构的完整定义（其中的宏也会在报告中展开）
+        for name in sorted(identifiers & self.file_data_structures.keys()):
+            ds_info = self.file_data_structures[name]
+            definition = ds_info.get('definition', '').encode('utf-8')
+            identifiers |= _identifiers(definition)
+            # 定义中的成员宏会递归展开，嵌套的宏也是依赖
+            identifiers |= get_macro_expander(self.root).expanded_macros(ds_info.get('definition', ''))
+            add('ds', name, ds_info.get('line'), hashlib.sha1(definition).hexdigest())
+
+        target_rel = self._index_relative(self.target_path)
+        dep_files: Set[str] = set()
+        for name in sorted(identifiers):
+            for definition in self.index.lookup(name):
+                if definition.file == target_rel:
+                    add('def', definition.name, definition.kind, definition.line,
+                        definition.text, definition.body)
+                else:
+                    dep_files.add(definition.file)
+
+        for rel_path, file_hash in self._base_dependencies():
+            add('dep', rel_path, file_hash)
+            dep_files.discard(rel_path)
+        for rel_path in sorted(dep_files):
+            add('dep', rel_path, _file_content_hash(self.index.root / rel_path))
+
+        return digest.hexdigest()
+
+    def _classifier_hash(self) -> str:
+        """外部函数分类配置的哈希（配置从当前目录加载，不同机器/目录可能不同）"""
+        if self._classifier_digest is None:
+            classifier = getattr(self.result, 'external_classifier', None)
+            config = getattr(classifier, 'config', None) if classifier is not None else None
+            text = json.dumps(config, sort_keys=True, ensure_ascii=False, default=str)
+            self._classifier_digest = hashlib.sha1(text.encode('utf-8')).hexdigest()
+        return self._classifier_digest
+
+    def _base_dependencies(self) -> List[Tuple[str, str]]:
+        """
+        所有报告共有的依赖文件（相对定义索引根目录）：与 FunctionReporter 相同的
+        HeaderSearcher 找到的头文件（报告分别以相对路径和绝对路径查找）和对应的 .h/.hpp。
+        目标文件本身不计入：它与报告相关的内容已经按函数和定义逐项进入键。
+        """
+        if self._base_deps is None:
+            searcher = HeaderSearcher(project_root=str(self.result.project_root))
+            paths = set()
+            for target in dict.fromkeys((str(self.result.target_file), str(self.target_path))):
+                paths.update(Path(p).resolve() for p in searcher.find_headers(target))
+            for suffix in ('.h', '.hpp'):
+                header = self.target_path.with_suffix(suffix)
+                if header.exists():
+                    paths.add(header.resolve())
+            paths.discard(self.target_path)
+            deps = {self._index_relative(p): _file_content_hash(p) for p in paths}
+            self._base_deps = sorted(deps.items())
+        return self._base_deps
+
+    def _relative(self, path: Path) -> str:
+        try:
+            return path.relative_to(self.root).as_posix()
+        except ValueError:
+            return path.as_posix()
+
+    def _index_relative(self, path: Path) -> str:
+        try:
+            return Path(path).relative_to(self.index.root).as_posix()
+        except ValueError:
+            return Path(path).as_posix()
+
+
+# 全局选项
+_enabled = True
+_cache_dir: Optional[str] = None  # None 时使用 <项目根目录>/.simple_ast_cache/reports
+
+
+def configure_report_cache(enabled: bool = True, cache_dir: Optional[str] = None):
+    """
+    设置报告缓存选项
+
+    Args:
+        enabled: False 时每次都重新生成报告
+        cache_dir: 缓存目录（可放在多台机器共享的存储上），默认在项目缓存目录下
+    """
+    global _enabled, _cache_dir
+    _enabled = enabled
+    _cache_dir = str(cache_dir) if cache_dir else None
+
+
+def get_report_cache_options() -> Tuple[bool, Optional[str]]:
+    """当前的 (enabled, cache_dir) 设置（传给工作进程时使用）"""
+    return _enabled, _cache_dir
+
+
+def get_report_cache(project_root) -> Optional[ReportCache]:
+    """项目的报告缓存；未启用时返回 None"""
+    if not _enabled:
+        return None
+    cache_dir = Path(_cache_dir) if _cache_dir else default_cache_dir(project_root) / REPORT_CACHE_DIR_NAME
+    return ReportCache(cache_dir)
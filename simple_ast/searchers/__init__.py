@@ -1,15 +1,29 @@
 """文件搜索模块"""
 
 from .header_searcher import HeaderSearcher
+from .include_resolver import IncludeResolver, clear_include_resolvers, get_include_resolver
 from .grep_searcher import GrepSearcher
+from .memory_searcher import MemorySearcher, clear_corpus_cache
+from .definition_index import (DefinitionIndex, configure_definition_index, get_definition_index,
+                               get_definition_index_options)
 from .structure_searcher import StructureSearcher
 from .signature_searcher import SignatureSearcher
 from .constant_searcher import ConstantSearcher
 from .search_config import SearchConfig, SearchTool, get_search_config, set_search_tool
+from .rg_stream import configure_search_concurrency
 
 __all__ = [
     'HeaderSearcher',
+    'IncludeResolver',
+    'clear_include_resolvers',
+    'get_include_resolver',
     'GrepSearcher',
+    'MemorySearcher',
+    'clear_corpus_cache',
+    'DefinitionIndex',
+    'configure_definition_index',
+    'get_definition_index',
+    'get_definition_index_options',
     'StructureSearcher',
     'SignatureSearcher',
     'ConstantSearcher',
@@ -17,4 +31,5 @@ __all__ = [
     'SearchTool',
     'get_search_config',
     'set_search_tool',
+    'configure_search_concurrency',
 ]
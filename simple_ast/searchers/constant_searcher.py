@@ -6,6 +6,7 @@
 import re
 from typing import Optional
 from .grep_searcher import GrepSearcher
+from .definition_index import CONSTANT_KINDS, KIND_ENUM_MEMBER
 
 
 class ConstantSearcher:
@@ -32,14 +33,25 @@ class ConstantSearcher:
         patterns = self._build_patterns(const_name)
         combined = '|'.join(patterns)
 
-        # 搜索匹配的内容
-        matches = self.grep.search_content(
+        # 搜索匹配的内容（优先查定义索引）
+        matches = self.grep.search_definitions(
+            const_name,
+            kinds=CONSTANT_KINDS,
             pattern=combined,
             file_glob='*.h',
-            max_results=5,
-            show_line_numbers=True
+            max_results=5
         )
 
+        if not matches:
+            # 没有初始化值的 enum 成员（如 DIAM_FAIL,）只能从定义索引中找到
+            matches = self.grep.search_definitions(
+                const_name,
+                kinds=(KIND_ENUM_MEMBER,),
+                pattern=None,
+                file_glob='*.h',
+                max_results=1
+            )
+
         if not matches:
             return None
 
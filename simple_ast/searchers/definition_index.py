@@ -0,0 +1,515 @@
+"""
+标识符 -> 定义 倒排索引（#define、enum 成员、struct/class/typedef/using、
+const 常量、全局变量）
+
+一次遍历项目中的 C/C++ 文件，按行记录每个可能的定义位置；之后
+StructureSearcher / ConstantSearcher / MacroExtractor / GlobalVariableExtractor
+的查找先查字典拿到候选行，再用各自原有的正则确认，结果与逐次 grep 一致。
+
+索引持久化在 <项目根目录>/.simple_ast_cache/definitions.pkl，
+按文件（mtime/大小/内容哈希）失效，只重新扫描变化的文件。
+"""
+import fnmatch
+import os
+import re
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Pattern, Set, Tuple
+from ..index_cache import IndexCache, CACHE_DIR_NAME, content_hash, default_cache_dir
+from ..logger import get_logger, traced
+
+logger = get_logger()
+
+DEFINITION_INDEX_VERSION = 1
+
+# 参与索引的文件扩展名
+INDEXED_EXTENSIONS = {'.h', '.hh', '.hpp', '.hxx', '.inc', '.inl',
+                      '.c', '.cc', '.cpp', '.cxx'}
+
+# 定义类型
+KIND_MACRO = 'macro'                # #define NAME
+KIND_ASSIGN = 'assign'              # 行首 NAME = ...（enum 成员初始化等）
+KIND_ENUM_MEMBER = 'enum_member'    # enum { NAME, ... } 中的成员
+KIND_CONST = 'const'                # const/constexpr Type NAME = ...
+KIND_STRUCT = 'struct'              # struct/class NAME { 或 typedef struct [前缀]NAME
+KIND_TYPEDEF_ALIAS = 'typedef_alias'  # } MSG_CB, NAME;
+KIND_TYPEDEF = 'typedef'            # typedef Type NAME;
+KIND_USING = 'using'                # using NAME = ...
+KIND_GLOBAL = 'global'              # 文件作用域（或 namespace/extern "C" 内）的变量声明
+
+# 与 StructureSearcher._build_prioritized_patterns 的优先级分组对应
+STRUCTURE_KIND_GROUPS = [
+    (1, (KIND_STRUCT,)),
+    (2, (KIND_TYPEDEF_ALIAS,)),
+    (3, (KIND_TYPEDEF, KIND_USING)),
+]
+# 与 ConstantSearcher._build_patterns 对应
+CONSTANT_KINDS = (KIND_MACRO, KIND_ASSIGN, KIND_CONST)
+
+# 逐行提取候选名字的通用正则（是各搜索器按名字构造的正则的超集）
+_MACRO_RE = re.compile(r'^\s*#\s*define\s+(\w+)')
+_ASSIGN_RE = re.compile(r'^\s*(\w+)\s*=')
+_CONST_RE = re.compile(r'^\s*(?:const|constexpr)\s+\w+\s+(\w+)\s*=')
+_TYPEDEF_STRUCT_RE = re.compile(r'typedef\s+struct\s+(\w+)')
+_STRUCT_BRACE_RE = re.compile(r'(?:struct|class)\s+(\w+)\s*\{')
+_TYPEDEF_RE = re.compile(r'typedef\s+\w+\s+(\w+)\s*;')
+_USING_RE = re.compile(r'using\s+(\w+)\s*=')
+_GLOBAL_RE = re.compile(r'\b(\w+)\s+(\w+)\s*(?:=|;)')
+_WORD_RE = re.compile(r'\w+')
+_NON_GLOBAL_LINE_RE = re.compile(r'^\s*(?:#|typedef\b|using\b)')
+_IDENT_RE = re.compile(r'[A-Za-z_]\w*')
+
+# typedef struct 后常见的名字前缀（与优先级1模式一致）
+_STRUCT_NAME_PREFIXES = ('__', '_', 'tag_', 's_', 'st_')
+
+# 这些词后面跟的标识符不是变量名
+_NON_VARIABLE_WORDS = {
+    'struct', 'class', 'union', 'enum', 'typedef', 'using', 'namespace',
+    'return', 'goto', 'delete', 'case', 'friend', 'template', 'typename',
+}
+
+_BINARY_SNIFF_BYTES = 8192
+
+
+@dataclass
+class Definition:
+    """一条定义记录"""
+    name: str
+    kind: str
+    file: str           # 相对项目根目录的路径
+    line: int           # 起始行（从1开始）
+    end_line: int       # 结束行（多行宏的续行；其余与 line 相同）
+    text: str           # 起始行原文（与 grep 输出的行内容一致）
+    body: str = ''      # 多行宏的完整原文（按行以 \n 连接）
+
+
+class _FileScanner:
+    """扫描单个文件，产出 Definition 列表"""
+
+    def __init__(self, rel_path: str, text: str):
+        self.rel_path = rel_path
+        self.lines = [line[:-1] if line.endswith('\r') else line for line in text.split('\n')]
+        self.definitions: List[Definition] = []
+
+    def scan(self) -> List[Definition]:
+        lines = self.lines
+        # 先做词法扫描，得到每行开头的作用域状态和 enum 成员
+        line_scopes = self._lex()
+
+        for idx, line in enumerate(lines):
+            line_num = idx + 1
+
+            m = _MACRO_RE.match(line)
+            if m:
+                end_idx = idx
+                while end_idx + 1 < len(lines) and lines[end_idx].rstrip().endswith('\\'):
+                    end_idx += 1
+                body = '\n'.join(lines[idx:end_idx + 1]) if end_idx > idx else ''
+                self._add(m.group(1), KIND_MACRO, line_num, line, end_idx + 1, body)
+
+            m = _ASSIGN_RE.match(line)
+            if m:
+                self._add(m.group(1), KIND_ASSIGN, line_num, line)
+            m = _CONST_RE.match(line)
+            if m:
+                self._add(m.group(1), KIND_CONST, line_num, line)
+
+            if 'struct' in line or 'class' in line:
+                for m in _TYPEDEF_STRUCT_RE.finditer(line):
+                    word = m.group(1)
+                    self._add(word, KIND_STRUCT, line_num, line)
+                    for prefix in _STRUCT_NAME_PREFIXES:
+                        if word.startswith(prefix) and len(word) > len(prefix):
+                            self._add(word[len(prefix):], KIND_STRUCT, line_num, line)
+                for m in _STRUCT_BRACE_RE.finditer(line):
+                    self._add(m.group(1), KIND_STRUCT, line_num, line)
+
+            brace_pos = line.find('}')
+            if brace_pos >= 0:
+                # } 之后的每个完整标识符都可能是 typedef 别名，查找时再用原正则确认
+                for word in _WORD_RE.findall(line, brace_pos):
+                    self._add(word, KIND_TYPEDEF_ALIAS, line_num, line)
+
+            if 'typedef' in line:
+                for m in _TYPEDEF_RE.finditer(line):
+                    self._add(m.group(1), KIND_TYPEDEF, line_num, line)
+            if 'using' in line:
+                for m in _USING_RE.finditer(line):
+                    self._add(m.group(1), KIND_USING, line_num, line)
+
+            if line_scopes[idx] and not _NON_GLOBAL_LINE_RE.match(line):
+                for m in _GLOBAL_RE.finditer(line):
+                    if m.group(1) in _NON_VARIABLE_WORDS:
+                        continue
+                    # 同一行内已进入花括号（如 struct { int x; }）的不算
+                    head = line[:m.start()]
+                    if head.count('{') > head.count('}'):
+                        continue
+                    self._add(m.group(2), KIND_GLOBAL, line_num, line)
+
+        return self.definitions
+
+    def _add(self, name: str, kind: str, line_num: int, text: str,
+             end_line: Optional[int] = None, body: str = ''):
+        self.definitions.append(Definition(
+            name=name, kind=kind, file=self.rel_path, line=line_num,
+            end_line=end_line or line_num, text=text, body=body
+        ))
+
+    def _lex(self) -> List[bool]:
+        """
+        简单词法扫描（跳过注释、字符串、预处理行），跟踪花括号作用域
+
+        Returns:
+            每行开头是否处于文件作用域（只被 namespace / extern "C" 包围）；
+            同时把 enum 成员写入 self.definitions
+        """
+        lines = self.lines
+        at_file_scope: List[bool] = []
+        stack: List[str] = []        # 'ns' / 'enum' / 'other'
+        prefix: List[str] = []       # 自上一个 ; { } 以来的代码文本，用于判断 { 的种类
+        in_block_comment = False
+        in_preprocessor = False
+
+        # 当前 enum 成员的累积状态
+        entry_chars: List[str] = []
+        entry_line = 0
+        paren_depth = 0
+
+        for idx, line in enumerate(lines):
+            at_file_scope.append(not in_block_comment and all(kind == 'ns' for kind in stack))
+
+            if not in_block_comment and not in_preprocessor and line.lstrip().startswith('#'):
+                in_preprocessor = True
+            if in_preprocessor:
+                in_preprocessor = line.rstrip().endswith('\\')
+                continue
+
+            i = 0
+            n = len(line)
+            while i < n:
+                c = line[i]
+                if in_block_comment:
+                    end = line.find('*/', i)
+                    if end < 0:
+                        break
+                    in_block_comment = False
+                    i = end + 2
+                    continue
+                if c == '/' and i + 1 < n and line[i + 1] == '/':
+                    break
+                if c == '/' and i + 1 < n and line[i + 1] == '*':
+                    in_block_comment = True
+                    i += 2
+                    continue
+                if c == '"' or c == "'":
+                    # 跳过字符串/字符字面量（保留在 prefix 中，用于识别 extern "C"）
+                    j = i + 1
+                    while j < n and line[j] != c:
+                        j += 2 if line[j] == '\\' else 1
+                    prefix.append(line[i:j + 1])
+                    i = j + 1
+                    continue
+
+                in_enum = bool(stack) and stack[-1] == 'enum'
+                if c == '{':
+                    head = ''.join(prefix)
+                    if re.search(r'\bnamespace\b', head) or re.search(r'\bextern\s*"C', head):
+                        stack.append('ns')
+                    elif re.search(r'\benum\b', head):
+                        stack.append('enum')
+                        entry_chars, entry_line, paren_depth = [], 0, 0
+                    else:
+                        stack.append('other')
+                    prefix = []
+                elif c == '}':
+                    if in_enum:
+                        self._flush_enum_entry(entry_chars, entry_line)
+                        entry_chars, entry_line = [], 0
+                    if stack:
+                        stack.pop()
+                    prefix = []
+                elif c == ';':
+                    prefix = []
+                else:
+                    prefix.append(c)
+                    if in_enum:
+                        if c in '([':
+                            paren_depth += 1
+                        elif c in ')]':
+                            paren_depth = max(0, paren_depth - 1)
+                        if c == ',' and paren_depth == 0:
+                            self._flush_enum_entry(entry_chars, entry_line)
+                            entry_chars, entry_line = [], 0
+                        else:
+                            if not entry_chars and not c.isspace():
+                                entry_line = idx + 1
+                            if entry_chars or not c.isspace():
+                                entry_chars.append(c)
+                i += 1
+
+            if prefix:
+                prefix.append('\n')
+            if stack and stack[-1] == 'enum' and entry_chars:
+                entry_chars.append(' ')
+
+        return at_file_scope
+
+    def _flush_enum_entry(self, entry_chars: List[str], entry_line: int):
+        if not entry_chars:
+            return
+        m = _IDENT_RE.match(''.join(entry_chars))
+        if m:
+            self._add(m.group(0), KIND_ENUM_MEMBER, entry_line, self.lines[entry_line - 1])
+
+
+def scan_source(rel_path: str, text: str) -> List[Definition]:
+    """扫描一个文件的源代码文本"""
+    return _FileScanner(rel_path, text).scan()
+
+
+class DefinitionIndex:
+    """单个项目根目录的定义倒排索引"""
+
+    def __init__(self, project_root, persist: bool = True, cache_dir: Optional[Path] = None):
+        """
+        Args:
+            project_root: 项目根目录
+            persist: 是否读写磁盘缓存
+            cache_dir: 缓存目录（默认 <project_root>/.simple_ast_cache）
+        """
+        self.root = Path(project_root).resolve()
+        self.persist = persist
+        self.cache_dir = Path(cache_dir) if cache_dir else default_cache_dir(self.root)
+        self._by_name: Dict[str, List[Tuple[int, Definition]]] = {}  # 名字 -> [(文件序号, 定义)]
+        self._files: List[str] = []
+        self._lock = threading.Lock()
+        self._built = False
+
+    @traced('definition_index.build', 'search')
+    def build(self):
+        """遍历项目建立（或从缓存增量更新）索引"""
+        cache = None
+        if self.persist:
+            cache = IndexCache(self.cache_dir / 'definitions.pkl', DEFINITION_INDEX_VERSION)
+            cache.load()
+
+        files = self._find_files()
+        by_name: Dict[str, List[Tuple[int, Definition]]] = {}
+        live = set()
+        scanned = 0
+        for order, file_path in enumerate(files):
+            rel_path = file_path.relative_to(self.root).as_posix()
+            live.add(rel_path)
+            definitions = None
+            stat = None
+            try:
+                stat = file_path.stat()
+                if cache is not None:
+                    definitions = cache.lookup(rel_path, file_path, stat)
+            except OSError:
+                continue
+
+            if definitions is None:
+                try:
+                    with open(file_path, 'rb') as f:
+                        data = f.read()
+                except OSError as e:
+                    logger.debug(f"[定义索引] 读取失败 {file_path}: {e}")
+                    continue
+                if b'\0' in data[:_BINARY_SNIFF_BYTES]:
+                    definitions = []
+                else:
+                    definitions = scan_source(rel_path, data.decode('utf-8', errors='ignore'))
+                scanned += 1
+                if cache is not None:
+                    cache.store(rel_path, stat, content_hash(data), definitions)
+
+            for definition in definitions:
+                by_name.setdefault(definition.name, []).append((order, definition))
+
+        if cache is not None:
+            cache.save(live)
+
+        for entries in by_name.values():
+            entries.sort(key=lambda e: (e[0], e[1].line))
+        self._by_name = by_name
+        self._files = [f.relative_to(self.root).as_posix() for f in files]
+        self._built = True
+        logger.info(f"[定义索引] {self.root}: {len(files)} 个文件（重新扫描 {scanned} 个），"
+                    f"{len(by_name)} 个名字")
+
+    def refresh(self):
+        """重新检查文件变化（长驻进程中文件修改后调用）"""
+        with self._lock:
+            self.build()
+
+    def _ensure_built(self):
+        if not self._built:
+            with self._lock:
+                if not self._built:
+                    self.build()
+
+    def _find_files(self) -> List[Path]:
+        """与进程内搜索的语料库一致：跳过隐藏目录和缓存目录，按名字排序"""
+        files = []
+        for dirpath, dirnames, filenames in os.walk(self.root):
+            dirnames[:] = sorted(d for d in dirnames
+                                 if not d.startswith('.') and d != CACHE_DIR_NAME)
+            for filename in sorted(filenames):
+                if os.path.splitext(filename)[1] in INDEXED_EXTENSIONS:
+                    files.append(Path(dirpath) / filename)
+        return files
+
+    def lookup(
+        self,
+        name: str,
+        kinds: Optional[Iterable[str]] = None,
+        file_glob: Optional[str] = None,
+        scope: Optional[Path] = None
+    ) -> List[Definition]:
+        """
+        按名字查找定义（按文件顺序、行号排序，同一行只返回一次）
+
+        Args:
+            name: 标识符
+            kinds: 只返回这些类型（默认全部）
+            file_glob: 文件名通配符（如 '*.h'）
+            scope: 只返回该目录下的文件
+        """
+        self._ensure_built()
+        entries = self._by_name.get(name)
+        if not entries:
+            return []
+
+        kind_set: Optional[Set[str]] = set(kinds) if kinds is not None else None
+        scope_prefix = None
+        if scope is not None and Path(scope).resolve() != self.root:
+            scope_prefix = Path(scope).resolve().relative_to(self.root).as_posix() + '/'
+
+        selected = []
+        seen = set()
+        for _, definition in entries:
+            if kind_set is not None and definition.kind not in kind_set:
+                continue
+            if file_glob and not fnmatch.fnmatchcase(definition.file.rsplit('/', 1)[-1], file_glob):
+                continue
+            if scope_prefix and not definition.file.startswith(scope_prefix):
+                continue
+            key = (definition.file, definition.line)
+            if key in seen:
+                continue
+            seen.add(key)
+            selected.append(definition)
+        return selected
+
+    def definitions_of_kind(self, kind: str, scope: Optional[Path] = None) -> Dict[str, List[Definition]]:
+        """
+        一次取出某一类型的全部定义（用于建立宏表等整表结构）
+
+        Returns:
+            {名字: 定义列表}，每个列表的顺序与 lookup 相同
+        """
+        self._ensure_built()
+        scope_prefix = None
+        if scope is not None and Path(scope).resolve() != self.root:
+            scope_prefix = Path(scope).resolve().relative_to(self.root).as_posix() + '/'
+
+        selected: Dict[str, List[Definition]] = {}
+        for name, entries in self._by_name.items():
+            seen = set()
+            for _, definition in entries:
+                if definition.kind != kind:
+                    continue
+                if scope_prefix and not definition.file.startswith(scope_prefix):
+                    continue
+                key = (definition.file, definition.line)
+                if key in seen:
+                    continue
+                seen.add(key)
+                selected.setdefault(name, []).append(definition)
+        return selected
+
+    def lookup_lines(
+        self,
+        name: str,
+        kinds: Optional[Iterable[str]] = None,
+        file_glob: Optional[str] = None,
+        scope: Optional[Path] = None,
+        verify: Optional[Pattern] = None,
+        max_results: int = 10
+    ) -> List[Tuple[Path, int, str]]:
+        """
+        以 grep 结果的格式返回候选行：[(文件路径, 行号, 行内容), ...]
+
+        Args:
+            verify: 已编译的正则；给出时只保留匹配的行（用于复现原搜索模式）
+        """
+        results = []
+        for definition in self.lookup(name, kinds, file_glob, scope):
+            if verify is not None and not verify.search(definition.text):
+                continue
+            results.append((self.root / definition.file, definition.line, definition.text))
+            if len(results) >= max_results:
+                break
+        return results
+
+    def path_of(self, definition: Definition) -> Path:
+        """定义所在文件的绝对路径"""
+        return self.root / definition.file
+
+
+# 全局选项与进程级索引缓存
+_enabled = True
+_persist = True
+_indexes: Dict[str, DefinitionIndex] = {}
+_indexes_lock = threading.Lock()
+
+
+def configure_definition_index(enabled: bool = True, persist: bool = True):
+    """
+    设置定义索引选项
+
+    Args:
+        enabled: False 时各搜索器回退到逐次文本搜索
+        persist: False 时不读写 .simple_ast_cache/definitions.pkl
+    """
+    global _enabled, _persist
+    _enabled = enabled
+    _persist = persist
+    clear_definition_indexes()
+
+
+def get_definition_index_options() -> Tuple[bool, bool]:
+    """当前的 (enabled, persist) 设置（传给工作进程时使用）"""
+    return _enabled, _persist
+
+
+def clear_definition_indexes():
+    """丢弃进程内已加载的索引"""
+    with _indexes_lock:
+        _indexes.clear()
+
+
+def get_definition_index(project_root) -> Tuple[Optional[DefinitionIndex], Optional[Path]]:
+    """
+    获取覆盖 project_root 的索引
+
+    已有索引的根目录是 project_root 的上级目录时直接复用（配合 scope 过滤），
+    避免为子目录重复建索引。
+
+    Returns:
+        (索引, scope)；索引未启用时返回 (None, None)
+    """
+    if not _enabled:
+        return None, None
+
+    root = Path(project_root).resolve()
+    with _indexes_lock:
+        for index in _indexes.values():
+            if index.root == root or index.root in root.parents:
+                return index, root
+        index = DefinitionIndex(root, persist=_persist)
+        _indexes[os.path.normcase(str(root))] = index
+        return index, root
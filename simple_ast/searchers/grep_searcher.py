@@ -1,7 +1,9 @@
 """
 基于 grep 命令的搜索器
 
-使用系统的 grep 命令（Git Bash 自带）或 ripgrep 进行快速文本搜索
+使用系统的 grep 命令（Git Bash 自带）或 ripgrep 进行快速文本搜索；
+配置为 SearchTool.PYTHON 时改用进程内搜索（见 memory_searcher），不启动子进程。
+ripgrep 的内容搜索走 rg --json 流式解析，够数后立即结束（见 rg_stream）
 """
 import subprocess
 import re
@@ -11,7 +13,10 @@ from pathlib import Path
 from typing import List, Optional, Tuple, Dict
 import sys
 from .search_config import get_search_config
-from ..logger import get_logger
+from .memory_searcher import MemorySearcher, MultiPatternMatcher, compile_pattern
+from .definition_index import get_definition_index
+from .rg_stream import RG_BATCH_TIMEOUT, rg_json_command, search_rg, stream_matches
+from ..logger import count, get_logger, traced
 
 logger = get_logger()
 
@@ -26,7 +31,16 @@ class GrepSearcher:
         """
         self.project_root = Path(project_root).resolve()
         self.config = get_search_config()  # 获取全局配置
+        self._memory: Optional[MemorySearcher] = None
 
+    @property
+    def memory(self) -> MemorySearcher:
+        """进程内搜索器（语料库在进程内共享）"""
+        if self._memory is None:
+            self._memory = MemorySearcher(self.project_root)
+        return self._memory
+
+    @traced('search.files', 'search')
     def search_files(
         self,
         pattern: str,
@@ -46,6 +60,9 @@ class GrepSearcher:
         Returns:
             匹配的文件路径列表
         """
+        if self.config.in_process:
+            return self.memory.search_files(pattern, file_glob, max_results, ignore_case)
+
         # 使用配置构建命令
         cmd = self.config.build_search_command(
             pattern=pattern,
@@ -56,6 +73,7 @@ class GrepSearcher:
         )
 
         try:
+            count('search.subprocess')
             result = subprocess.run(
                 cmd,
                 capture_output=True,
@@ -83,6 +101,7 @@ class GrepSearcher:
             logger.error(f"grep异常: {e}")
             return []
 
+    @traced('search.content', 'search')
     def search_content(
         self,
         pattern: str,
@@ -104,6 +123,14 @@ class GrepSearcher:
         Returns:
             列表：[(文件路径, 行号, 匹配的行内容), ...]
         """
+        if self.config.in_process:
+            return self.memory.search_content(pattern, file_glob, max_results)
+
+        if self.config.command == 'rg':
+            # 每个文件最多也只需要 max_results 行
+            cmd = rg_json_command(self.project_root, file_glob, [pattern], max_count=max_results)
+            return search_rg(cmd, max_results)
+
         # 使用脚本文件方式执行，避免参数传递问题
         return self._search_via_script(
             pattern=pattern,
@@ -112,6 +139,7 @@ class GrepSearcher:
             show_line_numbers=show_line_numbers
         )
 
+    @traced('search.content_batch', 'search')
     def search_content_batch(
         self,
         patterns: List[str],
@@ -132,11 +160,29 @@ class GrepSearcher:
         if not patterns:
             return {}
 
+        if self.config.in_process:
+            return self.memory.search_content_batch(patterns, file_glob, max_results_per_pattern)
+
+        pattern_path = None
         try:
             # 根据操作系统选择脚本类型
             is_windows = sys.platform == 'win32'
             suffix = '.bat' if is_windows else '.sh'
 
+            # 模式写入文件（-f），避免命令行长度限制和引号转义问题
+            with tempfile.NamedTemporaryFile(
+                mode='w',
+                suffix='.txt',
+                delete=False,
+                encoding='utf-8',
+                newline='\n'
+            ) as pattern_file:
+                pattern_path = pattern_file.name
+                pattern_file.write('\n'.join(patterns) + '\n')
+
+            if self.config.command == 'rg':
+                return self._search_batch_rg(patterns, file_glob, max_results_per_pattern, pattern_path)
+
             # 创建临时脚本文件
             with tempfile.NamedTemporaryFile(
                 mode='w',
@@ -147,14 +193,8 @@ class GrepSearcher:
                 script_path = script_file.name
 
                 # 构建批量搜索命令
-                if self.config.command == 'rg':
-                    # ripgrep 支持多个 -e 参数
-                    pattern_args = ' '.join([f'-e "{p}"' for p in patterns])
-                    cmd = f'rg -n --glob="{file_glob}" {pattern_args} "{self.project_root}"'
-                elif self.config.command == 'grep':
-                    # grep 使用 -e 参数
-                    pattern_args = ' '.join([f'-e "{p}"' for p in patterns])
-                    cmd = f'grep -r -E -n --include="{file_glob}" {pattern_args} "{self.project_root}"'
+                if self.config.command == 'grep':
+                    cmd = f'grep -r -E -n --include="{file_glob}" -f "{pattern_path}" "{self.project_root}"'
                 else:
                     return {}
 
@@ -169,6 +209,7 @@ class GrepSearcher:
 
             # 执行脚本
             if is_windows:
+                count('search.subprocess')
                 result = subprocess.run(
                     [script_path],
                     capture_output=True,
@@ -179,6 +220,7 @@ class GrepSearcher:
                     shell=True
                 )
             else:
+                count('search.subprocess')
                 result = subprocess.run(
                     ['bash', script_path],
                     capture_output=True,
@@ -198,8 +240,9 @@ class GrepSearcher:
                 logger.error(f"批量搜索错误: {result.stderr}")
                 return {}
 
-            # 解析输出并按模式分组
+            # 解析输出并按模式分组（同一行可以命中多个模式）
             results_by_pattern = {p: [] for p in patterns}
+            matcher = MultiPatternMatcher(patterns)
 
             for line in result.stdout.splitlines():
                 parsed = self._parse_grep_line(line)
@@ -208,20 +251,132 @@ class GrepSearcher:
 
                 file_path, line_num, content = parsed
 
-                # 判断这行匹配哪个模式
-                for pattern in patterns:
-                    try:
-                        if re.search(pattern, content):
-                            if len(results_by_pattern[pattern]) < max_results_per_pattern:
-                                results_by_pattern[pattern].append((file_path, line_num, content))
-                    except re.error:
-                        continue
+                for pattern in matcher.match_line(content):
+                    if len(results_by_pattern[pattern]) < max_results_per_pattern:
+                        results_by_pattern[pattern].append((file_path, line_num, content))
 
             return results_by_pattern
 
         except Exception as e:
             logger.error(f"批量搜索异常: {e}")
             return {}
+        finally:
+            if pattern_path:
+                try:
+                    os.unlink(pattern_path)
+                except OSError:
+                    pass
+
+    def _search_batch_rg(
+        self,
+        patterns: List[str],
+        file_glob: str,
+        max_results_per_pattern: int,
+        pattern_path: str
+    ) -> Dict[str, List[Tuple[Path, int, str]]]:
+        """rg 批量搜索：流式按模式分组，所有模式都够数后立即结束 rg"""
+        results_by_pattern = {p: [] for p in patterns}
+        matcher = MultiPatternMatcher(patterns)
+        unfilled = len(results_by_pattern)
+        cmd = rg_json_command(self.project_root, file_glob, pattern_file=pattern_path)
+
+        stream = stream_matches(cmd, timeout=RG_BATCH_TIMEOUT)
+        try:
+            for file_path, line_num, content in stream:
+                for pattern in matcher.match_line(content):
+                    bucket = results_by_pattern[pattern]
+                    if len(bucket) < max_results_per_pattern:
+                        bucket.append((file_path, line_num, content))
+                        if len(bucket) == max_results_per_pattern:
+                            unfilled -= 1
+                if unfilled == 0:
+                    break
+        finally:
+            stream.close()
+        return results_by_pattern
+
+    def search_definitions(
+        self,
+        name: str,
+        kinds: Tuple[str, ...],
+        pattern: Optional[str],
+        file_glob: str = '*.h',
+        max_results: int = 10,
+        fallback_on_miss: bool = False
+    ) -> List[Tuple[Path, int, str]]:
+        """
+        按名字查找定义行：优先查定义索引（字典命中 + 原模式确认），索引未启用时退回文本搜索
+
+        Args:
+            name: 标识符
+            kinds: 定义索引中的定义类型（见 definition_index.KIND_*）
+            pattern: 原来的 grep 模式，用于确认候选行；为 None 时只查索引
+            file_glob: 文件匹配模式
+            max_results: 最多返回结果数
+            fallback_on_miss: 索引没有命中时是否再做一次文本搜索
+                              （用于索引只做近似判断的类型，如全局变量）
+
+        Returns:
+            列表：[(文件路径, 行号, 匹配的行内容), ...]
+        """
+        index, scope = (None, None)
+        if re.fullmatch(r'\w+', name):
+            index, scope = get_definition_index(self.project_root)
+
+        if index is None:
+            if pattern is None:
+                return []
+            return self.search_content(pattern=pattern, file_glob=file_glob, max_results=max_results)
+
+        verify = None
+        if pattern is not None:
+            verify = compile_pattern(pattern)
+            if verify is None:
+                return []
+        matches = index.lookup_lines(name, kinds, file_glob, scope, verify, max_results)
+        count('definition_index.hit' if matches else 'definition_index.miss')
+        if not matches and fallback_on_miss and pattern is not None:
+            return self.search_content(pattern=pattern, file_glob=file_glob, max_results=max_results)
+        return matches
+
+    @traced('search.definitions_batch', 'search')
+    def search_definitions_batch(
+        self,
+        name_patterns: Dict[str, str],
+        kinds: Tuple[str, ...],
+        file_glob: str = '*.h',
+        max_results_per_name: int = 1
+    ) -> Dict[str, List[Tuple[Path, int, str]]]:
+        """
+        批量按名字查找定义行
+
+        定义索引启用时每个名字都是字典查找；否则所有模式合并成一次批量文本搜索。
+
+        Args:
+            name_patterns: {名字: 原 grep 模式}
+            kinds: 定义索引中的定义类型
+            file_glob: 文件匹配模式
+            max_results_per_name: 每个名字最多返回结果数
+
+        Returns:
+            字典：{名字: [(文件路径, 行号, 匹配的行内容), ...]}
+        """
+        if not name_patterns:
+            return {}
+
+        index, _ = get_definition_index(self.project_root)
+        if index is not None:
+            return {
+                name: self.search_definitions(name, kinds, pattern, file_glob, max_results_per_name)
+                for name, pattern in name_patterns.items()
+            }
+
+        batch = self.search_content_batch(
+            patterns=list(name_patterns.values()),
+            file_glob=file_glob,
+            max_results_per_pattern=max_results_per_name
+        )
+        return {name: batch.get(pattern, []) for name, pattern in name_patterns.items()}
 
     def _search_via_script(
         self,
@@ -256,11 +411,9 @@ class GrepSearcher:
             ) as script_file:
                 script_path = script_file.name
 
-                # 根据工具类型构建命令
+                # 根据工具类型构建命令（rg 走 search_content 中的流式搜索）
                 if self.config.command == 'grep':
                     cmd = f'grep -r -E -n --include="{file_glob}" "{pattern}" "{self.project_root}"'
-                elif self.config.command == 'rg':
-                    cmd = f'rg -n --glob="{file_glob}" "{pattern}" "{self.project_root}"'
                 else:
                     return []
 
@@ -278,6 +431,7 @@ class GrepSearcher:
             # 执行脚本
             if is_windows:
                 # Windows 上直接执行批处理文件
+                count('search.subprocess')
                 result = subprocess.run(
                     [script_path],
                     capture_output=True,
@@ -289,6 +443,7 @@ class GrepSearcher:
                 )
             else:
                 # Linux/Mac 上使用 bash 执行
+                count('search.subprocess')
                 result = subprocess.run(
                     ['bash', script_path],
                     capture_output=True,
@@ -404,6 +559,7 @@ class GrepSearcher:
                 cmd.insert(-2, f'-C{context_lines}')
 
         try:
+            count('search.subprocess')
             result = subprocess.run(
                 cmd,
                 capture_output=True,
@@ -5,27 +5,56 @@
 - _extract_constants_from_function() 中的头文件搜索
 - _search_function_signature() 中的头文件搜索
 - _try_read_external_data_structure() 中的头文件搜索
+
+指定项目根目录时优先使用 #include 传递闭包（见 include_resolver.py），
+只有目标文件没有可解析的项目内包含时才退回到目录启发式搜索。
 """
 from pathlib import Path
-from typing import List
+from typing import List, Optional
+from .include_resolver import get_include_resolver
 
 
 class HeaderSearcher:
     """头文件搜索器 - 简单实用，不过度设计"""
 
-    def __init__(self, max_files: int = 50, max_depth: int = 3):
+    def __init__(self, max_files: int = 50, max_depth: int = 3, project_root: Optional[str] = None):
         """
         Args:
             max_files: 最多搜索的文件数量
             max_depth: 向上搜索的最大层级
+            project_root: 项目根目录（指定后按 #include 闭包查找）
         """
         self.max_files = max_files
         self.max_depth = max_depth
+        self.project_root = project_root
 
     def find_headers(self, target_file: str) -> List[Path]:
         """
         查找所有相关的头文件
 
+        有项目根目录时：当前文件本身 + 它传递包含的项目头文件（先直接包含，再间接包含）。
+        没有可用的包含关系时按目录启发式搜索。
+
+        Args:
+            target_file: 目标源文件路径
+
+        Returns:
+            头文件路径列表（去重，限制数量）
+        """
+        if self.project_root:
+            target_path = Path(target_file)
+            if not target_path.is_absolute():
+                target_path = Path(self.project_root) / target_path
+            closure = get_include_resolver(self.project_root).include_closure(target_path)
+            if closure:
+                return ([target_path] + closure)[:self.max_files]
+
+        return self._find_headers_by_directory(target_file)
+
+    def _find_headers_by_directory(self, target_file: str) -> List[Path]:
+        """
+        按目录结构猜测相关的头文件
+
         搜索策略：
         1. 当前 .cpp 文件本身（枚举可能在文件内部）
         2. 同目录的同名 .h 文件
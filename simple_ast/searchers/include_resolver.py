@@ -0,0 +1,199 @@
+"""
+#include 解析器 - 按翻译单元计算传递包含闭包
+
+HeaderSearcher 只在这个闭包里找头文件：实际被包含的头文件才可能提供
+常量、宏、结构体和函数声明，顺序按包含层级（先直接包含，再间接包含）。
+
+- 每个文件的 #include 列表只读取一次（按 mtime/大小失效）；
+  全量模式下可直接使用 ProjectIndexer.include_graph，不再读文件（sqlite 存储时
+  按需逐个查询，不整表载入内存）
+- 包含名先按包含者所在目录解析，再在项目头文件中按路径后缀匹配，
+  多个候选时取与包含者目录公共前缀最长的（相同时优先 include/ 目录下的）
+- 系统头文件（项目中找不到的）忽略
+"""
+import os
+import re
+import threading
+from pathlib import Path
+from typing import Dict, List, Mapping, Optional, Tuple
+from ..index_cache import CACHE_DIR_NAME
+from ..logger import count, get_logger, traced
+
+logger = get_logger()
+
+HEADER_EXTENSIONS = {'.h', '.hh', '.hpp', '.hxx', '.inc', '.inl'}
+
+_INCLUDE_RE = re.compile(r'^\s*#\s*include\s*[<"]([^>"]+)[>"]', re.MULTILINE)
+
+
+class IncludeResolver:
+    """项目级 #include 解析与闭包缓存"""
+
+    def __init__(self, project_root):
+        self.root = Path(project_root).resolve()
+        self._lock = threading.RLock()
+        self._headers_by_name: Optional[Dict[str, List[Path]]] = None  # 文件名 -> 项目内头文件
+        self._direct: Dict[Path, Tuple[Tuple[int, int], List[Path]]] = {}  # 文件 -> (stat, 直接包含)
+        self._closures: Dict[Path, List[Path]] = {}
+        self._include_graph: Mapping[str, List[str]] = {}  # 相对路径 -> 包含名
+
+    def use_include_graph(self, include_graph: Mapping[str, List[str]]):
+        """
+        使用 ProjectIndexer 已经解析出的 include 名（相对路径 -> 包含名列表）
+
+        直接引用而不复制：sqlite 存储的 include_graph 每次查找是一条查询
+        """
+        with self._lock:
+            self._include_graph = include_graph
+            self._direct.clear()
+            self._closures.clear()
+
+    def clear(self):
+        """文件增删或修改后调用"""
+        with self._lock:
+            self._headers_by_name = None
+            self._direct.clear()
+            self._closures.clear()
+            self._include_graph = {}
+
+    @traced('include.closure', 'search')
+    def include_closure(self, file_path) -> List[Path]:
+        """
+        文件传递包含的项目头文件（不含自身），按广度优先顺序
+
+        Args:
+            file_path: 源文件路径（绝对路径，或相对项目根目录）
+        """
+        path = self._absolute(file_path)
+        with self._lock:
+            cached = self._closures.get(path)
+            if cached is not None:
+                count('include.closure_hit')
+                return cached
+
+            closure: List[Path] = []
+            seen = {path}
+            queue = [path]
+            while queue:
+                current = queue.pop(0)
+                for included in self.direct_includes(current):
+                    if included not in seen:
+                        seen.add(included)
+                        closure.append(included)
+                        queue.append(included)
+
+            self._closures[path] = closure
+            return closure
+
+    def direct_includes(self, file_path) -> List[Path]:
+        """文件直接包含、且能在项目中解析到的头文件"""
+        path = self._absolute(file_path)
+        with self._lock:
+            names = self._graph_includes(path)
+            if names is not None:
+                key = (0, 0)
+            else:
+                try:
+                    stat = path.stat()
+                except OSError:
+                    return []
+                key = (stat.st_mtime_ns, stat.st_size)
+
+            cached = self._direct.get(path)
+            if cached is not None and cached[0] == key:
+                return cached[1]
+
+            if names is None:
+                names = self._read_include_names(path)
+            resolved = []
+            for name in names:
+                target = self.resolve(name, path)
+                if target is not None and target not in resolved:
+                    resolved.append(target)
+            self._direct[path] = (key, resolved)
+            return resolved
+
+    def _graph_includes(self, path: Path) -> Optional[List[str]]:
+        try:
+            rel_path = str(path.relative_to(self.root))
+        except ValueError:
+            return None
+        return self._include_graph.get(rel_path)
+
+    def resolve(self, include_name: str, including_file: Path) -> Optional[Path]:
+        """把 #include 名解析为项目内的文件，找不到（系统头文件等）返回 None"""
+        local = including_file.parent / include_name
+        if local.is_file():
+            return local.resolve()
+
+        suffix = os.path.normcase(os.path.normpath(include_name))
+        candidates = [p for p in self._header_index().get(os.path.basename(suffix), [])
+                      if self._path_endswith(p, suffix)]
+        if not candidates:
+            return None
+        if len(candidates) == 1:
+            return candidates[0]
+
+        # 与包含者目录公共前缀最长的优先，其次是 include/ 目录下的，再次是路径最短的
+        including_dir = str(including_file.parent)
+        return min(candidates, key=lambda p: (-len(os.path.commonpath([including_dir, str(p)])),
+                                              'include' not in p.parts, len(str(p)), str(p)))
+
+    @staticmethod
+    def _path_endswith(path: Path, suffix: str) -> bool:
+        normalized = os.path.normcase(str(path))
+        return normalized == suffix or normalized.endswith(os.sep + suffix)
+
+    @staticmethod
+    def _read_include_names(path: Path) -> List[str]:
+        try:
+            with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+                text = f.read()
+        except OSError:
+            return []
+        count('include.read')
+        return _INCLUDE_RE.findall(text)
+
+    def _header_index(self) -> Dict[str, List[Path]]:
+        """一次遍历项目建立 文件名 -> 头文件 的索引（跳过隐藏目录和缓存目录）"""
+        if self._headers_by_name is None:
+            headers: Dict[str, List[Path]] = {}
+            for dirpath, dirnames, filenames in os.walk(self.root):
+                dirnames[:] = sorted(d for d in dirnames
+                                     if not d.startswith('.') and d != CACHE_DIR_NAME)
+                for filename in sorted(filenames):
+                    if os.path.splitext(filename)[1] in HEADER_EXTENSIONS:
+                        headers.setdefault(os.path.normcase(filename), []).append(Path(dirpath) / filename)
+            self._headers_by_name = headers
+            logger.info(f"[包含解析] 项目中共 {sum(len(v) for v in headers.values())} 个头文件")
+        return self._headers_by_name
+
+    def _absolute(self, file_path) -> Path:
+        path = Path(file_path)
+        if not path.is_absolute():
+            path = self.root / path
+        return path.resolve()
+
+
+# 进程级解析器缓存（按项目根目录）
+_resolvers: Dict[str, IncludeResolver] = {}
+_resolvers_lock = threading.Lock()
+
+
+def get_include_resolver(project_root) -> IncludeResolver:
+    """获取 project_root 的解析器（同一进程内共享）"""
+    root = Path(project_root).resolve()
+    key = os.path.normcase(str(root))
+    with _resolvers_lock:
+        resolver = _resolvers.get(key)
+        if resolver is None:
+            resolver = IncludeResolver(root)
+            _resolvers[key] = resolver
+        return resolver
+
+
+def clear_include_resolvers():
+    """丢弃已计算的包含闭包（文件变化后调用）"""
+    with _resolvers_lock:
+        for resolver in _resolvers.values():
+            resolver.clear()
@@ -0,0 +1,308 @@
+"""
+进程内搜索引擎 - 不再为每次查询启动 grep/rg 子进程
+
+- SourceCorpus：按项目根目录缓存文件内容（整个进程只读一次磁盘）
+- MemorySearcher：编译后的正则在内存中按行匹配，批量查询时多个模式合并成一个
+  交替表达式，一次扫描完成
+
+输出格式与 GrepSearcher 的 grep/rg 路径一致：[(文件路径, 行号, 行内容), ...]
+"""
+import fnmatch
+import os
+import re
+import threading
+from pathlib import Path
+from typing import Dict, List, Optional, Pattern, Tuple
+from ..index_cache import CACHE_DIR_NAME
+from ..logger import count, get_logger
+
+logger = get_logger()
+
+# POSIX 字符类 -> Python 正则（只出现在方括号表达式内，如 [[:space:](]）
+_POSIX_CLASSES = {
+    'space': r'\s',
+    'blank': r' \t',
+    'alnum': r'a-zA-Z0-9',
+    'alpha': r'a-zA-Z',
+    'digit': r'0-9',
+    'xdigit': r'0-9A-Fa-f',
+    'upper': r'A-Z',
+    'lower': r'a-z',
+    'punct': r'!-/:-@\[-`{-~',
+}
+_POSIX_CLASS_RE = re.compile(r'\[:(\w+):\]')
+
+# 判断二进制文件时检查的前缀长度（与 grep 的启发式一致：含 NUL 即视为二进制）
+_BINARY_SNIFF_BYTES = 8192
+
+
+def translate_pattern(pattern: str) -> str:
+    """
+    把 grep -E / rg 的模式转换成 Python 正则
+
+    目前只需要处理 POSIX 字符类；\\b \\s \\w 等 GNU 扩展 Python 原生支持。
+    """
+    def replace(match):
+        return _POSIX_CLASSES.get(match.group(1), match.group(0))
+    return _POSIX_CLASS_RE.sub(replace, pattern)
+
+
+def compile_pattern(pattern: str, ignore_case: bool = False) -> Optional[Pattern]:
+    """编译模式，失败返回 None"""
+    flags = re.MULTILINE | (re.IGNORECASE if ignore_case else 0)
+    try:
+        return re.compile(translate_pattern(pattern), flags)
+    except re.error as e:
+        logger.error(f"[内存搜索] 无效的正则表达式 {pattern}: {e}")
+        return None
+
+
+class SourceFile:
+    """语料库中的单个文件（内容按需加载，之后常驻内存）"""
+
+    __slots__ = ('path', 'name', '_text', '_lines')
+
+    def __init__(self, path: Path):
+        self.path = path
+        self.name = path.name
+        self._text: Optional[str] = None
+        self._lines: Optional[List[str]] = None
+
+    @property
+    def text(self) -> str:
+        """文件全文（二进制文件或读取失败时为空串）"""
+        if self._text is None:
+            self._text = self._load()
+        return self._text
+
+    @property
+    def lines(self) -> List[str]:
+        """按行切分（不含换行符，与 grep 输出一致）"""
+        if self._lines is None:
+            self._lines = [line[:-1] if line.endswith('\r') else line
+                           for line in self.text.split('\n')]
+        return self._lines
+
+    def _load(self) -> str:
+        count('search.corpus_file_load')
+        try:
+            with open(self.path, 'rb') as f:
+                data = f.read()
+        except OSError as e:
+            logger.debug(f"[内存搜索] 读取失败 {self.path}: {e}")
+            return ''
+        if b'\0' in data[:_BINARY_SNIFF_BYTES]:
+            return ''
+        return data.decode('utf-8', errors='ignore')
+
+
+class SourceCorpus:
+    """单个项目根目录下的文件语料库"""
+
+    def __init__(self, root: Path):
+        self.root = root
+        self.files: List[SourceFile] = []
+        self._by_glob: Dict[str, List[SourceFile]] = {}
+        self._lock = threading.Lock()
+        self._scan()
+
+    def _scan(self):
+        """遍历目录（跳过隐藏目录和缓存目录，与 rg 的默认行为一致）"""
+        files = []
+        for dirpath, dirnames, filenames in os.walk(self.root):
+            dirnames[:] = sorted(d for d in dirnames
+                                 if not d.startswith('.') and d != CACHE_DIR_NAME)
+            for filename in sorted(filenames):
+                files.append(SourceFile(Path(dirpath) / filename))
+        self.files = files
+        self._by_glob = {}
+        logger.debug(f"[内存搜索] 语料库 {self.root}: {len(files)} 个文件")
+
+    def refresh(self):
+        """重新扫描目录并丢弃已加载的内容（文件变化后调用）"""
+        with self._lock:
+            self._scan()
+
+    def files_matching(self, file_glob: Optional[str]) -> List[SourceFile]:
+        """按文件名通配符过滤（与 grep --include / rg --glob 一样只看文件名）"""
+        if not file_glob:
+            return self.files
+        with self._lock:
+            matched = self._by_glob.get(file_glob)
+            if matched is None:
+                matched = [f for f in self.files if fnmatch.fnmatchcase(f.name, file_glob)]
+                self._by_glob[file_glob] = matched
+            return matched
+
+
+# 进程级语料库缓存：resolved root -> SourceCorpus
+_corpora: Dict[str, SourceCorpus] = {}
+_corpora_lock = threading.Lock()
+
+
+def get_corpus(project_root) -> SourceCorpus:
+    """获取（必要时创建）项目的语料库"""
+    root = Path(project_root).resolve()
+    key = os.path.normcase(str(root))
+    with _corpora_lock:
+        corpus = _corpora.get(key)
+        if corpus is None:
+            corpus = SourceCorpus(root)
+            _corpora[key] = corpus
+        return corpus
+
+
+def clear_corpus_cache():
+    """清空所有语料库（用于长驻进程在文件变化后重新加载）"""
+    with _corpora_lock:
+        _corpora.clear()
+
+
+class MemorySearcher:
+    """在内存语料库上执行 grep 风格的行匹配"""
+
+    def __init__(self, project_root):
+        self.corpus = get_corpus(project_root)
+
+    def search_files(
+        self,
+        pattern: str,
+        file_glob: Optional[str] = '*.h',
+        max_results: int = 10,
+        ignore_case: bool = False
+    ) -> List[Path]:
+        """返回包含匹配的文件（grep -l）"""
+        count('search.in_process')
+        regex = compile_pattern(pattern, ignore_case)
+        if regex is None:
+            return []
+
+        files = []
+        for source in self.corpus.files_matching(file_glob):
+            if len(files) >= max_results:
+                break
+            if not regex.search(source.text):
+                continue
+            # 整体命中后再按行确认：跨行的 \s 之类在 grep 中不会匹配
+            if any(regex.search(line) for line in source.lines):
+                files.append(source.path)
+        return files
+
+    def search_content(
+        self,
+        pattern: str,
+        file_glob: Optional[str] = '*.h',
+        max_results: int = 10,
+        ignore_case: bool = False
+    ) -> List[Tuple[Path, int, str]]:
+        """返回匹配行（grep -n）"""
+        count('search.in_process')
+        regex = compile_pattern(pattern, ignore_case)
+        if regex is None:
+            return []
+
+        matches = []
+        for source in self.corpus.files_matching(file_glob):
+            # 整个文件没有匹配时直接跳过，不用逐行
+            if not regex.search(source.text):
+                continue
+            for line_num, line in enumerate(source.lines, 1):
+                if regex.search(line):
+                    matches.append((source.path, line_num, line))
+                    if len(matches) >= max_results:
+                        return matches
+        return matches
+
+    def search_content_batch(
+        self,
+        patterns: List[str],
+        file_glob: Optional[str] = '*.h',
+        max_results_per_pattern: int = 10
+    ) -> Dict[str, List[Tuple[Path, int, str]]]:
+        """
+        一次扫描匹配多个模式
+
+        所有模式合并成一个交替表达式（MultiPatternMatcher）做文件级和行级预过滤，
+        只有命中的行再逐个模式确认。
+        """
+        results: Dict[str, List[Tuple[Path, int, str]]] = {p: [] for p in patterns}
+        count('search.in_process')
+        matcher = MultiPatternMatcher(patterns)
+        if not matcher:
+            return results
+
+        remaining = len(matcher)
+        for source in self.corpus.files_matching(file_glob):
+            if remaining <= 0:
+                break
+            if not matcher.search(source.text):
+                continue
+            for line_num, line in enumerate(source.lines, 1):
+                for pattern in matcher.match_line(line):
+                    hits = results[pattern]
+                    if len(hits) < max_results_per_pattern:
+                        hits.append((source.path, line_num, line))
+                        if len(hits) == max_results_per_pattern:
+                            remaining -= 1
+        return results
+
+
+# 无法合并进交替表达式的模式：反向引用、命名分组、内联全局标志
+_UNMERGEABLE_RE = re.compile(r'\\[1-9]|\(\?P[<=]|\(\?[aiLmsux]+\)')
+
+
+class MultiPatternMatcher:
+    """
+    多个模式合并成一个带命名分组的交替表达式
+
+    合并后的表达式做整文件/整行预过滤：不命中的行（绝大多数）只做一次 search。
+    命中的行再用各模式自己的正则逐个确认，因为交替表达式的 finditer 只给出互不重叠的匹配，
+    同一行命中两个模式（如 `} MSG_CB, MsgBlock;` 同时是两个 typedef 名）时会漏掉后一个。
+    逐个确认只发生在命中的行上，开销与输出行数成线性。
+    """
+
+    def __init__(self, patterns: List[str], ignore_case: bool = False):
+        self.patterns: List[str] = []
+        self.regex: Optional[Pattern] = None
+        self._merged: List[Tuple[str, Pattern]] = []    # 合并进交替表达式的模式
+        self._fallback: List[Tuple[str, Pattern]] = []  # 无法合并的模式，逐个匹配
+
+        parts = []
+        for pattern in dict.fromkeys(patterns):
+            compiled = compile_pattern(pattern, ignore_case)
+            if compiled is None:
+                continue
+            self.patterns.append(pattern)
+            if _UNMERGEABLE_RE.search(compiled.pattern):
+                self._fallback.append((pattern, compiled))
+                continue
+            self._merged.append((pattern, compiled))
+            parts.append(f'(?:{compiled.pattern})')
+
+        if parts:
+            flags = re.MULTILINE | (re.IGNORECASE if ignore_case else 0)
+            self.regex = re.compile('|'.join(parts), flags)
+
+    def __len__(self) -> int:
+        return len(self.patterns)
+
+    def search(self, text: str) -> bool:
+        """文本中是否有任一模式匹配（用于整文件预过滤）"""
+        if self.regex is not None and self.regex.search(text):
+            return True
+        return any(regex.search(text) for _, regex in self._fallback)
+
+    def match_line(self, line: str) -> List[str]:
+        """返回该行命中的全部模式（按首个匹配位置排序，位置相同时按模式顺序，不重复）"""
+        found: List[Tuple[int, int, str]] = []
+        if self.regex is not None and self.regex.search(line):
+            for order, (pattern, regex) in enumerate(self._merged):
+                m = regex.search(line)
+                if m:
+                    found.append((m.start(), order, pattern))
+        for order, (pattern, regex) in enumerate(self._fallback, len(self._merged)):
+            m = regex.search(line)
+            if m:
+                found.append((m.start(), order, pattern))
+        found.sort()
+        return [pattern for _, _, pattern in found]
@@ -0,0 +1,200 @@
+"""
+ripgrep JSON 流式搜索 - 边读边解析 rg --json 的输出，够数后立即结束 rg
+
+- 命令以参数列表直接启动 rg（不经过 shell 和临时脚本），模式中的引号、$ 等不需要转义
+- 逐行解析 JSON 事件，只取 "match"；路径或内容不是合法 UTF-8 时 rg 输出 base64 的 bytes 字段
+- 拿到 max_results 条匹配后立即结束 rg 进程：search_first_match 不再扫完整个项目
+- 外部搜索共用一个有界线程池（map_searches）：多个查询并发执行，
+  同时运行的 rg 进程数不超过 configure_search_concurrency 设置的上限（命令行的 --jobs；
+  工作进程中为 1，并行度已经由进程数提供）
+"""
+import base64
+import json
+import os
+import subprocess
+import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import closing
+from pathlib import Path
+from typing import Callable, Iterable, Iterator, List, Optional, Sequence, Tuple, TypeVar
+
+from ..logger import count, get_logger
+from .search_config import get_search_config
+
+logger = get_logger()
+
+T = TypeVar('T')
+R = TypeVar('R')
+
+RG_TIMEOUT = 30         # 单次搜索超时（秒）
+RG_BATCH_TIMEOUT = 60   # 批量搜索可能需要更长时间
+
+# 并发搜索上限：线程池大小，同时也是同时运行的 rg 进程数上限
+_max_concurrent = min(8, os.cpu_count() or 1)
+_slots = threading.BoundedSemaphore(_max_concurrent)
+_pool: Optional[ThreadPoolExecutor] = None
+_pool_lock = threading.Lock()
+_local = threading.local()  # in_pool：当前线程是否是搜索池的工作线程
+
+
+def configure_search_concurrency(max_concurrent: int):
+    """设置并发搜索上限（已创建的线程池会在下次使用时按新大小重建）"""
+    global _max_concurrent, _slots, _pool
+    max_concurrent = max(1, max_concurrent)
+    with _pool_lock:
+        if max_concurrent == _max_concurrent:
+            return
+        _max_concurrent = max_concurrent
+        _slots = threading.BoundedSemaphore(max_concurrent)
+        old_pool, _pool = _pool, None
+    if old_pool is not None:
+        old_pool.shutdown(wait=False)
+
+
+def rg_json_command(root, file_glob: str, patterns: Sequence[str] = (),
+                    pattern_file: Optional[str] = None, ignore_case: bool = False,
+                    max_count: Optional[int] = None) -> List[str]:
+    """
+    构建 rg --json 命令
+
+    Args:
+        root: 搜索目录
+        file_glob: 文件匹配模式
+        patterns: 正则表达式（每个一个 -e）
+        pattern_file: 模式文件（-f，批量搜索用，避免命令行长度限制）
+        ignore_case: 是否忽略大小写
+        max_count: 每个文件最多匹配行数
+    """
+    cmd = ['rg', '--json', f'--glob={file_glob}']
+    if ignore_case:
+        cmd.append('-i')
+    if max_count:
+        cmd.append(f'--max-count={max_count}')
+    for pattern in patterns:
+        cmd.append(f'--regexp={pattern}')
+    if pattern_file:
+        cmd.append(f'--file={pattern_file}')
+    cmd += ['--', str(root)]
+    return cmd
+
+
+def _decode(field: dict) -> str:
+    """rg JSON 中的 {"text": ...} 或 {"bytes": base64}"""
+    if 'text' in field:
+        return field['text']
+    return base64.b64decode(field.get('bytes', '')).decode('utf-8', errors='ignore')
+
+
+def parse_match_event(line: bytes) -> Optional[Tuple[Path, int, str]]:
+    """
+    解析 rg --json 的一行
+
+    Returns:
+        match 事件的 (文件路径, 行号, 行内容)；其他事件（begin/end/summary/context）返回 None
+    """
+    try:
+        event = json.loads(line)
+    except ValueError:
+        return None
+    if event.get('type') != 'match':
+        return None
+    data = event['data']
+    content = _decode(data['lines']).rstrip('\r\n')
+    return Path(_decode(data['path'])), data['line_number'], content
+
+
+def stream_matches(cmd: List[str], timeout: float = RG_TIMEOUT) -> Iterator[Tuple[Path, int, str]]:
+    """
+    启动 rg --json 并逐条产出匹配 (文件路径, 行号, 行内容)
+
+    调用方不再迭代时（关闭生成器）立即结束 rg；超时也会结束 rg 并停止产出。
+    运行期间占用一个并发名额。
+    """
+    slots = _slots
+    with slots:
+        count('search.subprocess')
+        count('search.rg_stream')
+        # stderr 写到临时文件：rg 报大量错误时也不会因为管道写满而阻塞
+        with tempfile.TemporaryFile() as stderr:
+            try:
+                proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=stderr,
+                                        stdin=subprocess.DEVNULL)
+            except OSError as e:
+                logger.error(f"rg 启动失败: {e}")
+                return
+            timed_out = threading.Event()
+
+            def on_timeout():
+                timed_out.set()
+                proc.kill()
+
+            timer = threading.Timer(timeout, on_timeout)
+            timer.daemon = True
+            timer.start()
+            finished = False
+            try:
+                for line in proc.stdout:
+                    match = parse_match_event(line)
+                    if match is not None:
+                        yield match
+                finished = True
+            finally:
+                timer.cancel()
+                if not finished:
+                    # 调用方已经拿够结果：不等 rg 扫完
+                    count('search.rg_early_exit')
+                    proc.kill()
+                proc.stdout.close()
+                returncode = proc.wait()
+
+            if timed_out.is_set():
+                logger.error(f"rg 超时: {' '.join(cmd)}")
+            elif finished and returncode not in (0, 1):
+                # returncode=1 表示没找到（正常），其他非0是错误
+                stderr.seek(0)
+                message = stderr.read().decode('utf-8', errors='ignore').strip()
+                logger.error(f"rg 搜索错误: {message}")
+
+
+def search_rg(cmd: List[str], max_results: int, timeout: float = RG_TIMEOUT) -> List[Tuple[Path, int, str]]:
+    """最多取 max_results 条匹配，够数后结束 rg"""
+    matches = []
+    if max_results <= 0:
+        return matches
+    with closing(stream_matches(cmd, timeout)) as stream:
+        for match in stream:
+            matches.append(match)
+            if len(matches) >= max_results:
+                break
+    return matches
+
+
+def map_searches(func: Callable[[T], R], items: Iterable[T]) -> List[R]:
+    """
+    在共享的有界线程池中执行一组搜索，结果顺序与 items 一致
+
+    只有一项、并发上限为 1、使用进程内搜索（不启动子进程，并发没有收益），或已经在
+    搜索池的工作线程中（避免嵌套提交互相等待）时直接串行执行。
+    """
+    items = list(items)
+    if (len(items) <= 1 or _max_concurrent <= 1 or get_search_config().in_process
+            or getattr(_local, 'in_pool', False)):
+        return [func(item) for item in items]
+
+    def run(item):
+        _local.in_pool = True
+        try:
+            return func(item)
+        finally:
+            _local.in_pool = False
+
+    return list(_get_pool().map(run, items))
+
+
+def _get_pool() -> ThreadPoolExecutor:
+    global _pool
+    with _pool_lock:
+        if _pool is None:
+            _pool = ThreadPoolExecutor(max_workers=_max_concurrent, thread_name_prefix='search')
+        return _pool
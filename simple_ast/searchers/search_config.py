@@ -1,7 +1,7 @@
 """
 搜索工具配置
 
-支持不同的搜索工具：grep (Git Bash)、ripgrep (rg)
+支持不同的搜索工具：grep (Git Bash)、ripgrep (rg)、进程内搜索 (python)
 """
 import subprocess
 import sys
@@ -17,6 +17,7 @@ class SearchTool(Enum):
     """可用的搜索工具"""
     GREP = "grep"           # Git Bash 自带
     RIPGREP = "rg"          # 需要安装 ripgrep
+    PYTHON = "python"       # 进程内搜索，不启动子进程
     AUTO = "auto"           # 自动检测
 
 
@@ -45,8 +46,14 @@ class SearchConfig:
                 self.tool = SearchTool.GREP
                 self.command = 'grep'
                 logger.info("检测到 grep，使用: grep")
+            # 都不可用时使用进程内搜索
             else:
-                raise RuntimeError("未检测到可用的搜索工具 (grep 或 ripgrep)")
+                self.tool = SearchTool.PYTHON
+                self.command = None
+                logger.info("未检测到 grep/ripgrep，使用进程内搜索")
+        elif self.tool == SearchTool.PYTHON:
+            self.command = None
+            logger.info("使用进程内搜索")
         else:
             # 使用指定工具
             cmd = self.tool.value
@@ -55,6 +62,11 @@ class SearchConfig:
             self.command = cmd
             logger.info(f"使用指定的搜索工具: {cmd}")
 
+    @property
+    def in_process(self) -> bool:
+        """是否使用进程内搜索（不构建命令行）"""
+        return self.tool == SearchTool.PYTHON
+
     def _check_tool_available(self, cmd: str) -> bool:
         """
         检查工具是否可用
@@ -4,8 +4,9 @@
 用于查找 struct、class、typedef、using 等数据结构定义
 """
 import re
-from typing import Optional
+from typing import Dict, Iterable, Optional
 from .grep_searcher import GrepSearcher
+from .definition_index import STRUCTURE_KIND_GROUPS
 
 
 class StructureSearcher:
@@ -32,12 +33,15 @@ class StructureSearcher:
         """
         # 按优先级依次尝试不同的模式（从最精确到最宽松）
         pattern_groups = self._build_prioritized_patterns(struct_name)
+        kind_groups = dict(STRUCTURE_KIND_GROUPS)
 
         for priority, patterns in pattern_groups:
             combined = '|'.join(patterns)
 
-            # 搜索所有匹配项
-            matches = self.grep.search_content(
+            # 搜索所有匹配项（优先查定义索引）
+            matches = self.grep.search_definitions(
+                struct_name,
+                kinds=kind_groups[priority],
                 pattern=combined,
                 file_glob='*.h',
                 max_results=10  # 获取前10个候选
@@ -60,6 +64,55 @@ class StructureSearcher:
 
         return None
 
+    def search_many(self, struct_names: Iterable[str]) -> Dict[str, Optional[str]]:
+        """
+        批量搜索多个数据结构定义
+
+        与逐个调用 search() 的优先级规则相同，但每个优先级只做一次批量搜索
+        （所有名字的模式合并），而不是每个名字每个优先级各搜一次。
+
+        Returns:
+            {名字: 定义文本 或 None}
+        """
+        results: Dict[str, Optional[str]] = {name: None for name in struct_names}
+        pending = list(results)
+        kind_groups = dict(STRUCTURE_KIND_GROUPS)
+
+        for group_idx in range(len(STRUCTURE_KIND_GROUPS)):
+            if not pending:
+                break
+
+            # 每个名字在当前优先级的合并模式
+            name_patterns = {}
+            priority = None
+            for name in pending:
+                priority, patterns = self._build_prioritized_patterns(name)[group_idx]
+                name_patterns[name] = '|'.join(patterns)
+
+            batch = self.grep.search_definitions_batch(
+                name_patterns,
+                kinds=kind_groups[priority],
+                file_glob='*.h',
+                max_results_per_name=10  # 与 search() 一样取前10个候选
+            )
+
+            still_pending = []
+            for name in pending:
+                result = None
+                matches = batch.get(name)
+                if matches:
+                    best_match = self._select_best_definition(matches, name)
+                    if best_match:
+                        file_path, line_num, content = best_match
+                        result = self._extract_definition_from_file(file_path, line_num, content, name)
+                if result:
+                    results[name] = result
+                else:
+                    still_pending.append(name)
+            pending = still_pending
+
+        return results
+
     def _build_prioritized_patterns(self, struct_name: str) -> list:
         """
         构造按优先级分组的搜索模式
@@ -0,0 +1,415 @@
+"""
+长驻分析服务 - 在多次请求之间保持解析器、索引、解析缓存和搜索索引常驻
+
+每次调用 analyze.py 都要付出解释器启动、tree-sitter 语言加载、搜索工具探测和
+（完整模式下）全项目索引的开销；服务模式只在启动时做一次，之后按请求分析。
+
+协议：JSON-RPC 2.0，每行一个请求 / 一个响应（stdio 或本地 TCP）
+    {"jsonrpc": "2.0", "id": 1, "method": "analyze", "params": {"file": "src/a.cpp"}}
+
+方法：
+    analyze  {file, function?, depth?, reports?}  -> 分析结果（同 analysis.json），
+             reports 为 true 或函数名列表时附带单函数报告
+    report   {file, function, depth?}            -> 单函数报告（复用整个文件的分析结果）
+    callers  {function, transitive?, depth?}      -> 调用点 / 间接调用者（仅 full 模式）
+    impact   {functions, depth?}                  -> 一组函数的影响范围（仅 full 模式）
+    refresh  {}                                   -> 立即检查文件变化
+    status   {}                                   -> 服务状态
+    shutdown {}                                   -> 停止服务
+
+文件监视：后台线程按 watch_interval 轮询源文件的 mtime/大小，发现变化后增量刷新
+全项目索引和定义索引并丢弃缓存的分析结果（解析缓存本身按 mtime 校验，无需处理）。
+"""
+import json
+import os
+import socketserver
+import threading
+import time
+import traceback
+from collections import OrderedDict
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, TextIO, Tuple
+
+from .analysis_modes import AnalysisMode, get_mode_config
+from .cpp_analyzer import AnalysisResult, CppProjectAnalyzer
+from .extractors import clear_macro_tables
+from .index_cache import CACHE_DIR_NAME
+from .logger import get_logger
+from .project_indexer import DEFAULT_HOT_CACHE_SIZE
+from .searchers import clear_corpus_cache, clear_include_resolvers, get_definition_index, get_include_resolver
+from .searchers.definition_index import INDEXED_EXTENSIONS
+
+logger = get_logger()
+
+# JSON-RPC 错误码
+PARSE_ERROR = -32700
+INVALID_REQUEST = -32600
+METHOD_NOT_FOUND = -32601
+INVALID_PARAMS = -32602
+SERVER_ERROR = -32000
+
+# 最多保留多少个 (文件, 深度, 函数) 的分析结果
+MAX_CACHED_RESULTS = 16
+
+
+class RpcError(Exception):
+    """带 JSON-RPC 错误码的异常"""
+
+    def __init__(self, code: int, message: str):
+        super().__init__(message)
+        self.code = code
+
+
+class FileWatcher:
+    """轮询方式的源文件变化监视（不依赖第三方库）"""
+
+    def __init__(self, root: Path, interval: float, on_change: Callable[[List[str]], None]):
+        self.root = root
+        self.interval = interval
+        self.on_change = on_change
+        self._snapshot = self.scan()
+        self._snapshot_lock = threading.Lock()
+        self._stop = threading.Event()
+        self._thread: Optional[threading.Thread] = None
+
+    def scan(self) -> Dict[str, Tuple[int, int]]:
+        """当前所有源文件的 (mtime, 大小)"""
+        snapshot = {}
+        for dirpath, dirnames, filenames in os.walk(self.root):
+            dirnames[:] = [d for d in dirnames if not d.startswith('.') and d != CACHE_DIR_NAME]
+            for filename in filenames:
+                if os.path.splitext(filename)[1] not in INDEXED_EXTENSIONS:
+                    continue
+                path = os.path.join(dirpath, filename)
+                try:
+                    stat = os.stat(path)
+                except OSError:
+                    continue
+                snapshot[path] = (stat.st_mtime_ns, stat.st_size)
+        return snapshot
+
+    def check(self) -> List[str]:
+        """与上次快照比较，返回新增/修改/删除的文件"""
+        with self._snapshot_lock:
+            current = self.scan()
+            changed = [path for path, key in current.items() if self._snapshot.get(path) != key]
+            changed.extend(path for path in self._snapshot if path not in current)
+            self._snapshot = current
+            return changed
+
+    def start(self):
+        if self.interval <= 0 or self._thread is not None:
+            return
+        self._thread = threading.Thread(target=self._run, name='simple-ast-watcher', daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        self._stop.set()
+
+    def _run(self):
+        while not self._stop.wait(self.interval):
+            try:
+                changed = self.check()
+                if changed:
+                    self.on_change(changed)
+            except Exception as e:
+                logger.error(f"[服务] 文件监视异常: {e}")
+
+    @property
+    def file_count(self) -> int:
+        return len(self._snapshot)
+
+
+class AnalysisServer:
+    """持有常驻 CppProjectAnalyzer 的请求处理器（与传输方式无关）"""
+
+    def __init__(self, project_root: str, mode: AnalysisMode = AnalysisMode.SINGLE_FILE_BOUNDARY,
+                 use_index_cache: bool = True, jobs: int = 1, watch_interval: float = 2.0,
+                 store: str = 'memory', hot_cache_size: int = DEFAULT_HOT_CACHE_SIZE):
+        self.project_root = Path(project_root).resolve()
+        self.mode = mode
+        self.default_depth = get_mode_config(mode).max_trace_depth
+        self.started_at = time.time()
+        self.request_count = 0
+        self.refresh_count = 0
+        self.shutdown_requested = threading.Event()
+
+        # 分析器不是线程安全的：请求和刷新都在这把锁下串行执行
+        self._lock = threading.RLock()
+        self._results: "OrderedDict[tuple, AnalysisResult]" = OrderedDict()
+
+        self.analyzer = CppProjectAnalyzer(str(self.project_root), mode=mode,
+                                           use_index_cache=use_index_cache, jobs=jobs, store=store,
+                                           hot_cache_size=hot_cache_size)
+        # 预热定义索引（结构体/宏/常量/全局变量查找）
+        index, _ = get_definition_index(self.project_root)
+        if index is not None:
+            index.refresh()
+
+        self.watcher = FileWatcher(self.project_root, watch_interval, self._on_files_changed)
+        self.watcher.start()
+        logger.info(f"[服务] 已启动: {self.project_root} ({mode.value})，监视 {self.watcher.file_count} 个文件")
+
+        self._methods = {
+            'analyze': self._analyze,
+            'report': self._report,
+            'callers': self._callers,
+            'impact': self._impact,
+            'refresh': self._refresh,
+            'status': self._status,
+            'shutdown': self._shutdown,
+        }
+
+    # ==================== 请求分发 ====================
+
+    def handle_line(self, line: str) -> Optional[str]:
+        """处理一行请求，返回一行响应（通知请求返回 None）"""
+        try:
+            request = json.loads(line)
+        except ValueError as e:
+            return self._encode(self._error_response(None, PARSE_ERROR, f"Parse error: {e}"))
+        response = self.handle(request)
+        return self._encode(response) if response is not None else None
+
+    def handle(self, request) -> Optional[dict]:
+        """处理一个已解码的 JSON-RPC 请求"""
+        if not isinstance(request, dict) or not isinstance(request.get('method'), str):
+            return self._error_response(None, INVALID_REQUEST, "Invalid request")
+
+        request_id = request.get('id')
+        is_notification = 'id' not in request
+        method = self._methods.get(request['method'])
+        params = request.get('params') or {}
+
+        try:
+            if method is None:
+                raise RpcError(METHOD_NOT_FOUND, f"Method not found: {request['method']}")
+            if not isinstance(params, dict):
+                raise RpcError(INVALID_PARAMS, "params must be an object")
+            self.request_count += 1
+            result = method(params)
+        except RpcError as e:
+            return None if is_notification else self._error_response(request_id, e.code, str(e))
+        except Exception as e:
+            logger.error(f"[服务] 请求失败 {request['method']}: {e}\n{traceback.format_exc()}")
+            return None if is_notification else self._error_response(request_id, SERVER_ERROR, str(e))
+
+        if is_notification:
+            return None
+        return {'jsonrpc': '2.0', 'id': request_id, 'result': result}
+
+    @staticmethod
+    def _error_response(request_id, code: int, message: str) -> dict:
+        return {'jsonrpc': '2.0', 'id': request_id, 'error': {'code': code, 'message': message}}
+
+    @staticmethod
+    def _encode(response: dict) -> str:
+        return json.dumps(response, ensure_ascii=False)
+
+    # ==================== 方法 ====================
+
+    def _analyze(self, params: dict) -> dict:
+        target_file = self._require_file(params)
+        function = params.get('function')
+        depth = self._depth(params)
+        reports = params.get('reports', False)
+
+        start = time.perf_counter()
+        with self._lock:
+            result = self._get_result(target_file, depth, function)
+            response = {'analysis': json.loads(result.to_json())}
+            if reports:
+                names = reports if isinstance(reports, list) else self._reportable_functions(result)
+                response['reports'] = dict(result.generate_single_function_reports(names))
+        response['elapsed'] = round(time.perf_counter() - start, 4)
+        return response
+
+    def _report(self, params: dict) -> dict:
+        target_file = self._require_file(params)
+        function = params.get('function')
+        if not isinstance(function, str) or not function:
+            raise RpcError(INVALID_PARAMS, "'function' is required")
+        depth = self._depth(params)
+
+        start = time.perf_counter()
+        with self._lock:
+            # 复用整个文件的分析结果：同一文件的后续函数报告只走缓存
+            result = self._get_result(target_file, depth, None)
+            if function not in result.function_signatures and function not in result.call_chains:
+                raise RpcError(INVALID_PARAMS, f"Function not found in {target_file}: {function}")
+            report = result.generate_single_function_report(function)
+        return {'function': function, 'report': report,
+                'elapsed': round(time.perf_counter() - start, 4)}
+
+    def _callers(self, params: dict) -> dict:
+        function = params.get('function')
+        if not isinstance(function, str) or not function:
+            raise RpcError(INVALID_PARAMS, "'function' is required")
+        depth = self._optional_depth(params)
+        indexer = self._require_indexer()
+        with self._lock:
+            if params.get('transitive') or depth is not None:
+                distances = indexer.find_transitive_callers(function, max_depth=depth)
+                callers = [{'name': name, 'distance': distance}
+                           for name, distance in sorted(distances.items(), key=lambda kv: (kv[1], kv[0]))]
+            else:
+                callers = [{'caller': site.caller, 'file': site.file_path, 'line': site.line}
+                           for site in indexer.find_callers(function)]
+        return {'function': function, 'callers': callers}
+
+    def _impact(self, params: dict) -> dict:
+        functions = params.get('functions')
+        if isinstance(functions, str):
+            functions = [functions]
+        if not isinstance(functions, list) or not functions or not all(isinstance(f, str) for f in functions):
+            raise RpcError(INVALID_PARAMS, "'functions' must be a non-empty list of names")
+        depth = self._optional_depth(params)
+        indexer = self._require_indexer()
+        with self._lock:
+            return indexer.impact_set(functions, max_depth=depth).to_dict()
+
+    def _refresh(self, params: dict) -> dict:
+        changed = self.watcher.check()
+        if changed:
+            self._on_files_changed(changed)
+        return {'changed': len(changed)}
+
+    def _status(self, params: dict) -> dict:
+        return {
+            'project_root': str(self.project_root),
+            'mode': self.mode.value,
+            'uptime': round(time.time() - self.started_at, 1),
+            'requests': self.request_count,
+            'refreshes': self.refresh_count,
+            'watched_files': self.watcher.file_count,
+            'cached_results': len(self._results),
+        }
+
+    def _shutdown(self, params: dict) -> dict:
+        self.shutdown_requested.set()
+        self.watcher.stop()
+        return {'ok': True}
+
+    # ==================== 内部 ====================
+
+    def _require_file(self, params: dict) -> str:
+        target_file = params.get('file')
+        if not isinstance(target_file, str) or not target_file:
+            raise RpcError(INVALID_PARAMS, "'file' is required")
+        path = Path(target_file)
+        if not path.is_absolute():
+            path = self.project_root / path
+        if not path.is_file():
+            raise RpcError(INVALID_PARAMS, f"File not found: {target_file}")
+        return target_file
+
+    def _depth(self, params: dict) -> int:
+        depth = params.get('depth', self.default_depth)
+        if not isinstance(depth, int) or depth <= 0:
+            raise RpcError(INVALID_PARAMS, "'depth' must be a positive integer")
+        return depth
+
+    def _optional_depth(self, params: dict) -> Optional[int]:
+        """调用者查询的深度：不传为不限"""
+        if params.get('depth') is None:
+            return None
+        return self._depth(params)
+
+    def _require_indexer(self):
+        if self.analyzer.indexer is None:
+            raise RpcError(INVALID_PARAMS, "callers/impact need the server to run in full mode")
+        return self.analyzer.indexer
+
+    def _get_result(self, target_file: str, depth: int, function: Optional[str]) -> AnalysisResult:
+        """分析结果按 (文件, 深度, 函数) 缓存，文件变化时整体失效"""
+        key = (str(target_file), depth, function)
+        result = self._results.get(key)
+        if result is not None:
+            self._results.move_to_end(key)
+            return result
+        result = self.analyzer.analyze_file(target_file, trace_depth=depth, target_function=function)
+        # 缓存的结果不持有语法树，生成报告时才按需重新解析（通常命中解析缓存）
+        result.release_syntax_trees()
+        self._results[key] = result
+        while len(self._results) > MAX_CACHED_RESULTS:
+            self._results.popitem(last=False)
+        return result
+
+    @staticmethod
+    def _reportable_functions(result: AnalysisResult) -> List[str]:
+        if result.file_boundary:
+            return sorted(result.file_boundary.internal_functions)
+        return sorted(result.function_signatures.keys())
+
+    def _on_files_changed(self, changed: List[str]):
+        """文件变化：增量刷新索引，丢弃已缓存的分析结果"""
+        with self._lock:
+            logger.info(f"[服务] {len(changed)} 个文件变化，刷新索引")
+            self.refresh_count += 1
+            self._results.clear()
+            clear_corpus_cache()
+            clear_include_resolvers()
+            clear_macro_tables()
+            index, _ = get_definition_index(self.project_root)
+            if index is not None:
+                index.refresh()
+            if self.analyzer.indexer is not None:
+                self.analyzer.indexer.refresh()
+                self.analyzer.tracer.clear_cache()
+                get_include_resolver(self.project_root).use_include_graph(self.analyzer.indexer.include_graph)
+
+    def close(self):
+        self.watcher.stop()
+
+
+# ==================== 传输 ====================
+
+def serve_stdio(server: AnalysisServer, stdin: TextIO, stdout: TextIO):
+    """逐行读取 stdin 的请求，响应写到 stdout（直到 EOF 或 shutdown）"""
+    for line in stdin:
+        line = line.strip()
+        if not line:
+            continue
+        response = server.handle_line(line)
+        if response is not None:
+            stdout.write(response + '\n')
+            stdout.flush()
+        if server.shutdown_requested.is_set():
+            break
+    server.close()
+
+
+class _RpcRequestHandler(socketserver.StreamRequestHandler):
+    """TCP 连接：与 stdio 相同的逐行协议，一个连接可以发多个请求"""
+
+    def handle(self):
+        analysis_server: AnalysisServer = self.server.analysis_server
+        for raw in self.rfile:
+            line = raw.decode('utf-8', errors='replace').strip()
+            if not line:
+                continue
+            response = analysis_server.handle_line(line)
+            if response is not None:
+                self.wfile.write((response + '\n').encode('utf-8'))
+                self.wfile.flush()
+            if analysis_server.shutdown_requested.is_set():
+                threading.Thread(target=self.server.shutdown, daemon=True).start()
+                break
+
+
+class _ThreadingRpcServer(socketserver.ThreadingTCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def serve_tcp(server: AnalysisServer, host: str = '127.0.0.1', port: int = 0,
+              on_ready: Optional[Callable[[str, int], None]] = None):
+    """在 host:port 上监听（port 为 0 时自动分配），直到 shutdown"""
+    with _ThreadingRpcServer((host, port), _RpcRequestHandler) as tcp_server:
+        tcp_server.analysis_server = server
+        if on_ready is not None:
+            on_ready(*tcp_server.server_address[:2])
+        try:
+            tcp_server.serve_forever()
+        finally:
+            server.close()
@@ -4,17 +4,42 @@
 """
 import sys
 from pathlib import Path
-from typing import Dict, List, Set, Optional
+from typing import Dict, FrozenSet, List, Set, Optional, Tuple
 from dataclasses import dataclass
 
 from .cpp_parser import CppParser
+from .function_index import FunctionIndex
 from .entry_point_classifier import EntryPointInfo
-from .call_chain_tracer import CallNode
+from .boundary_snapshot import BoundarySnapshot
+from .call_chain_tracer import CallNode, NO_BACK_EDGE
 from .data_structure_analyzer import DataStructureInfo
-from .logger import get_logger
+from .logger import count, get_logger, span
+from .source_loader import read_source
 
 logger = get_logger()
 
+# 标准库函数/类型：调用和类型统计时跳过（模块级常量，不在每次判断时重建）
+STD_FUNCTIONS = frozenset({
+    'printf', 'scanf', 'sprintf', 'fprintf', 'snprintf',
+    'malloc', 'free', 'calloc', 'realloc',
+    'memcpy', 'memset', 'memmove', 'memcmp',
+    'strlen', 'strcpy', 'strcat', 'strcmp', 'strncpy', 'strncmp',
+    'fopen', 'fclose', 'fread', 'fwrite', 'fseek', 'ftell',
+    'exit', 'abort', 'assert',
+    'sqrt', 'pow', 'sin', 'cos', 'exp', 'log',
+})
+
+STD_TYPES = frozenset({
+    'string', 'vector', 'list', 'map', 'set', 'unordered_map', 'unordered_set',
+    'queue', 'stack', 'deque', 'priority_queue',
+    'shared_ptr', 'unique_ptr', 'weak_ptr',
+    'mutex', 'thread', 'atomic',
+    'ifstream', 'ofstream', 'fstream', 'stringstream',
+    'int8_t', 'int16_t', 'int32_t', 'int64_t',
+    'uint8_t', 'uint16_t', 'uint32_t', 'uint64_t',
+    'size_t', 'ptrdiff_t',
+})
+
 
 @dataclass
 class FileBoundary:
@@ -37,12 +62,57 @@ class FileBoundary:
     # 数据结构详细信息 (name -> {node, type, line, definition})
     file_data_structures: Dict[str, dict] = None
 
-    # 函数详细信息 (name -> {node, signature, line, source_code})
+    # 函数详细信息 (name -> {node, span, signature, line, is_static, call_sites})
     file_functions: Dict[str, dict] = None
 
     # 源代码（用于从节点提取文本）
     source_code: bytes = None
 
+    def snapshot(self) -> BoundarySnapshot:
+        """不含语法树的紧凑快照（从快照恢复的边界直接返回原快照）"""
+        snapshot = self.__dict__.get('_snapshot')
+        if snapshot is None:
+            snapshot = BoundarySnapshot.from_boundary(self)
+        return snapshot
+
+    @classmethod
+    def from_snapshot(cls, snapshot: BoundarySnapshot) -> 'FileBoundary':
+        """从快照恢复：调用点由快照中的调用边重建，函数/数据结构节点在第一次访问时才解析补上"""
+        source_code = snapshot.load_source()
+        file_functions, file_data_structures = snapshot.lazy_infos(source_code)
+        boundary = cls(
+            internal_functions=set(snapshot.internal_functions),
+            external_functions=set(snapshot.external_functions),
+            internal_data_structures=set(snapshot.internal_data_structures),
+            external_data_structures=set(snapshot.external_data_structures),
+            file_path=snapshot.file_path,
+            file_data_structures=file_data_structures,
+            file_functions=file_functions,
+            source_code=source_code
+        )
+        boundary._snapshot = snapshot
+        return boundary
+
+    def function_text(self, func_name: str) -> Optional[str]:
+        """函数定义的源码文本（按记录的字节范围切取，不需要语法树节点）"""
+        info = (self.file_functions or {}).get(func_name)
+        if not info or not self.source_code:
+            return None
+        start_byte, end_byte = info['span'] if 'span' in info else (info['node'].start_byte, info['node'].end_byte)
+        return CppParser.get_text(self.source_code, start_byte, end_byte)
+
+    def __getstate__(self):
+        """
+        序列化为快照：不含 tree-sitter 节点（不可 pickle），源文件未变时也不带源码
+
+        用于把边界信息传给 spawn 方式启动的报告工作进程（fork 方式直接继承，不经过这里）。
+        """
+        return {'snapshot': self.snapshot()}
+
+    def __setstate__(self, state):
+        """反序列化：源码从源文件读取，节点在第一次访问时才重新解析"""
+        self.__dict__.update(FileBoundary.from_snapshot(state['snapshot']).__dict__)
+
 
 class SingleFileAnalyzer:
     """单文件边界分析器 - 不需要全局索引"""
@@ -52,7 +122,8 @@ class SingleFileAnalyzer:
         self.parser = CppParser()
 
         # 当前文件的符号表
-        self.file_functions: Dict[str, dict] = {}  # function_name -> {node, signature, line}
+        self.function_index: Optional[FunctionIndex] = None  # 一次遍历建立的函数定义索引
+        self.file_functions: Dict[str, dict] = {}  # function_name -> {node, span, signature, line, is_static, call_sites}
         self.file_data_structures: Dict[str, dict] = {}  # struct_name -> {node, type, line, definition}
 
         # 边界追踪
@@ -61,12 +132,18 @@ class SingleFileAnalyzer:
         self.internal_data_structures: Set[str] = set()
         self.external_data_structures: Set[str] = set()
 
-    def analyze_file(self, file_path: str) -> FileBoundary:
+        # 调用链追踪的记忆化子树：(函数名, 剩余深度) -> (children, 展开过的函数集合)
+        self._subtree_cache: Dict[tuple, Tuple[List[CallNode], FrozenSet[str]]] = {}
+
+    def analyze_file(self, file_path: str, focus_function: Optional[str] = None) -> FileBoundary:
         """
         分析单个文件的边界
 
         Args:
             file_path: 文件路径（相对于项目根目录或绝对路径）
+            focus_function: 可选，惰性模式。指定后步骤2-4只处理该函数及其传递调用的
+                内部函数（闭包），外部函数/数据结构也只统计闭包内用到的；
+                internal_functions 仍包含文件内全部函数，用于内外部判定
 
         Returns:
             FileBoundary: 文件边界信息
@@ -81,37 +158,67 @@ class SingleFileAnalyzer:
 
         print(f"Analyzing file boundary: {target_path}")
 
+        # 同一个分析器可以依次分析多个文件（如长驻服务），先清掉上一个文件的符号表
+        self._reset_file_state()
+
         # 读取文件
-        source_code = self._read_file(target_path)
+        with span('boundary.read', 'boundary'):
+            source_code = self._read_file(target_path)
         if not source_code:
             raise ValueError(f"Could not read file: {target_path}")
 
         # 解析 AST
-        tree = self.parser.parser.parse(source_code)
+        tree = self.parser.parse_source(source_code, target_path)
         if not tree:
             raise ValueError(f"Failed to parse file: {target_path}")
 
         root_node = tree.root_node
 
-        # 步骤1: 索引文件内的所有函数定义
-        print("  Step 1: Indexing functions in file...")
-        self._index_file_functions(root_node, source_code)
-        print(f"    Found {len(self.file_functions)} functions")
+        # 新文件的函数表不同，之前的记忆化子树失效
+        self._subtree_cache.clear()
 
-        # 步骤2: 索引文件内的所有数据结构定义
-        print("  Step 2: Indexing data structures in file...")
-        self._index_file_data_structures(root_node, source_code)
-        print(f"    Found {len(self.file_data_structures)} data structures")
+        # 步骤1: 索引文件内的所有函数定义（一次遍历，同时收集调用点）
+        print("  Step 1: Indexing functions in file...")
+        with span('boundary.step1_functions', 'boundary'):
+            self.function_index = FunctionIndex(root_node, source_code)
+            self._index_file_functions(root_node, source_code)
 
-        # 步骤3: 分析函数调用，区分内部/外部
-        print("  Step 3: Analyzing function calls...")
-        self._analyze_function_calls(root_node, source_code)
-        print(f"    Internal: {len(self.internal_functions)}, External: {len(self.external_functions)}")
+        # 放入进程级解析缓存（连同函数索引），供追踪器/提取器复用，避免重复解析
+        CppParser.register_parsed_file(target_path, source_code, tree, self.function_index)
+        print(f"    Found {len(self.file_functions)} functions")
 
-        # 步骤4: 分析数据结构使用，区分内部/外部
-        print("  Step 4: Analyzing data structure usage...")
-        self._analyze_data_structure_usage(root_node, source_code)
-        print(f"    Internal: {len(self.internal_data_structures)}, External: {len(self.external_data_structures)}")
+        closure = None
+        if focus_function:
+            if focus_function in self.file_functions:
+                closure = self._collect_function_closure(focus_function)
+                print(f"    Lazy mode: {focus_function} reaches {len(closure)} internal functions")
+            else:
+                print(f"    Warning: Function '{focus_function}' not found, analyzing whole file")
+
+        if closure is None:
+            # 步骤2: 索引文件内的所有数据结构定义
+            print("  Step 2: Indexing data structures in file...")
+            with span('boundary.step2_data_structures', 'boundary'):
+                self._index_file_data_structures(root_node, source_code)
+            print(f"    Found {len(self.file_data_structures)} data structures")
+
+            # 步骤3: 分析函数调用，区分内部/外部
+            print("  Step 3: Analyzing function calls...")
+            with span('boundary.step3_calls', 'boundary'):
+                self._analyze_function_calls(root_node, source_code)
+            print(f"    Internal: {len(self.internal_functions)}, External: {len(self.external_functions)}")
+
+            # 步骤4: 分析数据结构使用，区分内部/外部
+            print("  Step 4: Analyzing data structure usage...")
+            with span('boundary.step4_data_structure_usage', 'boundary'):
+                self._analyze_data_structure_usage(root_node, source_code)
+            print(f"    Internal: {len(self.internal_data_structures)}, External: {len(self.external_data_structures)}")
+        else:
+            with span('boundary.lazy_closure', 'boundary', functions=len(closure)):
+                self._analyze_closure(root_node, source_code, closure)
+            print(f"    Data structures: {len(self.file_data_structures)} internal, "
+                  f"{len(self.external_data_structures)} external; "
+                  f"external functions: {len(self.external_functions)}")
 
         # 构建边界信息
         boundary = FileBoundary(
@@ -128,59 +235,113 @@ class SingleFileAnalyzer:
         print("  Boundary analysis complete!")
         return boundary
 
-    def _read_file(self, file_path: Path) -> Optional[bytes]:
-        """读取文件内容，尝试多种编码"""
-        encodings_to_try = ['utf-8', 'gbk', 'gb2312', 'latin-1', 'cp1252']
-
-        for encoding in encodings_to_try:
-            try:
-                with open(file_path, 'r', encoding=encoding) as f:
-                    f.read()  # 测试编码
-                # 成功后读取为 bytes
-                with open(file_path, 'rb') as f:
-                    return f.read()
-            except (UnicodeDecodeError, UnicodeError):
-                continue
+    def _reset_file_state(self):
+        self.function_index = None
+        self.file_functions = {}
+        self.file_data_structures = {}
+        self.internal_functions = set()
+        self.external_functions = set()
+        self.internal_data_structures = set()
+        self.external_data_structures = set()
 
-        return None
+    def _read_file(self, file_path: Path) -> Optional[bytes]:
+        """读取文件内容（只读一次，同一缓冲区完成编码检测后直接交给 tree-sitter）"""
+        source = read_source(file_path)
+        return source.data if source else None
 
     def _index_file_functions(self, root_node, source_code: bytes):
         """索引文件中定义的所有函数"""
-        func_defs = CppParser.find_nodes_by_type(root_node, 'function_definition')
+        if self.function_index is None:
+            self.function_index = FunctionIndex(root_node, source_code)
 
-        for func_node in func_defs:
-            func_name = CppParser.get_function_name(func_node, source_code)
-            if not func_name:
+        for func_def in self.function_index.definitions:
+            if not func_def.name:
                 continue
 
-            signature = CppParser.get_function_signature(func_node, source_code)
-            line_number = func_node.start_point[0] + 1
-
-            # 检查是否是static函数
-            is_static = self._is_static_function(func_node, source_code)
-
-            self.file_functions[func_name] = {
-                'node': func_node,
-                'signature': signature,
-                'line': line_number,
-                'is_static': is_static
+            self.file_functions[func_def.name] = {
+                'node': func_def.node,
+                'span': (func_def.start_byte, func_def.end_byte),
+                'signature': func_def.signature,
+                'line': func_def.line,
+                'is_static': func_def.is_static,
+                'call_sites': func_def.call_sites
             }
 
             # 标记为内部函数
-            self.internal_functions.add(func_name)
+            self.internal_functions.add(func_def.name)
+
+    def _collect_function_closure(self, func_name: str) -> Set[str]:
+        """函数及其传递调用的文件内函数（按调用点名称，不受追踪深度限制）"""
+        closure = set()
+        stack = [func_name]
+        while stack:
+            name = stack.pop()
+            if name in closure or name not in self.file_functions:
+                continue
+            closure.add(name)
+            for call_site in self.file_functions[name]['call_sites']:
+                if call_site.callee_text and call_site.name not in closure:
+                    stack.append(call_site.name)
+        return closure
+
+    def _analyze_closure(self, root_node, source_code: bytes, closure: Set[str]):
+        """
+        惰性模式下的步骤2-4：只看闭包内函数的调用点和类型
+
+        数据结构定义仍需在文件中查找，但跳过闭包外的函数体，
+        并且只保留闭包内实际用到的类型。
+        """
+        closure_nodes = [self.file_functions[name]['node'] for name in sorted(closure)]
+
+        # 步骤3: 闭包内的外部调用
+        for name in closure:
+            for call_site in self.file_functions[name]['call_sites']:
+                if not call_site.callee_text:
+                    continue
+                called_func = call_site.name
+                if self._is_standard_library_function(called_func):
+                    continue
+                if called_func not in self.file_functions:
+                    self.external_functions.add(called_func)
+
+        # 步骤4（收集）: 闭包内用到的类型
+        used_types = set()
+        for func_node in closure_nodes:
+            used_types |= self._collect_used_type_names(func_node, source_code)
+
+        # 步骤2: 只索引用到的数据结构
+        closure_spans = {(node.start_byte, node.end_byte) for node in closure_nodes}
+        self._index_file_data_structures(root_node, source_code,
+                                         wanted=used_types, function_spans=closure_spans)
+
+        # 步骤4（分类）
+        for type_name in used_types:
+            if type_name not in self.file_data_structures:
+                self.external_data_structures.add(type_name)
+
+    def _collect_used_type_names(self, node, source_code: bytes) -> Set[str]:
+        """节点下用到的非标准库类型名（类型转换里的类型也是 type_identifier，已包含在内）"""
+        type_names = set()
+        for type_node in CppParser.find_nodes_by_type(node, 'type_identifier'):
+            type_name = CppParser.get_node_text(type_node, source_code)
+            if not self._is_standard_library_type(type_name):
+                type_names.add(type_name)
+        return type_names
 
     def _is_static_function(self, func_node, source_code: bytes) -> bool:
         """检查函数是否是static函数"""
-        # 检查函数定义节点的storage_class_specifier子节点
-        for child in func_node.children:
-            if child.type == 'storage_class_specifier':
-                text = CppParser.get_node_text(child, source_code)
-                if text == 'static':
-                    return True
-        return False
-
-    def _index_file_data_structures(self, root_node, source_code: bytes):
-        """索引文件中定义的所有数据结构"""
+        return FunctionIndex.is_static_function(func_node, source_code)
+
+    def _index_file_data_structures(self, root_node, source_code: bytes,
+                                    wanted: Optional[Set[str]] = None,
+                                    function_spans: Optional[Set[Tuple[int, int]]] = None):
+        """
+        索引文件中定义的所有数据结构
+
+        Args:
+            wanted: 可选，只记录这些名称的数据结构
+            function_spans: 可选，(start_byte, end_byte) 集合；指定后不进入其他函数体查找
+        """
         structure_types = {
             'struct_specifier': 'struct',
             'class_specifier': 'class',
@@ -188,10 +349,13 @@ class SingleFileAnalyzer:
             'type_definition': 'typedef'
         }
 
-        for node_type, struct_type in structure_types.items():
-            nodes = CppParser.find_nodes_by_type(root_node, node_type)
+        if function_spans is not None:
+            nodes_by_type = self._find_structure_nodes(root_node, structure_types, function_spans)
+        else:
+            nodes_by_type = CppParser.find_nodes_by_types(root_node, structure_types)
 
-            for node in nodes:
+        for node_type, struct_type in structure_types.items():
+            for node in nodes_by_type[node_type]:
                 # 查找名称
                 name_node = CppParser.find_child_by_type(node, 'type_identifier')
                 if not name_node:
@@ -201,6 +365,8 @@ class SingleFileAnalyzer:
                     continue
 
                 struct_name = CppParser.get_node_text(name_node, source_code)
+                if wanted is not None and struct_name not in wanted:
+                    continue
                 line_number = node.start_point[0] + 1
 
                 # 获取定义（限制长度）
@@ -218,24 +384,33 @@ class SingleFileAnalyzer:
                 # 标记为内部数据结构
                 self.internal_data_structures.add(struct_name)
 
+    @staticmethod
+    def _find_structure_nodes(root_node, structure_types, function_spans: Set[Tuple[int, int]]) -> Dict[str, list]:
+        """一次遍历按类型收集数据结构节点，不进入 function_spans 以外的函数体"""
+        nodes_by_type = {node_type: [] for node_type in structure_types}
+        stack = [root_node]
+        while stack:
+            node = stack.pop()
+            if node.type in nodes_by_type:
+                nodes_by_type[node.type].append(node)
+            elif (node.type == 'function_definition' and
+                  (node.start_byte, node.end_byte) not in function_spans):
+                continue
+            stack.extend(reversed(node.children))
+        return nodes_by_type
+
     def _analyze_function_calls(self, root_node, source_code: bytes):
         """分析函数调用，区分内部和外部"""
-        call_expressions = CppParser.find_nodes_by_type(root_node, 'call_expression')
+        if self.function_index is None:
+            self.function_index = FunctionIndex(root_node, source_code)
 
-        for call_node in call_expressions:
+        for call_site in self.function_index.all_call_sites:
             # 获取被调用的函数名
-            func_node = call_node.child_by_field_name('function')
-            if not func_node:
+            if not call_site.callee_text:
                 continue
 
-            called_func = CppParser.get_node_text(func_node, source_code)
-
             # 处理成员函数调用（obj.method() 或 obj->method()）
-            if '.' in called_func or '->' in called_func:
-                # 提取方法名
-                parts = called_func.replace('->', '.').split('.')
-                if len(parts) >= 2:
-                    called_func = parts[-1]
+            called_func = call_site.name
 
             # 过滤掉明显的标准库函数
             if self._is_standard_library_function(called_func):
@@ -293,34 +468,16 @@ class SingleFileAnalyzer:
 
     def _is_standard_library_function(self, func_name: str) -> bool:
         """判断是否是标准库函数"""
-        std_functions = {
-            'printf', 'scanf', 'sprintf', 'fprintf', 'snprintf',
-            'malloc', 'free', 'calloc', 'realloc',
-            'memcpy', 'memset', 'memmove', 'memcmp',
-            'strlen', 'strcpy', 'strcat', 'strcmp', 'strncpy', 'strncmp',
-            'fopen', 'fclose', 'fread', 'fwrite', 'fseek', 'ftell',
-            'exit', 'abort', 'assert',
-            'sqrt', 'pow', 'sin', 'cos', 'exp', 'log',
-        }
-        return func_name in std_functions
+        return func_name in STD_FUNCTIONS
 
     def _is_standard_library_type(self, type_name: str) -> bool:
         """判断是否是标准库类型"""
-        std_types = {
-            'string', 'vector', 'list', 'map', 'set', 'unordered_map', 'unordered_set',
-            'queue', 'stack', 'deque', 'priority_queue',
-            'shared_ptr', 'unique_ptr', 'weak_ptr',
-            'mutex', 'thread', 'atomic',
-            'ifstream', 'ofstream', 'fstream', 'stringstream',
-            'int8_t', 'int16_t', 'int32_t', 'int64_t',
-            'uint8_t', 'uint16_t', 'uint32_t', 'uint64_t',
-            'size_t', 'ptrdiff_t',
-        }
-        return type_name in std_types
+        return type_name in STD_TYPES
 
-    def get_entry_points(self, source_code: bytes, file_path: str) -> List[EntryPointInfo]:
+    def get_entry_points(self, source_code: bytes, file_path: str,
+                         only: Optional[Set[str]] = None) -> List[EntryPointInfo]:
         """
-        获取入口点函数列表
+        获取入口点函数列表（only 指定时只分类这些函数）
 
         改进：正确分类函数
         - INTERNAL: static函数或匿名命�空间中的函数
@@ -330,9 +487,11 @@ class SingleFileAnalyzer:
         entry_points = []
 
         # 尝试找到对应的头文件
-        header_functions = self._find_header_declarations(file_path)
+        header_functions = self._find_header_declarations(file_path, only)
 
         for func_name, func_info in self.file_functions.items():
+            if only is not None and func_name not in only:
+                continue
             # 判断函数类型
             is_static = func_info.get('is_static', False)
             signature = func_info.get('signature', '')
@@ -359,7 +518,7 @@ class SingleFileAnalyzer:
 
         return entry_points
 
-    def _find_header_declarations(self, cpp_file_path: str) -> dict:
+    def _find_header_declarations(self, cpp_file_path: str, func_names: Optional[Set[str]] = None) -> dict:
         """
         查找cpp文件对应的头文件中的函数声明
         使用简单的文本搜索，不需要AST解析
@@ -390,7 +549,7 @@ class SingleFileAnalyzer:
                         header_content = f.read()
 
                     # 对每个文件中的函数名，在头文件中搜索
-                    for func_name in self.file_functions.keys():
+                    for func_name in (func_names if func_names is not None else self.file_functions.keys()):
                         # 简单搜索：函数名出现在头文件中
                         # 排除注释中的出现（简单检查：不在 // 或 /* */ 之后）
                         if func_name in header_content:
@@ -420,29 +579,44 @@ class SingleFileAnalyzer:
     # 删除不再需要的 _extract_function_name_from_declarator 方法
 
     def trace_call_chain(self, func_name: str, source_code: bytes, max_depth: int = 100) -> Optional[CallNode]:
-        """追踪函数调用链（仅在文件内部追踪）"""
+        """
+        追踪函数调用链（仅在文件内部追踪）
+
+        调用图（函数 -> 调用点）来自函数索引，只构建一次；相同 (函数, 剩余深度)
+        的子树会被记忆化并在多个调用者之间共享，避免指数级重复展开。
+        """
         if func_name not in self.file_functions:
             return None
 
-        return self._trace_function_calls_recursive(
-            func_name,
-            source_code,
-            visited=set(),
-            depth=0,
-            max_depth=max_depth
-        )
+        with span('tracer.trace', 'tracer', function=func_name):
+            node, _, _ = self._trace_function_calls_recursive(
+                func_name,
+                source_code,
+                visited={},
+                depth=0,
+                max_depth=max_depth
+            )
+        return node
 
     def _trace_function_calls_recursive(
         self,
         func_name: str,
         source_code: bytes,
-        visited: Set[str],
+        visited: Dict[str, int],
         depth: int,
         max_depth: int
-    ) -> Optional[CallNode]:
-        """递归追踪函数调用"""
+    ) -> Tuple[Optional[CallNode], float, FrozenSet[str]]:
+        """
+        递归追踪函数调用
+
+        Args:
+            visited: 当前调用路径上的函数 -> 所在深度（回溯维护，不再逐边复制）
+
+        Returns:
+            (节点, 子树中递归引用到的最浅祖先深度或 NO_BACK_EDGE, 子树中展开过的函数集合)
+        """
         if depth >= max_depth:
-            return None
+            return None, NO_BACK_EDGE, frozenset()
 
         if func_name not in self.file_functions:
             # 外部函数，创建外部节点
@@ -455,10 +629,9 @@ class SingleFileAnalyzer:
                 is_external=True,
                 is_recursive=False,
                 children=[]
-            )
+            ), NO_BACK_EDGE, frozenset()
 
         func_info = self.file_functions[func_name]
-        func_node = func_info['node']
 
         # 创建当前节点
         current_node = CallNode(
@@ -473,44 +646,59 @@ class SingleFileAnalyzer:
         )
 
         if func_name in visited:
-            return current_node
-
-        visited.add(func_name)
-
-        # 查找函数体中的所有调用
-        call_expressions = CppParser.find_nodes_by_type(func_node, 'call_expression')
-
-        for call_expr in call_expressions:
-            func_expr = call_expr.child_by_field_name('function')
-            if not func_expr:
+            return current_node, visited[func_name], frozenset()
+
+        # 记忆化子树：当前路径与子树中展开过的函数不相交时，结果与重新展开完全一致
+        memo_key = (func_name, max_depth - depth)
+        cached = self._subtree_cache.get(memo_key)
+        if cached is not None:
+            children, expanded = cached
+            if visited.keys().isdisjoint(expanded):
+                current_node.children = children
+                count('tracer.memo_hit')
+                return current_node, NO_BACK_EDGE, expanded
+        count('tracer.memo_miss')
+
+        visited[func_name] = depth
+        low = NO_BACK_EDGE
+        expanded = {func_name}
+
+        # 函数体中的所有调用（函数索引中已预先收集）
+        for call_site in func_info['call_sites']:
+            if not call_site.callee_text:
                 continue
 
-            called_name = CppParser.get_node_text(func_expr, source_code)
-
             # 处理成员函数调用
-            if '.' in called_name or '->' in called_name:
-                parts = called_name.replace('->', '.').split('.')
-                if len(parts) >= 2:
-                    called_name = parts[-1]
+            called_name = call_site.name
 
             # 过滤标准库函数
             if self._is_standard_library_function(called_name):
                 continue
 
             # 递归追踪
-            child_node = self._trace_function_calls_recursive(
+            child_node, child_low, child_expanded = self._trace_function_calls_recursive(
                 called_name,
                 source_code,
-                visited.copy(),
+                visited,
                 depth + 1,
                 max_depth
             )
+            low = min(low, child_low)
+            expanded.update(child_expanded)
 
             if child_node:
-                child_node.called_from_line = call_expr.start_point[0] + 1
+                child_node.called_from_line = call_site.line
                 current_node.children.append(child_node)
 
-        return current_node
+        del visited[func_name]
+
+        expanded = frozenset(expanded)
+        if low < depth:
+            # 子树依赖路径上更浅的祖先（递归环），不能复用
+            return current_node, low, expanded
+
+        self._subtree_cache[memo_key] = (current_node.children, expanded)
+        return current_node, NO_BACK_EDGE, expanded
 
     def get_data_structures_info(self) -> Dict[str, DataStructureInfo]:
         """获取数据结构信息（用于兼容原有接口）"""
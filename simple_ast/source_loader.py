@@ -0,0 +1,125 @@
+"""
+Single-read source loader with encoding detection.
+
+Files are read once as bytes; the same buffer is sniffed for its encoding and
+handed to tree-sitter. The detected encoding is cached per (path, mtime, size)
+so re-reading an unchanged file skips the sniff, and it travels with the
+buffer (SourceBytes.encoding) so CppParser.get_text decodes node text with
+the file's codec instead of trying UTF-8 first on every GBK node.
+"""
+import os
+import threading
+from dataclasses import dataclass
+from typing import Dict, Optional, Tuple
+
+from .logger import count
+
+# Tried in order; the first codec that decodes the whole file wins.
+SOURCE_ENCODINGS = ('utf-8', 'gbk', 'gb2312', 'latin-1', 'cp1252')
+
+
+class SourceBytes(bytes):
+    """
+    File contents tagged with the encoding they decode with.
+
+    Behaves as plain bytes everywhere (tree-sitter, hashing, pickling);
+    slices are plain bytes again.
+    """
+    encoding: Optional[str] = None
+
+    @classmethod
+    def tagged(cls, data: bytes, encoding: Optional[str]) -> 'SourceBytes':
+        tagged = cls(data)
+        tagged.encoding = encoding
+        return tagged
+
+
+@dataclass
+class SourceBuffer:
+    """Raw file contents plus the encoding they decode with."""
+    path: str
+    data: SourceBytes
+    encoding: str
+
+
+# normalized path -> (mtime_ns, size, encoding)
+_encoding_cache: Dict[str, Tuple[int, int, str]] = {}
+_encoding_cache_lock = threading.Lock()
+
+
+def detect_encoding(data: bytes) -> Optional[str]:
+    """
+    Return the first of SOURCE_ENCODINGS that decodes data, or None.
+
+    Pure-ASCII buffers (the common case) are recognised without decoding.
+    """
+    if data.isascii():
+        return 'utf-8'
+    for encoding in SOURCE_ENCODINGS:
+        try:
+            data.decode(encoding)
+            return encoding
+        except (UnicodeDecodeError, LookupError):
+            continue
+    return None
+
+
+def read_source(file_path) -> Optional[SourceBuffer]:
+    """
+    Read a source file with a single read() and detect its encoding.
+
+    Returns:
+        SourceBuffer, or None if the file cannot be read or decoded
+    """
+    key = os.path.normcase(os.path.abspath(str(file_path)))
+    try:
+        with open(key, 'rb') as f:
+            stat = os.fstat(f.fileno())
+            data = f.read()
+    except OSError as e:
+        print(f"Warning: Could not read {file_path}: {e}")
+        return None
+    count('source.read')
+
+    with _encoding_cache_lock:
+        cached = _encoding_cache.get(key)
+    if cached and cached[0] == stat.st_mtime_ns and cached[1] == stat.st_size:
+        count('source.encoding_cache_hit')
+        return SourceBuffer(path=key, data=SourceBytes.tagged(data, cached[2]), encoding=cached[2])
+
+    encoding = detect_encoding(data)
+    if encoding is None:
+        print(f"Warning: Could not decode {file_path} with any supported encoding")
+        return None
+
+    with _encoding_cache_lock:
+        _encoding_cache[key] = (stat.st_mtime_ns, stat.st_size, encoding)
+    return SourceBuffer(path=key, data=SourceBytes.tagged(data, encoding), encoding=encoding)
+
+
+def decode_text(data: bytes, encoding: Optional[str] = None) -> str:
+    """
+    Decode a slice of source text: the file's detected encoding first (when
+    known), then UTF-8 and the common legacy codecs, finally UTF-8 with
+    replacement characters.
+    """
+    if encoding:
+        try:
+            return data.decode(encoding)
+        except (UnicodeDecodeError, LookupError):
+            pass
+    try:
+        return data.decode('utf8')
+    except UnicodeDecodeError:
+        pass
+    for fallback in ('gbk', 'gb2312', 'latin-1'):
+        try:
+            return data.decode(fallback)
+        except (UnicodeDecodeError, LookupError):
+            continue
+    return data.decode('utf8', errors='replace')
+
+
+def clear_encoding_cache():
+    with _encoding_cache_lock:
+        _encoding_cache.clear()
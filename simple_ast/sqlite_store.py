@@ -0,0 +1,409 @@
+"""
+Disk-backed project index for very large repositories (``store='sqlite'``).
+
+The in-memory tables (SymbolStore, CallerIndex) grow with the repository.
+SqliteIndexStore keeps the same data in one SQLite file under the cache
+directory, and that file doubles as the per-file index cache:
+
+- files: one row per indexed file with its (mtime, size, content hash), its
+  #include names and ``ord``, the file's position in the current walk, so
+  lookups return symbols in the same order as the in-memory store; a sync
+  resets ``ord`` first, so files the walk no longer visits are found by query
+- symbols / calls: one row per symbol / call edge, indexed by name / callee
+  and by file
+
+Indexing writes with batched executemany calls, one transaction per batch of
+files; lookups are indexed queries behind a bounded LRU hot cache. Memory is
+bounded by the batch size, SQLite's page cache and the hot cache rather than
+by the size of the repository.
+
+SqliteSymbolStore and SqliteCallerIndex expose the read interfaces of
+SymbolStore and CallerIndex on top of the database.
+"""
+import json
+import os
+import sqlite3
+import threading
+from collections import OrderedDict
+from collections.abc import Mapping
+from itertools import groupby
+from pathlib import Path
+from typing import Dict, Iterator, List, NamedTuple, Optional, Set
+
+from .caller_index import CallerIndex, CallerSite, callee_key
+from .index_cache import content_hash
+from .logger import count
+
+DEFAULT_HOT_CACHE_SIZE = 4096  # names kept in the in-memory lookup cache
+_PAGE_CACHE_KB = 16 * 1024     # SQLite page cache per connection
+_FETCH_ROWS = 1024
+_MAX_PARAMS = 900              # bound parameters per statement (SQLite < 3.32 allows 999)
+
+_FLAG_DECLARATION = 1
+_FLAG_IN_HEADER = 2
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT);
+CREATE TABLE IF NOT EXISTS files (
+    id INTEGER PRIMARY KEY,
+    path TEXT NOT NULL UNIQUE,
+    ord INTEGER NOT NULL,
+    mtime_ns INTEGER NOT NULL,
+    size INTEGER NOT NULL,
+    content_hash TEXT NOT NULL,
+    includes TEXT NOT NULL
+);
+CREATE TABLE IF NOT EXISTS symbols (
+    file_id INTEGER NOT NULL,
+    seq INTEGER NOT NULL,
+    name TEXT NOT NULL,
+    type TEXT NOT NULL,
+    line INTEGER NOT NULL,
+    signature TEXT NOT NULL,
+    flags INTEGER NOT NULL,
+    PRIMARY KEY (file_id, seq)
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS symbols_by_name ON symbols (name);
+CREATE TABLE IF NOT EXISTS calls (
+    file_id INTEGER NOT NULL,
+    seq INTEGER NOT NULL,
+    callee TEXT NOT NULL,
+    caller TEXT NOT NULL,
+    line INTEGER NOT NULL,
+    PRIMARY KEY (file_id, seq)
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS calls_by_callee ON calls (callee);
+"""
+
+
+class FileState(NamedTuple):
+    """What the database knows about one indexed file."""
+    id: int
+    mtime_ns: int
+    size: int
+    content_hash: str
+
+
+def file_unchanged(state: FileState, file_path: Path, stat: os.stat_result) -> bool:
+    """Same rule as IndexCache: trust (mtime, size), else compare content hashes."""
+    if state.mtime_ns == stat.st_mtime_ns and state.size == stat.st_size:
+        return True
+    if state.size != stat.st_size:
+        return False
+    try:
+        with open(file_path, 'rb') as f:
+            return content_hash(f.read()) == state.content_hash
+    except OSError:
+        return False
+
+
+class SqliteIndexStore:
+    """One SQLite database holding a project's symbols, call edges and includes."""
+
+    def __init__(self, db_path, version: int, hot_cache_size: int = DEFAULT_HOT_CACHE_SIZE,
+                 fresh: bool = False):
+        """
+        Args:
+            db_path: Database file (created if missing)
+            version: Index format version; a mismatch discards the stored data
+            hot_cache_size: Number of names whose lookups are cached in memory
+            fresh: Discard any existing data (indexing without cache)
+        """
+        self.db_path = Path(db_path)
+        self.version = version
+        self.hot_cache_size = max(0, hot_cache_size)
+        self._lock = threading.RLock()
+        self._conn: Optional[sqlite3.Connection] = None
+        self._pid = None
+        if fresh:
+            self._delete_files()
+        self.symbols = SqliteSymbolStore(self)
+        self.callers = SqliteCallerIndex(self)
+        self._open()
+
+    # -- connection ------------------------------------------------------
+
+    def _delete_files(self):
+        for suffix in ('', '-journal', '-wal', '-shm'):
+            try:
+                os.unlink(str(self.db_path) + suffix)
+            except OSError:
+                pass
+
+    def _open(self):
+        self.db_path.parent.mkdir(parents=True, exist_ok=True)
+        conn = sqlite3.connect(str(self.db_path), check_same_thread=False)
+        conn.execute('PRAGMA synchronous = NORMAL')
+        conn.execute('PRAGMA temp_store = MEMORY')
+        conn.execute(f'PRAGMA cache_size = -{_PAGE_CACHE_KB}')
+        conn.executescript(_SCHEMA)
+        row = conn.execute("SELECT value FROM meta WHERE key = 'version'").fetchone()
+        if row is None or row[0] != str(self.version):
+            if row is not None:
+                print(f"Index store version changed, rebuilding: {self.db_path}")
+            conn.executescript('DELETE FROM files; DELETE FROM symbols; DELETE FROM calls;')
+            conn.execute("INSERT OR REPLACE INTO meta (key, value) VALUES ('version', ?)",
+                         (str(self.version),))
+            conn.commit()
+        self._conn = conn
+        self._pid = os.getpid()
+
+    @property
+    def conn(self) -> sqlite3.Connection:
+        # A connection must not be used across fork(): reopen in the child
+        if self._pid != os.getpid():
+            self._open()
+        return self._conn
+
+    def query(self, sql: str, params=()) -> list:
+        with self._lock:
+            return self.conn.execute(sql, params).fetchall()
+
+    def iterate(self, sql: str, params=()) -> Iterator[tuple]:
+        """Stream a large result set without holding the lock between chunks."""
+        with self._lock:
+            cursor = self.conn.execute(sql, params)
+        while True:
+            with self._lock:
+                rows = cursor.fetchmany(_FETCH_ROWS)
+            if not rows:
+                return
+            yield from rows
+
+    def close(self):
+        with self._lock:
+            if self._conn is not None and self._pid == os.getpid():
+                self._conn.close()
+            self._conn = None
+
+    # -- writes (one transaction per commit()) ---------------------------
+
+    def begin_sync(self):
+        """Mark every file unvisited; touch_files/replace_file mark them visited again."""
+        with self._lock:
+            self.conn.execute('UPDATE files SET ord = -1')
+
+    def file_states(self, paths: List[str]) -> Dict[str, FileState]:
+        """States of the given files that are in the database (one batch of the walk)."""
+        states = {}
+        for start in range(0, len(paths), _MAX_PARAMS):
+            chunk = paths[start:start + _MAX_PARAMS]
+            for file_id, path, mtime_ns, size, digest in self.query(
+                    'SELECT id, path, mtime_ns, size, content_hash FROM files '
+                    f'WHERE path IN ({", ".join("?" * len(chunk))})', chunk):
+                states[path] = FileState(file_id, mtime_ns, size, digest)
+        return states
+
+    def touch_files(self, updates: List[tuple]):
+        """Unchanged files: [(order, mtime_ns, size, id), ...]"""
+        if updates:
+            with self._lock:
+                self.conn.executemany('UPDATE files SET ord = ?, mtime_ns = ?, size = ? WHERE id = ?',
+                                      updates)
+
+    def replace_file(self, rel_path: str, order: int, stat: os.stat_result, entry):
+        """Store one freshly indexed file (a FileIndexEntry), replacing its old rows."""
+        with self._lock:
+            conn = self.conn
+            self._delete_rows(conn, rel_path)
+            cursor = conn.execute(
+                'INSERT INTO files (path, ord, mtime_ns, size, content_hash, includes) '
+                'VALUES (?, ?, ?, ?, ?, ?)',
+                (rel_path, order, stat.st_mtime_ns, stat.st_size, entry.content_hash,
+                 json.dumps(entry.includes)))
+            file_id = cursor.lastrowid
+            conn.executemany(
+                'INSERT INTO symbols (file_id, seq, name, type, line, signature, flags) '
+                'VALUES (?, ?, ?, ?, ?, ?, ?)',
+                [(file_id, seq, s.name, s.type, s.line_number, s.signature,
+                  (_FLAG_DECLARATION if s.is_declaration else 0) | (_FLAG_IN_HEADER if s.is_in_header else 0))
+                 for seq, s in enumerate(entry.symbols)])
+            conn.executemany(
+                'INSERT INTO calls (file_id, seq, callee, caller, line) VALUES (?, ?, ?, ?, ?)',
+                [(file_id, seq, callee, caller, line)
+                 for seq, (callee, caller, line) in enumerate(entry.calls)])
+        count('index_store.write_file')
+
+    def remove_file(self, rel_path: str):
+        with self._lock:
+            self._delete_rows(self.conn, rel_path)
+
+    def remove_unvisited(self) -> int:
+        """Delete the files not visited since begin_sync(). Returns how many."""
+        with self._lock:
+            conn = self.conn
+            removed = conn.execute('SELECT COUNT(*) FROM files WHERE ord < 0').fetchone()[0]
+            if removed:
+                conn.execute('DELETE FROM symbols WHERE file_id IN (SELECT id FROM files WHERE ord < 0)')
+                conn.execute('DELETE FROM calls WHERE file_id IN (SELECT id FROM files WHERE ord < 0)')
+                conn.execute('DELETE FROM files WHERE ord < 0')
+        return removed
+
+    @staticmethod
+    def _delete_rows(conn: sqlite3.Connection, rel_path: str):
+        row = conn.execute('SELECT id FROM files WHERE path = ?', (rel_path,)).fetchone()
+        if row is None:
+            return
+        conn.execute('DELETE FROM symbols WHERE file_id = ?', row)
+        conn.execute('DELETE FROM calls WHERE file_id = ?', row)
+        conn.execute('DELETE FROM files WHERE id = ?', row)
+
+    def commit(self):
+        with self._lock:
+            self.conn.commit()
+        self.clear_hot_cache()
+
+    def clear_hot_cache(self):
+        self.symbols.clear_hot_cache()
+
+    # -- reads -----------------------------------------------------------
+
+    def include_graph(self) -> 'SqliteIncludeGraph':
+        """rel_path -> include names, read from the database on demand."""
+        return SqliteIncludeGraph(self)
+
+    def file_includes(self, rel_path: str) -> Optional[List[str]]:
+        rows = self.query('SELECT includes FROM files WHERE path = ?', (rel_path,))
+        return json.loads(rows[0][0]) if rows else None
+
+    def file_count(self) -> int:
+        return self.query('SELECT COUNT(*) FROM files')[0][0]
+
+
+def _symbol(name, symbol_type, file_path, line, signature, flags):
+    from .project_indexer import SymbolInfo
+    return SymbolInfo(
+        name=name,
+        type=symbol_type,
+        file_path=file_path,
+        line_number=line,
+        signature=signature,
+        is_declaration=bool(flags & _FLAG_DECLARATION),
+        is_in_header=bool(flags & _FLAG_IN_HEADER)
+    )
+
+
+_SYMBOL_COLUMNS = 's.name, s.type, f.path, s.line, s.signature, s.flags'
+
+
+class SqliteIncludeGraph(Mapping):
+    """
+    Read-only ProjectIndexer.include_graph for the sqlite store: each lookup
+    is one indexed query instead of holding every file's includes in memory.
+    """
+
+    def __init__(self, store: SqliteIndexStore):
+        self.store = store
+
+    def __getitem__(self, rel_path: str) -> List[str]:
+        includes = self.store.file_includes(rel_path)
+        if includes is None:
+            raise KeyError(rel_path)
+        count('index_store.includes_lookup')
+        return includes
+
+    def __iter__(self) -> Iterator[str]:
+        for (path,) in self.store.iterate('SELECT path FROM files ORDER BY ord'):
+            yield path
+
+    def __len__(self) -> int:
+        return self.store.file_count()
+
+
+class SqliteSymbolStore(Mapping):
+    """Read-only ``name -> List[SymbolInfo]`` mapping backed by SqliteIndexStore."""
+
+    def __init__(self, store: SqliteIndexStore):
+        self.store = store
+        self._hot: 'OrderedDict[str, list]' = OrderedDict()
+        self._hot_lock = threading.Lock()
+
+    def clear_hot_cache(self):
+        with self._hot_lock:
+            self._hot.clear()
+
+    def lookup(self, name: str) -> list:
+        """Symbols named ``name`` in file order (empty list when unknown)."""
+        with self._hot_lock:
+            cached = self._hot.get(name)
+            if cached is not None:
+                self._hot.move_to_end(name)
+                count('index_store.hot_hit')
+                return cached
+        count('index_store.query')
+        symbols = [_symbol(*row) for row in self.store.query(
+            f'SELECT {_SYMBOL_COLUMNS} FROM symbols s JOIN files f ON f.id = s.file_id '
+            'WHERE s.name = ? ORDER BY f.ord, s.seq', (name,))]
+        if self.store.hot_cache_size:
+            with self._hot_lock:
+                self._hot[name] = symbols
+                while len(self._hot) > self.store.hot_cache_size:
+                    self._hot.popitem(last=False)
+        return symbols
+
+    def file_symbol_names(self, file_path: str) -> Set[str]:
+        return {name for name, in self.store.query(
+            'SELECT s.name FROM symbols s JOIN files f ON f.id = s.file_id WHERE f.path = ?',
+            (file_path,))}
+
+    def files(self) -> List[str]:
+        return [path for path, in self.store.query('SELECT path FROM files ORDER BY ord')]
+
+    @property
+    def row_count(self) -> int:
+        return self.store.query('SELECT COUNT(*) FROM symbols')[0][0]
+
+    # -- Mapping interface -----------------------------------------------
+
+    def __getitem__(self, name: str):
+        symbols = self.lookup(name) if isinstance(name, str) else []
+        if not symbols:
+            raise KeyError(name)
+        return symbols
+
+    def __contains__(self, name) -> bool:
+        return isinstance(name, str) and bool(self.lookup(name))
+
+    def __iter__(self) -> Iterator[str]:
+        return (name for name, in self.store.iterate('SELECT DISTINCT name FROM symbols ORDER BY name'))
+
+    def __len__(self) -> int:
+        return self.store.query('SELECT COUNT(DISTINCT name) FROM symbols')[0][0]
+
+    def items(self):
+        """All (name, symbols) pairs from one streamed query (not one query per name)."""
+        rows = self.store.iterate(
+            f'SELECT {_SYMBOL_COLUMNS} FROM symbols s JOIN files f ON f.id = s.file_id '
+            'ORDER BY s.name, f.ord, s.seq')
+        for name, group in groupby(rows, key=lambda row: row[0]):
+            yield name, [_symbol(*row) for row in group]
+
+
+class SqliteCallerIndex(CallerIndex):
+    """Reverse call index queries (callers, transitive callers, impact) backed by SqliteIndexStore."""
+
+    def __init__(self, store: SqliteIndexStore):
+        self.store = store
+
+    def add_file(self, file_path, calls):
+        raise TypeError("SqliteCallerIndex is written through SqliteIndexStore.replace_file()")
+
+    def copy_file_from(self, other, file_path):
+        raise TypeError("SqliteCallerIndex is written through SqliteIndexStore.replace_file()")
+
+    def callers_of(self, callee: str) -> List[CallerSite]:
+        return [CallerSite(callee=name, caller=caller, file_path=path, line=line)
+                for name, caller, path, line in self.store.query(
+                    'SELECT c.callee, c.caller, f.path, c.line FROM calls c JOIN files f ON f.id = c.file_id '
+                    'WHERE c.callee = ? ORDER BY f.ord, c.seq', (callee_key(callee),))]
+
+    def caller_names(self, callee: str) -> Set[str]:
+        return {caller for caller, in self.store.query(
+            'SELECT DISTINCT caller FROM calls WHERE callee = ?', (callee_key(callee),))}
+
+    @property
+    def row_count(self) -> int:
+        return self.store.query('SELECT COUNT(*) FROM calls')[0][0]
+
+    def __len__(self) -> int:
+        return self.row_count
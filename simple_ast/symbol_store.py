@@ -0,0 +1,183 @@
+"""
+Compact project-wide symbol storage.
+
+Symbols are kept as parallel arrays (struct-of-arrays) of small integers:
+names, file paths and symbol types are interned once in a StringPool and
+referenced by id; signatures (almost always unique) sit in a plain list.
+SymbolInfo objects are only built when a caller asks for them, so a large
+project holds a few arrays instead of one Python object, one list per name
+and duplicated path strings per symbol.
+
+SymbolStore implements the read-only Mapping interface of the old
+``Dict[str, List[SymbolInfo]]`` symbol table, so ``symbol_table[name]``,
+``.get()``, ``.items()``, ``in`` and ``len()`` keep working.
+"""
+from array import array
+from collections.abc import Mapping
+from typing import Dict, Iterator, List, Set, Tuple
+
+_FLAG_DECLARATION = 1
+_FLAG_IN_HEADER = 2
+_NO_ROW = -1
+
+
+class StringPool:
+    """Interns strings and hands out dense integer ids."""
+
+    __slots__ = ('_ids', '_strings')
+
+    def __init__(self):
+        self._ids: Dict[str, int] = {}
+        self._strings: List[str] = []
+
+    def intern(self, value: str) -> int:
+        string_id = self._ids.get(value)
+        if string_id is None:
+            string_id = len(self._strings)
+            self._ids[value] = string_id
+            self._strings.append(value)
+        return string_id
+
+    def lookup(self, value: str) -> int:
+        """Id of an already interned string, or -1."""
+        return self._ids.get(value, _NO_ROW)
+
+    def __getitem__(self, string_id: int) -> str:
+        return self._strings[string_id]
+
+    def __len__(self) -> int:
+        return len(self._strings)
+
+
+class SymbolStore(Mapping):
+    """
+    Struct-of-arrays symbol table: name -> symbols in insertion order.
+
+    Rows of one name are chained through ``_next`` (head/tail per name id)
+    so no per-name list is kept; rows of one file are contiguous because
+    files are merged one at a time.
+    """
+
+    def __init__(self):
+        self.names = StringPool()
+        self.strings = StringPool()  # file paths and symbol types
+        self._name = array('i')
+        self._type = array('i')
+        self._file = array('i')
+        self._line = array('i')
+        self._flags = array('b')
+        self._next = array('i')
+        self._signatures: List[str] = []
+        # name id -> first / last row
+        self._head = array('i')
+        self._tail = array('i')
+        # file path -> (first row, end row)
+        self._file_rows: Dict[str, Tuple[int, int]] = {}
+
+    # -- building --------------------------------------------------------
+
+    def add(self, symbol) -> int:
+        """Append a SymbolInfo (or anything with the same fields). Returns the row."""
+        return self.add_row(symbol.name, symbol.type, symbol.file_path, symbol.line_number,
+                            symbol.signature, symbol.is_declaration, symbol.is_in_header)
+
+    def add_row(self, name: str, symbol_type: str, file_path: str, line_number: int,
+                signature: str, is_declaration: bool, is_in_header: bool) -> int:
+        intern = self.strings.intern
+        row = len(self._name)
+        name_id = self.names.intern(name)
+        self._name.append(name_id)
+        self._type.append(intern(symbol_type))
+        self._file.append(intern(file_path))
+        self._line.append(line_number)
+        self._signatures.append(signature)
+        self._flags.append((_FLAG_DECLARATION if is_declaration else 0) |
+                           (_FLAG_IN_HEADER if is_in_header else 0))
+        self._next.append(_NO_ROW)
+
+        if name_id == len(self._head):
+            self._head.append(row)
+            self._tail.append(row)
+        else:
+            self._next[self._tail[name_id]] = row
+            self._tail[name_id] = row
+
+        span = self._file_rows.get(file_path)
+        self._file_rows[file_path] = (span[0] if span else row, row + 1)
+        return row
+
+    def add_file(self, file_path: str, symbols):
+        """Append all symbols of one file (keeps the file's rows contiguous)."""
+        for symbol in symbols:
+            self.add(symbol)
+        self._file_rows.setdefault(file_path, (len(self._name), len(self._name)))
+
+    def copy_file_from(self, other: 'SymbolStore', file_path: str):
+        """Append one file's rows from another store (used by incremental refresh)."""
+        span = other._file_rows.get(file_path)
+        if span is None:
+            return
+        names, strings = other.names, other.strings
+        for row in range(*span):
+            flags = other._flags[row]
+            self.add_row(names[other._name[row]], strings[other._type[row]],
+                         strings[other._file[row]], other._line[row],
+                         other._signatures[row],
+                         bool(flags & _FLAG_DECLARATION), bool(flags & _FLAG_IN_HEADER))
+        self._file_rows.setdefault(file_path, (len(self._name), len(self._name)))
+
+    # -- views -----------------------------------------------------------
+
+    def symbol_at(self, row: int):
+        """Build the SymbolInfo view of one row (strings are shared, not copied)."""
+        from .project_indexer import SymbolInfo
+        strings = self.strings
+        flags = self._flags[row]
+        return SymbolInfo(
+            name=self.names[self._name[row]],
+            type=strings[self._type[row]],
+            file_path=strings[self._file[row]],
+            line_number=self._line[row],
+            signature=self._signatures[row],
+            is_declaration=bool(flags & _FLAG_DECLARATION),
+            is_in_header=bool(flags & _FLAG_IN_HEADER)
+        )
+
+    def rows(self, name: str) -> Iterator[int]:
+        name_id = self.names.lookup(name)
+        row = self._head[name_id] if name_id != _NO_ROW else _NO_ROW
+        while row != _NO_ROW:
+            yield row
+            row = self._next[row]
+
+    def file_symbol_names(self, file_path: str) -> Set[str]:
+        span = self._file_rows.get(file_path)
+        if span is None:
+            return set()
+        names = self.names
+        return {names[self._name[row]] for row in range(*span)}
+
+    def files(self) -> List[str]:
+        return list(self._file_rows)
+
+    @property
+    def row_count(self) -> int:
+        return len(self._name)
+
+    # -- Mapping interface (name -> List[SymbolInfo]) --------------------
+
+    def __getitem__(self, name: str):
+        symbols = [self.symbol_at(row) for row in self.rows(name)]
+        if not symbols:
+            raise KeyError(name)
+        return symbols
+
+    def __contains__(self, name) -> bool:
+        return isinstance(name, str) and self.names.lookup(name) != _NO_ROW
+
+    def __iter__(self) -> Iterator[str]:
+        names = self.names
+        return (names[name_id] for name_id in range(len(names)))
+
+    def __len__(self) -> int:
+        return len(self.names)
@@ -0,0 +1,80 @@
+"""
+单次遍历访问器 - 用一个 tree-sitter 游标先序遍历子树，按节点类型分派到处理函数
+
+需要多种节点统计/收集的地方（分支分析、数据结构索引等）注册各自关心的类型，
+一次遍历完成，不再为每种统计各走一遍整棵树；显式游标遍历也不受递归深度限制。
+"""
+from typing import Callable, Dict, Iterable, List, Optional
+
+NodeHandler = Callable[[object], None]
+
+
+class TreeVisitor:
+    """
+    按节点类型注册 enter/leave 处理函数，然后 visit(root) 一次遍历
+
+    enter 在进入节点时（子节点之前）调用，leave 在节点的子树全部访问后调用；
+    通过 leave 可以维护“当前处于哪些 switch/函数之内”之类的嵌套状态。
+    """
+
+    def __init__(self):
+        self._enter: Dict[str, List[NodeHandler]] = {}
+        self._leave: Dict[str, List[NodeHandler]] = {}
+
+    def on(self, node_types, enter: Optional[NodeHandler] = None,
+           leave: Optional[NodeHandler] = None) -> 'TreeVisitor':
+        """为一个或多个节点类型注册处理函数（可多次注册，按注册顺序调用）"""
+        if isinstance(node_types, str):
+            node_types = (node_types,)
+        for node_type in node_types:
+            if enter is not None:
+                self._enter.setdefault(node_type, []).append(enter)
+            if leave is not None:
+                self._leave.setdefault(node_type, []).append(leave)
+        return self
+
+    def visit(self, root):
+        """先序遍历 root 的整棵子树（包括 root 本身）"""
+        enter_handlers = self._enter
+        leave_handlers = self._leave
+
+        cursor = root.walk()
+        while True:
+            node = cursor.node
+            handlers = enter_handlers.get(node.type)
+            if handlers:
+                for handler in handlers:
+                    handler(node)
+
+            if cursor.goto_first_child():
+                continue
+
+            # 叶子节点：离开自身，再向上离开已访问完的祖先，直到找到下一个兄弟
+            if leave_handlers:
+                self._leave_node(node)
+            while not cursor.goto_next_sibling():
+                if not cursor.goto_parent():
+                    return
+                if leave_handlers:
+                    self._leave_node(cursor.node)
+
+    def _leave_node(self, node):
+        handlers = self._leave.get(node.type)
+        if handlers:
+            for handler in handlers:
+                handler(node)
+
+
+def collect_nodes_by_type(root, node_types: Iterable[str]) -> Dict[str, list]:
+    """
+    一次遍历收集多种类型的节点
+
+    Returns:
+        {节点类型: 节点列表}，每个列表按先序（出现）顺序
+    """
+    collected: Dict[str, list] = {node_type: [] for node_type in node_types}
+    visitor = TreeVisitor()
+    for node_type, nodes in collected.items():
+        visitor.on(node_type, nodes.append)
+    visitor.visit(root)
+    return collected
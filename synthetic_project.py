@@ -0,0 +1,319 @@
+"""
+SimpleAST 合成大项目生成器 - 按指定规模生成 C/C++ 源码树，用于压力测试
+
+生成的代码仿照 tests/test_real_scenario.cpp / tests/test_msgblock.cpp 的写法：
+VOS_* 基础类型、PID_* 常量、GET_DOPRA_MSG_LEN / OFFSET_AFTER 等宏、MsgBlock 式的
+消息结构体强转，以及按发送方 PID 分发的 switch 入口函数。
+
+目录结构:
+    include/common/syn_types.h          基础类型、公共宏、外部库函数声明
+    include/mod<M>/mod<M>.h             每个模块一个头文件：结构体、宏、枚举、本模块函数声明
+    src/mod<M>/mod<M>_file<F>.cpp       源文件：一个分发入口 + 分层调用的内部函数
+
+可调参数见 SyntheticSpec：文件数、每文件函数数、调用深度与扇出、结构体/宏密度、
+GBK 文件比例、模块头文件之间的包含关系（tree / chain / flat）。相同参数和 seed
+生成的内容完全相同。
+
+用法:
+    python synthetic_project.py <输出目录> [--files N] [--functions N] [--depth N] [--fan-out N]
+                                [--structs N] [--macros N] [--files-per-module N]
+                                [--include-shape tree|chain|flat] [--gbk-ratio R] [--seed N]
+"""
+import io
+import sys
+
+# 设置标准输出为 UTF-8 编码
+if sys.platform == 'win32':
+    sys.stdout = io.TextIOWrapper(sys.stdout.buffer, encoding='utf-8')
+    sys.stderr = io.TextIOWrapper(sys.stderr.buffer, encoding='utf-8')
+
+import random
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Callable, List, Tuple
+
+INCLUDE_SHAPES = ('tree', 'chain', 'flat')
+
+# 分发入口 switch 的分支（发送方 PID）
+PIDS = [('PID_DIAM', 306), ('DOPRA_PID_TIMER', 100), ('PID_SF', 206), ('PID_DSP', 242),
+        ('PID_HAPD', 204), ('PID_MAINTAIN', 181), ('PID_OM', 241)]
+
+
+@dataclass
+class SyntheticSpec:
+    """合成项目的规模参数"""
+    files: int = 20                # 源文件数
+    functions_per_file: int = 20   # 每个源文件的内部函数数（不含分发入口）
+    call_depth: int = 4            # 文件内调用层数（入口 -> 第 0 层 -> ... -> 最后一层）
+    fan_out: int = 3               # 每个函数调用下一层的函数数（同文件内的调用闭包大量重叠）
+    structs_per_header: int = 4    # 每个模块头文件的结构体数
+    macros_per_header: int = 8     # 每个模块头文件的常量宏数
+    files_per_module: int = 8      # 每个模块（一个头文件）的源文件数
+    include_shape: str = 'tree'    # 模块头文件之间的包含关系
+    gbk_ratio: float = 0.25        # GBK 编码的源文件比例（其余为 UTF-8）
+    cross_module_calls: int = 2    # 最后一层函数调用其他模块函数的次数
+    seed: int = 0
+
+
+@dataclass
+class SyntheticProject:
+    """生成结果"""
+    root: Path
+    spec: SyntheticSpec
+    sources: List[Path] = field(default_factory=list)
+    headers: List[Path] = field(default_factory=list)
+    functions: int = 0
+    lines: int = 0
+    bytes: int = 0
+
+    def to_dict(self) -> dict:
+        return {
+            'root': str(self.root),
+            'spec': asdict(self.spec),
+            'sources': len(self.sources),
+            'headers': len(self.headers),
+            'functions': self.functions,
+            'lines': self.lines,
+            'bytes': self.bytes,
+        }
+
+
+def _mod_header(module: int) -> str:
+    return f'mod{module}/mod{module}.h'
+
+
+def _function_name(module: int, file_no: int, level: int, index: int) -> str:
+    return f'Mod{module}F{file_no}L{level}N{index}'
+
+
+def _levels(spec: SyntheticSpec) -> List[int]:
+    """每层的函数数（函数尽量平均分到各层，每层至少一个）"""
+    depth = max(1, min(spec.call_depth, spec.functions_per_file))
+    base, extra = divmod(max(spec.functions_per_file, depth), depth)
+    return [base + (1 if level < extra else 0) for level in range(depth)]
+
+
+class _Writer:
+    """按文件写出并统计行数/字节数"""
+
+    def __init__(self, project: SyntheticProject):
+        self.project = project
+
+    def write(self, path: Path, lines: List[str], encoding: str = 'utf-8'):
+        path.parent.mkdir(parents=True, exist_ok=True)
+        data = ('\n'.join(lines) + '\n').encode(encoding)
+        path.write_bytes(data)
+        self.project.lines += len(lines)
+        self.project.bytes += len(data)
+
+
+def _types_header() -> List[str]:
+    lines = ['// 公共基础类型与宏（合成项目）', '#ifndef SYN_TYPES_H', '#define SYN_TYPES_H',
+             '#include <stddef.h>', '',
+             'typedef unsigned int VOS_UINT32;', 'typedef unsigned char VOS_UINT8;',
+             'typedef void VOS_VOID;', '']
+    lines += [f'#define {name} {value}' for name, value in PIDS]
+    lines += ['', '#define DIAM_CMDFLAG_REQUEST 0x01', '#define DIAM_CMDFLAG_ANSWER 0x00',
+              '#define DIAM_SUCCESS 0', '#define VOS_OK 0', '',
+              '#define GET_DOPRA_MSG_LEN(msgPtr) ((msgPtr)->ulLength)',
+              '#define OFFSET_AFTER(type, member) (offsetof(type, member) + sizeof(((type*)0)->member))',
+              '#define OFFSET_OF(type, member) offsetof(type, member)',
+              '#define MSGLEN_CHECK_RETURN(cond) if (cond) return', '',
+              '// 消息头',
+              'struct MsgBlock {', '    VOS_UINT32 ulSenderPid;', '    VOS_UINT32 ulReceiverPid;',
+              '    VOS_UINT32 ulLength;', '};', '',
+              'VOS_UINT32 VOS_MemCpy(VOS_VOID *dst, const VOS_VOID *src, VOS_UINT32 len);',
+              'VOS_VOID SynLogError(VOS_UINT32 code);',
+              '#endif']
+    return lines
+
+
+def _module_header(spec: SyntheticSpec, module: int, module_files: List[int],
+                   rng: random.Random) -> List[str]:
+    guard = f'SYN_MOD{module}_H'
+    lines = [f'// 模块 {module} 的数据结构与接口', f'#ifndef {guard}', f'#define {guard}',
+             '#include "common/syn_types.h"']
+    if spec.include_shape == 'tree' and module > 0:
+        lines.append(f'#include "{_mod_header((module - 1) // 2)}"')
+    elif spec.include_shape == 'chain' and module > 0:
+        lines.append(f'#include "{_mod_header(module - 1)}"')
+    lines.append('')
+
+    for index in range(spec.macros_per_header):
+        lines.append(f'#define MOD{module}_LIMIT_{index} {rng.randint(4, 64)}')
+    lines.append('')
+
+    for index in range(spec.structs_per_header):
+        name = f'Mod{module}Msg{index}'
+        limit = f'MOD{module}_LIMIT_{index % max(1, spec.macros_per_header)}' \
+            if spec.macros_per_header else str(8 + index)
+        lines += [f'/* 模块 {module} 消息体 {index} */', f'typedef struct tag{name} {{',
+                  '    VOS_UINT32 ulSenderPid;', '    VOS_UINT32 ulMsgType;',
+                  f'    VOS_UINT8 aucData[{limit}];', f'}} {name};', '']
+
+    lines.append(f'enum Mod{module}State {{')
+    lines += [f'    MOD{module}_STATE_{index} = {index},' for index in range(4)]
+    lines += ['};', '']
+
+    # 本模块各文件最后一层的函数对外可见（供其他模块跨文件调用）
+    last_level = len(_levels(spec)) - 1
+    for file_no in module_files:
+        lines.append(f'VOS_UINT32 {_function_name(module, file_no, last_level, 0)}'
+                     f'(struct MsgBlock *pMsg, VOS_UINT32 state);')
+    lines.append('#endif')
+    return lines
+
+
+def _source_file(spec: SyntheticSpec, module: int, file_no: int, modules: int,
+                 files_in_module: Callable[[int], List[int]], rng: random.Random,
+                 gbk: bool) -> Tuple[List[str], int]:
+    """生成一个源文件，返回 (行, 函数数)"""
+    levels = _levels(spec)
+    last_level = len(levels) - 1
+    structs = max(1, spec.structs_per_header)
+    encoding_note = 'GBK 编码' if gbk else 'UTF-8 编码'
+    lines = [f'// 模块 {module} 文件 {file_no}（{encoding_note}）：消息处理',
+             f'#include "{_mod_header(module)}"', '',
+             f'static VOS_UINT32 g_mod{module}f{file_no}Count = 0;', '']
+
+    # 从最后一层往前生成，被调用的函数先定义
+    function_count = 0
+    for level in reversed(range(len(levels))):
+        for index in range(levels[level]):
+            name = _function_name(module, file_no, level, index)
+            struct_name = f'Mod{module}Msg{rng.randrange(structs)}'
+            is_static = level > 0 and index % 3 == 2 and level != last_level
+            prefix = 'static ' if is_static else ''
+            lines += [f'/* 第 {level} 层处理函数：校验长度后转发 */',
+                      f'{prefix}VOS_UINT32 {name}(struct MsgBlock *pMsg, VOS_UINT32 state)', '{',
+                      f'    {struct_name} *pBody = ({struct_name} *)pMsg;',
+                      f'    MSGLEN_CHECK_RETURN(GET_DOPRA_MSG_LEN(pMsg) < OFFSET_AFTER({struct_name}, aucData)) DIAM_SUCCESS;',
+                      f'    g_mod{module}f{file_no}Count++;',
+                      '    switch (state) {']
+            for case in range(2):
+                lines += [f'        case MOD{module}_STATE_{case}:',
+                          f'            pBody->ulMsgType = {case};', '            break;']
+            lines += ['        default:', '            SynLogError(state);', '            break;', '    }']
+
+            if level < last_level:
+                width = levels[level + 1]
+                for callee in sorted(rng.sample(range(width), min(spec.fan_out, width))):
+                    lines.append(f'    (void){_function_name(module, file_no, level + 1, callee)}(pMsg, state);')
+            else:
+                lines.append('    (void)VOS_MemCpy(pBody->aucData, pMsg, sizeof(struct MsgBlock));')
+                for _ in range(spec.cross_module_calls):
+                    other = rng.randrange(modules)
+                    other_file = rng.choice(files_in_module(other))
+                    if (other, other_file) != (module, file_no):
+                        lines.append(f'    (void){_function_name(other, other_file, last_level, 0)}(pMsg, state);')
+            lines += ['    return DIAM_SUCCESS;', '}', '']
+            function_count += 1
+
+    # 分发入口：按发送方 PID 调用第 0 层
+    lines += [f'/* 模块 {module} 文件 {file_no} 的消息入口 */',
+              f'VOS_VOID PidMod{module}F{file_no}MsgProc(struct MsgBlock *pMsg)', '{',
+              '    if (pMsg == NULL) {', '        return;', '    }',
+              '    switch (pMsg->ulSenderPid) {']
+    for case, (pid, _) in enumerate(PIDS[:max(1, levels[0])]):
+        lines += [f'        case {pid}:',
+                  f'            (void){_function_name(module, file_no, 0, case % levels[0])}'
+                  f'(pMsg, MOD{module}_STATE_{case % 4});',
+                  '            break;']
+    lines += ['        default:', '            SynLogError(pMsg->ulSenderPid);', '            break;',
+              '    }', '}']
+    return lines, function_count + 1
+
+
+def generate_project(root, spec: SyntheticSpec) -> SyntheticProject:
+    """
+    在 root 下生成合成项目（root 不存在时创建；已存在的同名文件被覆盖）
+
+    Returns:
+        SyntheticProject：源文件/头文件列表与总行数、字节数、函数数
+    """
+    if spec.include_shape not in INCLUDE_SHAPES:
+        raise ValueError(f"include_shape 必须是 {'/'.join(INCLUDE_SHAPES)}: {spec.include_shape}")
+    root = Path(root)
+    rng = random.Random(spec.seed)
+    project = SyntheticProject(root=root, spec=spec)
+    writer = _Writer(project)
+
+    files = max(1, spec.files)
+    per_module = max(1, spec.files_per_module)
+    modules = (files + per_module - 1) // per_module
+
+    def files_in_module(module: int) -> List[int]:
+        return list(range(module * per_module, min(files, (module + 1) * per_module)))
+
+    types_path = root / 'include' / 'common' / 'syn_types.h'
+    writer.write(types_path, _types_header())
+    project.headers.append(types_path)
+
+    for module in range(modules):
+        header_path = root / 'include' / _mod_header(module)
+        writer.write(header_path, _module_header(spec, module, files_in_module(module), rng))
+        project.headers.append(header_path)
+
+    gbk_files = set(rng.sample(range(files), int(round(files * min(1.0, max(0.0, spec.gbk_ratio))))))
+    for file_no in range(files):
+        module = file_no // per_module
+        gbk = file_no in gbk_files
+        lines, function_count = _source_file(spec, module, file_no, modules, files_in_module, rng, gbk)
+        source_path = root / 'src' / f'mod{module}' / f'mod{module}_file{file_no}.cpp'
+        writer.write(source_path, lines, encoding='gbk' if gbk else 'utf-8')
+        project.sources.append(source_path)
+        project.functions += function_count
+
+    return project
+
+
+# ==================== 命令行 ====================
+
+_OPTIONS = {
+    '--files': ('files', int), '--functions': ('functions_per_file', int),
+    '--depth': ('call_depth', int), '--fan-out': ('fan_out', int),
+    '--structs': ('structs_per_header', int), '--macros': ('macros_per_header', int),
+    '--files-per-module': ('files_per_module', int), '--include-shape': ('include_shape', str),
+    '--gbk-ratio': ('gbk_ratio', float), '--seed': ('seed', int),
+}
+
+
+def parse_spec_options(args: List[str], spec: SyntheticSpec) -> List[str]:
+    """从参数列表中取出 SyntheticSpec 的选项（原地修改 spec），返回剩余参数"""
+    rest = []
+    args = list(args)
+    while args:
+        arg = args.pop(0)
+        if arg not in _OPTIONS:
+            rest.append(arg)
+            continue
+        if not args:
+            raise ValueError(f"{arg} 需要指定参数值")
+        attr, convert = _OPTIONS[arg]
+        setattr(spec, attr, convert(args.pop(0)))
+    return rest
+
+
+def main():
+    args = sys.argv[1:]
+    if not args or args[0] in ('-h', '--help'):
+        print(__doc__)
+        sys.exit(0 if args else 1)
+
+    spec = SyntheticSpec()
+    try:
+        rest = parse_spec_options(args, spec)
+        if len(rest) != 1:
+            raise ValueError("需要且只能指定一个输出目录")
+        project = generate_project(rest[0], spec)
+    except ValueError as e:
+        print(f"错误: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    print(f"已生成: {project.root}")
+    print(f"  {len(project.sources)} 个源文件，{len(project.headers)} 个头文件，"
+          f"{project.functions} 个函数，{project.lines} 行，{project.bytes / 1024:.0f} KB")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,51 @@
+"""
+测试用的简化文件索引：不依赖 tree-sitter，按行描述一个文件的符号和调用
+
+每行一条记录：
+    def <函数名>              函数定义
+    decl <函数名>             函数声明
+    inc <头文件>              #include
+    call <调用者> <被调用者>  调用边
+
+install() 把 ProjectIndexer._index_file 换成按上述格式解析，返回被解析的文件列表（用于
+检查哪些文件被重新索引）。工作进程中不可用，配合 jobs=1 使用。
+"""
+from pathlib import Path
+from typing import List
+
+from simple_ast.index_cache import content_hash
+from simple_ast.project_indexer import FileIndexEntry, ProjectIndexer, SymbolInfo
+
+
+def fake_index_file(indexer: ProjectIndexer, file_path: Path) -> FileIndexEntry:
+    data = file_path.read_bytes()
+    rel_path = str(file_path.relative_to(indexer.project_root))
+    in_header = file_path.suffix in ('.h', '.hpp')
+    entry = FileIndexEntry(content_hash=content_hash(data))
+    for line_number, line in enumerate(data.decode('utf-8').splitlines(), 1):
+        if not line.strip():
+            continue
+        kind, name, *rest = line.split()
+        if kind == 'def':
+            entry.symbols.append(SymbolInfo(name, 'function', rel_path, line_number,
+                                            f'void {name}()', False, in_header))
+        elif kind == 'decl':
+            entry.symbols.append(SymbolInfo(name, 'function', rel_path, line_number,
+                                            f'void {name}();', True, in_header))
+        elif kind == 'inc':
+            entry.includes.append(name)
+        elif kind == 'call':
+            entry.calls.append((rest[0], name, line_number))
+    return entry
+
+
+def install() -> List[str]:
+    """替换 ProjectIndexer._index_file；返回的列表记录每次被解析的相对路径"""
+    parsed: List[str] = []
+
+    def index_file(self, file_path):
+        parsed.append(str(file_path.relative_to(self.project_root)))
+        return fake_index_file(self, file_path)
+
+    ProjectIndexer._index_file = index_file
+    return parsed
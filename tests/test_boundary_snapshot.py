@@ -0,0 +1,98 @@
+"""
+边界快照测试：调用点不需要重新解析、源文件被修改后仍可恢复、pickle 时按需携带源码
+
+运行: python tests/test_boundary_snapshot.py
+"""
+import pickle
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.boundary_snapshot import NodeHydrator
+from simple_ast.function_index import CallSite
+from simple_ast.single_file_analyzer import FileBoundary
+
+SOURCE = b'void helper() {}\nvoid run() {\n  helper();\n  obj->Send(1);\n}\n'
+
+
+def make_boundary(path: Path) -> FileBoundary:
+    run_start = SOURCE.index(b'void run')
+    return FileBoundary(
+        internal_functions={'helper', 'run'},
+        external_functions={'Send'},
+        internal_data_structures=set(),
+        external_data_structures=set(),
+        file_path=str(path),
+        file_data_structures={},
+        file_functions={
+            'helper': {'span': (0, 16), 'signature': 'void helper()', 'line': 1,
+                       'is_static': False, 'call_sites': []},
+            'run': {'span': (run_start, len(SOURCE) - 1), 'signature': 'void run()', 'line': 2,
+                    'is_static': False,
+                    'call_sites': [CallSite(node=None, callee_text='helper', line=3),
+                                   CallSite(node=None, callee_text='obj->Send', line=4)]},
+        },
+        source_code=SOURCE,
+    )
+
+
+def no_hydrate(self):
+    raise AssertionError("call sites must not need a re-parse")
+
+
+def calls_of(boundary, name):
+    return [(c.callee_text, c.name, c.line) for c in boundary.file_functions[name]['call_sites']]
+
+
+def test_call_sites_restored_without_parsing():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_bytes(SOURCE)
+        original = NodeHydrator.hydrate
+        NodeHydrator.hydrate = no_hydrate
+        try:
+            restored = FileBoundary.from_snapshot(make_boundary(path).snapshot())
+            assert calls_of(restored, 'run') == [('helper', 'helper', 3), ('obj->Send', 'Send', 4)]
+            assert restored.file_functions['run']['line'] == 2
+            assert restored.function_text('helper') == 'void helper() {}'
+        finally:
+            NodeHydrator.hydrate = original
+
+
+def test_source_survives_file_edit():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_bytes(SOURCE)
+        snapshot = make_boundary(path).snapshot()
+        path.write_bytes(b'// rewritten\n')
+        restored = FileBoundary.from_snapshot(snapshot)
+        assert restored.source_code == SOURCE
+        assert restored.function_text('helper') == 'void helper() {}'
+
+
+def test_pickle_carries_source_only_when_file_changed():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_bytes(SOURCE)
+        snapshot = make_boundary(path).snapshot()
+
+        unchanged = pickle.loads(pickle.dumps(snapshot))
+        assert unchanged.source is None
+        assert unchanged.load_source() == SOURCE
+
+        path.write_bytes(b'// rewritten\n')
+        changed = pickle.loads(pickle.dumps(snapshot))
+        assert changed.source == SOURCE
+
+        boundary = pickle.loads(pickle.dumps(FileBoundary.from_snapshot(snapshot)))
+        assert boundary.source_code == SOURCE
+        assert calls_of(boundary, 'run')[0] == ('helper', 'helper', 3)
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
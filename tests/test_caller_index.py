@@ -0,0 +1,138 @@
+"""
+反向调用索引测试：callee_key 的名字规整、直接/传递调用者与逐边广度优先搜索一致、
+深度限制、影响范围（函数与文件）、按文件复制
+
+运行: python tests/test_caller_index.py
+"""
+import random
+import sys
+import tempfile
+from collections import deque
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+import fake_indexer
+from simple_ast.caller_index import CallerIndex, callee_key
+from simple_ast.project_indexer import ProjectIndexer
+
+
+def make_edges(seed=5, functions=30, files=6, edges=80):
+    rng = random.Random(seed)
+    result = {}
+    for _ in range(edges):
+        path = f'src/f{rng.randrange(files)}.cpp'
+        result.setdefault(path, []).append(
+            (f'fn{rng.randrange(functions)}', f'fn{rng.randrange(functions)}', rng.randrange(1, 500)))
+    return result
+
+
+def build(edges_by_file) -> CallerIndex:
+    index = CallerIndex()
+    for path, calls in edges_by_file.items():
+        index.add_file(path, calls)
+    return index
+
+
+def reference_distances(edges_by_file, roots, max_depth=None):
+    callers = {}
+    for calls in edges_by_file.values():
+        for callee, caller, _ in calls:
+            callers.setdefault(callee, set()).add(caller)
+    distances = {root: 0 for root in roots}
+    queue = deque(roots)
+    while queue:
+        name = queue.popleft()
+        if max_depth is not None and distances[name] >= max_depth:
+            continue
+        for caller in callers.get(name, ()):
+            if caller not in distances:
+                distances[caller] = distances[name] + 1
+                queue.append(caller)
+    return distances
+
+
+def test_callee_key():
+    assert callee_key('obj->Send') == 'Send'
+    assert callee_key('msg.body.Send') == 'Send'
+    assert callee_key('ns::Send') == 'Send'
+    assert callee_key('Make<int>') == 'Make'
+    assert callee_key('ns::Make<a::b>') == 'Make'
+    assert callee_key('std::vector<int>::push_back') == 'push_back'
+    assert callee_key('Outer<A<B>>::run') == 'run'
+    assert callee_key('operator<') == 'operator<'
+
+
+def test_direct_callers():
+    edges = make_edges()
+    index = build(edges)
+    assert len(index) == sum(len(calls) for calls in edges.values())
+    for name in (f'fn{i}' for i in range(32)):
+        expected = [(callee, caller, path, line) for path, calls in edges.items()
+                    for callee, caller, line in calls if callee == name]
+        sites = index.callers_of(name)
+        assert [(s.callee, s.caller, s.file_path, s.line) for s in sites] == expected
+        assert index.caller_names(f'obj->{name}') == {caller for _, caller, _, _ in expected}
+
+
+def test_transitive_callers_match_bfs():
+    edges = make_edges()
+    index = build(edges)
+    for roots in (['fn0'], ['fn1', 'fn2'], ['missing']):
+        for max_depth in (None, 0, 1, 2):
+            assert index.transitive_callers(roots, max_depth) == reference_distances(edges, roots, max_depth)
+
+
+def test_impact_files():
+    index = CallerIndex()
+    index.add_file('a.cpp', [('leaf', 'mid', 10), ('printf', 'mid', 11)])
+    index.add_file('b.cpp', [('mid', 'top', 3), ('leaf', 'unrelated_caller', 4)])
+    index.add_file('c.cpp', [('top', 'main', 1), ('other', 'main', 2)])
+    impact = index.impact(['leaf'], max_depth=2)
+    assert impact.distances == {'leaf': 0, 'mid': 1, 'unrelated_caller': 1, 'top': 2}
+    assert impact.functions == ['leaf', 'mid', 'unrelated_caller', 'top']
+    # 深度 2 处的 top 仍记入其调用所在的文件，main（深度 3）不在范围内
+    assert impact.files == {'a.cpp': ['mid'], 'b.cpp': ['top', 'unrelated_caller']}
+    assert index.impact(['leaf']).distances['main'] == 3
+
+
+def test_copy_file_from():
+    edges = make_edges()
+    old = build(edges)
+    changed = sorted(edges)[0]
+    edges[changed] = [('fn0', 'fresh', 1)]
+    new = CallerIndex()
+    for path, calls in edges.items():
+        if path == changed:
+            new.add_file(path, calls)
+        else:
+            new.copy_file_from(old, path)
+    expected = build(edges)
+    for name in (f'fn{i}' for i in range(30)):
+        assert new.callers_of(name) == expected.callers_of(name)
+
+
+def test_indexer_callers_and_impact():
+    fake_indexer.install()
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        (root / 'util.cpp').write_text('def leaf\n')
+        (root / 'mid.cpp').write_text('def mid\ncall mid leaf\n')
+        (root / 'top.cpp').write_text('def top\ncall top mid\n')
+        (root / 'api.h').write_text('decl top\n')
+        indexer = ProjectIndexer(str(root), use_cache=False)
+        indexer.index_project()
+
+        assert [(s.caller, s.file_path, s.line) for s in indexer.find_callers('leaf')] == [('mid', 'mid.cpp', 2)]
+        assert indexer.find_transitive_callers('leaf') == {'mid': 1, 'top': 2}
+        assert indexer.find_transitive_callers('leaf', max_depth=1) == {'mid': 1}
+        impact = indexer.impact_set(['leaf'])
+        # 调用所在文件和定义所在文件（声明不计）
+        assert impact.files == {'mid.cpp': ['mid'], 'top.cpp': ['top'], 'util.cpp': ['leaf']}
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
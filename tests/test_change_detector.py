@@ -0,0 +1,252 @@
+"""
+增量分析测试：-U0 diff 的行区间解析（新增/修改/纯删除）、行区间到函数的映射、
+沿调用树反向扩展依赖函数、在临时 git 仓库中取真实 diff、函数外改动
+（结构体成员、头文件）映射到引用它们的函数
+
+运行: python tests/test_change_detector.py
+"""
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+from types import SimpleNamespace
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.call_chain_tracer import CallNode
+from simple_ast.change_detector import (GitDiffError, changed_line_ranges, detect_changes,
+                                        find_changed_definitions, find_changed_functions,
+                                        find_dependent_functions, parse_diff_files,
+                                        parse_diff_line_ranges, top_level_spans)
+
+DIFF = """diff --git a/a.cpp b/a.cpp
+index 1111111..2222222 100644
+--- a/a.cpp
++++ b/a.cpp
+@@ -3 +3 @@ int helper()
+-    return 1;
++    return 2;
+@@ -10,0 +11,3 @@ void run()
++    a();
++    b();
++    c();
+@@ -20,2 +22,0 @@ void run()
+-    old();
+-    older();
+@@ -0,0 +1 @@
++// header
+"""
+
+
+def test_parse_hunk_ranges():
+    assert parse_diff_line_ranges(DIFF) == [(3, 3), (11, 13), (22, 23), (1, 1)]
+    assert parse_diff_line_ranges('') == []
+    # 删除发生在文件开头：新版本第 0 行之后
+    assert parse_diff_line_ranges('@@ -1,2 +0,0 @@\n') == [(1, 1)]
+
+
+def test_parse_multi_file_diff():
+    diff = DIFF + """diff --git a/inc/b.h b/inc/b.h
+--- a/inc/b.h
++++ b/inc/b.h
+@@ -5 +5 @@
+-x
++y
+diff --git a/gone.h b/gone.h
+--- a/gone.h
++++ /dev/null
+@@ -1 +0,0 @@
+-z
+"""
+    assert parse_diff_files(diff) == {'a.cpp': [(3, 3), (11, 13), (22, 23), (1, 1)], 'inc/b.h': [(5, 5)]}
+
+
+SOURCE = """#include "msg.h"
+#define MAX_LEN \\
+    64
+namespace app {
+typedef struct {
+    int len;   /* { */
+    char data[MAX_LEN];
+} Packet;
+
+struct Frame {
+    Packet packet;
+};
+static int g_count = 0;
+int Proto(Packet *p);
+static int Helper(Packet *p)
+{
+    if (p) { return p->len; }
+    return 0;
+}
+}
+"""
+
+
+def test_top_level_spans():
+    assert top_level_spans(SOURCE) == [
+        (1, 1, 'pp'), (2, 3, 'pp'), (5, 8, 'decl'), (10, 12, 'decl'),
+        (13, 13, 'decl'), (14, 14, 'decl'), (15, 19, 'fn')]
+
+
+def test_changed_definitions_follow_references():
+    sources = {'a.c': SOURCE}
+    # 结构体成员 -> 结构体，以及成员引用它的 Frame；函数声明不参与扩展
+    assert find_changed_definitions(sources, {'a.c': [(6, 6)]}) == {'Packet', 'Frame'}
+    assert find_changed_definitions(sources, {'a.c': [(3, 3)]}) == {'MAX_LEN', 'Packet', 'Frame'}
+    assert find_changed_definitions(sources, {'a.c': [(13, 13)]}) == {'g_count'}
+    assert find_changed_definitions(sources, {'a.c': [(14, 14)]}) == {'Proto'}
+    # 注释和空行不属于任何声明
+    assert find_changed_definitions(sources, {'a.c': [(9, 9)]}) == set()
+
+
+def make_index(definitions):
+    """与 FunctionIndex.definitions_in_lines 相同的重叠规则"""
+    funcs = [SimpleNamespace(name=name, line=start, end_line=end) for name, start, end in definitions]
+    return SimpleNamespace(definitions_in_lines=lambda start, end: [
+        f for f in funcs if f.line <= end and f.end_line >= start])
+
+
+def test_ranges_map_to_functions():
+    index = make_index([('helper', 1, 5), ('run', 8, 25), ('', 30, 32)])
+    changed, outside = find_changed_functions(index, [(3, 3), (6, 7), (5, 8), (31, 31), (40, 41)])
+    assert changed == {'helper', 'run'}
+    # 无名定义（解析不出名字的函数）不计入改动函数，但行区间也不算落在函数外
+    assert outside == [(6, 7), (40, 41)]
+
+
+def tree(name, *callees, external=()):
+    children = [CallNode(callee) for callee in callees]
+    children += [CallNode(callee, is_external=True) for callee in external]
+    return CallNode(name, children=children)
+
+
+def test_dependents_follow_callers_transitively():
+    call_chains = {
+        'leaf': tree('leaf', external=('memcpy',)),
+        'mid': tree('mid', 'leaf'),
+        'top': tree('top', 'mid', 'other'),
+        'other': tree('other'),
+        'self_loop': tree('self_loop', 'self_loop'),
+        'via_external': tree('via_external', external=('leaf',)),
+        'missing': None,
+    }
+    assert find_dependent_functions(call_chains, {'leaf'}) == {'mid', 'top'}
+    assert find_dependent_functions(call_chains, {'leaf', 'mid'}) == {'top'}
+    assert find_dependent_functions(call_chains, {'self_loop'}) == set()
+    assert find_dependent_functions(call_chains, set()) == set()
+
+
+def git(root, *args):
+    subprocess.run(['git', '-C', str(root), *args], check=True, capture_output=True)
+
+
+def test_git_diff_ranges():
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        git(root, 'init', '-q')
+        git(root, 'config', 'user.email', 'test@example.com')
+        git(root, 'config', 'user.name', 'test')
+        source = root / 'a.cpp'
+        source.write_text(''.join(f'line {i}\n' for i in range(1, 11)))
+        git(root, 'add', 'a.cpp')
+        git(root, 'commit', '-q', '-m', 'base')
+
+        lines = source.read_text().splitlines(keepends=True)
+        lines[1] = 'changed 2\n'
+        del lines[5]
+        lines.append('line 11\n')
+        source.write_text(''.join(lines))
+        git(root, 'commit', '-q', '-am', 'edit')
+
+        assert changed_line_ranges(root, source, 'HEAD~1..HEAD') == [(2, 2), (5, 6), (10, 10)]
+        assert changed_line_ranges(root, source, 'HEAD..HEAD') == []
+        try:
+            changed_line_ranges(root, source, 'no-such-rev..HEAD')
+        except GitDiffError:
+            pass
+        else:
+            raise AssertionError("invalid revision range must raise GitDiffError")
+
+
+class FakeParser:
+    """按 "name start end" 行号给出函数定义，代替需要 tree-sitter 的 CppParser"""
+
+    def __init__(self, functions):
+        self.functions = functions
+
+    def get_parsed_file(self, path):
+        source = Path(path).read_bytes()
+        offsets = [0]
+        for line in source.split(b'\n'):
+            offsets.append(offsets[-1] + len(line) + 1)
+        funcs = [SimpleNamespace(name=name, line=start, end_line=end,
+                                 start_byte=offsets[start - 1], end_byte=offsets[end] - 1)
+                 for name, start, end in self.functions]
+        index = SimpleNamespace(definitions=funcs, definitions_in_lines=lambda start, end: [
+            f for f in funcs if f.line <= end and f.end_line >= start])
+        return SimpleNamespace(source_code=source, function_index=index)
+
+
+TARGET = """#include "types.h"
+struct Msg {
+    int len;
+};
+
+int size_of(struct Msg *m)
+{
+    return m->len;
+}
+
+int count(void)
+{
+    return 1;
+}
+
+int header_user(Header *h)
+{
+    return h->id;
+}
+"""
+
+
+def test_struct_member_change_marks_users():
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        git(root, 'init', '-q')
+        git(root, 'config', 'user.email', 'test@example.com')
+        git(root, 'config', 'user.name', 'test')
+        (root / 'types.h').write_text('typedef struct {\n    int id;\n} Header;\n')
+        source = root / 'a.c'
+        source.write_text(TARGET)
+        git(root, 'add', '.')
+        git(root, 'commit', '-q', '-m', 'base')
+        parser = FakeParser([('size_of', 6, 9), ('count', 11, 14), ('header_user', 16, 19)])
+
+        # 只改结构体成员所在的行：没有函数被改动，但引用 Msg 的函数要重新生成
+        source.write_text(TARGET.replace('    int len;', '    long len;'))
+        git(root, 'commit', '-q', '-am', 'member')
+        change_set = detect_changes(root, source, 'HEAD~1..HEAD', parser=parser)
+        assert change_set.line_ranges == [(3, 3)]
+        assert change_set.outside_functions == [(3, 3)]
+        assert change_set.definitions == {'Msg'}
+        assert change_set.changed == {'size_of'}
+        assert change_set.headers == {}
+
+        # 包含闭包中的头文件改动
+        (root / 'types.h').write_text('typedef struct {\n    long id;\n} Header;\n')
+        git(root, 'commit', '-q', '-am', 'header')
+        change_set = detect_changes(root, 'a.c', 'HEAD~1..HEAD', parser=parser)
+        assert change_set.line_ranges == []
+        assert change_set.headers == {'types.h': [(2, 2)]}
+        assert change_set.definitions == {'Header'}
+        assert change_set.changed == {'header_user'}
+        assert change_set.to_dict()['headers'] == {'types.h': [[2, 2]]}
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
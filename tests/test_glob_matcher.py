@@ -0,0 +1,87 @@
+"""
+通配符匹配器测试：GlobMatcher 与逐个 fnmatch 的结果一致（使用 .simple_ast_config.json
+和内置默认配置中的模式）
+
+运行: python tests/test_glob_matcher.py
+"""
+import fnmatch
+import json
+import random
+import re
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.external_classifier import ExternalFunctionClassifier
+from simple_ast.glob_matcher import GlobMatcher, get_glob_matcher
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+GROUPS = ('standard_library', 'logging_utility', 'macro_definitions', 'custom_exclusions')
+
+
+def config_pattern_groups():
+    """配置文件和内置默认配置中的每组模式"""
+    with open(REPO_ROOT / '.simple_ast_config.json', 'r', encoding='utf-8') as f:
+        configs = [json.load(f)['external_function_classification']]
+    # 配置文件不存在时使用内置默认配置
+    configs.append(ExternalFunctionClassifier(str(REPO_ROOT / 'missing_config.json')).config)
+    groups = []
+    for config in configs:
+        for group in GROUPS:
+            groups.append(config.get(group, {}).get('patterns', []))
+    return groups
+
+
+def candidate_names(patterns):
+    """由模式本身变出的名字、测试样例中的标识符和随机名字"""
+    rng = random.Random(3)
+    names = set()
+    for pattern in patterns:
+        literal = pattern.replace('*', '')
+        names.update({literal, literal + 'X', 'X' + literal, literal[:-1], literal.lower(),
+                      pattern.replace('*', 'Abc_1'), pattern.replace('*', '')})
+    for fixture in (REPO_ROOT / 'tests').glob('*.cpp'):
+        names.update(re.findall(r'[A-Za-z_][\w:]*', fixture.read_text(encoding='utf-8', errors='ignore')))
+    alphabet = 'abLOGPRINTstd:_mecpyfr'
+    for _ in range(2000):
+        names.add(''.join(rng.choice(alphabet) for _ in range(rng.randrange(1, 12))))
+    return sorted(names)
+
+
+def check(patterns, names):
+    matcher = GlobMatcher(patterns)
+    for name in names:
+        expected = any(fnmatch.fnmatch(name, pattern) for pattern in patterns)
+        assert matcher.matches(name) == expected, (name, patterns)
+
+
+def test_config_patterns_match_fnmatch():
+    groups = config_pattern_groups()
+    names = candidate_names([p for group in groups for p in group])
+    for patterns in groups:
+        check(patterns, names)
+    check([p for group in groups for p in group], names)
+
+
+def test_wildcards_outside_prefix_position():
+    # 字面量、纯前缀、以及需要走正则的 ? / [] / 中间的 *
+    patterns = ['new', 'GET_*', '*_RETURN*', 'm?mcpy', '[A-C]*_LOG', 'a*b*c', '*']
+    names = ['new', 'newer', 'GET_', 'GET_LEN', 'XGET_', 'A_RETURN', 'memcpy', 'mZmcpy',
+             'B1_LOG', 'D_LOG', 'abc', 'aXbYc', 'ab', '']
+    check(patterns[:-1], names)
+    check(patterns, names)
+    check([], names)
+    assert not GlobMatcher([]) and len(GlobMatcher(patterns)) == len(patterns)
+
+
+def test_matchers_are_shared():
+    assert get_glob_matcher(['a*', 'b']) is get_glob_matcher(('a*', 'b'))
+    assert get_glob_matcher(['a*']) is not get_glob_matcher(['b*'])
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
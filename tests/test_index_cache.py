@@ -0,0 +1,132 @@
+"""
+索引缓存测试：mtime/大小不变直接命中，只改 mtime 时按内容哈希命中，内容变化、版本变化、
+文件删除时失效；ProjectIndexer 再次运行只重新解析有变化的文件
+
+运行: python tests/test_index_cache.py
+"""
+import os
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+import fake_indexer
+from simple_ast import index_cache
+from simple_ast.index_cache import IndexCache, content_hash
+from simple_ast.project_indexer import ProjectIndexer
+
+
+def touch(path: Path, seconds: int = 10):
+    stat = path.stat()
+    os.utime(path, ns=(stat.st_atime_ns, stat.st_mtime_ns + seconds * 1_000_000_000))
+
+
+def no_hash(data):
+    raise AssertionError("mtime/size match must not re-hash the file")
+
+
+def cache_with(tmp, path: Path, entry='entry', version=1) -> IndexCache:
+    cache = IndexCache(Path(tmp) / 'cache.pkl', version)
+    cache.store('a.cpp', path.stat(), content_hash(path.read_bytes()), entry)
+    return cache
+
+
+def test_unchanged_file_hits():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_text('int a;\n')
+        cache = cache_with(tmp, path)
+        assert cache.lookup('a.cpp', path, path.stat()) == 'entry'
+        assert cache.lookup('b.cpp', path, path.stat()) is None
+
+
+def test_touched_identical_file_hits_and_refreshes_key():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_text('int a;\n')
+        cache = cache_with(tmp, path)
+        cache.save({'a.cpp'})
+        touch(path)
+        assert cache.lookup('a.cpp', path, path.stat()) == 'entry'
+        # 新的 mtime 记入缓存并写回：下次运行不必再读文件算哈希
+        cache.save({'a.cpp'})
+        reloaded = IndexCache(Path(tmp) / 'cache.pkl', 1)
+        reloaded.load()
+        original = index_cache.content_hash
+        index_cache.content_hash = no_hash
+        try:
+            assert reloaded.lookup('a.cpp', path, path.stat()) == 'entry'
+        finally:
+            index_cache.content_hash = original
+
+
+def test_changed_content_misses():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_text('int a;\n')
+        cache = cache_with(tmp, path)
+        # 大小相同、内容不同
+        path.write_text('int b;\n')
+        touch(path)
+        assert cache.lookup('a.cpp', path, path.stat()) is None
+        # 大小不同
+        path.write_text('int abc;\n')
+        assert cache.lookup('a.cpp', path, path.stat()) is None
+
+
+def test_version_mismatch_discards_cache():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_text('int a;\n')
+        cache_with(tmp, path, version=1).save({'a.cpp'})
+        assert IndexCache(Path(tmp) / 'cache.pkl', 1).load() == 1
+        newer = IndexCache(Path(tmp) / 'cache.pkl', 2)
+        assert newer.load() == 0
+        assert newer.lookup('a.cpp', path, path.stat()) is None
+
+
+def test_save_drops_deleted_files():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_text('int a;\n')
+        cache = cache_with(tmp, path)
+        cache.save(set())
+        reloaded = IndexCache(Path(tmp) / 'cache.pkl', 1)
+        assert reloaded.load() == 0
+
+
+def test_indexer_reparses_only_changed_files():
+    parsed = fake_indexer.install()
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        (root / 'a.cpp').write_text('def alpha\ncall alpha beta\n')
+        (root / 'b.cpp').write_text('def beta\n')
+        (root / 'c.h').write_text('decl beta\n')
+
+        ProjectIndexer(str(root)).index_project()
+        assert sorted(parsed) == ['a.cpp', 'b.cpp', 'c.h']
+
+        del parsed[:]
+        touch(root / 'c.h')  # 只改 mtime
+        (root / 'b.cpp').write_text('def beta\ndef gamma\n')
+        (root / 'a.cpp').unlink()
+        (root / 'd.cpp').write_text('def delta\n')
+        indexer = ProjectIndexer(str(root))
+        indexer.index_project()
+        assert sorted(parsed) == ['b.cpp', 'd.cpp']
+        assert [s.file_path for s in indexer.find_symbol('gamma')] == ['b.cpp']
+        assert indexer.find_symbol('alpha') == []
+        assert sorted(s.file_path for s in indexer.find_symbol('beta')) == ['b.cpp', 'c.h']
+
+        # 与不使用缓存的结果一致
+        fresh = ProjectIndexer(str(root), use_cache=False)
+        fresh.index_project()
+        assert dict(fresh.symbol_table.items()) == dict(indexer.symbol_table.items())
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
@@ -0,0 +1,75 @@
+"""
+JSON Lines 输出测试：共享子树只写一次、子节点先于父节点、函数报告边生成边写
+
+运行: python tests/test_jsonl_writer.py
+"""
+import io
+import json
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.call_chain_tracer import CallNode
+from simple_ast.cpp_analyzer import AnalysisResult
+
+
+def diamond_chain(depth):
+    """每层两个调用都指向同一个子节点：展开后 2^depth 个节点，实际只有 depth+1 个"""
+    node = CallNode('leaf', 'a.cpp', 1)
+    for level in range(depth):
+        node = CallNode(f'f{level}', 'a.cpp', level + 2, children=[node, node])
+    return node
+
+
+def make_result(call_chains):
+    return AnalysisResult(target_file='a.cpp', project_root='.', entry_points=[],
+                          call_chains=call_chains, function_signatures={'f0': 'void f0()'},
+                          data_structures={}, mode='single_file_boundary')
+
+
+def read_records(buffer):
+    return [json.loads(line) for line in buffer.getvalue().splitlines()]
+
+
+def test_shared_subtrees_written_once():
+    # 40 层：to_json 需要展开 2^40 个节点，JSONL 只写 41 个
+    root = diamond_chain(40)
+    result = make_result({'top': root, 'again': root})
+    buffer = io.StringIO()
+    result.write_jsonl(buffer)
+    records = read_records(buffer)
+
+    nodes = [r for r in records if r['type'] == 'call_node']
+    assert len(nodes) == 41
+    seen = set()
+    for node in nodes:
+        assert all(child in seen for child in node['children'])
+        seen.add(node['id'])
+    chains = {r['function']: r['root'] for r in records if r['type'] == 'call_chain'}
+    assert chains['top'] == chains['again'] == nodes[-1]['id']
+    assert records[0]['type'] == 'header' and records[-1]['type'] == 'end'
+    assert records[-1]['counts']['call_node'] == 41
+
+
+def test_reports_streamed_after_tree_records():
+    buffer = io.StringIO()
+    observed = []
+
+    def reports():
+        for name in ('f0', 'f1'):
+            # 生成报告时调用树记录已经写出
+            observed.append(sum(1 for r in read_records(buffer) if r['type'] == 'call_chain'))
+            yield name, f'report {name}'
+
+    make_result({'top': diamond_chain(3)}).write_jsonl(buffer, reports=reports())
+    records = read_records(buffer)
+    assert observed == [1, 1]
+    assert [r['function'] for r in records if r['type'] == 'function_report'] == ['f0', 'f1']
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
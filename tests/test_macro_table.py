@@ -0,0 +1,124 @@
+"""
+宏表与成员宏展开测试：单行/多行/函数宏、嵌套成员宏、循环引用、展开用到的宏、
+按项目共享；定义索引建表与逐次搜索两条路径结果一致
+
+运行: python tests/test_macro_table.py
+"""
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.extractors.macro_extractor import MacroExtractor
+from simple_ast.extractors.macro_table import clear_macro_tables, get_macro_expander, get_macro_table
+from simple_ast.searchers import SearchTool, configure_definition_index, set_search_tool
+from simple_ast.searchers.memory_searcher import clear_corpus_cache
+
+HEADER = """#ifndef MACROS_H
+#define MACROS_H
+#define LIMIT   10
+#define MAX(a, b)  ((a) > (b) ? (a) : (b))
+#define VOS_MSG_HEADER \\
+    unsigned int ulSenderPid; \\
+    unsigned int ulLength;
+#define EXT_HEADER \\
+    VOS_MSG_HEADER \\
+    int ext;
+#define LOOP_A \\
+    LOOP_B
+#define LOOP_B \\
+    LOOP_A
+#endif
+"""
+
+STRUCT = """typedef struct {
+    EXT_HEADER /* 消息头 */
+    int body;
+    LOOP_A
+} Msg;"""
+
+
+def make_project(tmp) -> Path:
+    root = Path(tmp)
+    (root / 'inc').mkdir()
+    (root / 'inc' / 'macros.h').write_text(HEADER, encoding='utf-8')
+    (root / 'a.cpp').write_text('#include "inc/macros.h"\nint x = LIMIT;\n', encoding='utf-8')
+    return root
+
+
+def each_lookup_mode(check):
+    """分别用定义索引建表和逐次（进程内）搜索运行 check(项目根目录)"""
+    set_search_tool(SearchTool.PYTHON)
+    for enabled in (True, False):
+        with tempfile.TemporaryDirectory() as tmp:
+            configure_definition_index(enabled=enabled, persist=False)
+            clear_macro_tables()
+            clear_corpus_cache()
+            check(make_project(tmp))
+    configure_definition_index()
+    clear_macro_tables()
+
+
+def test_definitions():
+    def check(root):
+        extractor = MacroExtractor(str(root))
+        extractor.prefetch(['LIMIT', 'MAX(x, y)', 'VOS_MSG_HEADER'])
+        assert extractor.extract_macro_definition('LIMIT') == '#define LIMIT 10'
+        assert extractor.extract_macro_definition('MAX(x, y)') == '#define MAX(a, b) ((a) > (b) ? (a) : (b))'
+        assert extractor.extract_macro_definition('VOS_MSG_HEADER') == (
+            '#define VOS_MSG_HEADER\n    unsigned int ulSenderPid;\n    unsigned int ulLength;')
+        assert extractor.extract_macro_definition('MISSING') is None
+        macro = get_macro_table(root).get('MAX')
+        assert macro.params == '(a, b)' and macro.line == 4 and not macro.is_multiline
+    each_lookup_mode(check)
+
+
+def test_struct_macro_expands_nested_members():
+    def check(root):
+        extractor = MacroExtractor(str(root))
+        assert extractor.extract_struct_macro('EXT_HEADER') == '\n    '.join([
+            '/* VOS_MSG_HEADER 展开: */', 'unsigned int ulSenderPid;', 'unsigned int ulLength;',
+            'int ext;'])
+        # 函数宏和未定义的名字不作为成员宏展开
+        assert extractor.extract_struct_macro('MAX') is None
+        assert extractor.extract_struct_macro('MISSING') is None
+    each_lookup_mode(check)
+
+
+def test_expand_definition_keeps_layout_and_stops_at_cycles():
+    def check(root):
+        expander = get_macro_expander(root)
+        # 与原报告格式一致：首个成员行用原缩进，其余成员行再缩进 4 格
+        assert expander.expand_definition(STRUCT).split('\n') == [
+            'typedef struct {',
+            '    /* EXT_HEADER 展开: */',
+            '    /* VOS_MSG_HEADER 展开: */',
+            '        unsigned int ulSenderPid;',
+            '        unsigned int ulLength;',
+            '        int ext;',
+            '    /* 消息头 */',
+            '    int body;',
+            # LOOP_A -> LOOP_B -> LOOP_A：循环处保留原名
+            '    /* LOOP_A 展开: */',
+            '    /* LOOP_B 展开: */',
+            '        LOOP_A',
+            '} Msg;',
+        ]
+        assert {'EXT_HEADER', 'VOS_MSG_HEADER'} <= expander.expanded_macros(STRUCT)
+        assert expander.expand_definition('int plain;') == 'int plain;'
+    each_lookup_mode(check)
+
+
+def test_tables_are_shared_per_project():
+    def check(root):
+        assert get_macro_table(root) is get_macro_table(str(root))
+        assert MacroExtractor(str(root)).macro_expander is get_macro_expander(root)
+    each_lookup_mode(check)
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
@@ -0,0 +1,59 @@
+"""
+MultiPatternMatcher 分拣测试：批量搜索的结果必须与逐个模式 re.search 完全一致
+
+运行: python tests/test_multi_pattern.py
+"""
+import re
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.searchers.memory_searcher import MultiPatternMatcher
+
+
+def typedef_pattern(name):
+    # StructureSearcher 按名字构造的 typedef 结尾模式
+    return rf'}}\s*.*\b{name}\b.*;'
+
+
+def expected(patterns, line):
+    return {p for p in patterns if re.search(p, line)}
+
+
+def test_two_patterns_on_one_line():
+    patterns = [typedef_pattern('MSG_CB'), typedef_pattern('MsgBlock')]
+    matcher = MultiPatternMatcher(patterns)
+    assert set(matcher.match_line('} MSG_CB, MsgBlock;')) == set(patterns)
+    assert matcher.match_line('} Other;') == []
+
+
+def test_overlapping_identifiers():
+    patterns = [r'\bFOO\b', r'\bFOO_BAR\b', r'FOO_BAR\s*=', r'\bBAR\b']
+    matcher = MultiPatternMatcher(patterns)
+    for line in ['#define FOO_BAR 1', 'int FOO = FOO_BAR = BAR;', 'nothing here', 'BAR FOO']:
+        assert set(matcher.match_line(line)) == expected(patterns, line), line
+
+
+def test_order_and_unmergeable_patterns():
+    # 反向引用无法合并，走逐个匹配；结果按首个匹配位置排序
+    patterns = [r'\bsecond\b', r'(\w+) \1', r'\bfirst\b']
+    matcher = MultiPatternMatcher(patterns)
+    assert matcher.match_line('first second second') == [r'\bfirst\b', r'\bsecond\b', r'(\w+) \1']
+
+
+def test_matches_per_pattern_search():
+    words = ['Msg', 'MsgBlock', 'MSG_CB', 'Block', 'CB']
+    patterns = [rf'\b{w}\b' for w in words] + [typedef_pattern(w) for w in words]
+    matcher = MultiPatternMatcher(patterns)
+    lines = ['} MSG_CB, MsgBlock;', 'struct Msg { int Block; };', 'CB Block Msg',
+             '} *PMsg, Msg;', '']
+    for line in lines:
+        assert set(matcher.match_line(line)) == expected(patterns, line), line
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
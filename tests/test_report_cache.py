@@ -0,0 +1,94 @@
+"""
+报告缓存键测试：报告依赖的每一项输入变化时键都要变化，无关变化时保持不变
+
+运行: python tests/test_report_cache.py
+"""
+import os
+import sys
+import tempfile
+from pathlib import Path
+from types import SimpleNamespace
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.reporters.report_cache import ReportKeyBuilder, ReportCache
+from simple_ast.searchers import configure_definition_index
+
+SOURCE = b'int handle(Msg *m) { return LIMIT + m->len; }\n'
+
+
+def make_project(tmp):
+    root = Path(tmp)
+    (root / 'src').mkdir()
+    (root / 'src' / 'a.cpp').write_bytes(SOURCE)
+    # 没有 #include：HeaderSearcher 退回目录启发式，同目录的头文件都会被读取
+    (root / 'src' / 'types.h').write_text('typedef struct { int len; } Msg;\n')
+    return root
+
+
+def make_result(root, classifier_config):
+    boundary = SimpleNamespace(
+        file_functions={'handle': {'span': (0, len(SOURCE) - 1), 'line': 1}},
+        file_data_structures={},
+        source_code=SOURCE,
+    )
+    return SimpleNamespace(
+        project_root=str(root), target_file='src/a.cpp', file_boundary=boundary,
+        data_structures={}, function_signatures={'handle': 'int handle(Msg *m)'},
+        call_chains={}, external_classifier=SimpleNamespace(config=classifier_config),
+    )
+
+
+def key_for(root, config=None):
+    config = config if config is not None else {'logging_utility': {'patterns': ['*LOG*']}}
+    return ReportKeyBuilder(make_result(root, config)).key('handle', ['handle'])
+
+
+def bump(path: Path, text: str):
+    path.write_text(text)
+    stat = path.stat()
+    os.utime(path, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1_000_000_000))
+
+
+def test_key_is_stable():
+    configure_definition_index(persist=False)
+    with tempfile.TemporaryDirectory() as tmp:
+        root = make_project(tmp)
+        first = key_for(root)
+        assert first is not None
+        assert key_for(root) == first
+
+
+def test_classifier_config_changes_key():
+    configure_definition_index(persist=False)
+    with tempfile.TemporaryDirectory() as tmp:
+        root = make_project(tmp)
+        base = key_for(root)
+        assert key_for(root, {'logging_utility': {'patterns': ['*LOG*', '*Trace*']}}) != base
+        # 键与字典顺序无关
+        assert key_for(root, {'logging_utility': {'patterns': ['*LOG*']}}) == base
+
+
+def test_directory_fallback_headers_change_key():
+    configure_definition_index(persist=False)
+    with tempfile.TemporaryDirectory() as tmp:
+        root = make_project(tmp)
+        base = key_for(root)
+        bump(root / 'src' / 'types.h', 'typedef struct { int len; int flags; } Msg;\n')
+        configure_definition_index(persist=False)
+        assert key_for(root) != base
+
+
+def test_cache_round_trip():
+    with tempfile.TemporaryDirectory() as tmp:
+        cache = ReportCache(tmp)
+        assert cache.get('ab' * 32) is None
+        cache.put('ab' * 32, '报告\r\n内容')
+        assert cache.get('ab' * 32) == '报告\r\n内容'
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
@@ -0,0 +1,88 @@
+"""
+rg --json 流式解析测试：match/非 match 事件、base64 字段、命令构建、够数即停、搜索池
+
+运行: python tests/test_rg_stream.py
+"""
+import base64
+import json
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.searchers import rg_stream
+from simple_ast.searchers.rg_stream import (configure_search_concurrency, map_searches,
+                                            parse_match_event, rg_json_command, search_rg)
+
+
+def match_event(path, line_number, text):
+    return json.dumps({'type': 'match', 'data': {
+        'path': path, 'lines': text, 'line_number': line_number,
+        'absolute_offset': 0, 'submatches': []}}).encode('utf-8')
+
+
+def fake_rg(lines, hang=False):
+    """用 Python 子进程模拟 rg：依次输出给定的 JSON 行；hang 时输出后不退出"""
+    script = ['import sys, time']
+    for line in lines:
+        script.append(f'sys.stdout.write({line.decode("utf-8")!r} + "\\n")')
+    script.append('sys.stdout.flush()')
+    if hang:
+        script.append('time.sleep(30)')
+    return [sys.executable, '-c', '\n'.join(script)]
+
+
+def test_parse_text_match():
+    line = match_event({'text': 'src/a.h'}, 12, {'text': '#define LIMIT 10\r\n'})
+    assert parse_match_event(line) == (Path('src/a.h'), 12, '#define LIMIT 10')
+
+
+def test_parse_base64_fields():
+    gbk = '// 中文注释'.encode('gbk')
+    line = match_event({'bytes': base64.b64encode(b'src/\xff.h').decode()}, 3,
+                       {'bytes': base64.b64encode(b'int x; ' + gbk + b'\n').decode()})
+    path, line_number, content = parse_match_event(line)
+    assert line_number == 3
+    assert path.name == '.h'
+    assert content.startswith('int x; ')
+
+
+def test_non_match_events_ignored():
+    for event in ({'type': 'begin', 'data': {'path': {'text': 'a.h'}}},
+                  {'type': 'context', 'data': {}},
+                  {'type': 'summary', 'data': {}}):
+        assert parse_match_event(json.dumps(event).encode()) is None
+    assert parse_match_event(b'not json') is None
+
+
+def test_command_arguments():
+    cmd = rg_json_command('/p', '*.h', ['a"b', '$x'], pattern_file='/tmp/f', ignore_case=True,
+                          max_count=5)
+    assert cmd == ['rg', '--json', '--glob=*.h', '-i', '--max-count=5',
+                   '--regexp=a"b', '--regexp=$x', '--file=/tmp/f', '--', '/p']
+    assert rg_json_command('/p', '*.c') == ['rg', '--json', '--glob=*.c', '--', '/p']
+
+
+def test_search_stops_after_max_results():
+    lines = [json.dumps({'type': 'begin', 'data': {}}).encode()]
+    lines += [match_event({'text': f'f{i}.h'}, i, {'text': f'line {i}\n'}) for i in range(1, 4)]
+    # 子进程输出后会挂起 30 秒：拿够结果必须立即结束它，而不是等超时
+    matches = search_rg(fake_rg(lines, hang=True), max_results=2, timeout=10)
+    assert [(p.name, n, t) for p, n, t in matches] == [('f1.h', 1, 'line 1'), ('f2.h', 2, 'line 2')]
+
+
+def test_map_searches_keeps_order():
+    original = rg_stream._max_concurrent
+    try:
+        for limit in (4, 1):
+            configure_search_concurrency(limit)
+            assert map_searches(lambda x: x * x, range(10)) == [x * x for x in range(10)]
+    finally:
+        configure_search_concurrency(original)
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
@@ -0,0 +1,66 @@
+"""
+source_loader 测试：一次读取、编码检测与缓存、按检测到的编码解码节点文本
+
+运行: python tests/test_source_loader.py
+"""
+import os
+import pickle
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.cpp_parser import CppParser
+from simple_ast.logger import enable_profiling, get_profile_summary
+from simple_ast.source_loader import SourceBytes, clear_encoding_cache, detect_encoding, read_source
+
+FIXTURES = Path(__file__).resolve().parent
+
+
+def test_fixture_encodings():
+    assert read_source(FIXTURES / 'test_chinese.cpp').encoding == 'utf-8'
+    assert read_source(FIXTURES / 'test_gbk.cpp').encoding == 'gbk'
+    assert detect_encoding(b'int main() { return 0; }') == 'utf-8'
+
+
+def test_buffer_carries_encoding():
+    source = read_source(FIXTURES / 'test_gbk.cpp')
+    assert isinstance(source.data, SourceBytes)
+    assert source.data.encoding == 'gbk'
+    assert source.data == (FIXTURES / 'test_gbk.cpp').read_bytes()
+    # 进程间传递（并行报告 / 快照）后仍带编码
+    restored = pickle.loads(pickle.dumps(source.data))
+    assert restored == source.data and restored.encoding == 'gbk'
+
+
+def test_get_text_uses_detected_encoding():
+    text = '// 消息处理\nint x;'
+    gbk = SourceBytes.tagged(text.encode('gbk'), 'gbk')
+    assert CppParser.get_text(gbk, 0, len(gbk)) == text
+    # 没有编码信息的普通 bytes 仍按 utf-8 → gbk → ... 的顺序解码
+    assert CppParser.get_text(text.encode('gbk'), 0, len(gbk)) == text
+    assert CppParser.get_text(text.encode('utf-8'), 0, len(text.encode('utf-8'))) == text
+
+
+def test_encoding_cache_follows_file_changes():
+    clear_encoding_cache()
+    enable_profiling()
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'a.cpp'
+        path.write_bytes('// 中文\n'.encode('gbk'))
+        assert read_source(path).encoding == 'gbk'
+        hits = get_profile_summary()['counters'].get('source.encoding_cache_hit', 0)
+        assert read_source(path).encoding == 'gbk'
+        assert get_profile_summary()['counters'].get('source.encoding_cache_hit', 0) == hits + 1
+
+        path.write_bytes('// 中文 utf8\n'.encode('utf-8'))
+        os.utime(path, ns=(1, 1))
+        assert read_source(path).encoding == 'utf-8'
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
@@ -0,0 +1,142 @@
+"""
+SQLite 符号存储测试：与内存存储的查询结果一致（首次建立、重新打开、增量刷新、
+强制重建），重新打开时只解析有变化的文件，分批同步时删除的文件按查询找出，
+#include 解析按需从数据库读取
+
+运行: python tests/test_sqlite_store.py
+"""
+import os
+import random
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+import fake_indexer
+from simple_ast import project_indexer
+from simple_ast.project_indexer import ProjectIndexer
+from simple_ast.searchers.include_resolver import IncludeResolver
+
+NAMES = [f'fn{i}' for i in range(45)] + ['newfn']
+
+
+def make_project(root: Path, files=24, seed=1):
+    rng = random.Random(seed)
+    (root / 'src').mkdir()
+    for i in range(files):
+        lines = [f'inc src/f{rng.randrange(files)}.h']
+        for _ in range(4):
+            lines.append(f'def fn{rng.randrange(40)}')
+            lines.append(f'decl fn{rng.randrange(40)}')
+            lines.append(f'call fn{rng.randrange(40)} fn{rng.randrange(40)}')
+        suffix = 'h' if i % 3 == 0 else 'cpp'
+        (root / 'src' / f'f{i}.{suffix}').write_text('\n'.join(lines) + '\n')
+
+
+def assert_same(memory: ProjectIndexer, sqlite: ProjectIndexer):
+    assert sorted(memory.symbol_table) == sorted(sqlite.symbol_table)
+    assert len(memory.symbol_table) == len(sqlite.symbol_table)
+    assert memory.symbol_table.row_count == sqlite.symbol_table.row_count
+    assert memory.symbol_table.files() == sqlite.symbol_table.files()
+    assert memory.include_graph == sqlite.include_graph
+    for name in NAMES:
+        assert memory.find_symbol(name) == sqlite.find_symbol(name), name
+        assert memory.find_definition(name) == sqlite.find_definition(name), name
+        assert memory.find_callers(name) == sqlite.find_callers(name), name
+        assert memory.find_transitive_callers(name, 3) == sqlite.find_transitive_callers(name, 3), name
+    assert memory.impact_set(['fn1', 'fn2']).to_dict() == sqlite.impact_set(['fn1', 'fn2']).to_dict()
+    for path in memory.symbol_table.files():
+        assert memory.get_file_symbols(path) == sqlite.get_file_symbols(path), path
+
+
+def memory_index(root: Path) -> ProjectIndexer:
+    indexer = ProjectIndexer(str(root), use_cache=False)
+    indexer.index_project()
+    return indexer
+
+
+def test_sqlite_matches_memory():
+    parsed = fake_indexer.install()
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        make_project(root)
+        memory = memory_index(root)
+
+        # 热缓存很小：大部分查询走 SQL
+        sqlite = ProjectIndexer(str(root), store='sqlite', hot_cache_size=4)
+        sqlite.index_project()
+        assert_same(memory, sqlite)
+
+        # 重新打开：数据库同时是索引缓存，未变化的文件不再解析
+        del parsed[:]
+        reopened = ProjectIndexer(str(root), store='sqlite')
+        reopened.index_project()
+        assert parsed == []
+        assert_same(memory, reopened)
+
+
+def test_refresh_matches_memory():
+    fake_indexer.install()
+    with tempfile.TemporaryDirectory() as tmp:
+        root = Path(tmp)
+        make_project(root)
+        memory = memory_index(root)
+        sqlite = ProjectIndexer(str(root), store='sqlite', hot_cache_size=4)
+        sqlite.index_project()
+        for name in NAMES:
+            sqlite.find_symbol(name)  # 填满热缓存：刷新后不能返回旧结果
+
+        changed = root / 'src' / 'f5.cpp'
+        changed.write_text('def newfn\ncall fn1 newfn\n')
+        stat = changed.stat()
+        os.utime(changed, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1_000_000_000))
+        (root / 'src' / 'f7.cpp').unlink()
+        (root / 'src' / 'g1.cpp').write_text('def fn1\ncall newfn fn3\n')
+
+        assert memory.refresh() == sqlite.refresh() == 3
+        assert_same(memory, sqlite)
+        assert [s.file_path for s in sqlite.find_symbol('newfn')] == ['src/f5.cpp']
+
+        # 强制重建（--no-cache）与内存结果一致
+        rebuilt = ProjectIndexer(str(root), store='sqlite', use_cache=False)
+        rebuilt.index_project()
+        assert_same(memory, rebuilt)
+
+
+def test_small_batches_and_include_lookups():
+    fake_indexer.install()
+    batch_files = project_indexer.SQLITE_BATCH_FILES
+    project_indexer.SQLITE_BATCH_FILES = 5
+    try:
+        with tempfile.TemporaryDirectory() as tmp:
+            root = Path(tmp)
+            make_project(root, seed=3)
+            memory = memory_index(root)
+            sqlite = ProjectIndexer(str(root), store='sqlite')
+            sqlite.index_project()
+            assert_same(memory, sqlite)
+
+            # 删除的文件分布在不同批次中
+            for name in ('f1.cpp', 'f8.cpp', 'f22.cpp'):
+                (root / 'src' / name).unlink()
+            assert memory.refresh() == sqlite.refresh() == 3
+            assert_same(memory, sqlite)
+            assert sqlite.symbol_table.store.file_count() == len(memory.include_graph)
+
+            from_memory = IncludeResolver(root)
+            from_memory.use_include_graph(memory.include_graph)
+            from_store = IncludeResolver(root)
+            from_store.use_include_graph(sqlite.include_graph)
+            for rel_path in memory.include_graph:
+                assert from_memory.include_closure(rel_path) == from_store.include_closure(rel_path), rel_path
+            assert 'src/f1.cpp' not in sqlite.include_graph
+    finally:
+        project_indexer.SQLITE_BATCH_FILES = batch_files
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")
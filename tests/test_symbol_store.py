@@ -0,0 +1,110 @@
+"""
+符号表存储测试：StringPool 驻留、SymbolStore 与 Dict[str, List[SymbolInfo]] 行为一致、
+按文件复制（增量刷新）
+
+运行: python tests/test_symbol_store.py
+"""
+import random
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+
+from simple_ast.project_indexer import SymbolInfo
+from simple_ast.symbol_store import StringPool, SymbolStore
+
+
+def make_files(seed=7, files=12):
+    rng = random.Random(seed)
+    result = {}
+    for file_no in range(files):
+        path = f'src/m{file_no % 3}/f{file_no}.{"h" if file_no % 4 == 0 else "cpp"}'
+        result[path] = [
+            SymbolInfo(f'fn{rng.randrange(40)}', rng.choice(['function', 'struct', 'typedef']),
+                       path, line, f'void sig{rng.randrange(10**6)}()', rng.random() < 0.3,
+                       path.endswith('.h'))
+            for line in range(1, rng.randrange(0, 15) + 1)
+        ]
+    return result
+
+
+def build(files):
+    store = SymbolStore()
+    reference = {}
+    for path, symbols in files.items():
+        store.add_file(path, symbols)
+        for symbol in symbols:
+            reference.setdefault(symbol.name, []).append(symbol)
+    return store, reference
+
+
+def test_string_pool_interns_once():
+    pool = StringPool()
+    first = pool.intern('src/a.cpp')
+    assert pool.intern('src/a.cpp') == first
+    second = pool.intern('src/b.cpp')
+    assert second != first and len(pool) == 2
+    assert pool[first] == 'src/a.cpp' and pool[second] == 'src/b.cpp'
+    assert pool.lookup('src/b.cpp') == second
+    assert pool.lookup('missing') == -1
+
+
+def test_store_matches_dict_of_lists():
+    files = make_files()
+    store, reference = build(files)
+    assert dict(store.items()) == reference
+    assert len(store) == len(reference)
+    assert sorted(store) == sorted(reference)
+    assert store.row_count == sum(len(symbols) for symbols in files.values())
+    for name in reference:
+        assert name in store
+        assert [store.symbol_at(row) for row in store.rows(name)] == reference[name]
+
+
+def test_missing_names():
+    store, _ = build(make_files())
+    assert 'nope' not in store
+    assert 42 not in store
+    assert store.get('nope') is None
+    assert list(store.rows('nope')) == []
+    try:
+        store['nope']
+    except KeyError:
+        pass
+    else:
+        raise AssertionError("missing name must raise KeyError")
+
+
+def test_file_views():
+    files = make_files()
+    store, _ = build(files)
+    # 没有符号的文件也要出现在文件列表中
+    assert store.files() == list(files)
+    for path, symbols in files.items():
+        assert store.file_symbol_names(path) == {s.name for s in symbols}
+    assert store.file_symbol_names('missing.cpp') == set()
+
+
+def test_copy_file_from_rebuilds_same_table():
+    files = make_files()
+    old, _ = build(files)
+    # 增量刷新：一个文件换成新内容，其余文件逐行复制
+    changed = next(path for path, symbols in files.items() if symbols)
+    files[changed] = [SymbolInfo('fresh', 'function', changed, 1, 'void fresh()', False, False)]
+    new = SymbolStore()
+    for path, symbols in files.items():
+        if path == changed:
+            new.add_file(path, symbols)
+        else:
+            new.copy_file_from(old, path)
+    expected, reference = build(files)
+    assert dict(new.items()) == reference
+    assert new.files() == expected.files()
+    assert new.row_count == expected.row_count
+
+
+if __name__ == '__main__':
+    for name, func in list(globals().items()):
+        if name.startswith('test_') and callable(func):
+            func()
+            print(f"ok  {name}")